@@ -0,0 +1,87 @@
+// Measures whole-array arithmetic and reductions against the same computation written as a loop over the
+// elements. Run with LYNX_SIMD=scalar, sse2 or avx2 to compare levels. Usage: lynx_bench_arrays [elements]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "interpreter.h"
+#include "kernels.h"
+
+namespace {
+
+    const char* const SETUP = R"(
+        var a: float[] = array(count, 1.5);
+        var b: float[] = array(count, 0.25);
+    )";
+
+    const char* const ARRAY_SCRIPT = R"(
+        var total: float = 0.0;
+        var round: int = 0;
+        while round < 10 {
+            var c: float[] = a * 2.0 + b;
+            total = total + sum(c * b) + dot(a, b);
+            round = round + 1;
+        }
+        print total;
+    )";
+
+    const char* const LOOP_SCRIPT = R"(
+        var total: float = 0.0;
+        var round: int = 0;
+        while round < 10 {
+            var c: float[] = array(count, 0.0);
+            var i: int = 0;
+            while i < count {
+                c[i] = a[i] * 2.0 + b[i];
+                i = i + 1;
+            }
+            i = 0;
+            while i < count {
+                total = total + c[i] * b[i] + a[i] * b[i];
+                i = i + 1;
+            }
+            round = round + 1;
+        }
+        print total;
+    )";
+
+    // Returns the best of a few runs in nanoseconds per element and round.
+    double measure(const char* const name, const std::string& script, const long long count) {
+        const auto compiled = lynx::Program::compile(name, "var count: int = " + std::to_string(count) + ";"
+                + SETUP + script);
+        if(compiled.program == nullptr) {
+            std::cerr << "Failed to compile '" << name << "'\n";
+            std::exit(1);
+        }
+        double best = 0;
+        for(int run = 0; run < 5; ++run) {
+            std::string sink;
+            lynx::Output_Buffer output{sink};
+            lynx::Interpreter interpreter{output};
+            const auto start = std::chrono::steady_clock::now();
+            const auto result = interpreter.run(*compiled.program);
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            if(!result.ok()) {
+                std::cerr << name << ": " << result.error << '\n';
+                std::exit(1);
+            }
+            const auto per_element = elapsed.count() / static_cast<double>(count * 10);
+            if(run == 0 || per_element < best) {
+                best = per_element;
+            }
+        }
+        return best;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    const long long count = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    std::cout << "elements:   " << count << '\n'
+              << "loop:       " << measure("loop", LOOP_SCRIPT, count) << " ns/element\n";
+    const auto level = lynx::to_string(lynx::kernels().level);
+    std::cout << "arrays (" << level << "): " << measure("arrays", ARRAY_SCRIPT, count) << " ns/element\n";
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Measures what streaming values out of a generator costs compared to building the same values into an array
+// first, and to computing them inline in the consumer's loop. Usage: lynx_bench_generators [values]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "interpreter.h"
+
+namespace {
+
+    const char* const GENERATOR_SCRIPT = R"(
+        func numbers(n: int) {
+            var i: int = 0;
+            while i < n {
+                yield i;
+                i = i + 1;
+            }
+        }
+        var total: int = 0;
+        for x in numbers(count) {
+            total = total + x;
+        }
+        print total;
+    )";
+
+    const char* const EAGER_SCRIPT = R"(
+        func numbers(n: int): int[] {
+            var values: int[] = array(n, 0);
+            var i: int = 0;
+            while i < n {
+                values[i] = i;
+                i = i + 1;
+            }
+            return values;
+        }
+        var total: int = 0;
+        for x in numbers(count) {
+            total = total + x;
+        }
+        print total;
+    )";
+
+    const char* const INLINE_SCRIPT = R"(
+        var total: int = 0;
+        var i: int = 0;
+        while i < count {
+            total = total + i;
+            i = i + 1;
+        }
+        print total;
+    )";
+
+    // Returns the best of a few runs in nanoseconds per value.
+    double measure(const char* const name, const std::string& script, const long long count) {
+        const auto compiled = lynx::Program::compile(name, "var count: int = " + std::to_string(count) + ";"
+                + script);
+        if(compiled.program == nullptr) {
+            std::cerr << "Failed to compile '" << name << "'\n";
+            std::exit(1);
+        }
+        double best = 0;
+        for(int run = 0; run < 5; ++run) {
+            std::string sink;
+            lynx::Output_Buffer output{sink};
+            lynx::Interpreter interpreter{output};
+            const auto start = std::chrono::steady_clock::now();
+            const auto result = interpreter.run(*compiled.program);
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            if(!result.ok()) {
+                std::cerr << name << ": " << result.error << '\n';
+                std::exit(1);
+            }
+            const auto per_value = elapsed.count() / static_cast<double>(count);
+            if(run == 0 || per_value < best) {
+                best = per_value;
+            }
+        }
+        return best;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    const long long count = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    const auto streamed = measure("generator", GENERATOR_SCRIPT, count);
+    const auto eager = measure("eager", EAGER_SCRIPT, count);
+    const auto computed_inline = measure("inline", INLINE_SCRIPT, count);
+    std::cout << "values:          " << count << '\n'
+              << "generator:       " << streamed << " ns/value, constant memory\n"
+              << "eager array:     " << eager << " ns/value, " << count * sizeof(long long) << " bytes\n"
+              << "inline:          " << computed_inline << " ns/value\n"
+              << "resume overhead: " << streamed - computed_inline << " ns/value\n";
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Measures counting records by key in a map, with the map growing as keys arrive and pre-sized with map(n).
+// Usage: lynx_bench_maps [records] [distinct keys]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "interpreter.h"
+
+namespace {
+
+    const char* const GROWING_SCRIPT = R"(
+        var counts: int[int] = {};
+    )";
+
+    const char* const PRESIZED_SCRIPT = R"(
+        var counts: int[int] = map(keys);
+    )";
+
+    const char* const COUNT_SCRIPT = R"(
+        var i: int = 0;
+        var key: int = 0;
+        while i < records {
+            key = (key + 7919) - ((key + 7919) / keys) * keys;
+            counts[key] = counts[key] + 1;
+            i = i + 1;
+        }
+        print len(counts);
+    )";
+
+    // Returns the best of a few runs in nanoseconds per record.
+    double measure(const char* const name, const std::string& script, const long long records, const long long keys) {
+        const auto compiled = lynx::Program::compile(name, "var records: int = " + std::to_string(records)
+                + "; var keys: int = " + std::to_string(keys) + ";" + script + COUNT_SCRIPT);
+        if(compiled.program == nullptr) {
+            std::cerr << "Failed to compile '" << name << "'\n";
+            std::exit(1);
+        }
+        double best = 0;
+        for(int run = 0; run < 5; ++run) {
+            std::string sink;
+            lynx::Output_Buffer output{sink};
+            lynx::Interpreter interpreter{output};
+            const auto start = std::chrono::steady_clock::now();
+            const auto result = interpreter.run(*compiled.program);
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            if(!result.ok()) {
+                std::cerr << name << ": " << result.error << '\n';
+                std::exit(1);
+            }
+            const auto per_record = elapsed.count() / static_cast<double>(records);
+            if(run == 0 || per_record < best) {
+                best = per_record;
+            }
+        }
+        return best;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    const long long records = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    const long long keys = argc > 2 ? std::atoll(argv[2]) : 100000;
+    std::cout << "records:  " << records << ", keys: " << keys << '\n'
+              << "growing:  " << measure("growing", GROWING_SCRIPT, records, keys) << " ns/record\n"
+              << "presized: " << measure("presized", PRESIZED_SCRIPT, records, keys) << " ns/record\n";
+    return 0;
+}
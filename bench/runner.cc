@@ -0,0 +1,182 @@
+// Runs the scripts of bench/scripts (or the ones given) repeatedly and reports their run time: median, 90th and
+// 99th percentile, and operations per second, where a script declares how many operations one run makes with a
+// '# ops: <n>' first line. Only running is timed, every script is compiled once.
+// With --baseline, medians are compared to the ones stored in the file and the runner exits with 1 if any is
+// slower than its baseline by more than the tolerance. --write-baseline stores the medians of this run instead.
+// Baselines are only comparable on the machine and build type (Release) they were written with.
+// Usage: lynx_bench_runner [--runs <n>] [--warmup <n>] [--baseline <file>] [--tolerance <percent>]
+//                          [--write-baseline <file>] [<script.lnx>...]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "file.h"
+#include "interpreter.h"
+
+namespace {
+
+    struct Options {
+        std::size_t              runs{10};
+        std::size_t              warmup{2};
+        double                   tolerance{0.25};
+        std::string              baseline;
+        std::string              write_baseline;
+        std::vector<std::string> paths;
+    };
+
+    struct Result {
+        std::string name;
+        double      median_ms;
+        double      p90_ms;
+        double      p99_ms;
+        double      ops_per_second;
+    };
+
+    bool parse_options(int argc, char** argv, Options& options) {
+        for(int i = 1; i < argc; ++i) {
+            const std::string argument{argv[i]};
+            const bool has_value = i + 1 < argc;
+            if(argument == "--runs" && has_value) {
+                options.runs = std::max(1L, std::atol(argv[++i]));
+            } else if(argument == "--warmup" && has_value) {
+                options.warmup = std::max(0L, std::atol(argv[++i]));
+            } else if(argument == "--tolerance" && has_value) {
+                options.tolerance = std::atof(argv[++i]) / 100.0;
+            } else if(argument == "--baseline" && has_value) {
+                options.baseline = argv[++i];
+            } else if(argument == "--write-baseline" && has_value) {
+                options.write_baseline = argv[++i];
+            } else if(argument.rfind("--", 0) == 0) {
+                return false;
+            } else {
+                options.paths.push_back(argument);
+            }
+        }
+        if(options.paths.empty()) {
+            for(const auto& entry : std::filesystem::directory_iterator{LYNX_BENCH_SCRIPTS}) {
+                if(entry.path().extension() == ".lnx") {
+                    options.paths.push_back(entry.path().string());
+                }
+            }
+            std::sort(options.paths.begin(), options.paths.end());
+        }
+        return true;
+    }
+
+    // Value of the '# ops: <n>' line at the top of a script, or 1.
+    double operations(const std::string& code) {
+        const std::string prefix{"# ops:"};
+        if(code.rfind(prefix, 0) != 0) {
+            return 1;
+        }
+        return std::max(1.0, std::atof(code.c_str() + prefix.size()));
+    }
+
+    // Nearest-rank percentile of sorted times.
+    double percentile(const std::vector<double>& sorted, const double fraction) {
+        const auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+        return sorted[std::min(sorted.size(), std::max<std::size_t>(rank, 1)) - 1];
+    }
+
+    Result measure(const std::string& path, const Options& options) {
+        auto code = lynx::read_file(path);
+        if(!code.has_value()) {
+            std::cerr << "Can't read '" << path << "'\n";
+            std::exit(2);
+        }
+        const auto ops = operations(*code);
+        const auto compiled = lynx::Program::compile(path, std::move(*code));
+        if(compiled.program == nullptr) {
+            std::cerr << "Failed to compile '" << path << "'\n";
+            std::exit(2);
+        }
+        std::vector<double> times;
+        for(std::size_t run = 0; run < options.warmup + options.runs; ++run) {
+            std::string sink;
+            lynx::Output_Buffer output{sink};
+            lynx::Interpreter interpreter{output};
+            const auto start = std::chrono::steady_clock::now();
+            const auto result = interpreter.run(*compiled.program);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if(!result.ok()) {
+                std::cerr << path << ": " << result.error << '\n';
+                std::exit(2);
+            }
+            if(run >= options.warmup) {
+                times.push_back(elapsed.count());
+            }
+        }
+        std::sort(times.begin(), times.end());
+        const auto median = percentile(times, 0.5);
+        return Result{std::filesystem::path{path}.stem().string(), median, percentile(times, 0.9),
+                percentile(times, 0.99), ops / (median / 1000.0)};
+    }
+
+    // 'name median_ms' per line.
+    std::map<std::string, double> read_baseline(const std::string& path) {
+        std::map<std::string, double> medians;
+        std::ifstream file{path};
+        if(!file) {
+            std::cerr << "Can't read the baseline '" << path << "'\n";
+            std::exit(2);
+        }
+        std::string name;
+        double median;
+        while(file >> name >> median) {
+            medians[name] = median;
+        }
+        return medians;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if(!parse_options(argc, argv, options)) {
+        std::cerr << "Usage: lynx_bench_runner [--runs <n>] [--warmup <n>] [--baseline <file>] "
+                "[--tolerance <percent>] [--write-baseline <file>] [<script.lnx>...]\n";
+        return 2;
+    }
+    const auto baseline = options.baseline.empty() ? std::map<std::string, double>{} : read_baseline(options.baseline);
+    std::vector<Result> results;
+    bool regressed = false;
+    std::printf("%-20s %10s %10s %10s %14s %10s\n", "script", "median ms", "p90 ms", "p99 ms", "ops/s", "baseline");
+    for(const auto& path : options.paths) {
+        const auto result = measure(path, options);
+        std::string comparison{"-"};
+        if(const auto base = baseline.find(result.name); base != baseline.end()) {
+            const auto change = result.median_ms / base->second - 1.0;
+            char buffer[64];
+            std::snprintf(buffer, sizeof(buffer), "%+.1f%%", change * 100.0);
+            comparison = buffer;
+            if(change > options.tolerance) {
+                comparison += " REGRESSION";
+                regressed = true;
+            }
+        }
+        std::printf("%-20s %10.2f %10.2f %10.2f %14.0f %10s\n", result.name.c_str(), result.median_ms, result.p90_ms,
+                result.p99_ms, result.ops_per_second, comparison.c_str());
+        std::fflush(stdout);
+        results.push_back(result);
+    }
+    if(!options.write_baseline.empty()) {
+        std::ofstream file{options.write_baseline};
+        for(const auto& result : results) {
+            file << result.name << ' ' << result.median_ms << '\n';
+        }
+    }
+    if(regressed) {
+        std::printf("Slower than the baseline by more than %.0f%%.\n", options.tolerance * 100.0);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "array.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace lynx {
+
+    namespace {
+
+        Array::Elements make_elements(const Value::Type element_type, const std::size_t size) {
+            switch(element_type) {
+                case Value::Type::INTEGER:
+                    return Array::Integers(size);
+                case Value::Type::FLOAT:
+                    return Array::Floats(size);
+                case Value::Type::BOOL:
+                    return Array::Bools(size);
+                default:
+                    throw std::runtime_error{"Arrays can only hold 'int', 'float' or 'bool' values"};
+            }
+        }
+
+        std::size_t checked_index(const Array& array, const long long index) {
+            if(index < 0 || static_cast<unsigned long long>(index) >= array.size()) {
+                throw std::runtime_error{"Index " + std::to_string(index) + " is out of bounds of an array of size "
+                        + std::to_string(array.size())};
+            }
+            return static_cast<std::size_t>(index);
+        }
+
+        void check_element(const Array& array, const Value& value) {
+            if(value.type != array.element_type()) {
+                throw std::runtime_error{"Can't store this value in an array of type '" + type_name(array) + "'"};
+            }
+        }
+
+    }
+
+    Array::Array(const Value::Type element_type, const std::size_t size)
+            : elements{make_elements(element_type, size)} {
+    }
+
+    Array::Array(Elements&& elements)
+            : elements{std::move(elements)} {
+    }
+
+    std::size_t Array::max_size(const Value::Type element_type) noexcept {
+        switch(element_type) {
+            case Value::Type::FLOAT:
+                return Floats{}.max_size();
+            case Value::Type::BOOL:
+                return Bools{}.max_size();
+            default:
+                return Integers{}.max_size();
+        }
+    }
+
+    Value::Type Array::element_type() const noexcept {
+        if(std::holds_alternative<Integers>(elements)) {
+            return Value::Type::INTEGER;
+        }
+        if(std::holds_alternative<Floats>(elements)) {
+            return Value::Type::FLOAT;
+        }
+        return Value::Type::BOOL;
+    }
+
+    std::size_t Array::size() const noexcept {
+        return std::visit([](const auto& vector) { return vector.size(); }, elements);
+    }
+
+    Value Array::load(const long long index) const {
+        const auto i = checked_index(*this, index);
+        if(auto integers = std::get_if<Integers>(&elements); integers != nullptr) {
+            return Value{Value::Type::INTEGER, (*integers)[i]};
+        }
+        if(auto floats = std::get_if<Floats>(&elements); floats != nullptr) {
+            return Value{Value::Type::FLOAT, static_cast<long double>((*floats)[i])};
+        }
+        return Value{Value::Type::BOOL, std::get<Bools>(elements)[i] != 0};
+    }
+
+    void Array::store(const long long index, const Value& value) {
+        const auto i = checked_index(*this, index);
+        check_element(*this, value);
+        if(auto integers = std::get_if<Integers>(&elements); integers != nullptr) {
+            (*integers)[i] = small_integer(value);
+            return;
+        }
+        if(auto floats = std::get_if<Floats>(&elements); floats != nullptr) {
+            (*floats)[i] = static_cast<double>(std::get<long double>(value.data));
+            return;
+        }
+        std::get<Bools>(elements)[i] = std::get<bool>(value.data);
+    }
+
+    void Array::fill(const Value& value) {
+        check_element(*this, value);
+        if(auto integers = std::get_if<Integers>(&elements); integers != nullptr) {
+            std::fill(integers->begin(), integers->end(), small_integer(value));
+            return;
+        }
+        if(auto floats = std::get_if<Floats>(&elements); floats != nullptr) {
+            std::fill(floats->begin(), floats->end(), static_cast<double>(std::get<long double>(value.data)));
+            return;
+        }
+        auto& bools = std::get<Bools>(elements);
+        std::fill(bools.begin(), bools.end(), std::get<bool>(value.data));
+    }
+
+    std::string type_name(const Array& array) {
+        switch(array.element_type()) {
+            case Value::Type::INTEGER:
+                return "int[]";
+            case Value::Type::FLOAT:
+                return "float[]";
+            default:
+                return "bool[]";
+        }
+    }
+
+    Value::Type element_type(const std::string& type) {
+        if(type == "int[]") {
+            return Value::Type::INTEGER;
+        }
+        if(type == "float[]") {
+            return Value::Type::FLOAT;
+        }
+        if(type == "bool[]") {
+            return Value::Type::BOOL;
+        }
+        return Value::Type::VOID;
+    }
+
+}
@@ -0,0 +1,52 @@
+#ifndef LYNX_ARRAY_H
+#define LYNX_ARRAY_H
+
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "value.h"
+
+namespace lynx {
+
+    // Array keeps its elements unboxed in one contiguous vector of the element type's machine representation:
+    // 'int[]' as long long, 'float[]' as double and 'bool[]' as one byte per element. Floats are narrowed to
+    // double when stored, which halves their size and lets arithmetic on them use vector instructions.
+    // Arrays are values: Value shares an Array until one of its owners writes to it, which copies it first.
+    struct Array {
+        template<typename T>
+        using Vector = std::vector<T, Heap_Allocator<T>>;
+        using Integers = Vector<long long>;
+        using Floats = Vector<double>;
+        using Bools = Vector<std::uint8_t>;
+        using Elements = std::variant<Integers, Floats, Bools>;
+
+        // Empty array of the given element type, which has to be INTEGER, FLOAT or BOOL.
+        explicit Array(const Value::Type element_type, const std::size_t size = 0);
+        explicit Array(Elements&& elements);
+
+        Value::Type element_type() const noexcept;
+        std::size_t size() const noexcept;
+
+        // Most elements an array of the given element type can have.
+        static std::size_t max_size(const Value::Type element_type) noexcept;
+
+        // Both throw if the index is out of bounds; store() also if the value doesn't match the element type.
+        Value load(const long long index) const;
+        void store(const long long index, const Value& value);
+
+        void fill(const Value& value);
+
+        Elements elements;
+    };
+
+    // 'int[]', 'float[]' or 'bool[]'.
+    std::string type_name(const Array& array);
+
+    // Element type of an array type name, or VOID if 'type' isn't one.
+    Value::Type element_type(const std::string& type);
+
+}
+
+#endif //LYNX_ARRAY_H
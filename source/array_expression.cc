@@ -0,0 +1,525 @@
+#include "array_expression.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "big_integer.h"
+
+namespace lynx {
+
+    namespace {
+
+        // Elements computed per pass. A multiple of KERNEL_LANES, so that tiled reductions match whole-array ones.
+        constexpr std::size_t TILE = 1024;
+
+        bool is_comparison(const Token::Type operator_) noexcept {
+            switch(operator_) {
+                case Token::Type::EQUALS_EQUALS:
+                case Token::Type::BANG_EQUALS:
+                case Token::Type::LESS:
+                case Token::Type::LESS_EQUALS:
+                case Token::Type::GREATER:
+                case Token::Type::GREATER_EQUALS:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        Comparison to_comparison(const Token::Type operator_) noexcept {
+            switch(operator_) {
+                case Token::Type::EQUALS_EQUALS:
+                    return Comparison::EQUAL;
+                case Token::Type::BANG_EQUALS:
+                    return Comparison::NOT_EQUAL;
+                case Token::Type::LESS:
+                    return Comparison::LESS;
+                case Token::Type::LESS_EQUALS:
+                    return Comparison::LESS_EQUAL;
+                case Token::Type::GREATER:
+                    return Comparison::GREATER;
+                default:
+                    return Comparison::GREATER_EQUAL;
+            }
+        }
+
+        Arithmetic to_arithmetic(const Token::Type operator_) {
+            switch(operator_) {
+                case Token::Type::PLUS:
+                    return Arithmetic::ADD;
+                case Token::Type::MINUS:
+                    return Arithmetic::SUBTRACT;
+                case Token::Type::STAR:
+                    return Arithmetic::MULTIPLY;
+                case Token::Type::SLASH:
+                    return Arithmetic::DIVIDE;
+                default:
+                    throw std::runtime_error{"Unsupported operator on arrays"};
+            }
+        }
+
+        // Overloads picking the kernel of an element type.
+        void arithmetic(const Kernels& k, Arithmetic operation, const double* a, const double* b, double* out,
+                std::size_t n) {
+            k.arithmetic_f64(operation, a, b, out, n);
+        }
+
+        void arithmetic(const Kernels& k, Arithmetic operation, const long long* a, const long long* b,
+                long long* out, std::size_t n) {
+            k.arithmetic_i64(operation, a, b, out, n);
+        }
+
+        void arithmetic_scalar(const Kernels& k, Arithmetic operation, const double* a, double b, bool reversed,
+                double* out, std::size_t n) {
+            k.arithmetic_scalar_f64(operation, a, b, reversed, out, n);
+        }
+
+        void arithmetic_scalar(const Kernels& k, Arithmetic operation, const long long* a, long long b,
+                bool reversed, long long* out, std::size_t n) {
+            k.arithmetic_scalar_i64(operation, a, b, reversed, out, n);
+        }
+
+        void compare(const Kernels& k, Comparison comparison, const double* a, const double* b, std::uint8_t* out,
+                std::size_t n) {
+            k.compare_f64(comparison, a, b, out, n);
+        }
+
+        void compare(const Kernels& k, Comparison comparison, const long long* a, const long long* b,
+                std::uint8_t* out, std::size_t n) {
+            k.compare_i64(comparison, a, b, out, n);
+        }
+
+        void compare_scalar(const Kernels& k, Comparison comparison, const double* a, double b, std::uint8_t* out,
+                std::size_t n) {
+            k.compare_scalar_f64(comparison, a, b, out, n);
+        }
+
+        void compare_scalar(const Kernels& k, Comparison comparison, const long long* a, long long b,
+                std::uint8_t* out, std::size_t n) {
+            k.compare_scalar_i64(comparison, a, b, out, n);
+        }
+
+        // Reductions return false if an integer sum may have overflowed.
+        bool reduce_kernel(const Kernels& k, Array_Expression::Reduction reduction, const double* a, std::size_t n,
+                double* lanes) {
+            switch(reduction) {
+                case Array_Expression::Reduction::SUM:
+                    k.sum_f64(a, n, lanes);
+                    break;
+                case Array_Expression::Reduction::MIN:
+                    k.min_f64(a, n, lanes);
+                    break;
+                case Array_Expression::Reduction::MAX:
+                    k.max_f64(a, n, lanes);
+                    break;
+            }
+            return true;
+        }
+
+        bool reduce_kernel(const Kernels& k, Array_Expression::Reduction reduction, const long long* a,
+                std::size_t n, long long* lanes) {
+            switch(reduction) {
+                case Array_Expression::Reduction::SUM:
+                    return k.sum_i64(a, n, lanes);
+                case Array_Expression::Reduction::MIN:
+                    k.min_i64(a, n, lanes);
+                    break;
+                case Array_Expression::Reduction::MAX:
+                    k.max_i64(a, n, lanes);
+                    break;
+            }
+            return true;
+        }
+
+        bool dot_kernel(const Kernels& k, const double* a, const double* b, std::size_t n, double* lanes) {
+            k.dot_f64(a, b, n, lanes);
+            return true;
+        }
+
+        bool dot_kernel(const Kernels& k, const long long* a, const long long* b, std::size_t n, long long* lanes) {
+            return k.dot_i64(a, b, n, lanes);
+        }
+
+        // Value every lane of a reduction starts with.
+        template<typename T>
+        T identity(const Array_Expression::Reduction reduction) noexcept {
+            switch(reduction) {
+                case Array_Expression::Reduction::MIN:
+                    return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+                            : std::numeric_limits<T>::max();
+                case Array_Expression::Reduction::MAX:
+                    return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity()
+                            : std::numeric_limits<T>::lowest();
+                default:
+                    return T{};
+            }
+        }
+
+        // Total of integers of any size, kept in a 'long long' until it doesn't fit in one any more.
+        class Exact_Sum {
+        public:
+            void add(const long long term) {
+                if(long long total{}; !__builtin_add_overflow(_small, term, &total)) {
+                    _small = total;
+                    return;
+                }
+                _big = (_big ? *_big : Big_Integer{0}) + Big_Integer{_small} + Big_Integer{term};
+                _small = 0;
+            }
+
+            void add_product(const long long a, const long long b) {
+                long long product;
+                if(__builtin_mul_overflow(a, b, &product)) {
+                    _big = (_big ? *_big : Big_Integer{0}) + Big_Integer{a} * Big_Integer{b};
+                    return;
+                }
+                add(product);
+            }
+
+            Value value() const {
+                if(!_big) {
+                    return Value{Value::Type::INTEGER, _small};
+                }
+                return make_integer(*_big + Big_Integer{_small});
+            }
+
+        private:
+            long long                  _small{};
+            std::optional<Big_Integer> _big;
+        };
+
+        Value to_value(const long long value) {
+            return Value{Value::Type::INTEGER, value};
+        }
+
+        Value to_value(const double value) {
+            return Value{Value::Type::FLOAT, static_cast<long double>(value)};
+        }
+
+        const char* name(const Array_Expression::Reduction reduction) noexcept {
+            switch(reduction) {
+                case Array_Expression::Reduction::MIN:
+                    return "min";
+                case Array_Expression::Reduction::MAX:
+                    return "max";
+                default:
+                    return "sum";
+            }
+        }
+
+    }
+
+    Array_Expression::Node Array_Expression::leaf(Value value) {
+        auto kind = Entry::Kind::SCALAR;
+        auto type = value.type;
+        std::size_t length = 0;
+        if(value.type == Value::Type::ARRAY) {
+            const auto& array = *std::get<std::shared_ptr<Array>>(value.data);
+            kind = Entry::Kind::ARRAY;
+            type = array.element_type();
+            length = array.size();
+        }
+        _entries.emplace_back(kind, type, length, std::move(value));
+        return _entries.size() - 1;
+    }
+
+    Array_Expression::Node Array_Expression::operation(const Token::Type operator_, const Node left,
+            const Node right) {
+        const auto& l = _entries[left];
+        const auto& r = _entries[right];
+        if(l.type != r.type) {
+            throw std::runtime_error{"Incompatible operands in binary operation"};
+        }
+        if(l.type != Value::Type::INTEGER && l.type != Value::Type::FLOAT) {
+            throw std::runtime_error{"Element-wise operations need 'int' or 'float' elements"};
+        }
+        const auto l_array = l.kind != Entry::Kind::SCALAR;
+        const auto r_array = r.kind != Entry::Kind::SCALAR;
+        if(!l_array && !r_array) {
+            throw std::logic_error{"Should never reach this point."};
+        }
+        if(l_array && r_array && l.length != r.length) {
+            throw std::runtime_error{"Arrays of different sizes (" + std::to_string(l.length) + " and "
+                    + std::to_string(r.length) + ") in an element-wise operation"};
+        }
+        const auto length = l_array ? l.length : r.length;
+        const auto comparison = is_comparison(operator_);
+        const auto type = comparison ? Value::Type::BOOL : l.type;
+        _entries.emplace_back(comparison ? Entry::Kind::COMPARISON : Entry::Kind::ARITHMETIC, type, length,
+                comparison ? Arithmetic{} : to_arithmetic(operator_), to_comparison(operator_), left, right);
+        return _entries.size() - 1;
+    }
+
+    void Array_Expression::truncate(const std::size_t size) noexcept {
+        if(size < _entries.size()) {
+            _entries.erase(_entries.begin() + static_cast<std::ptrdiff_t>(size), _entries.end());
+        }
+    }
+
+    Value Array_Expression::evaluate(const Node root) {
+        const auto& entry = _entries[root];
+        if(entry.kind == Entry::Kind::ARRAY || entry.kind == Entry::Kind::SCALAR) {
+            return entry.value;
+        }
+        const auto length = entry.length;
+        const auto operand_type = _entries[entry.left].type;
+        std::shared_ptr<Array> result;
+        if(entry.kind == Entry::Kind::COMPARISON) {
+            result = make_managed<Array>(Value::Type::BOOL, length);
+            auto& out = std::get<Array::Bools>(result->elements);
+            if(operand_type == Value::Type::FLOAT) {
+                allocate_scratch<double>(root, false);
+                for(std::size_t begin = 0; begin < length; begin += TILE) {
+                    compare<double>(_entries[root], begin, std::min(TILE, length - begin), out.data() + begin);
+                }
+            } else {
+                allocate_scratch<long long>(root, false);
+                for(std::size_t begin = 0; begin < length; begin += TILE) {
+                    compare<long long>(_entries[root], begin, std::min(TILE, length - begin), out.data() + begin);
+                }
+            }
+        } else if(entry.type == Value::Type::FLOAT) {
+            result = make_managed<Array>(Value::Type::FLOAT, length);
+            auto& out = std::get<Array::Floats>(result->elements);
+            allocate_scratch<double>(root, false);
+            for(std::size_t begin = 0; begin < length; begin += TILE) {
+                compute<double>(root, begin, std::min(TILE, length - begin), out.data() + begin);
+            }
+        } else {
+            result = make_managed<Array>(Value::Type::INTEGER, length);
+            auto& out = std::get<Array::Integers>(result->elements);
+            allocate_scratch<long long>(root, false);
+            for(std::size_t begin = 0; begin < length; begin += TILE) {
+                compute<long long>(root, begin, std::min(TILE, length - begin), out.data() + begin);
+            }
+        }
+        return Value{Value::Type::ARRAY, std::move(result)};
+    }
+
+    Value Array_Expression::reduce(const Node root, const Reduction reduction) {
+        const auto& entry = _entries[root];
+        if(entry.kind == Entry::Kind::SCALAR) {
+            throw std::runtime_error{std::string{"'"} + name(reduction) + "' expects an array"};
+        }
+        if(entry.length == 0 && reduction != Reduction::SUM) {
+            throw std::runtime_error{std::string{"'"} + name(reduction) + "' of an empty array"};
+        }
+        switch(entry.type) {
+            case Value::Type::INTEGER:
+                return reduce<long long>(root, reduction);
+            case Value::Type::FLOAT:
+                return reduce<double>(root, reduction);
+            default:
+                break;
+        }
+        if(reduction != Reduction::SUM) {
+            throw std::runtime_error{std::string{"'"} + name(reduction) + "' expects an 'int[]' or 'float[]' array"};
+        }
+        // The sum of a 'bool[]' counts its true elements.
+        long long count = 0;
+        if(entry.kind == Entry::Kind::ARRAY) {
+            const auto& bools = std::get<Array::Bools>(std::get<std::shared_ptr<Array>>(entry.value.data)->elements);
+            count = std::count_if(bools.begin(), bools.end(), [](const std::uint8_t b) { return b != 0; });
+            return to_value(count);
+        }
+        std::uint8_t mask[TILE];
+        const auto length = entry.length;
+        const auto floats = _entries[entry.left].type == Value::Type::FLOAT;
+        if(floats) {
+            allocate_scratch<double>(root, false);
+        } else {
+            allocate_scratch<long long>(root, false);
+        }
+        for(std::size_t begin = 0; begin < length; begin += TILE) {
+            const auto n = std::min(TILE, length - begin);
+            if(floats) {
+                compare<double>(_entries[root], begin, n, mask);
+            } else {
+                compare<long long>(_entries[root], begin, n, mask);
+            }
+            count += std::count_if(mask, mask + n, [](const std::uint8_t b) { return b != 0; });
+        }
+        return to_value(count);
+    }
+
+    template<typename T>
+    Value Array_Expression::reduce(const Node root, const Reduction reduction) {
+        const auto& k = kernels();
+        T lanes[KERNEL_LANES];
+        std::fill(lanes, lanes + KERNEL_LANES, identity<T>(reduction));
+        const auto& entry = _entries[root];
+        const auto length = entry.length;
+        auto fits = true;
+        if(entry.kind == Entry::Kind::ARRAY) {
+            fits = reduce_kernel(k, reduction, elements<T>(root, 0, length), length, lanes);
+        } else if(reduction == Reduction::SUM && is_product_of_arrays(entry)) {
+            // sum(a * b) of two arrays doesn't need the products at all.
+            fits = dot_kernel(k, elements<T>(entry.left, 0, length), elements<T>(entry.right, 0, length), length,
+                    lanes);
+        } else {
+            allocate_scratch<T>(root, true);
+            const auto tile = scratch<T>(_entries[root].scratch);
+            for(std::size_t begin = 0; begin < length && fits; begin += TILE) {
+                const auto n = std::min(TILE, length - begin);
+                compute<T>(root, begin, n, tile);
+                fits = reduce_kernel(k, reduction, tile, n, lanes);
+            }
+        }
+        switch(reduction) {
+            case Reduction::MIN:
+                return to_value(min_lanes(lanes));
+            case Reduction::MAX:
+                return to_value(max_lanes(lanes));
+            case Reduction::SUM:
+                break;
+        }
+        if constexpr(std::is_integral_v<T>) {
+            // A sum that doesn't fit is an arbitrary-precision 'int', like any other.
+            if(long long sum{}; fits && sum_lanes(lanes, sum)) {
+                return to_value(sum);
+            }
+            return exact_sum(root);
+        } else {
+            return to_value(sum_lanes(lanes));
+        }
+    }
+
+    bool Array_Expression::is_product_of_arrays(const Entry& entry) const noexcept {
+        return entry.kind == Entry::Kind::ARITHMETIC && entry.arithmetic == Arithmetic::MULTIPLY
+                && _entries[entry.left].kind == Entry::Kind::ARRAY && _entries[entry.right].kind == Entry::Kind::ARRAY;
+    }
+
+    Value Array_Expression::exact_sum(const Node root) {
+        const auto& entry = _entries[root];
+        const auto length = entry.length;
+        Exact_Sum sum;
+        if(entry.kind == Entry::Kind::ARRAY) {
+            const auto a = elements<long long>(root, 0, length);
+            for(std::size_t i = 0; i < length; ++i) {
+                sum.add(a[i]);
+            }
+        } else if(is_product_of_arrays(entry)) {
+            const auto a = elements<long long>(entry.left, 0, length);
+            const auto b = elements<long long>(entry.right, 0, length);
+            for(std::size_t i = 0; i < length; ++i) {
+                sum.add_product(a[i], b[i]);
+            }
+        } else {
+            const auto tile = scratch<long long>(_entries[root].scratch);
+            for(std::size_t begin = 0; begin < length; begin += TILE) {
+                const auto n = std::min(TILE, length - begin);
+                compute<long long>(root, begin, n, tile);
+                for(std::size_t i = 0; i < n; ++i) {
+                    sum.add(tile[i]);
+                }
+            }
+        }
+        return sum.value();
+    }
+
+    template<typename T>
+    void Array_Expression::compute(const Node node, const std::size_t begin, const std::size_t length, T* out) {
+        const auto& k = kernels();
+        const auto& entry = _entries[node];
+        const auto left_scalar = _entries[entry.left].kind == Entry::Kind::SCALAR;
+        const auto right_scalar = _entries[entry.right].kind == Entry::Kind::SCALAR;
+        if(left_scalar) {
+            arithmetic_scalar(k, entry.arithmetic, elements<T>(entry.right, begin, length), scalar<T>(entry.left),
+                    true, out, length);
+        } else if(right_scalar) {
+            arithmetic_scalar(k, entry.arithmetic, elements<T>(entry.left, begin, length), scalar<T>(entry.right),
+                    false, out, length);
+        } else {
+            const auto a = elements<T>(entry.left, begin, length);
+            const auto b = elements<T>(entry.right, begin, length);
+            arithmetic(k, entry.arithmetic, a, b, out, length);
+        }
+    }
+
+    template<typename T>
+    void Array_Expression::compare(const Entry& entry, const std::size_t begin, const std::size_t length,
+            std::uint8_t* out) {
+        const auto& k = kernels();
+        if(_entries[entry.left].kind == Entry::Kind::SCALAR) {
+            compare_scalar(k, swapped(entry.comparison), elements<T>(entry.right, begin, length),
+                    scalar<T>(entry.left), out, length);
+        } else if(_entries[entry.right].kind == Entry::Kind::SCALAR) {
+            compare_scalar(k, entry.comparison, elements<T>(entry.left, begin, length), scalar<T>(entry.right), out,
+                    length);
+        } else {
+            const auto a = elements<T>(entry.left, begin, length);
+            const auto b = elements<T>(entry.right, begin, length);
+            lynx::compare(k, entry.comparison, a, b, out, length);
+        }
+    }
+
+    template<typename T>
+    const T* Array_Expression::elements(const Node node, const std::size_t begin, const std::size_t length) {
+        const auto& entry = _entries[node];
+        if(entry.kind == Entry::Kind::ARRAY) {
+            const auto& array = *std::get<std::shared_ptr<Array>>(entry.value.data);
+            return std::get<Array::Vector<T>>(array.elements).data() + begin;
+        }
+        const auto tile = scratch<T>(entry.scratch);
+        compute<T>(node, begin, length, tile);
+        return tile;
+    }
+
+    template<typename T>
+    T Array_Expression::scalar(const Node node) const {
+        const auto& value = _entries[node].value;
+        if constexpr(std::is_same_v<T, double>) {
+            return static_cast<double>(std::get<long double>(value.data));
+        } else {
+            return small_integer(value);
+        }
+    }
+
+    template<typename T>
+    void Array_Expression::allocate_scratch(const Node node, const bool including_node) {
+        auto tiles = assign_scratch(node, 0);
+        if(including_node) {
+            _entries[node].scratch = tiles++ * TILE;
+        }
+        auto& buffer = [this]() -> std::vector<T>& {
+            if constexpr(std::is_same_v<T, double>) {
+                return _float_scratch;
+            } else {
+                return _integer_scratch;
+            }
+        }();
+        if(buffer.size() < tiles * TILE) {
+            buffer.resize(tiles * TILE);
+        }
+    }
+
+    std::size_t Array_Expression::assign_scratch(const Node node, std::size_t tiles) {
+        auto& entry = _entries[node];
+        if(entry.kind != Entry::Kind::ARITHMETIC && entry.kind != Entry::Kind::COMPARISON) {
+            return tiles;
+        }
+        for(const auto child : {entry.left, entry.right}) {
+            auto& operand = _entries[child];
+            if(operand.kind == Entry::Kind::ARITHMETIC) {
+                operand.scratch = tiles++ * TILE;
+                tiles = assign_scratch(child, tiles);
+            }
+        }
+        return tiles;
+    }
+
+    template<typename T>
+    T* Array_Expression::scratch(const std::size_t offset) noexcept {
+        if constexpr(std::is_same_v<T, double>) {
+            return _float_scratch.data() + offset;
+        } else {
+            return _integer_scratch.data() + offset;
+        }
+    }
+
+}
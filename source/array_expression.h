@@ -0,0 +1,100 @@
+#ifndef LYNX_ARRAY_EXPRESSION_H
+#define LYNX_ARRAY_EXPRESSION_H
+
+#include <cstdint>
+#include <vector>
+
+#include "array.h"
+#include "kernels.h"
+#include "token.h"
+
+namespace lynx {
+
+    // Array_Expression records element-wise operations on arrays while their operands are being evaluated, and
+    // computes them afterwards in one pass over tiles of a few thousand elements. Intermediate results only ever
+    // occupy a tile-sized buffer, so 'a * 2.0 + b' allocates nothing but its result, and 'sum(a * b)' not even that.
+    // Nodes form a stack: an expression evaluated while another one is being recorded pushes its nodes on top and
+    // truncates them once it is done.
+    class Array_Expression {
+    public:
+        using Node = std::size_t;
+
+        enum class Reduction {
+            SUM, MIN, MAX
+        };
+
+        // Either operand may be a scalar, but not both. Throws if the operands don't fit together.
+        Node leaf(Value value);
+        Node operation(const Token::Type operator_, const Node left, const Node right);
+
+        std::size_t size() const noexcept {
+            return _entries.size();
+        }
+        void truncate(const std::size_t size) noexcept;
+
+        Value evaluate(const Node root);
+        Value reduce(const Node root, const Reduction reduction);
+
+    private:
+        struct Entry {
+            enum class Kind {
+                ARRAY, SCALAR, ARITHMETIC, COMPARISON
+            };
+
+            // A leaf.
+            Entry(const Kind kind, const Value::Type type, const std::size_t length, Value&& value)
+                    : kind{kind}, type{type}, length{length}, value{std::move(value)} {
+            }
+
+            // An operation.
+            Entry(const Kind kind, const Value::Type type, const std::size_t length, const Arithmetic arithmetic,
+                    const Comparison comparison, const Node left, const Node right)
+                    : kind{kind}, type{type}, length{length}, value{Value::Type::VOID, std::monostate{}},
+                      arithmetic{arithmetic}, comparison{comparison}, left{left}, right{right} {
+            }
+
+            Kind        kind;
+            // Element type of the result, BOOL for comparisons.
+            Value::Type type;
+            std::size_t length;
+            Value       value;
+            Arithmetic  arithmetic{};
+            Comparison  comparison{};
+            Node        left{};
+            Node        right{};
+            // Offset of the node's tile in _scratch.
+            std::size_t scratch{};
+        };
+
+        template<typename T>
+        void compute(const Node node, const std::size_t begin, const std::size_t length, T* out);
+        template<typename T>
+        void compare(const Entry& entry, const std::size_t begin, const std::size_t length, std::uint8_t* out);
+        // Pointer to the elements [begin, begin + length) of a node, computing them into its tile if needed.
+        template<typename T>
+        const T* elements(const Node node, const std::size_t begin, const std::size_t length);
+        template<typename T>
+        T scalar(const Node node) const;
+
+        template<typename T>
+        Value reduce(const Node root, const Reduction reduction);
+        // Whether 'entry' multiplies two arrays, so that its sum is a dot product.
+        bool is_product_of_arrays(const Entry& entry) const noexcept;
+        // Sum of an 'int[]' node computed again, exactly, after the kernels reported a possible overflow.
+        Value exact_sum(const Node root);
+
+        // Gives every operation below 'node', and 'node' itself if asked to, a tile of scratch space.
+        template<typename T>
+        void allocate_scratch(const Node node, const bool including_node);
+        std::size_t assign_scratch(const Node node, std::size_t tiles);
+        template<typename T>
+        T* scratch(const std::size_t offset) noexcept;
+
+        std::vector<Entry>     _entries;
+        std::vector<double>    _float_scratch;
+        std::vector<long long> _integer_scratch;
+    };
+
+}
+
+#endif //LYNX_ARRAY_EXPRESSION_H
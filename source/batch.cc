@@ -0,0 +1,124 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+
+#include "file.h"
+#include "interpreter.h"
+#include "thread_pool.h"
+
+namespace lynx {
+
+    namespace {
+
+        struct Script_Result {
+            std::string output;
+            std::string errors;
+            bool        finished = false;
+        };
+
+        // Everything a worker thread needs to run a script, created once per thread instead of once per script.
+        struct Worker_Context {
+            std::string   captured;
+            Output_Buffer output{captured, 64 * 1024};
+            Interpreter   interpreter{output};
+        };
+
+        void run_script(const std::string& path, const Batch_Options& options, Script_Result& result) {
+            thread_local Worker_Context context;
+            auto code = read_file(path);
+            if(!code.has_value()) {
+                result.errors = path + ": Error: File not found.\n";
+                return;
+            }
+            const auto compiled = Program::compile(path, std::move(*code), nullptr, options.bodies);
+            if(compiled.program == nullptr) {
+                for(const auto& diagnostic : compiled.diagnostics) {
+                    result.errors += path + ": " + to_string(diagnostic) + '\n';
+                }
+                return;
+            }
+            context.interpreter.set_limits(options.limits);
+            const auto run_result = context.interpreter.run(*compiled.program);
+            context.output.flush();
+            result.output = std::move(context.captured);
+            context.captured.clear();
+            if(!run_result.ok()) {
+                result.errors = path + ": Error: " + run_result.error + ".\n";
+            }
+        }
+
+    }
+
+    Batch_Summary run_batch(const std::vector<std::string>& paths, const Batch_Options& options,
+            Output_Buffer& output, Output_Buffer& errors) {
+        const auto start = std::chrono::steady_clock::now();
+        Batch_Summary summary;
+        summary.scripts = paths.size();
+        std::vector<Script_Result> results(paths.size());
+        std::mutex  mutex;
+        std::size_t next_to_print = 0;
+        std::vector<std::thread::id> threads;
+
+        const auto print = [&](Script_Result& result) {
+            output << result.output;
+            errors << result.errors;
+            summary.output_bytes += result.output.size();
+            if(!result.errors.empty()) {
+                ++summary.failed;
+            }
+            result.output = std::string{};
+            result.errors = std::string{};
+        };
+
+        Thread_Pool pool{options.jobs};
+        Task_Group  group;
+        for(std::size_t i = 0; i < paths.size(); ++i) {
+            pool.submit(group, [&, i] {
+                run_script(paths[i], options, results[i]);
+                std::lock_guard<std::mutex> lock{mutex};
+                if(std::find(threads.begin(), threads.end(), std::this_thread::get_id()) == threads.end()) {
+                    threads.push_back(std::this_thread::get_id());
+                }
+                results[i].finished = true;
+                if(options.streamed) {
+                    print(results[i]);
+                    return;
+                }
+                while(next_to_print < results.size() && results[next_to_print].finished) {
+                    print(results[next_to_print++]);
+                }
+            });
+        }
+        pool.wait(group);
+        summary.threads = threads.size();
+        summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return summary;
+    }
+
+    std::vector<std::string> read_manifest(const std::string& content) {
+        std::vector<std::string> paths;
+        std::istringstream stream{content};
+        std::string line;
+        while(std::getline(stream, line)) {
+            const auto begin = line.find_first_not_of(" \t\r");
+            if(begin == std::string::npos || line[begin] == '#') {
+                continue;
+            }
+            const auto end = line.find_last_not_of(" \t\r");
+            paths.push_back(line.substr(begin, end - begin + 1));
+        }
+        return paths;
+    }
+
+    void print_summary(const Batch_Summary& summary, Output_Buffer& output) {
+        const auto seconds = summary.seconds > 0.0 ? summary.seconds : 1e-9;
+        output << "Ran " << summary.scripts << " scripts (" << summary.failed << " failed) on " << summary.threads
+                << " threads in " << static_cast<long long>(summary.seconds * 1000.0) << " ms: "
+                << static_cast<long long>(static_cast<double>(summary.scripts) / seconds) << " scripts/s, "
+                << summary.output_bytes << " bytes of output.\n";
+    }
+
+}
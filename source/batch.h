@@ -0,0 +1,45 @@
+#ifndef LYNX_BATCH_H
+#define LYNX_BATCH_H
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "interpreter.h"
+#include "output.h"
+#include "program.h"
+
+namespace lynx {
+
+    struct Batch_Options {
+        std::size_t      jobs = std::thread::hardware_concurrency();
+        // Print every script's output as soon as it finishes, instead of in the order the scripts were given.
+        bool             streamed = false;
+        Body_Compilation bodies = Body_Compilation::EAGER;
+        // Of every script on its own. A script that goes over one of them fails.
+        Limits           limits;
+    };
+
+    struct Batch_Summary {
+        std::size_t scripts{};
+        std::size_t failed{};
+        // Threads that ran at least one script. The caller counts too, since it runs scripts while it waits.
+        std::size_t threads{};
+        std::size_t output_bytes{};
+        double      seconds{};
+    };
+
+    // Runs many independent scripts inside a single process, on a work-stealing Thread_Pool with one reusable
+    // Interpreter per worker thread. Output of each script is captured and written to 'output' in one piece, so
+    // scripts never interleave; errors go to 'errors' prefixed with the script's path.
+    Batch_Summary run_batch(const std::vector<std::string>& paths, const Batch_Options& options,
+            Output_Buffer& output, Output_Buffer& errors);
+
+    // Paths listed one per line; blank lines and lines starting with '#' are skipped.
+    std::vector<std::string> read_manifest(const std::string& content);
+
+    void print_summary(const Batch_Summary& summary, Output_Buffer& output);
+
+}
+
+#endif //LYNX_BATCH_H
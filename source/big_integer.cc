@@ -0,0 +1,389 @@
+#include "big_integer.h"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+namespace lynx {
+
+    namespace {
+
+        using Limb = Big_Integer::Limb;
+        using Limbs = Big_Integer::Limbs;
+        using Wide = std::uint64_t;
+
+        constexpr Wide BASE = Wide{1} << 32;
+        // Below this many limbs in the shorter operand, the schoolbook product is faster than splitting.
+        constexpr std::size_t KARATSUBA_THRESHOLD = 32;
+        // Largest power of ten in a limb, so that decimal conversions go nine digits at a time.
+        constexpr Limb DECIMAL_BASE = 1000000000;
+        constexpr std::size_t DECIMAL_DIGITS = 9;
+
+        void trim(Limbs& limbs) noexcept {
+            while(!limbs.empty() && limbs.back() == 0) {
+                limbs.pop_back();
+            }
+        }
+
+        int compare_magnitudes(const Limbs& left, const Limbs& right) noexcept {
+            if(left.size() != right.size()) {
+                return left.size() < right.size() ? -1 : 1;
+            }
+            for(auto i = left.size(); i-- > 0;) {
+                if(left[i] != right[i]) {
+                    return left[i] < right[i] ? -1 : 1;
+                }
+            }
+            return 0;
+        }
+
+        Limbs add_magnitudes(const Limb* left, const std::size_t left_size, const Limb* right,
+                const std::size_t right_size) {
+            if(left_size < right_size) {
+                return add_magnitudes(right, right_size, left, left_size);
+            }
+            Limbs sum(left_size + 1);
+            Wide carry = 0;
+            for(std::size_t i = 0; i < left_size; ++i) {
+                carry += Wide{left[i]} + (i < right_size ? right[i] : 0);
+                sum[i] = static_cast<Limb>(carry);
+                carry >>= 32;
+            }
+            sum[left_size] = static_cast<Limb>(carry);
+            trim(sum);
+            return sum;
+        }
+
+        // Adds 'addend' to 'sum' from limb 'shift' on. The result has to fit in 'sum'.
+        void add_at(Limbs& sum, const Limbs& addend, const std::size_t shift) noexcept {
+            Wide carry = 0;
+            auto i = shift;
+            for(const auto limb : addend) {
+                carry += Wide{sum[i]} + limb;
+                sum[i++] = static_cast<Limb>(carry);
+                carry >>= 32;
+            }
+            for(; carry != 0; ++i) {
+                carry += sum[i];
+                sum[i] = static_cast<Limb>(carry);
+                carry >>= 32;
+            }
+        }
+
+        // Subtracts 'subtrahend' from 'difference', which can't be smaller.
+        void subtract_in_place(Limbs& difference, const Limbs& subtrahend) noexcept {
+            Wide borrow = 0;
+            std::size_t i = 0;
+            for(; i < subtrahend.size(); ++i) {
+                const auto limb = Wide{difference[i]} - subtrahend[i] - borrow;
+                difference[i] = static_cast<Limb>(limb);
+                borrow = (limb >> 32) & 1;
+            }
+            for(; borrow != 0; ++i) {
+                const auto limb = Wide{difference[i]} - borrow;
+                difference[i] = static_cast<Limb>(limb);
+                borrow = (limb >> 32) & 1;
+            }
+            trim(difference);
+        }
+
+        Limbs schoolbook_product(const Limb* left, const std::size_t left_size, const Limb* right,
+                const std::size_t right_size) {
+            Limbs product(left_size + right_size);
+            for(std::size_t i = 0; i < left_size; ++i) {
+                Wide carry = 0;
+                for(std::size_t j = 0; j < right_size; ++j) {
+                    // (2^32 - 1)^2 + 2 * (2^32 - 1) still fits in 64 bits.
+                    carry += Wide{left[i]} * right[j] + product[i + j];
+                    product[i + j] = static_cast<Limb>(carry);
+                    carry >>= 32;
+                }
+                product[i + right_size] = static_cast<Limb>(carry);
+            }
+            trim(product);
+            return product;
+        }
+
+        // Karatsuba: with both operands split at 'half' limbs, left * right is
+        // high * B^(2 half) + ((left_low + left_high) * (right_low + right_high) - low - high) * B^half + low,
+        // three half-size products instead of four.
+        Limbs product(const Limb* left, std::size_t left_size, const Limb* right, std::size_t right_size) {
+            if(left_size < right_size) {
+                std::swap(left, right);
+                std::swap(left_size, right_size);
+            }
+            if(right_size < KARATSUBA_THRESHOLD) {
+                return schoolbook_product(left, left_size, right, right_size);
+            }
+            const auto half = left_size / 2;
+            Limbs result(left_size + right_size);
+            if(right_size <= half) {
+                // Too short to split, multiply it with both halves of the longer operand instead.
+                add_at(result, product(left, half, right, right_size), 0);
+                add_at(result, product(left + half, left_size - half, right, right_size), half);
+                trim(result);
+                return result;
+            }
+            const auto low = product(left, half, right, half);
+            const auto high = product(left + half, left_size - half, right + half, right_size - half);
+            const auto left_sum = add_magnitudes(left, half, left + half, left_size - half);
+            const auto right_sum = add_magnitudes(right, half, right + half, right_size - half);
+            auto middle = product(left_sum.data(), left_sum.size(), right_sum.data(), right_sum.size());
+            subtract_in_place(middle, low);
+            subtract_in_place(middle, high);
+            add_at(result, low, 0);
+            add_at(result, middle, half);
+            add_at(result, high, 2 * half);
+            trim(result);
+            return result;
+        }
+
+        // Divides 'limbs' by 'divisor' in place and returns the remainder.
+        Limb divide_in_place(Limbs& limbs, const Limb divisor) noexcept {
+            Wide remainder = 0;
+            for(auto i = limbs.size(); i-- > 0;) {
+                const auto current = (remainder << 32) | limbs[i];
+                limbs[i] = static_cast<Limb>(current / divisor);
+                remainder = current % divisor;
+            }
+            trim(limbs);
+            return static_cast<Limb>(remainder);
+        }
+
+        // Quotient of two magnitudes by Knuth's algorithm D (TAOCP 4.3.1). 'divisor' has at least two limbs and
+        // 'dividend' isn't smaller.
+        Limbs divide_magnitudes(const Limbs& dividend, const Limbs& divisor) {
+            const auto n = divisor.size();
+            const auto m = dividend.size() - n;
+            // Normalizing makes the top limb of the divisor have its high bit set, which keeps every estimate of
+            // a quotient limb at most two too large.
+            const auto shift = static_cast<unsigned>(__builtin_clz(divisor.back()));
+            const auto shifted = [shift](const Limb high, const Limb low) {
+                return static_cast<Limb>((Wide{high} << shift) | (Wide{low} >> (32 - shift)));
+            };
+            Limbs v(n);
+            for(auto i = n - 1; i > 0; --i) {
+                v[i] = shifted(divisor[i], divisor[i - 1]);
+            }
+            v[0] = static_cast<Limb>(Wide{divisor[0]} << shift);
+            Limbs u(m + n + 1);
+            u[m + n] = shifted(0, dividend[m + n - 1]);
+            for(auto i = m + n - 1; i > 0; --i) {
+                u[i] = shifted(dividend[i], dividend[i - 1]);
+            }
+            u[0] = static_cast<Limb>(Wide{dividend[0]} << shift);
+
+            Limbs quotient(m + 1);
+            for(auto j = m + 1; j-- > 0;) {
+                const auto numerator = (Wide{u[j + n]} << 32) | u[j + n - 1];
+                auto estimate = numerator / v[n - 1];
+                auto remainder = numerator % v[n - 1];
+                while(estimate >= BASE || estimate * v[n - 2] > ((remainder << 32) | u[j + n - 2])) {
+                    --estimate;
+                    remainder += v[n - 1];
+                    if(remainder >= BASE) {
+                        break;
+                    }
+                }
+                // u[j .. j + n] -= estimate * v.
+                std::int64_t borrow = 0;
+                std::int64_t difference = 0;
+                for(std::size_t i = 0; i < n; ++i) {
+                    const auto product = estimate * v[i];
+                    difference = static_cast<std::int64_t>(u[i + j]) - borrow
+                            - static_cast<std::int64_t>(product & 0xFFFFFFFF);
+                    u[i + j] = static_cast<Limb>(difference);
+                    borrow = static_cast<std::int64_t>(product >> 32) - (difference >> 32);
+                }
+                difference = static_cast<std::int64_t>(u[j + n]) - borrow;
+                u[j + n] = static_cast<Limb>(difference);
+                quotient[j] = static_cast<Limb>(estimate);
+                if(difference < 0) {
+                    // The estimate was one too large, which is rare: add the divisor back.
+                    --quotient[j];
+                    Wide carry = 0;
+                    for(std::size_t i = 0; i < n; ++i) {
+                        carry += Wide{u[i + j]} + v[i];
+                        u[i + j] = static_cast<Limb>(carry);
+                        carry >>= 32;
+                    }
+                    u[j + n] += static_cast<Limb>(carry);
+                }
+            }
+            trim(quotient);
+            return quotient;
+        }
+
+        // limbs = limbs * factor + addend.
+        void multiply_add(Limbs& limbs, const Limb factor, const Limb addend) {
+            Wide carry = addend;
+            for(auto& limb : limbs) {
+                carry += Wide{limb} * factor;
+                limb = static_cast<Limb>(carry);
+                carry >>= 32;
+            }
+            if(carry != 0) {
+                limbs.push_back(static_cast<Limb>(carry));
+            }
+        }
+
+        Big_Integer::Limbs magnitude_of(const long long value) {
+            const auto magnitude = value < 0 ? Wide{0} - static_cast<Wide>(value) : static_cast<Wide>(value);
+            Limbs limbs{static_cast<Limb>(magnitude), static_cast<Limb>(magnitude >> 32)};
+            trim(limbs);
+            return limbs;
+        }
+
+    }
+
+    Big_Integer::Big_Integer(const long long value)
+            : _negative{value < 0}, _limbs{magnitude_of(value)} {
+    }
+
+    Big_Integer::Big_Integer(const bool negative, Limbs magnitude) noexcept
+            : _limbs{std::move(magnitude)} {
+        trim(_limbs);
+        _negative = negative && !_limbs.empty();
+    }
+
+    Big_Integer Big_Integer::parse(const std::string_view text) {
+        const auto negative = !text.empty() && text.front() == '-';
+        const auto digits = text.substr(negative ? 1 : 0);
+        if(digits.empty() || !std::all_of(digits.begin(), digits.end(), [](const char c) {
+            return c >= '0' && c <= '9';
+        })) {
+            throw std::invalid_argument{"Not an integer"};
+        }
+        Limbs limbs;
+        limbs.reserve(digits.size() / DECIMAL_DIGITS + 1);
+        // The first chunk takes the digits that don't make a full chunk of nine.
+        auto chunk = digits.size() % DECIMAL_DIGITS == 0 ? DECIMAL_DIGITS : digits.size() % DECIMAL_DIGITS;
+        for(std::size_t position = 0; position < digits.size(); position += chunk, chunk = DECIMAL_DIGITS) {
+            Limb factor = 1;
+            Limb value = 0;
+            for(std::size_t i = position; i < position + chunk; ++i) {
+                factor *= 10;
+                value = value * 10 + static_cast<Limb>(digits[i] - '0');
+            }
+            multiply_add(limbs, factor, value);
+        }
+        return Big_Integer{negative, std::move(limbs)};
+    }
+
+    bool Big_Integer::negative() const noexcept {
+        return _negative;
+    }
+
+    bool Big_Integer::is_zero() const noexcept {
+        return _limbs.empty();
+    }
+
+    const Big_Integer::Limbs& Big_Integer::limbs() const noexcept {
+        return _limbs;
+    }
+
+    std::optional<long long> Big_Integer::to_small() const noexcept {
+        if(_limbs.size() > 2) {
+            return std::nullopt;
+        }
+        Wide magnitude = 0;
+        for(auto i = _limbs.size(); i-- > 0;) {
+            magnitude = (magnitude << 32) | _limbs[i];
+        }
+        const auto largest = static_cast<Wide>(LLONG_MAX);
+        if(!_negative) {
+            return magnitude <= largest ? std::optional<long long>{static_cast<long long>(magnitude)} : std::nullopt;
+        }
+        // LLONG_MIN has no positive counterpart, so negate in unsigned arithmetic.
+        return magnitude <= largest + 1 ? std::optional<long long>{static_cast<long long>(Wide{0} - magnitude)}
+                : std::nullopt;
+    }
+
+    std::string Big_Integer::to_string() const {
+        if(_limbs.empty()) {
+            return "0";
+        }
+        Limbs remaining{_limbs};
+        std::vector<Limb> chunks;
+        while(!remaining.empty()) {
+            chunks.push_back(divide_in_place(remaining, DECIMAL_BASE));
+        }
+        std::string text = _negative ? "-" : "";
+        text += std::to_string(chunks.back());
+        for(auto i = chunks.size() - 1; i-- > 0;) {
+            const auto digits = std::to_string(chunks[i]);
+            text.append(DECIMAL_DIGITS - digits.size(), '0').append(digits);
+        }
+        return text;
+    }
+
+    std::uint64_t Big_Integer::hash() const noexcept {
+        // FNV-1a over the limbs.
+        std::uint64_t hash = _negative ? 0xCBF29CE484222325 : 0x84222325CBF29CE4;
+        for(const auto limb : _limbs) {
+            hash = (hash ^ limb) * 0x100000001B3;
+        }
+        return hash;
+    }
+
+    Big_Integer Big_Integer::operator-() const {
+        return Big_Integer{!_negative, _limbs};
+    }
+
+    Big_Integer Big_Integer::add(const Big_Integer& left, const Big_Integer& right, const bool subtract) {
+        const auto right_negative = right._negative != subtract;
+        if(left._negative == right_negative) {
+            return Big_Integer{left._negative, add_magnitudes(left._limbs.data(), left._limbs.size(),
+                    right._limbs.data(), right._limbs.size())};
+        }
+        if(compare_magnitudes(left._limbs, right._limbs) >= 0) {
+            auto difference = left._limbs;
+            subtract_in_place(difference, right._limbs);
+            return Big_Integer{left._negative, std::move(difference)};
+        }
+        auto difference = right._limbs;
+        subtract_in_place(difference, left._limbs);
+        return Big_Integer{right_negative, std::move(difference)};
+    }
+
+    Big_Integer operator+(const Big_Integer& left, const Big_Integer& right) {
+        return Big_Integer::add(left, right, false);
+    }
+
+    Big_Integer operator-(const Big_Integer& left, const Big_Integer& right) {
+        return Big_Integer::add(left, right, true);
+    }
+
+    Big_Integer operator*(const Big_Integer& left, const Big_Integer& right) {
+        if(left.is_zero() || right.is_zero()) {
+            return Big_Integer{0};
+        }
+        return Big_Integer{left._negative != right._negative, product(left._limbs.data(), left._limbs.size(),
+                right._limbs.data(), right._limbs.size())};
+    }
+
+    Big_Integer operator/(const Big_Integer& left, const Big_Integer& right) {
+        if(right.is_zero()) {
+            throw std::runtime_error{"Division by zero"};
+        }
+        const auto negative = left._negative != right._negative;
+        if(compare_magnitudes(left._limbs, right._limbs) < 0) {
+            return Big_Integer{0};
+        }
+        if(right._limbs.size() == 1) {
+            auto quotient = left._limbs;
+            divide_in_place(quotient, right._limbs[0]);
+            return Big_Integer{negative, std::move(quotient)};
+        }
+        return Big_Integer{negative, divide_magnitudes(left._limbs, right._limbs)};
+    }
+
+    int compare(const Big_Integer& left, const Big_Integer& right) noexcept {
+        if(left._negative != right._negative) {
+            return left._negative ? -1 : 1;
+        }
+        const auto magnitudes = compare_magnitudes(left._limbs, right._limbs);
+        return left._negative ? -magnitudes : magnitudes;
+    }
+
+}
@@ -0,0 +1,61 @@
+#ifndef LYNX_BIG_INTEGER_H
+#define LYNX_BIG_INTEGER_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "heap.h"
+
+namespace lynx {
+
+    // Big_Integer is an integer of any size: a sign and a magnitude of 32-bit limbs, least significant first, on
+    // the accounted heap. 'int' values only turn into one when a result doesn't fit in 'long long' (see
+    // make_integer()), so none of this is on the path of ordinary arithmetic. Products of large operands are
+    // computed with Karatsuba's method.
+    class Big_Integer {
+    public:
+        using Limb = std::uint32_t;
+        using Limbs = std::vector<Limb, Heap_Allocator<Limb>>;
+
+        explicit Big_Integer(const long long value);
+
+        // Decimal digits with an optional leading '-'. Throws std::invalid_argument if that's not what 'text' is.
+        static Big_Integer parse(const std::string_view text);
+
+        bool negative() const noexcept;
+        bool is_zero() const noexcept;
+        const Limbs& limbs() const noexcept;
+
+        // The value as a 'long long', if it is in its range.
+        std::optional<long long> to_small() const noexcept;
+        std::string to_string() const;
+        std::uint64_t hash() const noexcept;
+
+        Big_Integer operator-() const;
+
+        friend Big_Integer operator+(const Big_Integer& left, const Big_Integer& right);
+        friend Big_Integer operator-(const Big_Integer& left, const Big_Integer& right);
+        friend Big_Integer operator*(const Big_Integer& left, const Big_Integer& right);
+        // Rounds toward zero, like '/' on 'long long'. Throws std::runtime_error when dividing by zero.
+        friend Big_Integer operator/(const Big_Integer& left, const Big_Integer& right);
+
+        // Negative, zero or positive as 'left' is less than, equal to or greater than 'right'.
+        friend int compare(const Big_Integer& left, const Big_Integer& right) noexcept;
+
+    private:
+        Big_Integer(const bool negative, Limbs magnitude) noexcept;
+
+        // left + right, or left - right if 'subtract' is set.
+        static Big_Integer add(const Big_Integer& left, const Big_Integer& right, const bool subtract);
+
+        bool  _negative{};
+        // Never has leading zero limbs, so zero is empty.
+        Limbs _limbs;
+    };
+
+}
+
+#endif //LYNX_BIG_INTEGER_H
@@ -0,0 +1,67 @@
+#include "builtin.h"
+
+namespace lynx {
+
+    Builtin find_builtin(std::string_view name) noexcept {
+        if(name == "len") {
+            return Builtin::LEN;
+        }
+        if(name == "array") {
+            return Builtin::ARRAY;
+        }
+        if(name == "sum") {
+            return Builtin::SUM;
+        }
+        if(name == "min") {
+            return Builtin::MIN;
+        }
+        if(name == "max") {
+            return Builtin::MAX;
+        }
+        if(name == "dot") {
+            return Builtin::DOT;
+        }
+        if(name == "map") {
+            return Builtin::MAP;
+        }
+        if(name == "has") {
+            return Builtin::HAS;
+        }
+        if(name == "lines") {
+            return Builtin::LINES;
+        }
+        if(name == "chunks") {
+            return Builtin::CHUNKS;
+        }
+        if(name == "write") {
+            return Builtin::WRITE;
+        }
+        if(name == "snapshot") {
+            return Builtin::SNAPSHOT;
+        }
+        return Builtin::NONE;
+    }
+
+    std::size_t arity(const Builtin builtin) noexcept {
+        switch(builtin) {
+            case Builtin::LEN:
+            case Builtin::SUM:
+            case Builtin::MIN:
+            case Builtin::MAX:
+            case Builtin::MAP:
+            case Builtin::LINES:
+                return 1;
+            case Builtin::ARRAY:
+            case Builtin::DOT:
+            case Builtin::HAS:
+            case Builtin::CHUNKS:
+            case Builtin::WRITE:
+                return 2;
+            case Builtin::SNAPSHOT:
+            case Builtin::NONE:
+                break;
+        }
+        return 0;
+    }
+
+}
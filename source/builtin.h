@@ -0,0 +1,32 @@
+#ifndef LYNX_BUILTIN_H
+#define LYNX_BUILTIN_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace lynx {
+
+    // Functions provided by the interpreter. A function declared by the script with the same name hides them.
+    enum class Builtin {
+        NONE,
+        LEN,    // len(array_or_string): int
+        ARRAY,  // array(size: int, value): array of 'size' copies of 'value'
+        SUM,    // sum(array): sum of the elements, or number of true ones of a 'bool[]'
+        MIN,    // min(array): smallest element of a non-empty array
+        MAX,    // max(array): largest element of a non-empty array
+        DOT,    // dot(a, b): sum(a * b)
+        MAP,    // map(capacity: int): empty map with room for 'capacity' entries, typed by the variable it initializes
+        HAS,    // has(map, key): bool
+        LINES,  // lines(path: string): generator of the lines of a file, without their line breaks
+        CHUNKS, // chunks(path: string, size: int): generator of the pieces of a file, 'size' bytes each but the last
+        WRITE,  // write(path: string, value): appends 'value' to a file as 'print' would; the file starts empty
+        SNAPSHOT,   // snapshot(): marks where 'lynx --snapshot' stops, does nothing otherwise; top level only
+    };
+
+    // Builtin called 'name', or NONE.
+    Builtin find_builtin(std::string_view name) noexcept;
+    std::size_t arity(const Builtin builtin) noexcept;
+
+}
+
+#endif //LYNX_BUILTIN_H
@@ -0,0 +1,25 @@
+#ifndef LYNX_DIAGNOSTIC_H
+#define LYNX_DIAGNOSTIC_H
+
+#include <string>
+
+namespace lynx {
+
+    // Error found while compiling a script. Reported to the caller as a value; it's up to the caller whether and
+    // where to print it.
+    struct Diagnostic {
+        std::string message;
+        std::string filename;
+        std::size_t line{};
+        std::size_t column{};
+    };
+
+    // Formats the diagnostic the way the 'lynx' driver prints it, "Error: file:line:column: message.".
+    inline std::string to_string(const Diagnostic& diagnostic) {
+        return "Error: " + diagnostic.filename + ':' + std::to_string(diagnostic.line) + ':'
+                + std::to_string(diagnostic.column) + ": " + diagnostic.message + '.';
+    }
+
+}
+
+#endif //LYNX_DIAGNOSTIC_H
@@ -1,37 +1,137 @@
 #include "environment.h"
 
-#include <iomanip>
 #include <stdexcept>
 
+#include "instrumentation.h"
+
 namespace lynx {
 
-    void Environment::define(const std::string& name, const Value value) {
-        for(const auto& symbol : _symbols) {
-            if(symbol.name == name) {
-                throw std::runtime_error{"Redefinition of '" + name + "'"};
+    Environment::Environment() {
+        _symbols.reserve(64);
+        _scopes.reserve(32);
+        _frames.reserve(32);
+    }
+
+    void Environment::define(std::string_view name, Value value) {
+        const auto scope_begin = _scopes.empty() ? 0 : _scopes.back();
+        for(auto i = scope_begin; i < _symbols.size(); ++i) {
+            if(_symbols[i].name == name) {
+                throw std::runtime_error{"Redefinition of '" + std::string{name} + "'"};
             }
         }
-        _symbols.emplace_back(Symbol{name, value});
+        _symbols.emplace_back(Symbol{name, std::move(value)});
+    }
+
+    Value Environment::get(std::string_view name) {
+        if(auto symbol = find(name); symbol != nullptr) {
+            return symbol->value;
+        }
+        throw std::runtime_error{"'" + std::string{name} + "' is undefined"};
+    }
+
+    Value& Environment::lookup(std::string_view name) {
+        if(auto symbol = find(name); symbol != nullptr) {
+            return symbol->value;
+        }
+        throw std::runtime_error{"'" + std::string{name} + "' is undefined"};
     }
 
-    void Environment::assign(const std::string& name, const Value value) {
-        for(auto& symbol : _symbols) {
-            if(symbol.name == name) {
-                symbol.value = std::move(value);
-                return;
+    void Environment::push_scope() {
+        _scopes.push_back(_symbols.size());
+    }
+
+    void Environment::pop_scope() {
+        _symbols.erase(_symbols.begin() + _scopes.back(), _symbols.end());
+        _scopes.pop_back();
+    }
+
+    void Environment::push_frame() {
+        push_scope();
+        _frames.push_back(Frame{_symbols.size(), _scopes.size()});
+    }
+
+    void Environment::pop_frame() {
+        _scopes.erase(_scopes.begin() + _frames.back().scopes, _scopes.end());
+        _frames.pop_back();
+        pop_scope();
+    }
+
+    void Environment::reset_frame() {
+        _scopes.erase(_scopes.begin() + _frames.back().scopes, _scopes.end());
+        _symbols.erase(_symbols.begin() + _frames.back().symbols, _symbols.end());
+    }
+
+    void Environment::save_frame(Saved_Frame& frame) {
+        const auto& current = _frames.back();
+        frame.symbols.clear();
+        for(auto i = current.symbols; i < _symbols.size(); ++i) {
+            frame.symbols.push_back(Binding{_symbols[i].name, std::move(_symbols[i].value)});
+        }
+        frame.scopes.clear();
+        for(auto i = current.scopes; i < _scopes.size(); ++i) {
+            frame.scopes.push_back(_scopes[i] - current.symbols);
+        }
+        reset_frame();
+    }
+
+    void Environment::restore_frame(Saved_Frame& frame) {
+        const auto& current = _frames.back();
+        for(auto& binding : frame.symbols) {
+            _symbols.emplace_back(Symbol{binding.name, std::move(binding.value)});
+        }
+        for(const auto scope : frame.scopes) {
+            _scopes.push_back(scope + current.symbols);
+        }
+    }
+
+    void Environment::clear() {
+        _symbols.clear();
+        _scopes.clear();
+        _frames.clear();
+    }
+
+    std::vector<Environment::Binding> Environment::visible() const {
+        std::vector<Binding> bindings;
+        const auto add = [&bindings](const Symbol& symbol) {
+            for(const auto& binding : bindings) {
+                if(binding.name == symbol.name) {
+                    return;
+                }
+            }
+            bindings.push_back(Binding{symbol.name, symbol.value});
+        };
+        const auto frame_begin = _frames.empty() ? 0 : _frames.back().symbols;
+        for(auto i = _symbols.size(); i > frame_begin; --i) {
+            add(_symbols[i - 1]);
+        }
+        if(frame_begin > 0) {
+            for(auto i = _scopes.front(); i > 0; --i) {
+                add(_symbols[i - 1]);
             }
         }
-        throw std::runtime_error{"Redefinition of '" + name + "'"};
+        return bindings;
     }
 
-    Value Environment::get(const std::string& name) {
-        for(const auto& symbol : _symbols) {
-            if(symbol.name == name) {
-                return symbol.value;
+    Environment::Symbol* Environment::find(std::string_view name) {
+        LYNX_COUNT(ENVIRONMENT_LOOKUPS);
+        const auto frame_begin = _frames.empty() ? 0 : _frames.back().symbols;
+        for(auto i = _symbols.size(); i > frame_begin; --i) {
+            LYNX_COUNT(ENVIRONMENT_PROBES);
+            if(_symbols[i - 1].name == name) {
+                return &_symbols[i - 1];
             }
         }
-        throw std::runtime_error{"'" + name + "' is undefined"};
+        if(frame_begin == 0) {
+            return nullptr;
+        }
+        // Globals are whatever was defined before the first scope was opened.
+        for(auto i = _scopes.front(); i > 0; --i) {
+            LYNX_COUNT(ENVIRONMENT_PROBES);
+            if(_symbols[i - 1].name == name) {
+                return &_symbols[i - 1];
+            }
+        }
+        return nullptr;
     }
 
 }
-
@@ -2,30 +2,76 @@
 #define LYNX_ENVIRONMENT_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "value.h"
 
 namespace lynx {
 
+    // Environment is a single contiguous stack of symbols shared by every scope and call frame. Opening a scope
+    // only records the current stack height and closing it truncates the stack back, so once the vectors have
+    // grown to the script's working set, entering blocks and calling functions doesn't allocate.
+    // Symbol names are borrowed from the AST, which has to outlive the environment.
     // TODO: Store data about variable's immutability.
     class Environment {
     public:
-        void define(const std::string& name, const Value value);
-        void assign(const std::string& name, const Value value);
-        Value get(const std::string& name);
+        Environment();
+
+        void define(std::string_view name, Value value);
+        Value get(std::string_view name);
+        // Borrows the stored value, so it can be read or updated in place without a copy.
+        Value& lookup(std::string_view name);
+
+        void push_scope();
+        void pop_scope();
+
+        // Call frames hide the caller's locals; only globals stay visible from inside a function.
+        void push_frame();
+        void pop_frame();
+        // Drops every local of the innermost frame, so it can be reused by a tail call.
+        void reset_frame();
+
+        struct Binding {
+            std::string_view name;
+            Value            value;
+        };
+
+        // Locals and open scopes of a suspended frame, relative to the frame's start.
+        struct Saved_Frame {
+            std::vector<Binding>     symbols;
+            std::vector<std::size_t> scopes;
+        };
+        // Moves the innermost frame's locals out, leaving it empty, and back into a freshly pushed frame. The
+        // saved vectors keep their capacity, so a frame that is suspended and resumed repeatedly doesn't allocate.
+        void save_frame(Saved_Frame& frame);
+        void restore_frame(Saved_Frame& frame);
+
+        void clear();
+
+        // Copies every variable visible from the current scope, innermost binding of each name only.
+        std::vector<Binding> visible() const;
 
     private:
         // Dirty workaround for std::(unordered_)map<std::string, std::variant.
         struct Symbol {
-            std::string name;
-            Value       value;
+            std::string_view name;
+            Value            value;
+        };
+
+        // Stack heights at the point a frame was opened.
+        struct Frame {
+            std::size_t symbols;
+            std::size_t scopes;
         };
 
-        std::vector<Symbol> _symbols;
+        Symbol* find(std::string_view name);
+
+        std::vector<Symbol>      _symbols;
+        std::vector<std::size_t> _scopes;
+        std::vector<Frame>       _frames;
     };
 
 }
 
 #endif //LYNX_ENVIRONMENT_H
-
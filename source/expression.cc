@@ -1,7 +1,61 @@
 #include "expression.h"
 
+#include "map.h"
+
 namespace lynx {
 
+    namespace {
+
+        std::optional<std::uint64_t> literal_key_hash(const Expr_Ptr& index) {
+            const auto literal = dynamic_cast<const Literal*>(index.get());
+            if(literal == nullptr
+                    || (literal->value.type != Value::Type::STRING && literal->value.type != Value::Type::INTEGER)) {
+                return std::nullopt;
+            }
+            return Map::hash(literal->value);
+        }
+
+        bool reads_only(const std::vector<Expr_Ptr>& expressions) {
+            for(const auto& expression : expressions) {
+                if(!reads_only(*expression)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    }
+
+    const Value& Expr::read(Expression_Visitor& visitor, Value& slot) {
+        slot = accept(visitor);
+        return slot;
+    }
+
+    bool reads_only(const Expr& expression) {
+        if(dynamic_cast<const Literal*>(&expression) != nullptr
+                || dynamic_cast<const Identifier*>(&expression) != nullptr
+                || dynamic_cast<const Compare_Identifier_Literal*>(&expression) != nullptr
+                || dynamic_cast<const Arithmetic_Identifier_Literal*>(&expression) != nullptr) {
+            return true;
+        }
+        if(auto unary = dynamic_cast<const Unary_Operation*>(&expression); unary != nullptr) {
+            return reads_only(*unary->operand);
+        }
+        if(auto binary = dynamic_cast<const Binary_Operation*>(&expression); binary != nullptr) {
+            return reads_only(*binary->left) && reads_only(*binary->right);
+        }
+        if(auto index = dynamic_cast<const Index*>(&expression); index != nullptr) {
+            return reads_only(*index->array) && reads_only(*index->index);
+        }
+        if(auto array = dynamic_cast<const Array_Literal*>(&expression); array != nullptr) {
+            return reads_only(array->elements);
+        }
+        if(auto map = dynamic_cast<const Map_Literal*>(&expression); map != nullptr) {
+            return reads_only(map->keys) && reads_only(map->values);
+        }
+        return false;
+    }
+
     Literal::Literal(const Value& value)
             : value{value} {
     }
@@ -10,6 +64,10 @@ namespace lynx {
         return visitor.visit_literal(*this);
     }
 
+    const Value& Literal::read(Expression_Visitor& visitor, Value&) {
+        return visitor.read_literal(*this);
+    }
+
     Identifier::Identifier(const Token name)
             : name{name} {
     }
@@ -18,6 +76,10 @@ namespace lynx {
         return visitor.visit_identifier(*this);
     }
 
+    const Value& Identifier::read(Expression_Visitor& visitor, Value&) {
+        return visitor.read_identifier(*this);
+    }
+
     Unary_Operation::Unary_Operation(const Token operator_, Expr_Ptr&& operand)
             : operator_{operator_}, operand{std::move(operand)} {
     }
@@ -27,12 +89,87 @@ namespace lynx {
     }
 
     Binary_Operation::Binary_Operation(Expr_Ptr&& left, const Token operator_, Expr_Ptr&& right)
-            : left{std::move(left)}, operator_{operator_}, right{std::move(right)} {
+            : left{std::move(left)}, operator_{operator_}, right{std::move(right)},
+              borrow_left{reads_only(*this->right)} {
     }
 
     Value Binary_Operation::accept(Expression_Visitor& visitor) {
         return visitor.visit_binary(*this);
     }
 
-}
+    Assignment::Assignment(const Token name, Expr_Ptr&& value)
+            : name{name}, value{std::move(value)} {
+    }
+
+    Value Assignment::accept(Expression_Visitor& visitor) {
+        return visitor.visit_assignment(*this);
+    }
+
+    Call::Call(const Token callee, std::vector<Expr_Ptr>&& arguments)
+            : callee{callee}, arguments{std::move(arguments)} {
+    }
+
+    Value Call::accept(Expression_Visitor& visitor) {
+        return visitor.visit_call(*this);
+    }
+
+    Array_Literal::Array_Literal(const Token bracket, std::vector<Expr_Ptr>&& elements)
+            : bracket{bracket}, elements{std::move(elements)} {
+    }
+
+    Value Array_Literal::accept(Expression_Visitor& visitor) {
+        return visitor.visit_array_literal(*this);
+    }
 
+    Map_Literal::Map_Literal(const Token brace, std::vector<Expr_Ptr>&& keys, std::vector<Expr_Ptr>&& values)
+            : brace{brace}, keys{std::move(keys)}, values{std::move(values)} {
+    }
+
+    Value Map_Literal::accept(Expression_Visitor& visitor) {
+        return visitor.visit_map_literal(*this);
+    }
+
+    Index::Index(Expr_Ptr&& array, const Token bracket, Expr_Ptr&& index)
+            : array{std::move(array)}, bracket{bracket}, index{std::move(index)},
+              name{dynamic_cast<const Identifier*>(this->array.get())}, key_hash{literal_key_hash(this->index)} {
+    }
+
+    Value Index::accept(Expression_Visitor& visitor) {
+        return visitor.visit_index(*this);
+    }
+
+    Index_Assignment::Index_Assignment(const Token name, Expr_Ptr&& index, Expr_Ptr&& value)
+            : name{name}, index{std::move(index)}, value{std::move(value)}, key_hash{literal_key_hash(this->index)},
+              borrow_index{reads_only(*this->value)} {
+    }
+
+    Value Index_Assignment::accept(Expression_Visitor& visitor) {
+        return visitor.visit_index_assignment(*this);
+    }
+
+    Compare_Identifier_Literal::Compare_Identifier_Literal(const Token name, const Token operator_, Value&& literal)
+            : name{name}, operator_{operator_}, literal{std::move(literal)} {
+    }
+
+    Value Compare_Identifier_Literal::accept(Expression_Visitor& visitor) {
+        return visitor.visit_compare_identifier_literal(*this);
+    }
+
+    Arithmetic_Identifier_Literal::Arithmetic_Identifier_Literal(const Token name, const Token operator_,
+            Value&& literal)
+            : name{name}, operator_{operator_}, literal{std::move(literal)} {
+    }
+
+    Value Arithmetic_Identifier_Literal::accept(Expression_Visitor& visitor) {
+        return visitor.visit_arithmetic_identifier_literal(*this);
+    }
+
+    Compound_Assignment::Compound_Assignment(const Token name, const Token operator_, Value&& literal)
+            : name{name}, operator_{operator_}, literal{std::move(literal)} {
+    }
+
+    Value Compound_Assignment::accept(Expression_Visitor& visitor) {
+        return visitor.visit_compound_assignment(*this);
+    }
+
+}
@@ -1,25 +1,37 @@
 #ifndef LYNX_EXPRESSION_H
 #define LYNX_EXPRESSION_H
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
+#include "builtin.h"
 #include "token.h"
 #include "value.h"
 
 namespace lynx {
 
     class Expression_Visitor;
+    struct Function_Declaration;
 
     struct Expr {
         virtual ~Expr() = default;
         virtual Value accept(Expression_Visitor& visitor) = 0;
+        // Borrows the value where it is already stored, in a literal or a variable, and evaluates anything else into
+        // 'slot'. A borrowed variable is only valid until the next call or assignment.
+        virtual const Value& read(Expression_Visitor& visitor, Value& slot);
     };
     using Expr_Ptr = std::unique_ptr<Expr>;
 
+    // Whether evaluating 'expression' leaves every variable as it is: it has no call or assignment in it.
+    bool reads_only(const Expr& expression);
+
     struct Literal : Expr {
         Literal(const Value& value);
         Value accept(Expression_Visitor& visitor) override;
+        const Value& read(Expression_Visitor& visitor, Value& slot) override;
 
         Value value;
     };
@@ -27,6 +39,7 @@ namespace lynx {
     struct Identifier : Expr {
         Identifier(const Token value);
         Value accept(Expression_Visitor& visitor) override;
+        const Value& read(Expression_Visitor& visitor, Value& slot) override;
 
         Token name;
     };
@@ -46,6 +59,113 @@ namespace lynx {
         Expr_Ptr    left;
         Token       operator_;
         Expr_Ptr    right;
+        // Set when 'left' can stay borrowed while 'right' is evaluated.
+        bool        borrow_left;
+
+        // Operands that are a literal or a variable can be read in place, without a call through read(). Set by the
+        // Resolver, once fusion has settled the tree.
+        enum class Operand : unsigned char {
+            OTHER, LITERAL, IDENTIFIER
+        };
+        Operand     left_operand{Operand::OTHER};
+        Operand     right_operand{Operand::OTHER};
+    };
+
+    struct Assignment : Expr {
+        Assignment(const Token name, Expr_Ptr&& value);
+        Value accept(Expression_Visitor& visitor) override;
+
+        Token    name;
+        Expr_Ptr value;
+    };
+
+    struct Call : Expr {
+        Call(const Token callee, std::vector<Expr_Ptr>&& arguments);
+        Value accept(Expression_Visitor& visitor) override;
+
+        Token                 callee;
+        std::vector<Expr_Ptr> arguments;
+        // Bound by the Resolver when the program is compiled, only one of them is set.
+        const Function_Declaration* function{};
+        Builtin                     builtin{Builtin::NONE};
+    };
+
+    // [element, ...]
+    struct Array_Literal : Expr {
+        Array_Literal(const Token bracket, std::vector<Expr_Ptr>&& elements);
+        Value accept(Expression_Visitor& visitor) override;
+
+        Token                 bracket;
+        std::vector<Expr_Ptr> elements;
+    };
+
+    // {key: value, ...}
+    struct Map_Literal : Expr {
+        Map_Literal(const Token brace, std::vector<Expr_Ptr>&& keys, std::vector<Expr_Ptr>&& values);
+        Value accept(Expression_Visitor& visitor) override;
+
+        Token                 brace;
+        std::vector<Expr_Ptr> keys;
+        std::vector<Expr_Ptr> values;
+    };
+
+    // array[index] or map[key]
+    struct Index : Expr {
+        Index(Expr_Ptr&& array, const Token bracket, Expr_Ptr&& index);
+        Value accept(Expression_Visitor& visitor) override;
+
+        Expr_Ptr          array;
+        Token             bracket;
+        Expr_Ptr          index;
+        // Set when the array is a variable, so it can be read without copying the value.
+        const Identifier* name;
+        // Map hash of the index when it is a literal, so that looking it up hashes nothing.
+        std::optional<std::uint64_t> key_hash;
+    };
+
+    // name[index] = value
+    struct Index_Assignment : Expr {
+        Index_Assignment(const Token name, Expr_Ptr&& index, Expr_Ptr&& value);
+        Value accept(Expression_Visitor& visitor) override;
+
+        Token                        name;
+        Expr_Ptr                     index;
+        Expr_Ptr                     value;
+        std::optional<std::uint64_t> key_hash;
+        // Set when 'index' can stay borrowed while 'value' is evaluated.
+        bool                         borrow_index;
+    };
+
+    // Superinstructions. Parser never produces them, Fusion_Pass rewrites common node shapes into them.
+
+    // identifier <comparison> literal
+    struct Compare_Identifier_Literal : Expr {
+        Compare_Identifier_Literal(const Token name, const Token operator_, Value&& literal);
+        Value accept(Expression_Visitor& visitor) override;
+
+        Token name;
+        Token operator_;
+        Value literal;
+    };
+
+    // identifier <arithmetic> literal
+    struct Arithmetic_Identifier_Literal : Expr {
+        Arithmetic_Identifier_Literal(const Token name, const Token operator_, Value&& literal);
+        Value accept(Expression_Visitor& visitor) override;
+
+        Token name;
+        Token operator_;
+        Value literal;
+    };
+
+    // identifier = identifier <arithmetic> literal, with the same identifier on both sides.
+    struct Compound_Assignment : Expr {
+        Compound_Assignment(const Token name, const Token operator_, Value&& literal);
+        Value accept(Expression_Visitor& visitor) override;
+
+        Token name;
+        Token operator_;
+        Value literal;
     };
 
     class Expression_Visitor {
@@ -53,8 +173,19 @@ namespace lynx {
         virtual ~Expression_Visitor() = default;
         virtual Value visit_literal(const Literal& floating) = 0;
         virtual Value visit_identifier(const Identifier& identifier) = 0;
+        virtual const Value& read_literal(const Literal& literal) = 0;
+        virtual const Value& read_identifier(const Identifier& identifier) = 0;
         virtual Value visit_unary(const Unary_Operation& unary) = 0;
         virtual Value visit_binary(const Binary_Operation& binary) = 0;
+        virtual Value visit_assignment(const Assignment& assignment) = 0;
+        virtual Value visit_call(const Call& call) = 0;
+        virtual Value visit_array_literal(const Array_Literal& array) = 0;
+        virtual Value visit_map_literal(const Map_Literal& map) = 0;
+        virtual Value visit_index(const Index& index) = 0;
+        virtual Value visit_index_assignment(const Index_Assignment& assignment) = 0;
+        virtual Value visit_compare_identifier_literal(const Compare_Identifier_Literal& compare) = 0;
+        virtual Value visit_arithmetic_identifier_literal(const Arithmetic_Identifier_Literal& arithmetic) = 0;
+        virtual Value visit_compound_assignment(const Compound_Assignment& assignment) = 0;
     };
 
 }
@@ -0,0 +1,135 @@
+#include "file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lynx {
+
+    namespace {
+
+        int open_for_writing(const std::string& path) {
+            const auto file_descriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if(file_descriptor < 0) {
+                throw std::runtime_error{"Can't open file \"" + path + "\" for writing"};
+            }
+            return file_descriptor;
+        }
+
+    }
+
+    std::optional<std::string> read_file(const std::string& path) {
+        // A directory opens like a file, with a bogus size.
+        if(std::error_code error; std::filesystem::is_directory(path, error)) {
+            return {};
+        }
+        std::ifstream file{path, std::ios::binary | std::ios::ate};
+        const auto size = file.tellg();
+        if(!file.good() || size < 0) {
+            return {};
+        }
+        std::string content(static_cast<std::size_t>(size), '\0');
+        file.seekg(0);
+        file.read(content.data(), static_cast<std::streamsize>(content.size()));
+        if(!file.good()) {
+            return {};
+        }
+        return content;
+    }
+
+    Mapped_File::Mapped_File(const std::string& path) {
+        const auto file_descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(file_descriptor < 0) {
+            throw std::runtime_error{"Can't open file \"" + path + "\""};
+        }
+        struct stat status{};
+        if(::fstat(file_descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+            ::close(file_descriptor);
+            throw std::runtime_error{"Can't map file \"" + path + "\""};
+        }
+        _size = static_cast<std::size_t>(status.st_size);
+        // An empty mapping isn't allowed, and an empty file needs none.
+        if(_size > 0) {
+            const auto data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+            if(data == MAP_FAILED) {
+                ::close(file_descriptor);
+                throw std::runtime_error{"Can't map file \"" + path + "\""};
+            }
+            _data = static_cast<const char*>(data);
+            ::madvise(const_cast<char*>(_data), _size, MADV_SEQUENTIAL);
+        }
+        // The mapping keeps the file open.
+        ::close(file_descriptor);
+    }
+
+    Mapped_File::~Mapped_File() {
+        if(_data != nullptr) {
+            ::munmap(const_cast<char*>(_data), _size);
+        }
+    }
+
+    std::string_view Mapped_File::content() const noexcept {
+        return std::string_view{_data, _size};
+    }
+
+    void Mapped_File::prefetch(const std::size_t offset, const std::size_t size) const noexcept {
+        if(offset >= _size) {
+            return;
+        }
+        // madvise() takes whole pages.
+        static const auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const auto begin = offset / page_size * page_size;
+        const auto end = std::min(offset + size, _size);
+        ::madvise(const_cast<char*>(_data) + begin, end - begin, MADV_WILLNEED);
+    }
+
+    File_Reader::File_Reader(const std::string& path, const std::size_t chunk_size)
+            : _file{path}, _chunk_size{chunk_size} {
+    }
+
+    std::optional<std::string_view> File_Reader::next() noexcept {
+        const auto content = _file.content();
+        if(_position == content.size()) {
+            return {};
+        }
+        // Half a window ahead, the next window is requested, so reading never waits for the one it is in.
+        if(_position + PREFETCH_WINDOW / 2 >= _prefetched) {
+            _file.prefetch(_prefetched, PREFETCH_WINDOW);
+            _prefetched += PREFETCH_WINDOW;
+        }
+        const auto rest = content.substr(_position);
+        if(_chunk_size > 0) {
+            const auto chunk = rest.substr(0, _chunk_size);
+            _position += chunk.size();
+            return chunk;
+        }
+        const auto newline = static_cast<const char*>(std::memchr(rest.data(), '\n', rest.size()));
+        auto line = newline == nullptr ? rest : rest.substr(0, static_cast<std::size_t>(newline - rest.data()));
+        _position += newline == nullptr ? line.size() : line.size() + 1;
+        if(!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        return line;
+    }
+
+    Output_File::Output_File(const std::string& path)
+            : _file_descriptor{open_for_writing(path)}, _buffer{_file_descriptor} {
+    }
+
+    Output_File::~Output_File() {
+        _buffer.flush();
+        ::close(_file_descriptor);
+    }
+
+    Output_Buffer& Output_File::buffer() noexcept {
+        return _buffer;
+    }
+
+}
@@ -0,0 +1,74 @@
+#ifndef LYNX_FILE_H
+#define LYNX_FILE_H
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "output.h"
+
+namespace lynx {
+
+    // Reads the whole file in one go, or returns nothing if it can't be opened.
+    std::optional<std::string> read_file(const std::string& path);
+
+    // Mapped_File is a file mapped read-only into memory, so it can be read without copying it into a buffer
+    // first. Pages are only read from disk, or the page cache, once they are touched.
+    class Mapped_File {
+    public:
+        // Throws std::runtime_error if the file can't be opened or mapped.
+        explicit Mapped_File(const std::string& path);
+        Mapped_File(const Mapped_File&) = delete;
+        Mapped_File& operator=(const Mapped_File&) = delete;
+        ~Mapped_File();
+
+        std::string_view content() const noexcept;
+        // Asks the kernel to start reading the pages of [offset, offset + size) ahead of their first use.
+        void prefetch(const std::size_t offset, const std::size_t size) const noexcept;
+
+    private:
+        const char* _data{};
+        std::size_t _size{};
+    };
+
+    // File_Reader walks a Mapped_File front to back, in lines or in chunks of a fixed size. Pieces are views into
+    // the mapping, and the pages in front of the current position are prefetched a window at a time.
+    class File_Reader {
+    public:
+        static constexpr std::size_t PREFETCH_WINDOW = 4 * 1024 * 1024;
+
+        // Reads lines if 'chunk_size' is zero. Throws std::runtime_error if the file can't be mapped.
+        File_Reader(const std::string& path, const std::size_t chunk_size);
+
+        // The next line, without its '\n' or "\r\n", or the next chunk. Nothing once the whole file was read.
+        std::optional<std::string_view> next() noexcept;
+
+    private:
+        Mapped_File _file;
+        std::size_t _chunk_size;
+        std::size_t _position{};
+        // End of what was prefetched so far.
+        std::size_t _prefetched{};
+    };
+
+    // Output_File is a file created, or truncated, for writing, and written through an Output_Buffer. The buffer is
+    // flushed and the file closed on destruction.
+    class Output_File {
+    public:
+        // Throws std::runtime_error if the file can't be opened.
+        explicit Output_File(const std::string& path);
+        Output_File(const Output_File&) = delete;
+        Output_File& operator=(const Output_File&) = delete;
+        ~Output_File();
+
+        Output_Buffer& buffer() noexcept;
+
+    private:
+        int           _file_descriptor;
+        Output_Buffer _buffer;
+    };
+
+}
+
+#endif //LYNX_FILE_H
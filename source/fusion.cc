@@ -0,0 +1,212 @@
+#include "fusion.h"
+
+namespace lynx {
+
+    namespace {
+
+        bool is_comparison(const Token::Type type) {
+            return type == Token::Type::EQUALS_EQUALS || type == Token::Type::BANG_EQUALS
+                    || type == Token::Type::LESS || type == Token::Type::LESS_EQUALS
+                    || type == Token::Type::GREATER || type == Token::Type::GREATER_EQUALS;
+        }
+
+        bool is_arithmetic(const Token::Type type) {
+            return type == Token::Type::PLUS || type == Token::Type::MINUS
+                    || type == Token::Type::STAR || type == Token::Type::SLASH;
+        }
+
+        // Matches 'identifier <operator> literal' and returns the identifier, or nullptr.
+        Identifier* match_identifier_literal(Binary_Operation& binary) {
+            if(dynamic_cast<Literal*>(binary.right.get()) == nullptr) {
+                return nullptr;
+            }
+            return dynamic_cast<Identifier*>(binary.left.get());
+        }
+
+    }
+
+    const char* to_string(const Fused_Pattern pattern) noexcept {
+        switch(pattern) {
+            case Fused_Pattern::COMPARE_IDENTIFIER_LITERAL:
+                return "compare_identifier_literal";
+            case Fused_Pattern::ARITHMETIC_IDENTIFIER_LITERAL:
+                return "arithmetic_identifier_literal";
+            case Fused_Pattern::COMPOUND_ASSIGNMENT:
+                return "compound_assignment";
+            case Fused_Pattern::IF_COMPARE:
+                return "if_compare";
+            case Fused_Pattern::COUNT:
+                break;
+        }
+        return "unknown";
+    }
+
+    void Fusion_Pass::fuse(std::vector<Statement_Ptr>& statements) {
+        for(auto& statement : statements) {
+            fuse(statement);
+        }
+    }
+
+    const Fusion_Counters& Fusion_Pass::rewrites() const noexcept {
+        return _rewrites;
+    }
+
+    void Fusion_Pass::fuse(Statement_Ptr& statement) {
+        if(statement == nullptr) {
+            return;
+        }
+        if(auto block = dynamic_cast<Block*>(statement.get()); block != nullptr) {
+            fuse(block->statements);
+            return;
+        }
+        if(auto expression = dynamic_cast<Expression*>(statement.get()); expression != nullptr) {
+            fuse(expression->expression);
+            return;
+        }
+        if(auto function = dynamic_cast<Function_Declaration*>(statement.get()); function != nullptr) {
+            fuse(function->body);
+            return;
+        }
+        if(auto variable = dynamic_cast<Variable_Declaration*>(statement.get()); variable != nullptr) {
+            fuse(variable->initializer);
+            return;
+        }
+        if(auto if_stmt = dynamic_cast<If*>(statement.get()); if_stmt != nullptr) {
+            fuse(if_stmt->then_block);
+            fuse(if_stmt->else_block);
+            auto condition = dynamic_cast<Binary_Operation*>(if_stmt->condition.get());
+            if(condition != nullptr && is_comparison(condition->operator_.type)) {
+                fuse(condition->left);
+                fuse(condition->right);
+                const auto line = statement->line;
+                statement = std::make_unique<If_Compare>(std::move(condition->left), condition->operator_,
+                        std::move(condition->right), std::move(if_stmt->then_block), std::move(if_stmt->else_block));
+                statement->line = line;
+                count(Fused_Pattern::IF_COMPARE);
+                return;
+            }
+            fuse(if_stmt->condition);
+            return;
+        }
+        if(auto for_stmt = dynamic_cast<For*>(statement.get()); for_stmt != nullptr) {
+            fuse(for_stmt->init_statement);
+            fuse(for_stmt->condition);
+            fuse(for_stmt->iteration_expression);
+            fuse(for_stmt->block);
+            return;
+        }
+        if(auto for_in = dynamic_cast<For_In*>(statement.get()); for_in != nullptr) {
+            fuse(for_in->iterable);
+            fuse(for_in->block);
+            return;
+        }
+        if(auto parallel_for = dynamic_cast<Parallel_For*>(statement.get()); parallel_for != nullptr) {
+            fuse(parallel_for->begin);
+            fuse(parallel_for->end);
+            fuse(parallel_for->block);
+            return;
+        }
+        if(auto while_stmt = dynamic_cast<While*>(statement.get()); while_stmt != nullptr) {
+            fuse(while_stmt->condition);
+            fuse(while_stmt->block);
+            return;
+        }
+        if(auto do_while = dynamic_cast<Do_While*>(statement.get()); do_while != nullptr) {
+            fuse(do_while->condition);
+            fuse(do_while->block);
+            return;
+        }
+        if(auto print = dynamic_cast<Print*>(statement.get()); print != nullptr) {
+            fuse(print->expression);
+            return;
+        }
+        if(auto return_stmt = dynamic_cast<Return*>(statement.get()); return_stmt != nullptr) {
+            // A tail call is a Call, which is never replaced, so Return::tail_call stays valid.
+            fuse(return_stmt->value);
+            return;
+        }
+        if(auto yield = dynamic_cast<Yield*>(statement.get()); yield != nullptr) {
+            fuse(yield->value);
+            return;
+        }
+    }
+
+    void Fusion_Pass::fuse(Expr_Ptr& expression) {
+        if(expression == nullptr) {
+            return;
+        }
+        if(auto unary = dynamic_cast<Unary_Operation*>(expression.get()); unary != nullptr) {
+            fuse(unary->operand);
+            return;
+        }
+        if(auto call = dynamic_cast<Call*>(expression.get()); call != nullptr) {
+            for(auto& argument : call->arguments) {
+                fuse(argument);
+            }
+            return;
+        }
+        if(auto array = dynamic_cast<Array_Literal*>(expression.get()); array != nullptr) {
+            for(auto& element : array->elements) {
+                fuse(element);
+            }
+            return;
+        }
+        if(auto map = dynamic_cast<Map_Literal*>(expression.get()); map != nullptr) {
+            for(std::size_t i = 0; i < map->keys.size(); ++i) {
+                fuse(map->keys[i]);
+                fuse(map->values[i]);
+            }
+            return;
+        }
+        if(auto index = dynamic_cast<Index*>(expression.get()); index != nullptr) {
+            fuse(index->array);
+            fuse(index->index);
+            return;
+        }
+        if(auto assignment = dynamic_cast<Index_Assignment*>(expression.get()); assignment != nullptr) {
+            fuse(assignment->index);
+            fuse(assignment->value);
+            return;
+        }
+        if(auto assignment = dynamic_cast<Assignment*>(expression.get()); assignment != nullptr) {
+            auto value = dynamic_cast<Binary_Operation*>(assignment->value.get());
+            if(value != nullptr && is_arithmetic(value->operator_.type)) {
+                auto identifier = match_identifier_literal(*value);
+                if(identifier != nullptr && identifier->name.value == assignment->name.value) {
+                    auto& literal = static_cast<Literal&>(*value->right);
+                    expression = std::make_unique<Compound_Assignment>(assignment->name, value->operator_,
+                            std::move(literal.value));
+                    count(Fused_Pattern::COMPOUND_ASSIGNMENT);
+                    return;
+                }
+            }
+            fuse(assignment->value);
+            return;
+        }
+        if(auto binary = dynamic_cast<Binary_Operation*>(expression.get()); binary != nullptr) {
+            if(auto identifier = match_identifier_literal(*binary); identifier != nullptr) {
+                auto& literal = static_cast<Literal&>(*binary->right);
+                if(is_comparison(binary->operator_.type)) {
+                    expression = std::make_unique<Compare_Identifier_Literal>(identifier->name, binary->operator_,
+                            std::move(literal.value));
+                    count(Fused_Pattern::COMPARE_IDENTIFIER_LITERAL);
+                    return;
+                }
+                if(is_arithmetic(binary->operator_.type)) {
+                    expression = std::make_unique<Arithmetic_Identifier_Literal>(identifier->name,
+                            binary->operator_, std::move(literal.value));
+                    count(Fused_Pattern::ARITHMETIC_IDENTIFIER_LITERAL);
+                    return;
+                }
+            }
+            fuse(binary->left);
+            fuse(binary->right);
+            return;
+        }
+    }
+
+    void Fusion_Pass::count(const Fused_Pattern pattern) noexcept {
+        ++_rewrites[static_cast<std::size_t>(pattern)];
+    }
+
+}
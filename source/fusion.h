@@ -0,0 +1,45 @@
+#ifndef LYNX_FUSION_H
+#define LYNX_FUSION_H
+
+#include <array>
+#include <vector>
+
+#include "statement.h"
+
+namespace lynx {
+
+    enum class Fused_Pattern {
+        COMPARE_IDENTIFIER_LITERAL,
+        ARITHMETIC_IDENTIFIER_LITERAL,
+        COMPOUND_ASSIGNMENT,
+        IF_COMPARE,
+        COUNT
+    };
+
+    const char* to_string(const Fused_Pattern pattern) noexcept;
+
+    // One counter per Fused_Pattern.
+    using Fusion_Counters = std::array<std::size_t, static_cast<std::size_t>(Fused_Pattern::COUNT)>;
+
+    // Fusion_Pass runs after parsing and rewrites the few node shapes that dominate typical scripts into
+    // superinstructions (see the end of expression.h and statement.h), which the Interpreter runs in a single visit
+    // instead of one per operand.
+    class Fusion_Pass {
+    public:
+        void fuse(std::vector<Statement_Ptr>& statements);
+
+        // How many times each pattern has been rewritten so far.
+        const Fusion_Counters& rewrites() const noexcept;
+
+    private:
+        void fuse(Statement_Ptr& statement);
+        void fuse(Expr_Ptr& expression);
+
+        void count(const Fused_Pattern pattern) noexcept;
+
+        Fusion_Counters _rewrites{};
+    };
+
+}
+
+#endif //LYNX_FUSION_H
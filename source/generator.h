@@ -0,0 +1,55 @@
+#ifndef LYNX_GENERATOR_H
+#define LYNX_GENERATOR_H
+
+#include <memory>
+#include <vector>
+
+#include "environment.h"
+#include "file.h"
+#include "statement.h"
+
+namespace lynx {
+
+    // Generator is a suspended call of a generator function. It doesn't keep any native stack: the point of
+    // suspension is a path of cursors through the body's statements, and the locals are moved out of the
+    // environment while the generator isn't running. Resuming moves them back and continues from the innermost
+    // cursor, so the cost of a suspend/resume pair doesn't depend on how long the generator has been running.
+    // Generators made by 'lines()' and 'chunks()' have no function and take their values from a File_Reader.
+    struct Generator {
+        struct Cursor {
+            enum class Kind {
+                BLOCK, WHILE, DO_WHILE, FOR, FOR_IN
+            };
+
+            Kind             kind;
+            const Statement* statement;
+            // Index of the next statement of a block or element of a 'for in', or whether a loop's body has run
+            // at least once.
+            std::size_t      position;
+            // The array or generator a 'for in' is iterating over.
+            Value            source{Value::Type::VOID, std::monostate{}};
+        };
+
+        explicit Generator(const Function_Declaration& function)
+                : function{&function} {
+        }
+        explicit Generator(std::unique_ptr<File_Reader> reader)
+                : function{}, reader{std::move(reader)} {
+        }
+
+        bool finished() const noexcept {
+            return cursors.empty();
+        }
+
+        const Function_Declaration*  function;
+        Environment::Saved_Frame     frame;
+        std::vector<Cursor>          cursors;
+        // The last yielded value, moved out by whoever resumed the generator.
+        Value                        value{Value::Type::VOID, std::monostate{}};
+        bool                         running{false};
+        std::unique_ptr<File_Reader> reader;
+    };
+
+}
+
+#endif //LYNX_GENERATOR_H
@@ -0,0 +1,223 @@
+#include "heap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace lynx {
+
+    namespace {
+
+        struct Totals {
+            std::size_t allocations{};
+            std::size_t deallocations{};
+            std::size_t allocated_bytes{};
+            std::size_t freed_bytes{};
+            std::size_t peak_bytes{};
+        };
+
+        // Counters of one thread. Only that thread writes them, so an update is a plain load and store rather than
+        // a locked read-modify-write, and no cache line is shared between threads. They are atomics because
+        // heap_stats() reads them from other threads, relaxed since they are only ever read as a snapshot.
+        struct Thread_Counters {
+            std::atomic<std::size_t> allocations{};
+            std::atomic<std::size_t> deallocations{};
+            std::atomic<std::size_t> allocated_bytes{};
+            // Storage is often freed by another thread than the one that allocated it, so the live bytes only
+            // add up over all threads.
+            std::atomic<std::size_t> freed_bytes{};
+
+            void add_to(Totals& totals) const noexcept {
+                totals.allocations += allocations.load(std::memory_order_relaxed);
+                totals.deallocations += deallocations.load(std::memory_order_relaxed);
+                totals.allocated_bytes += allocated_bytes.load(std::memory_order_relaxed);
+                totals.freed_bytes += freed_bytes.load(std::memory_order_relaxed);
+            }
+        };
+
+        struct Thread;
+
+        // Counters of the running threads, what the others left behind when they exited, and the peak of every budget
+        // that has ended.
+        struct Registry {
+            std::mutex mutex;
+            Thread*    threads{};
+            Totals     exited;
+        };
+
+        // Never destroyed, so threads that end after static destruction can still unregister.
+        Registry& thread_registry() {
+            static const auto registry = new Registry;
+            return *registry;
+        }
+
+        // Counters of the calling thread, null once it is exiting.
+        thread_local Thread_Counters* current{};
+        thread_local bool exiting{};
+
+        // Registers the counters of a thread on its first allocation or deallocation, and folds them into the totals
+        // of the exited threads when it ends.
+        struct Thread {
+            Thread() {
+                auto& registry = thread_registry();
+                const std::lock_guard lock{registry.mutex};
+                next = std::exchange(registry.threads, this);
+                if(next != nullptr) {
+                    next->previous = this;
+                }
+                current = &counters;
+            }
+
+            Thread(const Thread&) = delete;
+            Thread& operator=(const Thread&) = delete;
+
+            ~Thread() {
+                current = nullptr;
+                exiting = true;
+                auto& registry = thread_registry();
+                const std::lock_guard lock{registry.mutex};
+                counters.add_to(registry.exited);
+                (previous != nullptr ? previous->next : registry.threads) = next;
+                if(next != nullptr) {
+                    next->previous = previous;
+                }
+            }
+
+            Thread_Counters counters;
+            Thread*         previous{};
+            Thread*         next{};
+        };
+
+        // Updates a counter of the calling thread. Values held by other thread-local objects can still be freed after
+        // the thread's counters are gone, those go straight to the totals of the exited threads.
+        void add(std::atomic<std::size_t> Thread_Counters::* counter, std::size_t Totals::* total,
+                const std::size_t amount) noexcept {
+            if(current == nullptr && !exiting) {
+                thread_local Thread thread;
+            }
+            if(current != nullptr) {
+                auto& value = current->*counter;
+                value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+                return;
+            }
+            auto& registry = thread_registry();
+            const std::lock_guard lock{registry.mutex};
+            registry.exited.*total += amount;
+        }
+
+        thread_local Heap_Budget* budget{};
+
+    }
+
+    Heap_Stats heap_stats() noexcept {
+        auto& registry = thread_registry();
+        Totals totals;
+        {
+            const std::lock_guard lock{registry.mutex};
+            totals = registry.exited;
+            for(auto thread = registry.threads; thread != nullptr; thread = thread->next) {
+                thread->counters.add_to(totals);
+            }
+        }
+        // Budgets of the calling thread that are still in force haven't handed over their peaks yet.
+        for(auto enclosing = budget; enclosing != nullptr; enclosing = enclosing->_enclosing) {
+            totals.peak_bytes = std::max(totals.peak_bytes, static_cast<std::size_t>(enclosing->_peak));
+        }
+        Heap_Stats stats;
+        stats.allocations = totals.allocations;
+        stats.deallocations = totals.deallocations;
+        stats.allocated_bytes = totals.allocated_bytes;
+        stats.live_bytes = totals.allocated_bytes - totals.freed_bytes;
+        stats.peak_bytes = totals.peak_bytes;
+        return stats;
+    }
+
+    std::ostream& operator<<(std::ostream& stream, const Heap_Stats& stats) {
+        return stream << "Heap statistics:\n"
+                << "  allocations: " << stats.allocations << " (" << stats.allocated_bytes << " bytes)\n"
+                << "  live: " << stats.live_allocations() << " (" << stats.live_bytes << " bytes)\n"
+                << "  peak: " << stats.peak_bytes << " bytes\n";
+    }
+
+    Heap_Budget::Heap_Budget(const std::size_t limit) noexcept
+            : _limit{limit}, _enclosing{std::exchange(budget, this)} {
+    }
+
+    Heap_Budget::Heap_Budget(const std::size_t limit, std::atomic<std::ptrdiff_t>& shared) noexcept
+            : _limit{limit}, _enclosing{std::exchange(budget, this)}, _shared{&shared} {
+    }
+
+    Heap_Budget::~Heap_Budget() {
+        budget = _enclosing;
+        // Budgets are rare enough to hand over their peaks under the lock.
+        auto& registry = thread_registry();
+        const std::lock_guard lock{registry.mutex};
+        registry.exited.peak_bytes = std::max(registry.exited.peak_bytes, static_cast<std::size_t>(_peak));
+    }
+
+    std::ptrdiff_t Heap_Budget::used() const noexcept {
+        return _used;
+    }
+
+    std::ptrdiff_t Heap_Budget::peak() const noexcept {
+        return _peak;
+    }
+
+    std::size_t Heap_Budget::limit() const noexcept {
+        return _limit;
+    }
+
+    std::atomic<std::ptrdiff_t>* Heap_Budget::shared() const noexcept {
+        return _shared;
+    }
+
+    const Heap_Budget* Heap_Budget::current() noexcept {
+        return budget;
+    }
+
+    void* heap_allocate(const std::size_t bytes) {
+        if(budget != nullptr) {
+            const auto amount = static_cast<std::ptrdiff_t>(bytes);
+            const auto limit = static_cast<std::ptrdiff_t>(budget->_limit);
+            // A shared budget is charged first, so that threads racing for the last bytes can't both get them.
+            const auto used = budget->_shared != nullptr
+                    ? budget->_shared->fetch_add(amount, std::memory_order_relaxed) + amount : budget->_used + amount;
+            if(used > limit) {
+                if(budget->_shared != nullptr) {
+                    budget->_shared->fetch_sub(amount, std::memory_order_relaxed);
+                }
+                throw Limit_Exceeded{"Heap limit of " + std::to_string(budget->_limit) + " bytes exceeded"};
+            }
+        }
+        auto pointer = std::malloc(bytes);
+        if(pointer == nullptr) {
+            if(budget != nullptr && budget->_shared != nullptr) {
+                budget->_shared->fetch_sub(static_cast<std::ptrdiff_t>(bytes), std::memory_order_relaxed);
+            }
+            throw std::bad_alloc{};
+        }
+        if(budget != nullptr) {
+            budget->_used += static_cast<std::ptrdiff_t>(bytes);
+            budget->_peak = std::max(budget->_peak, budget->_used);
+        }
+        add(&Thread_Counters::allocations, &Totals::allocations, 1);
+        add(&Thread_Counters::allocated_bytes, &Totals::allocated_bytes, bytes);
+        return pointer;
+    }
+
+    void heap_deallocate(void* pointer, const std::size_t bytes) noexcept {
+        if(budget != nullptr) {
+            budget->_used -= static_cast<std::ptrdiff_t>(bytes);
+            if(budget->_shared != nullptr) {
+                budget->_shared->fetch_sub(static_cast<std::ptrdiff_t>(bytes), std::memory_order_relaxed);
+            }
+        }
+        add(&Thread_Counters::deallocations, &Totals::deallocations, 1);
+        add(&Thread_Counters::freed_bytes, &Totals::freed_bytes, bytes);
+        std::free(pointer);
+    }
+
+}
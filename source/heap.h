@@ -0,0 +1,126 @@
+#ifndef LYNX_HEAP_H
+#define LYNX_HEAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "instrumentation.h"
+
+namespace lynx {
+
+    // Heap accounts for every allocation made on behalf of a script's values: strings, array elements, map
+    // entries and generators. Values share that storage through reference-counted handles, so copying a value
+    // never copies what it points to, and storage is released as soon as its last handle goes away.
+    struct Heap_Stats {
+        std::size_t allocations{};
+        std::size_t deallocations{};
+        std::size_t allocated_bytes{};
+        std::size_t live_bytes{};
+        // Highest heap held under a single Heap_Budget, see Heap_Budget::peak().
+        std::size_t peak_bytes{};
+
+        std::size_t live_allocations() const noexcept {
+            return allocations - deallocations;
+        }
+    };
+
+    // Totals of all threads since the process started. Each thread counts its own allocations, these add them up.
+    Heap_Stats heap_stats() noexcept;
+
+    std::ostream& operator<<(std::ostream& stream, const Heap_Stats& stats);
+
+    // Thrown when a script goes over one of its budgets, e.g. when an allocation would overdraw a Heap_Budget.
+    class Limit_Exceeded : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Heap_Budget caps the value heap held by the thread that creates it, while it exists: the bytes the thread
+    // allocates minus those it frees. An allocation that would take that past 'limit' throws Limit_Exceeded
+    // instead. Budgets nest, the innermost one applies. A budget also records the most it was ever used, which is
+    // the only peak the heap keeps: tracking one for the whole process would put a shared counter on every allocation.
+    class Heap_Budget {
+    public:
+        static constexpr std::size_t UNLIMITED = PTRDIFF_MAX;
+
+        explicit Heap_Budget(const std::size_t limit) noexcept;
+        // Budgets of several threads can share one limit, e.g. the chunks of a 'parallel for': each also charges
+        // 'shared', and it is the bytes they hold together that may not go past 'limit'.
+        Heap_Budget(const std::size_t limit, std::atomic<std::ptrdiff_t>& shared) noexcept;
+        Heap_Budget(const Heap_Budget&) = delete;
+        Heap_Budget& operator=(const Heap_Budget&) = delete;
+        ~Heap_Budget();
+
+        // Can be negative if the thread frees storage allocated before the budget was created.
+        std::ptrdiff_t used() const noexcept;
+        std::ptrdiff_t peak() const noexcept;
+        std::size_t limit() const noexcept;
+        // Null unless the budget shares its limit.
+        std::atomic<std::ptrdiff_t>* shared() const noexcept;
+
+        // Innermost budget of the calling thread, if any.
+        static const Heap_Budget* current() noexcept;
+
+    private:
+        friend Heap_Stats heap_stats() noexcept;
+        friend void* heap_allocate(const std::size_t bytes);
+        friend void heap_deallocate(void* pointer, const std::size_t bytes) noexcept;
+
+        std::size_t    _limit;
+        std::ptrdiff_t _used{};
+        std::ptrdiff_t _peak{};
+        Heap_Budget*   _enclosing;
+        std::atomic<std::ptrdiff_t>* _shared{};
+    };
+
+    void* heap_allocate(const std::size_t bytes);
+    void heap_deallocate(void* pointer, const std::size_t bytes) noexcept;
+
+    // Standard allocator that goes through heap_allocate, for the containers inside values.
+    template<typename T>
+    struct Heap_Allocator {
+        using value_type = T;
+
+        Heap_Allocator() noexcept = default;
+
+        template<typename U>
+        Heap_Allocator(const Heap_Allocator<U>&) noexcept {
+        }
+
+        T* allocate(const std::size_t n) {
+            if constexpr(std::is_same_v<T, char>) {
+                LYNX_COUNT(STRING_ALLOCATIONS);
+            }
+            return static_cast<T*>(heap_allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T* pointer, const std::size_t n) noexcept {
+            heap_deallocate(pointer, n * sizeof(T));
+        }
+
+        template<typename U>
+        bool operator==(const Heap_Allocator<U>&) const noexcept {
+            return true;
+        }
+
+        template<typename U>
+        bool operator!=(const Heap_Allocator<U>&) const noexcept {
+            return false;
+        }
+    };
+
+    // std::make_shared for values' storage: the object and its reference counts are one accounted allocation.
+    template<typename T, typename... Args>
+    std::shared_ptr<T> make_managed(Args&&... args) {
+        return std::allocate_shared<T>(Heap_Allocator<T>{}, std::forward<Args>(args)...);
+    }
+
+}
+
+#endif //LYNX_HEAP_H
@@ -0,0 +1,101 @@
+#include "instrumentation.h"
+
+namespace lynx {
+
+    std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(Counter::COUNT)> counters{};
+
+    const char* to_string(const Counter counter) noexcept {
+        switch(counter) {
+            case Counter::BLOCK:
+                return "block";
+            case Counter::EXPRESSION:
+                return "expression";
+            case Counter::FUNCTION_DECLARATION:
+                return "function_declaration";
+            case Counter::VARIABLE_DECLARATION:
+                return "variable_declaration";
+            case Counter::IF:
+                return "if";
+            case Counter::FOR:
+                return "for";
+            case Counter::FOR_IN:
+                return "for_in";
+            case Counter::PARALLEL_FOR:
+                return "parallel_for";
+            case Counter::WHILE:
+                return "while";
+            case Counter::DO_WHILE:
+                return "do_while";
+            case Counter::PRINT:
+                return "print";
+            case Counter::RETURN:
+                return "return";
+            case Counter::YIELD:
+                return "yield";
+            case Counter::IF_COMPARE:
+                return "if_compare";
+            case Counter::LITERAL:
+                return "literal";
+            case Counter::IDENTIFIER:
+                return "identifier";
+            case Counter::UNARY:
+                return "unary";
+            case Counter::BINARY:
+                return "binary";
+            case Counter::ASSIGNMENT:
+                return "assignment";
+            case Counter::CALL:
+                return "call";
+            case Counter::ARRAY_LITERAL:
+                return "array_literal";
+            case Counter::MAP_LITERAL:
+                return "map_literal";
+            case Counter::INDEX:
+                return "index";
+            case Counter::INDEX_ASSIGNMENT:
+                return "index_assignment";
+            case Counter::COMPARE_IDENTIFIER_LITERAL:
+                return "compare_identifier_literal";
+            case Counter::ARITHMETIC_IDENTIFIER_LITERAL:
+                return "arithmetic_identifier_literal";
+            case Counter::COMPOUND_ASSIGNMENT:
+                return "compound_assignment";
+            case Counter::VALUE_COPIES:
+                return "value_copies";
+            case Counter::STRING_ALLOCATIONS:
+                return "string_allocations";
+            case Counter::ENVIRONMENT_LOOKUPS:
+                return "environment_lookups";
+            case Counter::ENVIRONMENT_PROBES:
+                return "environment_probes";
+            case Counter::EXCEPTIONS:
+                return "exceptions";
+            case Counter::COUNT:
+                break;
+        }
+        return "unknown";
+    }
+
+    std::uint64_t counter(const Counter which) noexcept {
+        return counters[static_cast<std::size_t>(which)].load(std::memory_order_relaxed);
+    }
+
+    // Node kinds are grouped under "statements" and "expressions"; everything else is a member of its own.
+    void write_counters_json(std::ostream& stream) {
+        const auto write_range = [&stream](const Counter first, const Counter end, const char* indent) {
+            for(auto i = static_cast<std::size_t>(first); i < static_cast<std::size_t>(end); ++i) {
+                const auto which = static_cast<Counter>(i);
+                stream << indent << '"' << to_string(which) << "\": " << counter(which)
+                        << (i + 1 < static_cast<std::size_t>(end) ? ",\n" : "\n");
+            }
+        };
+        stream << "{\n  \"statements\": {\n";
+        write_range(Counter::BLOCK, Counter::LITERAL, "    ");
+        stream << "  },\n  \"expressions\": {\n";
+        write_range(Counter::LITERAL, Counter::VALUE_COPIES, "    ");
+        stream << "  },\n";
+        write_range(Counter::VALUE_COPIES, Counter::COUNT, "  ");
+        stream << "}\n";
+    }
+
+}
@@ -0,0 +1,75 @@
+#ifndef LYNX_INSTRUMENTATION_H
+#define LYNX_INSTRUMENTATION_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+namespace lynx {
+
+    // Counters of the interpreter's hot paths, kept only in builds with LYNX_DEBUG=1 (the Debug build). In
+    // every other build LYNX_COUNT and LYNX_COUNT_N expand to nothing and their arguments aren't evaluated.
+    enum class Counter {
+        // Statements executed, by kind.
+        BLOCK,
+        EXPRESSION,
+        FUNCTION_DECLARATION,
+        VARIABLE_DECLARATION,
+        IF,
+        FOR,
+        FOR_IN,
+        PARALLEL_FOR,
+        WHILE,
+        DO_WHILE,
+        PRINT,
+        RETURN,
+        YIELD,
+        IF_COMPARE,
+        // Expressions evaluated, by kind.
+        LITERAL,
+        IDENTIFIER,
+        UNARY,
+        BINARY,
+        ASSIGNMENT,
+        CALL,
+        ARRAY_LITERAL,
+        MAP_LITERAL,
+        INDEX,
+        INDEX_ASSIGNMENT,
+        COMPARE_IDENTIFIER_LITERAL,
+        ARITHMETIC_IDENTIFIER_LITERAL,
+        COMPOUND_ASSIGNMENT,
+        // Copies of a Value, by construction or assignment. Moves aren't counted.
+        VALUE_COPIES,
+        // New string values, and every buffer allocated for their characters.
+        STRING_ALLOCATIONS,
+        // Variables looked up in the Environment, and how many symbols those lookups compared.
+        ENVIRONMENT_LOOKUPS,
+        ENVIRONMENT_PROBES,
+        // Exceptions caught by the lexer, the parser and the interpreter.
+        EXCEPTIONS,
+        COUNT
+    };
+
+    const char* to_string(const Counter counter) noexcept;
+
+    // Totals of every thread since the process started.
+    extern std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(Counter::COUNT)> counters;
+
+    std::uint64_t counter(const Counter which) noexcept;
+    // One JSON object with a member for every counter.
+    void write_counters_json(std::ostream& stream);
+
+}
+
+#if LYNX_DEBUG
+#define LYNX_COUNT_N(counter, n) \
+        ::lynx::counters[static_cast<std::size_t>(::lynx::Counter::counter)].fetch_add((n), std::memory_order_relaxed)
+#else
+#define LYNX_COUNT_N(counter, n) static_cast<void>(0)
+#endif
+
+#define LYNX_COUNT(counter) LYNX_COUNT_N(counter, 1)
+
+#endif //LYNX_INSTRUMENTATION_H
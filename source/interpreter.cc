@@ -1,32 +1,461 @@
 #include "interpreter.h"
 
-#include <iostream>
+#include <algorithm>
+#include <climits>
+#include <limits>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "array.h"
+#include "big_integer.h"
+#include "instrumentation.h"
+#include "map.h"
+
+#include "thread_pool.h"
 
 namespace lynx {
 
-    Interpreter::Interpreter(const std::vector<Statement_Ptr>& statements)
-            : _statements{statements} {
+    namespace {
+
+        // Upper bound on the number of chunks a 'parallel for' is split into. The split depends only on the size
+        // of the range, never on the number of threads, so reductions and output come out the same everywhere.
+        constexpr unsigned long long PARALLEL_CHUNKS = 64;
+
+        // Steps between two checks of the time limit.
+        constexpr std::uint64_t CHECK_INTERVAL = 4096;
+
+        Value default_value(const std::string& type) {
+            if(type == "int") {
+                return Value{Value::Type::INTEGER, 0LL};
+            }
+            if(type == "float") {
+                return Value{Value::Type::FLOAT, 0.0L};
+            }
+            if(type == "bool") {
+                return Value{Value::Type::BOOL, false};
+            }
+            if(type == "string") {
+                return make_string({});
+            }
+            if(const auto element = element_type(type); element != Value::Type::VOID) {
+                return Value{Value::Type::ARRAY, make_managed<Array>(element)};
+            }
+            if(const auto [key, value] = map_types(type); key != Value::Type::VOID) {
+                return Value{Value::Type::MAP, make_managed<Map>(key, value)};
+            }
+            throw std::runtime_error{"Unknown type '" + type + "'"};
+        }
+
+        long long to_index(const Value& index) {
+            if(index.type != Value::Type::INTEGER) {
+                throw std::runtime_error{"Array index has to be an 'int'"};
+            }
+            return small_integer(index);
+        }
+
+        const Array& to_array(const Value& value) {
+            if(value.type != Value::Type::ARRAY) {
+                throw std::runtime_error{"Only arrays and maps can be indexed"};
+            }
+            return *std::get<std::shared_ptr<Array>>(value.data);
+        }
+
+        Value load(const Value& source, const Value& key, const std::optional<std::uint64_t>& key_hash) {
+            if(source.type == Value::Type::MAP) {
+                const auto& map = *std::get<std::shared_ptr<Map>>(source.data);
+                return key_hash ? map.load(key, *key_hash) : map.load(key);
+            }
+            return to_array(source).load(to_index(key));
+        }
+
+        void check_iterable(const Value& value) {
+            if(value.type != Value::Type::ARRAY && value.type != Value::Type::MAP
+                    && value.type != Value::Type::GENERATOR) {
+                throw std::runtime_error{"Only arrays, maps and generators can be iterated by 'for in'"};
+            }
+        }
+
+        // Map of a value that is about to be written to, copied first if it is shared.
+        Map& writable_map(Value& value) {
+            auto& map = std::get<std::shared_ptr<Map>>(value.data);
+            if(map.use_count() > 1) {
+                map = make_managed<Map>(*map);
+            }
+            return *map;
+        }
+
+        // '{}' and 'map(n)' have no entries to take their types from, so they get those of their destination.
+        void type_empty_map(Value& value, const Value::Type key_type, const Value::Type value_type) {
+            if(std::get<std::shared_ptr<Map>>(value.data)->key_type() == Value::Type::VOID
+                    && key_type != Value::Type::VOID) {
+                writable_map(value).set_types(key_type, value_type);
+            }
+        }
+
+        // Whether 'value' is of the declared 'type', of which 'value_type' is the kind. As in a variable declaration,
+        // an empty array or map takes the declared type.
+        bool has_type(Value& value, const std::string& type, const Value::Type value_type) {
+            if(value.type != value_type) {
+                return false;
+            }
+            if(value_type == Value::Type::ARRAY) {
+                if(to_array(value).size() == 0) {
+                    value = default_value(type);
+                    return true;
+                }
+                return type_name(to_array(value)) == type;
+            }
+            if(value_type == Value::Type::MAP) {
+                const auto [key, element] = map_types(type);
+                type_empty_map(value, key, element);
+                return type_name(*std::get<std::shared_ptr<Map>>(value.data)) == type;
+            }
+            return true;
+        }
+
+        [[noreturn]] void wrong_argument(const Parameter& parameter, const Function_Declaration& function) {
+            throw std::runtime_error{"Argument '" + parameter.name + "' of '" + function.name.value
+                    + "' has to be of type '" + parameter.type + "'"};
+        }
+
+        [[noreturn]] void wrong_return(const Function_Declaration& function) {
+            throw std::runtime_error{"'" + function.name.value + "' has to return a value of type '"
+                    + function.return_type + "'"};
+        }
+
+        // Scalars only need their kind compared, which is all a call pays for them.
+        bool is_scalar(const Value::Type type) noexcept {
+            return type != Value::Type::ARRAY && type != Value::Type::MAP;
+        }
+
+        void check_argument(Value& argument, const Parameter& parameter, const Function_Declaration& function) {
+            if(argument.type == parameter.value_type && is_scalar(argument.type)) {
+                return;
+            }
+            if(!has_type(argument, parameter.type, parameter.value_type)) {
+                wrong_argument(parameter, function);
+            }
+        }
+
+        void check_return(Value& value, const Function_Declaration& function) {
+            if(function.returns == Value::Type::VOID || (value.type == function.returns && is_scalar(value.type))) {
+                return;
+            }
+            if(!has_type(value, function.return_type, function.returns)) {
+                wrong_return(function);
+            }
+        }
+
+        template<typename T>
+        bool compare(const T left, const Token::Type operator_, const T right) {
+            switch(operator_) {
+                case Token::Type::EQUALS_EQUALS:
+                    return left == right;
+                case Token::Type::BANG_EQUALS:
+                    return left != right;
+                case Token::Type::LESS:
+                    return left < right;
+                case Token::Type::LESS_EQUALS:
+                    return left <= right;
+                case Token::Type::GREATER:
+                    return left > right;
+                case Token::Type::GREATER_EQUALS:
+                    return left >= right;
+                default:
+                    throw std::runtime_error{"Should never reach this point."};
+            }
+        }
+
+        bool compare(const Value& left, const Token::Type operator_, const Value& right) {
+            if(left.type != right.type) {
+                throw std::runtime_error{"Incompatible operands in binary operation"};
+            }
+            if(left.type == Value::Type::INTEGER) {
+                const auto small_left = std::get_if<long long>(&left.data);
+                const auto small_right = std::get_if<long long>(&right.data);
+                if(small_left != nullptr && small_right != nullptr) {
+                    return compare(*small_left, operator_, *small_right);
+                }
+                return compare(compare_integers(left, right), operator_, 0);
+            }
+            if(left.type == Value::Type::FLOAT) {
+                return compare(std::get<long double>(left.data), operator_, std::get<long double>(right.data));
+            }
+            if(operator_ == Token::Type::EQUALS_EQUALS) {
+                return std::get<bool>((left == right).data);
+            }
+            if(operator_ == Token::Type::BANG_EQUALS) {
+                return std::get<bool>((left != right).data);
+            }
+            throw Incompatible_Value_Types{};
+        }
+
+        template<typename T>
+        T apply_arithmetic(const T left, const Token::Type operator_, const T right) {
+            switch(operator_) {
+                case Token::Type::PLUS:
+                    return left + right;
+                case Token::Type::MINUS:
+                    return left - right;
+                case Token::Type::STAR:
+                    return left * right;
+                case Token::Type::SLASH:
+                    return left / right;
+                default:
+                    throw std::runtime_error{"Should never reach this point."};
+            }
+        }
+
+        // 'left <operator> right' on 'long long's, unless it overflows or divides by zero. Those are left to the
+        // operators of Value, which promote the result to a Big_Integer or report the error.
+        bool apply_checked_arithmetic(const long long left, const Token::Type operator_, const long long right,
+                long long& result) {
+            switch(operator_) {
+                case Token::Type::PLUS:
+                    return !__builtin_add_overflow(left, right, &result);
+                case Token::Type::MINUS:
+                    return !__builtin_sub_overflow(left, right, &result);
+                case Token::Type::STAR:
+                    return !__builtin_mul_overflow(left, right, &result);
+                case Token::Type::SLASH:
+                    if(right == 0 || (left == LLONG_MIN && right == -1)) {
+                        return false;
+                    }
+                    result = left / right;
+                    return true;
+                default:
+                    throw std::runtime_error{"Should never reach this point."};
+            }
+        }
+
+        Value apply_binary(const Value& left, const Token::Type operator_, const Value& right) {
+            if(left.type != right.type) {
+                throw std::runtime_error{"Incompatible operands in binary operation"};
+            }
+            switch(operator_) {
+                case Token::Type::PLUS:
+                    return left + right;
+                case Token::Type::MINUS:
+                    return left - right;
+                case Token::Type::STAR:
+                    return left * right;
+                case Token::Type::SLASH:
+                    return left / right;
+                case Token::Type::EQUALS_EQUALS:
+                    return left == right;
+                case Token::Type::BANG_EQUALS:
+                    return left != right;
+                case Token::Type::LESS:
+                    return left < right;
+                case Token::Type::LESS_EQUALS:
+                    return left <= right;
+                case Token::Type::GREATER:
+                    return left > right;
+                case Token::Type::GREATER_EQUALS:
+                    return left >= right;
+                default:
+                    throw std::runtime_error{"Should never reach this point."};
+            }
+        }
+
+        // Applies 'left = left <operator> right' in place, without copying 'left'.
+        void apply_arithmetic_in_place(Value& left, const Token::Type operator_, const Value& right) {
+            if(left.type != right.type) {
+                throw std::runtime_error{"Incompatible operands in binary operation"};
+            }
+            if(left.type == Value::Type::INTEGER) {
+                const auto small_left = std::get_if<long long>(&left.data);
+                const auto small_right = std::get_if<long long>(&right.data);
+                long long result;
+                if(small_left != nullptr && small_right != nullptr
+                        && apply_checked_arithmetic(*small_left, operator_, *small_right, result)) {
+                    *small_left = result;
+                    return;
+                }
+                left = apply_binary(left, operator_, right);
+                return;
+            }
+            if(left.type == Value::Type::FLOAT) {
+                auto& data = std::get<long double>(left.data);
+                data = apply_arithmetic(data, operator_, std::get<long double>(right.data));
+                return;
+            }
+            if(left.type == Value::Type::STRING && operator_ == Token::Type::PLUS) {
+                auto& string = std::get<std::shared_ptr<String>>(left.data);
+                if(string.use_count() > 1) {
+                    LYNX_COUNT(STRING_ALLOCATIONS);
+                    string = make_managed<String>(*string);
+                }
+                *string += string_of(right);
+                return;
+            }
+            throw Incompatible_Value_Types{};
+        }
+
+    }
+
+    // Slices shrink as the budget runs out, so a chunk can't sit on steps that another one still needs. Once there
+    // are none left, a chunk goes on one step at a time while the others hold more than it has borrowed: steps
+    // they don't get to use pay for those. The run is certainly over its limit only when they hold no more.
+    std::uint64_t Interpreter::Parallel_Budget::take_steps(const std::uint64_t used, bool& borrowed) noexcept {
+        if(!borrowed) {
+            held.fetch_sub(used, std::memory_order_relaxed);
+        }
+        auto left = steps.load(std::memory_order_relaxed);
+        while(left > 0) {
+            const auto slice = std::clamp<std::uint64_t>(left / PARALLEL_CHUNKS, 1, CHECK_INTERVAL);
+            if(steps.compare_exchange_weak(left, left - slice, std::memory_order_relaxed)) {
+                held.fetch_add(slice, std::memory_order_relaxed);
+                borrowed = false;
+                return slice;
+            }
+        }
+        auto borrowing = credit.load(std::memory_order_relaxed);
+        do {
+            if(borrowing >= held.load(std::memory_order_relaxed)) {
+                return 0;
+            }
+        } while(!credit.compare_exchange_weak(borrowing, borrowing + 1, std::memory_order_relaxed));
+        borrowed = true;
+        return 1;
+    }
+
+    // Unused steps pay back what was borrowed first.
+    void Interpreter::Parallel_Budget::return_steps(const std::uint64_t slice, const std::uint64_t unused,
+            const bool borrowed) noexcept {
+        if(borrowed) {
+            credit.fetch_sub(unused, std::memory_order_relaxed);
+            return;
+        }
+        held.fetch_sub(slice, std::memory_order_relaxed);
+        auto owed = credit.load(std::memory_order_relaxed);
+        std::uint64_t repaid{};
+        do {
+            repaid = std::min(owed, unused);
+        } while(!credit.compare_exchange_weak(owed, owed - repaid, std::memory_order_relaxed));
+        steps.fetch_add(unused - repaid, std::memory_order_relaxed);
+    }
+
+    Interpreter::Interpreter(Output_Buffer& output)
+            : _output{output} {
+        _call_stack.reserve(64);
+        _arguments.reserve(64);
+    }
+
+    Run_Result Interpreter::run(const Program& program) {
+        return run(program, 0, program.statements().size(), nullptr, nullptr);
+    }
+
+    Run_Result Interpreter::run_to_snapshot(const Program& program, Snapshot& snapshot) {
+        if(program.snapshot_point() == Program::NO_SNAPSHOT) {
+            return Run_Result{Run_Result::Status::RUNTIME_ERROR, "The script has no 'snapshot()'"};
+        }
+        return run(program, 0, program.snapshot_point(), &snapshot, nullptr);
+    }
+
+    Run_Result Interpreter::run_from_snapshot(const Program& program, const Snapshot& snapshot) {
+        if(program.snapshot_point() == Program::NO_SNAPSHOT || snapshot.source_hash != program.source_hash()) {
+            return Run_Result{Run_Result::Status::RUNTIME_ERROR, "The snapshot wasn't taken of this script"};
+        }
+        return run(program, program.snapshot_point() + 1, program.statements().size(), nullptr, &snapshot);
     }
 
-    bool Interpreter::interpret() {
+    Run_Result Interpreter::run(const Program& program, const std::size_t begin, const std::size_t end,
+            Snapshot* save, const Snapshot* restore) {
+        Run_Result result;
+        start_limits(_limits);
+        std::optional<Heap_Budget> heap_budget;
+        if(_limits.heap_bytes > 0) {
+            heap_budget.emplace(_limits.heap_bytes);
+        }
         try {
-            for(const auto& statement : _statements) {
-                execute(*statement);
+            if(restore != nullptr) {
+                // Names are borrowed from the snapshot, which outlives the run.
+                for(const auto& global : restore->globals) {
+                    _environment.define(global.name, global.value);
+                }
+            } else if(begin == 0) {
+                // A restored run starts after the modules, their globals are in the snapshot.
+                for(const auto& module : program.modules()) {
+                    for(const auto& statement : module->statements) {
+                        execute(*statement);
+                    }
+                }
+            }
+            for(auto i = begin; i < end; ++i) {
+                execute(*program.statements()[i]);
+            }
+            if(save != nullptr) {
+                save->source_hash = program.source_hash();
+                save->globals.clear();
+                auto globals = _environment.visible();
+                // visible() lists the innermost binding first.
+                for(auto global = globals.rbegin(); global != globals.rend(); ++global) {
+                    if(global->value.type == Value::Type::GENERATOR) {
+                        throw std::runtime_error{"Generator '" + std::string{global->name}
+                                + "' can't be stored in a snapshot"};
+                    }
+                    save->globals.push_back(Snapshot::Global{std::string{global->name}, std::move(global->value)});
+                }
             }
+        } catch(const Limit_Exceeded& e) {
+            LYNX_COUNT(EXCEPTIONS);
+            result.status = Run_Result::Status::LIMIT_EXCEEDED;
+            result.error = e.what();
         } catch(const std::runtime_error& e) {
-            std::cout << "Error: " << e.what() << ".\n";
-            return false;
+            LYNX_COUNT(EXCEPTIONS);
+            result.status = Run_Result::Status::RUNTIME_ERROR;
+            result.error = e.what();
+        } catch(const std::bad_alloc&) {
+            // A script must not take down the process, which may be running others.
+            LYNX_COUNT(EXCEPTIONS);
+            result.status = Run_Result::Status::RUNTIME_ERROR;
+            result.error = "Out of memory";
+        } catch(const std::length_error&) {
+            LYNX_COUNT(EXCEPTIONS);
+            result.status = Run_Result::Status::RUNTIME_ERROR;
+            result.error = "Value too large to allocate";
         }
-        return true;
+        heap_budget.reset();
+        // Symbol names point into the program's AST, so nothing may outlive the run.
+        reset();
+        return result;
+    }
+
+    void Interpreter::set_max_call_depth(const std::size_t max_call_depth) noexcept {
+        _max_call_depth = max_call_depth;
+    }
+
+    void Interpreter::set_limits(const Limits& limits) noexcept {
+        _limits = limits;
+    }
+
+    void Interpreter::set_profiler(Profiler* profiler) noexcept {
+        _profiler = profiler;
+    }
+
+    const Fusion_Counters& Interpreter::fusion_counters() const noexcept {
+        return _fusion_counters;
     }
 
     void Interpreter::execute(Statement& expression) {
+        if(_profiler == nullptr) {
+            expression.accept(*this);
+            return;
+        }
+        const auto line = _profiler->enter_line(expression.line);
         expression.accept(*this);
+        _profiler->leave_line(line);
     }
 
     void Interpreter::execute_block(const Block& block) {
         for(const auto& statement : block.statements) {
             execute(*statement);
+            if(_control != Control::NORMAL) {
+                return;
+            }
         }
     }
 
@@ -34,33 +463,63 @@ namespace lynx {
         return expression->accept(*this);
     }
 
+    const Value& Interpreter::read(const Expr_Ptr& expression, Value& slot) {
+        return expression->read(*this, slot);
+    }
+
+    void Interpreter::discard(const Expr_Ptr& expression) {
+        _discarded = expression.get();
+        expression->accept(*this);
+    }
+
     void Interpreter::visit_expression(const Expression& expression) {
-        const auto result = evaluate(expression.expression);
+        LYNX_COUNT(EXPRESSION);
+        discard(expression.expression);
     }
 
     void Interpreter::visit_block(const Block& block) {
-        for(const auto& statement : block.statements) {
-            execute(*statement);
-        }
+        LYNX_COUNT(BLOCK);
+        _environment.push_scope();
+        execute_block(block);
+        _environment.pop_scope();
     }
 
-    void Interpreter::visit_function_declaration(const Function_Declaration& function_declaration) {
+    void Interpreter::visit_function_declaration(const Function_Declaration&) {
+        LYNX_COUNT(FUNCTION_DECLARATION);
+        // Functions are bound to their calls by the Resolver, there is nothing to do at runtime.
     }
 
     void Interpreter::visit_variable_declaration(const Variable_Declaration& variable_declaration) {
-        _environment.define(variable_declaration.identifier, evaluate(variable_declaration.initializer));
+        LYNX_COUNT(VARIABLE_DECLARATION);
+        if(variable_declaration.initializer == nullptr) {
+            _environment.define(variable_declaration.identifier, default_value(variable_declaration.type));
+            return;
+        }
+        auto value = evaluate(variable_declaration.initializer);
+        // '[]' has no elements to take a type from, so it gets the declared one.
+        if(value.type == Value::Type::ARRAY && to_array(value).size() == 0) {
+            value = default_value(variable_declaration.type);
+        } else if(value.type == Value::Type::MAP) {
+            const auto [key, element] = map_types(variable_declaration.type);
+            type_empty_map(value, key, element);
+        }
+        _environment.define(variable_declaration.identifier, std::move(value));
     }
 
     void Interpreter::visit_if(const If& if_stmt) {
+        LYNX_COUNT(IF);
         bool execute_then_block = false;
-        auto condition_result = evaluate(if_stmt.condition);
-        if(is_truthy(condition_result)) {
+        Value slot;
+        if(is_truthy(read(if_stmt.condition, slot))) {
             execute_then_block = true;
         }
         if(execute_then_block) {
             execute(*if_stmt.then_block);
             return;
         }
+        if(if_stmt.else_block == nullptr) {
+            return;
+        }
         if(dynamic_cast<Block*>(if_stmt.else_block.get()) != nullptr
                 || dynamic_cast<If*>(if_stmt.else_block.get()) != nullptr) {
             execute(*if_stmt.else_block);
@@ -70,49 +529,270 @@ namespace lynx {
     }
 
     void Interpreter::visit_for(const For& for_stmt) {
+        LYNX_COUNT(FOR);
+        if(for_stmt.init_statement != nullptr) {
+            discard(for_stmt.init_statement);
+        }
+        Value slot;
+        while(is_truthy(read(for_stmt.condition, slot))) {
+            step();
+            execute(*for_stmt.block);
+            if(_control != Control::NORMAL) {
+                return;
+            }
+            discard(for_stmt.iteration_expression);
+        }
+    }
+
+    void Interpreter::visit_for_in(const For_In& for_in) {
+        LYNX_COUNT(FOR_IN);
+        const auto source = evaluate(for_in.iterable);
+        check_iterable(source);
+        _environment.push_scope();
+        _environment.define(for_in.variable.value, Value{Value::Type::VOID, std::monostate{}});
+        std::size_t position = 0;
+        Value element{Value::Type::VOID, std::monostate{}};
+        // Resuming a generator grows the environment, so the variable can only be looked up afterwards.
+        while(next_element(source, position, element)) {
+            _environment.lookup(for_in.variable.value) = std::move(element);
+            step();
+            execute(*for_in.block);
+            if(_control != Control::NORMAL) {
+                break;
+            }
+        }
+        _environment.pop_scope();
+    }
+
+    void Interpreter::visit_parallel_for(const Parallel_For& parallel_for) {
+        LYNX_COUNT(PARALLEL_FOR);
+        const auto begin = evaluate(parallel_for.begin);
+        const auto end = evaluate(parallel_for.end);
+        if(begin.type != Value::Type::INTEGER || end.type != Value::Type::INTEGER) {
+            throw std::runtime_error{"Range of 'parallel for' has to be 'int'"};
+        }
+        const auto first = small_integer(begin);
+        const auto last = small_integer(end);
+        if(last <= first) {
+            return;
+        }
+        step();
+        if(_parallel_budget == nullptr && _budget.steps > 0 && steps_taken() >= _budget.steps) {
+            throw Limit_Exceeded{"Step limit of " + std::to_string(_budget.steps) + " exceeded"};
+        }
+        // A nested 'parallel for' keeps drawing from the budget of the outermost one.
+        Parallel_Budget own_budget;
+        auto& shared = _parallel_budget != nullptr ? *_parallel_budget : own_budget;
+        if(_parallel_budget == nullptr) {
+            if(_budget.steps > 0) {
+                own_budget.steps = _budget.steps - steps_taken();
+            }
+            if(const auto heap = Heap_Budget::current(); _budget.heap_bytes > 0 && heap != nullptr) {
+                own_budget.heap_bytes = std::max<std::ptrdiff_t>(heap->used(), 0);
+            }
+        }
+        const auto iterations = static_cast<unsigned long long>(last) - static_cast<unsigned long long>(first);
+        const auto chunk_count = std::min(iterations, PARALLEL_CHUNKS);
+        const auto bindings = _environment.visible();
+        std::vector<Parallel_Chunk> chunks(chunk_count);
+        auto& pool = Thread_Pool::shared();
+        Task_Group group;
+        auto chunk_begin = first;
+        for(unsigned long long i = 0; i < chunk_count; ++i) {
+            const auto length = iterations / chunk_count + (i < iterations % chunk_count ? 1 : 0);
+            const auto chunk_end = static_cast<long long>(static_cast<unsigned long long>(chunk_begin) + length);
+            pool.submit(group, [this, &parallel_for, chunk_begin, chunk_end, &bindings, &shared,
+                    &chunk = chunks[i]] {
+                run_chunk(parallel_for, chunk_begin, chunk_end, bindings, shared, chunk);
+            });
+            chunk_begin = chunk_end;
+        }
+        pool.wait(group);
+        // The chunks' steps count as this run's. The countdown starts over, so the next step checks the limit.
+        auto steps = steps_taken();
+        for(const auto& chunk : chunks) {
+            steps += chunk.steps;
+        }
+        if(_parallel_budget != nullptr && _budget.steps > 0) {
+            _parallel_budget->return_steps(_slice, _countdown, _borrowed);
+        }
+        _steps = steps;
+        _slice = 0;
+        _countdown = 0;
+        _borrowed = false;
+        // Only the outermost loop knows whether what the chunks borrowed was paid for.
+        if(_parallel_budget == nullptr && _budget.steps > 0 && steps > _budget.steps) {
+            throw Limit_Exceeded{"Step limit of " + std::to_string(_budget.steps) + " exceeded"};
+        }
+        for(auto& chunk : chunks) {
+            if(chunk.limit_exceeded) {
+                throw Limit_Exceeded{chunk.error};
+            }
+            if(!chunk.error.empty()) {
+                throw std::runtime_error{chunk.error};
+            }
+            _output << chunk.output;
+            for(std::size_t i = 0; i < _fusion_counters.size(); ++i) {
+                _fusion_counters[i] += chunk.fusion_counters[i];
+            }
+            for(std::size_t i = 0; i < parallel_for.reductions.size(); ++i) {
+                auto& target = _environment.lookup(parallel_for.reductions[i].variable.value);
+                const auto& partial = chunk.reductions[i];
+                switch(parallel_for.reductions[i].operation) {
+                    case Reduction::Operation::SUM:
+                        target = target + partial;
+                        break;
+                    case Reduction::Operation::MIN:
+                        if(compare(partial, Token::Type::LESS, target)) {
+                            target = partial;
+                        }
+                        break;
+                    case Reduction::Operation::MAX:
+                        if(compare(partial, Token::Type::GREATER, target)) {
+                            target = partial;
+                        }
+                        break;
+                }
+            }
+        }
     }
 
     void Interpreter::visit_while(const While& while_stmt) {
+        LYNX_COUNT(WHILE);
+        Value slot;
+        while(is_truthy(read(while_stmt.condition, slot))) {
+            step();
+            execute(*while_stmt.block);
+            if(_control != Control::NORMAL) {
+                return;
+            }
+        }
     }
 
     void Interpreter::visit_do_while(const Do_While& do_while) {
+        LYNX_COUNT(DO_WHILE);
+        Value slot;
+        do {
+            step();
+            execute(*do_while.block);
+            if(_control != Control::NORMAL) {
+                return;
+            }
+        } while(is_truthy(read(do_while.condition, slot)));
     }
 
     void Interpreter::visit_print(const Print& print) {
-        const auto expr = evaluate(print.expression);
+        LYNX_COUNT(PRINT);
+        Value slot;
+        print_value(read(print.expression, slot), _output);
+    }
+
+    void Interpreter::print_value(const Value& expr, Output_Buffer& output) {
         switch(expr.type) {
             case Value::Type::INTEGER:
-                std::cout << std::get<long long>(expr.data);
+                if(const auto small = std::get_if<long long>(&expr.data); small != nullptr) {
+                    output << *small;
+                } else {
+                    output << std::get<std::shared_ptr<const Big_Integer>>(expr.data)->to_string();
+                }
                 break;
             case Value::Type::FLOAT:
-                std::cout << std::get<long double>(expr.data);
+                output << std::get<long double>(expr.data);
                 break;
             case Value::Type::BOOL:
-                if(std::get<bool>(expr.data)) {
-                    std::cout << "true";
-                } else {
-                    std::cout << "false";
-                }
+                output << std::get<bool>(expr.data);
                 break;
             case Value::Type::STRING:
-                std::cout << std::get<std::string>(expr.data);
+                output << string_of(expr);
+                break;
+            case Value::Type::VOID:
+                throw std::runtime_error{"Can't print a 'void' value"};
+            case Value::Type::GENERATOR:
+                throw std::runtime_error{"Can't print a generator"};
+            case Value::Type::ARRAY:
+                print_array(to_array(expr), output);
                 break;
+            case Value::Type::MAP:
+                print_map(*std::get<std::shared_ptr<Map>>(expr.data), output);
+                break;
+        }
+    }
+
+    void Interpreter::visit_return(const Return& return_stmt) {
+        LYNX_COUNT(RETURN);
+        if(_call_stack.empty()) {
+            throw std::runtime_error{"'return' outside of a function"};
+        }
+        // Calls of builtins aren't bound to a function.
+        if(const auto call = return_stmt.tail_call; call != nullptr && call->function != nullptr) {
+            compile_body(*call->function);
+            if(!call->function->is_generator) {
+                push_arguments(*call);
+                _tail_call = call->function;
+                _control = Control::TAIL_CALL;
+                return;
+            }
+        }
+        if(return_stmt.value == nullptr) {
+            _return_value = Value{Value::Type::VOID, std::monostate{}};
+        } else {
+            _return_value = evaluate(return_stmt.value);
+        }
+        _control = Control::RETURN;
+    }
+
+    void Interpreter::visit_yield(const Yield&) {
+        LYNX_COUNT(YIELD);
+        // Generator bodies are run by run_generator, which handles 'yield' itself.
+        throw std::runtime_error{"'yield' outside of a generator's body"};
+    }
+
+    void Interpreter::visit_if_compare(const If_Compare& if_compare) {
+        LYNX_COUNT(IF_COMPARE);
+        count(Fused_Pattern::IF_COMPARE);
+        Value left_slot;
+        Value right_slot;
+        const auto& left = if_compare.borrow_left ? read(if_compare.left, left_slot)
+                : (left_slot = evaluate(if_compare.left));
+        if(compare(left, if_compare.operator_.type, read(if_compare.right, right_slot))) {
+            execute(*if_compare.then_block);
+            return;
+        }
+        if(if_compare.else_block != nullptr) {
+            execute(*if_compare.else_block);
         }
     }
 
     Value Interpreter::visit_literal(const Literal& literal) {
+        LYNX_COUNT(LITERAL);
         return literal.value;
     }
 
     Value Interpreter::visit_identifier(const Identifier& identifier) {
+        LYNX_COUNT(IDENTIFIER);
         return _environment.get(identifier.name.value);
     }
 
+    const Value& Interpreter::read_literal(const Literal& literal) {
+        LYNX_COUNT(LITERAL);
+        return literal.value;
+    }
+
+    const Value& Interpreter::read_identifier(const Identifier& identifier) {
+        LYNX_COUNT(IDENTIFIER);
+        return _environment.lookup(identifier.name.value);
+    }
+
     Value Interpreter::visit_unary(const Unary_Operation& unary) {
-        const auto operand = evaluate(unary.operand);
+        LYNX_COUNT(UNARY);
+        Value slot;
+        const auto& operand = read(unary.operand, slot);
         if(unary.operator_.type == Token::Type::MINUS) {
             if(operand.type == Value::Type::INTEGER) {
-                return Value{Value::Type::INTEGER, -std::get<long long>(operand.data)};
+                if(const auto small = std::get_if<long long>(&operand.data); small != nullptr && *small != LLONG_MIN) {
+                    return Value{Value::Type::INTEGER, -*small};
+                }
+                return Value{Value::Type::INTEGER, 0LL} - operand;
             }
             if(operand.type == Value::Type::FLOAT) {
                 return Value{Value::Type::FLOAT, -std::get<long double>(operand.data)};
@@ -129,47 +809,212 @@ namespace lynx {
     }
 
     Value Interpreter::visit_binary(const Binary_Operation& binary) {
-        const auto left = evaluate(binary.left);
-        const auto right = evaluate(binary.right);
-        if(left.type != right.type) {
-            throw std::runtime_error{"Incompatible operands in binary operation"};
+        LYNX_COUNT(BINARY);
+        const auto deferred = std::exchange(_array_operand, nullptr) == &binary;
+        const auto base = _array_expression.size();
+        if(binary.left_operand != Binary_Operation::Operand::OTHER
+                && binary.right_operand != Binary_Operation::Operand::OTHER) {
+            const auto& left = leaf_operand(*binary.left, binary.left_operand);
+            const auto& right = leaf_operand(*binary.right, binary.right_operand);
+            if(left.type != Value::Type::ARRAY && right.type != Value::Type::ARRAY) {
+                return apply_binary(left, binary.operator_.type, right);
+            }
+            if(deferred) {
+                _array_operand = &binary;
+            }
+            const auto left_node = _array_expression.leaf(left);
+            return element_wise(binary, left_node, binary.operator_.type, _array_expression.leaf(right), base);
+        }
+        // Computed operands are evaluated straight into their slots. A literal or a variable on the other side is
+        // still read in place, unless it is on the left and the right operand might assign to it.
+        const auto left_in_place = binary.left_operand != Binary_Operation::Operand::OTHER && binary.borrow_left;
+        const auto right_in_place = binary.right_operand != Binary_Operation::Operand::OTHER;
+        auto left_node = NO_NODE;
+        auto right_node = NO_NODE;
+        auto left_slot = left_in_place ? Value{} : evaluate_operand(binary.left, left_node);
+        auto right_slot = right_in_place ? Value{} : evaluate_operand(binary.right, right_node);
+        const auto& left = left_in_place ? leaf_operand(*binary.left, binary.left_operand) : left_slot;
+        const auto& right = right_in_place ? leaf_operand(*binary.right, binary.right_operand) : right_slot;
+        if(left_node != NO_NODE || right_node != NO_NODE || left.type == Value::Type::ARRAY
+                || right.type == Value::Type::ARRAY) {
+            left_node = to_node(left, left_slot, left_node);
+            right_node = to_node(right, right_slot, right_node);
+            if(deferred) {
+                _array_operand = &binary;
+            }
+            return element_wise(binary, left_node, binary.operator_.type, right_node, base);
         }
-        if(binary.operator_.type == Token::Type::PLUS) {
-            return left + right;
+        return apply_binary(left, binary.operator_.type, right);
+    }
+
+    Value Interpreter::visit_assignment(const Assignment& assignment) {
+        LYNX_COUNT(ASSIGNMENT);
+        const auto discarded = std::exchange(_discarded, nullptr) == &assignment;
+        auto value = evaluate(assignment.value);
+        auto& target = _environment.lookup(assignment.name.value);
+        if(value.type == Value::Type::MAP && target.type == Value::Type::MAP) {
+            const auto& map = *std::get<std::shared_ptr<Map>>(target.data);
+            type_empty_map(value, map.key_type(), map.value_type());
+        }
+        target = std::move(value);
+        if(discarded) {
+            return Value{Value::Type::VOID, std::monostate{}};
+        }
+        return target;
+    }
+
+    Value Interpreter::visit_call(const Call& call) {
+        LYNX_COUNT(CALL);
+        if(call.builtin != Builtin::NONE) {
+            return call_builtin(call);
         }
-        if(binary.operator_.type == Token::Type::MINUS) {
-            return left - right;
+        compile_body(*call.function);
+        push_arguments(call);
+        if(call.function->is_generator) {
+            return make_generator(*call.function);
         }
-        if(binary.operator_.type == Token::Type::STAR) {
-            return left * right;
+        return call_function(*call.function);
+    }
+
+    Value Interpreter::visit_array_literal(const Array_Literal& array_literal) {
+        LYNX_COUNT(ARRAY_LITERAL);
+        if(array_literal.elements.empty()) {
+            return Value{Value::Type::ARRAY, make_managed<Array>(Value::Type::INTEGER)};
+        }
+        Value slot;
+        const auto& first = read(array_literal.elements[0], slot);
+        auto array = make_managed<Array>(first.type, array_literal.elements.size());
+        array->store(0, first);
+        for(std::size_t i = 1; i < array_literal.elements.size(); ++i) {
+            array->store(static_cast<long long>(i), read(array_literal.elements[i], slot));
+        }
+        return Value{Value::Type::ARRAY, std::move(array)};
+    }
+
+    Value Interpreter::visit_map_literal(const Map_Literal& map_literal) {
+        LYNX_COUNT(MAP_LITERAL);
+        auto map = make_managed<Map>(Value::Type::VOID, Value::Type::VOID, map_literal.keys.size());
+        for(std::size_t i = 0; i < map_literal.keys.size(); ++i) {
+            const auto key = evaluate(map_literal.keys[i]);
+            map->store(key, evaluate(map_literal.values[i]));
         }
-        if(binary.operator_.type == Token::Type::SLASH) {
-            return left / right;
+        return Value{Value::Type::MAP, std::move(map)};
+    }
+
+    Value Interpreter::visit_index(const Index& index) {
+        LYNX_COUNT(INDEX);
+        // A named array or map is read in place, without taking a reference to it.
+        if(index.name != nullptr) {
+            Value slot;
+            const auto& key = read(index.index, slot);
+            return load(_environment.lookup(index.name->name.value), key, index.key_hash);
         }
-        if(binary.operator_.type == Token::Type::EQUALS_EQUALS) {
-            return left == right;
+        const auto key = evaluate(index.index);
+        return load(evaluate(index.array), key, index.key_hash);
+    }
+
+    Value Interpreter::visit_index_assignment(const Index_Assignment& assignment) {
+        LYNX_COUNT(INDEX_ASSIGNMENT);
+        const auto discarded = std::exchange(_discarded, nullptr) == &assignment;
+        Value slot;
+        const auto& key = assignment.borrow_index ? read(assignment.index, slot) : (slot = evaluate(assignment.index));
+        auto value = evaluate(assignment.value);
+        auto& target = _environment.lookup(assignment.name.value);
+        if(target.type == Value::Type::MAP) {
+            auto& map = writable_map(target);
+            auto result = discarded ? Value{Value::Type::VOID, std::monostate{}} : value;
+            if(assignment.key_hash) {
+                map.store(key, *assignment.key_hash, std::move(value));
+            } else {
+                map.store(key, std::move(value));
+            }
+            return result;
         }
-        if(binary.operator_.type == Token::Type::BANG_EQUALS) {
-            return left != right;
+        if(target.type != Value::Type::ARRAY) {
+            throw std::runtime_error{"'" + assignment.name.value + "' is not an array or a map"};
         }
-        if(binary.operator_.type == Token::Type::LESS) {
-            return left < right;
+        const auto position = to_index(key);
+        auto& array = std::get<std::shared_ptr<Array>>(target.data);
+        if(array.use_count() > 1) {
+            array = make_managed<Array>(*array);
         }
-        if(binary.operator_.type == Token::Type::LESS_EQUALS) {
-            return left <= right;
+        array->store(position, value);
+        if(discarded) {
+            return Value{Value::Type::VOID, std::monostate{}};
         }
-        if(binary.operator_.type == Token::Type::GREATER) {
-            return left > right;
+        return value;
+    }
+
+    Value Interpreter::visit_compare_identifier_literal(const Compare_Identifier_Literal& compare) {
+        LYNX_COUNT(COMPARE_IDENTIFIER_LITERAL);
+        count(Fused_Pattern::COMPARE_IDENTIFIER_LITERAL);
+        const auto& value = _environment.lookup(compare.name.value);
+        if(value.type == Value::Type::ARRAY) {
+            const auto deferred = std::exchange(_array_operand, nullptr) == &compare;
+            const auto base = _array_expression.size();
+            const auto left = _array_expression.leaf(value);
+            const auto right = _array_expression.leaf(compare.literal);
+            if(deferred) {
+                _array_operand = &compare;
+            }
+            return element_wise(compare, left, compare.operator_.type, right, base);
         }
-        if(binary.operator_.type == Token::Type::GREATER_EQUALS) {
-            return left >= right;
+        return Value{Value::Type::BOOL, lynx::compare(value, compare.operator_.type, compare.literal)};
+    }
+
+    Value Interpreter::visit_arithmetic_identifier_literal(const Arithmetic_Identifier_Literal& arithmetic) {
+        LYNX_COUNT(ARITHMETIC_IDENTIFIER_LITERAL);
+        count(Fused_Pattern::ARITHMETIC_IDENTIFIER_LITERAL);
+        const auto& value = _environment.lookup(arithmetic.name.value);
+        if(value.type == Value::Type::INTEGER && arithmetic.literal.type == Value::Type::INTEGER) {
+            const auto small_value = std::get_if<long long>(&value.data);
+            const auto small_literal = std::get_if<long long>(&arithmetic.literal.data);
+            long long result;
+            if(small_value != nullptr && small_literal != nullptr
+                    && apply_checked_arithmetic(*small_value, arithmetic.operator_.type, *small_literal, result)) {
+                return Value{Value::Type::INTEGER, result};
+            }
+            return apply_binary(value, arithmetic.operator_.type, arithmetic.literal);
         }
-        throw std::runtime_error{"Should never reach this point."};
+        if(value.type == Value::Type::ARRAY) {
+            const auto deferred = std::exchange(_array_operand, nullptr) == &arithmetic;
+            const auto base = _array_expression.size();
+            const auto left = _array_expression.leaf(value);
+            const auto right = _array_expression.leaf(arithmetic.literal);
+            if(deferred) {
+                _array_operand = &arithmetic;
+            }
+            return element_wise(arithmetic, left, arithmetic.operator_.type, right, base);
+        }
+        return apply_binary(value, arithmetic.operator_.type, arithmetic.literal);
+    }
+
+    Value Interpreter::visit_compound_assignment(const Compound_Assignment& assignment) {
+        LYNX_COUNT(COMPOUND_ASSIGNMENT);
+        count(Fused_Pattern::COMPOUND_ASSIGNMENT);
+        const auto discarded = std::exchange(_discarded, nullptr) == &assignment;
+        auto& value = _environment.lookup(assignment.name.value);
+        if(value.type == Value::Type::ARRAY) {
+            const auto base = _array_expression.size();
+            const auto node = _array_expression.operation(assignment.operator_.type, _array_expression.leaf(value),
+                    _array_expression.leaf(assignment.literal));
+            auto result = _array_expression.evaluate(node);
+            _array_expression.truncate(base);
+            value = std::move(result);
+        } else {
+            apply_arithmetic_in_place(value, assignment.operator_.type, assignment.literal);
+        }
+        if(discarded) {
+            return Value{Value::Type::VOID, std::monostate{}};
+        }
+        return value;
     }
 
     bool Interpreter::is_truthy(const Value& value) const {
         if(value.type == Value::Type::INTEGER) {
-            return std::get<long long>(value.data) != 0;
+            // Big integers are never zero.
+            const auto small = std::get_if<long long>(&value.data);
+            return small == nullptr || *small != 0;
         }
         if(value.type == Value::Type::FLOAT) {
             return std::get<long double>(value.data) != 0.0;
@@ -180,5 +1025,669 @@ namespace lynx {
         throw std::runtime_error{"Only numbers and booleans can be used as condition."};
     }
 
-}
+    void Interpreter::print_array(const Array& array, Output_Buffer& output) {
+        output << '[';
+        std::visit([&output](const auto& elements) {
+            for(std::size_t i = 0; i < elements.size(); ++i) {
+                if(i > 0) {
+                    output << ", ";
+                }
+                if constexpr(std::is_same_v<std::decay_t<decltype(elements)>, Array::Bools>) {
+                    output << (elements[i] != 0);
+                } else {
+                    output << elements[i];
+                }
+            }
+        }, array.elements);
+        output << ']';
+    }
+
+    void Interpreter::print_map(const Map& map, Output_Buffer& output) {
+        output << '{';
+        for(std::size_t i = 0; i < map.entries().size(); ++i) {
+            if(i > 0) {
+                output << ", ";
+            }
+            const auto& entry = map.entries()[i];
+            print_value(entry.key, output);
+            output << ": ";
+            print_value(entry.value, output);
+        }
+        output << '}';
+    }
+
+    void Interpreter::count(const Fused_Pattern pattern) noexcept {
+        ++_fusion_counters[static_cast<std::size_t>(pattern)];
+    }
+
+    void Interpreter::start_limits(const Limits& limits) {
+        _budget = limits;
+        _steps = 0;
+        _slice = 0;
+        _countdown = 0;
+        _borrowed = false;
+        if(limits.time.count() > 0) {
+            _deadline = std::chrono::steady_clock::now() + limits.time;
+        }
+    }
+
+    void Interpreter::check_limits() {
+        _steps += _slice;
+        if(_budget.steps > 0) {
+            // The chunks of a 'parallel for' take their steps from what the whole run has left.
+            if(_parallel_budget != nullptr) {
+                _slice = _parallel_budget->take_steps(_slice, _borrowed);
+            } else {
+                _slice = _steps >= _budget.steps ? 0 : std::min(CHECK_INTERVAL, _budget.steps - _steps);
+            }
+            if(_slice == 0) {
+                throw Limit_Exceeded{"Step limit of " + std::to_string(_budget.steps) + " exceeded"};
+            }
+        } else {
+            _slice = _budget.time.count() == 0 ? std::numeric_limits<std::uint64_t>::max() : CHECK_INTERVAL;
+        }
+        _countdown = _slice;
+        if(_budget.time.count() > 0 && std::chrono::steady_clock::now() >= _deadline) {
+            throw Limit_Exceeded{"Time limit of " + std::to_string(_budget.time.count()) + " ms exceeded"};
+        }
+    }
+
+    std::uint64_t Interpreter::steps_taken() const noexcept {
+        return _steps + _slice - _countdown;
+    }
+
+    void Interpreter::reset() noexcept {
+        _environment.clear();
+        _call_stack.clear();
+        _arguments.clear();
+        _control = Control::NORMAL;
+        _return_value = Value{Value::Type::VOID, std::monostate{}};
+        _array_expression.truncate(0);
+        _array_operand = nullptr;
+        _operand_node = NO_NODE;
+        _discarded = nullptr;
+        _files.clear();
+        _native_stack.reset();
+        if(_profiler != nullptr) {
+            _profiler->reset();
+        }
+    }
+
+    // Runs on a pool thread, in a fresh interpreter seeded with a copy of the variables visible at the loop. Sums
+    // start from zero and are added to the original value when chunks are merged; min and max can simply start
+    // from it.
+    void Interpreter::run_chunk(const Parallel_For& parallel_for, const long long begin, const long long end,
+            const std::vector<Environment::Binding>& bindings, Parallel_Budget& shared,
+            Parallel_Chunk& chunk) const {
+        // Created first, so that it is still in force when the worker releases its values.
+        std::optional<Heap_Budget> heap_budget;
+        if(_budget.heap_bytes > 0) {
+            heap_budget.emplace(_budget.heap_bytes, shared.heap_bytes);
+        }
+        Output_Buffer output{chunk.output, 4 * 1024};
+        Interpreter worker{output};
+        worker._max_call_depth = _max_call_depth;
+        worker._is_worker = true;
+        worker.start_limits(_budget);
+        worker._deadline = _deadline;
+        worker._parallel_budget = &shared;
+        try {
+            for(const auto& binding : bindings) {
+                // A generator is resumed in place, so sharing it between chunks would race.
+                if(binding.value.type == Value::Type::GENERATOR) {
+                    continue;
+                }
+                worker._environment.define(binding.name, binding.value);
+            }
+            for(const auto& reduction : parallel_for.reductions) {
+                auto& value = worker._environment.lookup(reduction.variable.value);
+                if(value.type != Value::Type::INTEGER && value.type != Value::Type::FLOAT) {
+                    throw std::runtime_error{"Reduction variable '" + reduction.variable.value
+                            + "' has to be a number"};
+                }
+                if(reduction.operation == Reduction::Operation::SUM) {
+                    value = value.type == Value::Type::INTEGER ? Value{Value::Type::INTEGER, 0LL}
+                            : Value{Value::Type::FLOAT, 0.0L};
+                }
+            }
+            worker._environment.push_scope();
+            worker._environment.define(parallel_for.variable.value, Value{Value::Type::INTEGER, begin});
+            for(auto i = begin; i < end; ++i) {
+                worker._environment.lookup(parallel_for.variable.value) = Value{Value::Type::INTEGER, i};
+                worker.step();
+                worker.execute(*parallel_for.block);
+            }
+            for(const auto& reduction : parallel_for.reductions) {
+                chunk.reductions.push_back(worker._environment.get(reduction.variable.value));
+            }
+        } catch(const Limit_Exceeded& e) {
+            LYNX_COUNT(EXCEPTIONS);
+            chunk.error = e.what();
+            chunk.limit_exceeded = true;
+        } catch(const std::runtime_error& e) {
+            LYNX_COUNT(EXCEPTIONS);
+            chunk.error = e.what();
+        } catch(const std::bad_alloc&) {
+            LYNX_COUNT(EXCEPTIONS);
+            chunk.error = "Out of memory";
+        } catch(const std::length_error&) {
+            LYNX_COUNT(EXCEPTIONS);
+            chunk.error = "Value too large to allocate";
+        }
+        output.flush();
+        chunk.fusion_counters = worker._fusion_counters;
+        chunk.steps = worker.steps_taken();
+        // What is left of the last slice goes back to the chunks still running.
+        if(_budget.steps > 0) {
+            shared.return_steps(worker._slice, worker._countdown, worker._borrowed);
+        }
+    }
+
+    Value Interpreter::call_builtin(const Call& call) {
+        switch(call.builtin) {
+            case Builtin::LEN: {
+                Value slot;
+                const auto& value = read(call.arguments[0], slot);
+                if(value.type == Value::Type::STRING) {
+                    return Value{Value::Type::INTEGER, static_cast<long long>(string_of(value).size())};
+                }
+                if(value.type == Value::Type::MAP) {
+                    return Value{Value::Type::INTEGER,
+                            static_cast<long long>(std::get<std::shared_ptr<Map>>(value.data)->size())};
+                }
+                if(value.type != Value::Type::ARRAY) {
+                    throw std::runtime_error{"'len' expects an array, a map or a string"};
+                }
+                return Value{Value::Type::INTEGER, static_cast<long long>(to_array(value).size())};
+            }
+            case Builtin::ARRAY: {
+                const auto size = evaluate(call.arguments[0]);
+                Value slot;
+                const auto& value = read(call.arguments[1], slot);
+                if(size.type != Value::Type::INTEGER || small_integer(size) < 0) {
+                    throw std::runtime_error{"Size of an array has to be a non-negative 'int'"};
+                }
+                if(static_cast<unsigned long long>(small_integer(size)) > Array::max_size(value.type)) {
+                    throw std::runtime_error{"Array of " + std::to_string(small_integer(size))
+                            + " elements is too large"};
+                }
+                auto array = make_managed<Array>(value.type, small_integer(size));
+                array->fill(value);
+                return Value{Value::Type::ARRAY, std::move(array)};
+            }
+            case Builtin::SUM:
+                return reduce(call.arguments[0], Array_Expression::Reduction::SUM);
+            case Builtin::MIN:
+                return reduce(call.arguments[0], Array_Expression::Reduction::MIN);
+            case Builtin::MAX:
+                return reduce(call.arguments[0], Array_Expression::Reduction::MAX);
+            case Builtin::MAP: {
+                Value slot;
+                const auto& capacity = read(call.arguments[0], slot);
+                if(capacity.type != Value::Type::INTEGER || small_integer(capacity) < 0) {
+                    throw std::runtime_error{"Capacity of a map has to be a non-negative 'int'"};
+                }
+                return Value{Value::Type::MAP, make_managed<Map>(Value::Type::VOID, Value::Type::VOID,
+                        static_cast<std::size_t>(small_integer(capacity)))};
+            }
+            case Builtin::HAS: {
+                const auto map = evaluate(call.arguments[0]);
+                Value slot;
+                const auto& key = read(call.arguments[1], slot);
+                if(map.type != Value::Type::MAP) {
+                    throw std::runtime_error{"'has' expects a map"};
+                }
+                return Value{Value::Type::BOOL, std::get<std::shared_ptr<Map>>(map.data)->contains(key)};
+            }
+            case Builtin::DOT: {
+                const auto base = _array_expression.size();
+                auto left_node = NO_NODE;
+                auto right_node = NO_NODE;
+                Value left_slot;
+                Value right_slot;
+                const auto& left = operand(call.arguments[0], left_node, left_slot, false);
+                const auto& right = operand(call.arguments[1], right_node, right_slot, true);
+                if((left_node == NO_NODE && left.type != Value::Type::ARRAY)
+                        || (right_node == NO_NODE && right.type != Value::Type::ARRAY)) {
+                    throw std::runtime_error{"'dot' expects two arrays"};
+                }
+                left_node = to_node(left, left_slot, left_node);
+                right_node = to_node(right, right_slot, right_node);
+                const auto product = _array_expression.operation(Token::Type::STAR, left_node, right_node);
+                auto result = _array_expression.reduce(product, Array_Expression::Reduction::SUM);
+                _array_expression.truncate(base);
+                return result;
+            }
+            case Builtin::LINES:
+            case Builtin::CHUNKS: {
+                Value slot;
+                const auto& path = read(call.arguments[0], slot);
+                if(path.type != Value::Type::STRING) {
+                    throw std::runtime_error{"'lines' and 'chunks' expect the path of a file"};
+                }
+                std::size_t chunk_size = 0;
+                if(call.builtin == Builtin::CHUNKS) {
+                    const auto size = evaluate(call.arguments[1]);
+                    if(size.type != Value::Type::INTEGER || small_integer(size) <= 0) {
+                        throw std::runtime_error{"Size of a chunk has to be a positive 'int'"};
+                    }
+                    chunk_size = static_cast<std::size_t>(small_integer(size));
+                }
+                const auto& name = string_of(path);
+                auto reader = std::make_unique<File_Reader>(std::string{name.begin(), name.end()}, chunk_size);
+                return Value{Value::Type::GENERATOR, make_managed<Generator>(std::move(reader))};
+            }
+            case Builtin::WRITE: {
+                const auto path = evaluate(call.arguments[0]);
+                Value slot;
+                const auto& value = read(call.arguments[1], slot);
+                if(path.type != Value::Type::STRING) {
+                    throw std::runtime_error{"'write' expects the path of a file"};
+                }
+                const auto& name = string_of(path);
+                write_file(std::string{name.begin(), name.end()}, value);
+                return Value{Value::Type::VOID, std::monostate{}};
+            }
+            case Builtin::SNAPSHOT:
+                // Only a marker, run() stops in front of it when a snapshot is being taken.
+                return Value{Value::Type::VOID, std::monostate{}};
+            case Builtin::NONE:
+                break;
+        }
+        throw std::runtime_error{"Should never reach this point."};
+    }
+
+    void Interpreter::write_file(const std::string& path, const Value& value) {
+        // Every chunk would truncate the file again.
+        if(_is_worker) {
+            throw std::runtime_error{"'write' can't be used inside a 'parallel for'"};
+        }
+        auto file = _files.find(path);
+        if(file == _files.end()) {
+            file = _files.emplace(path, std::make_unique<Output_File>(path)).first;
+        }
+        print_value(value, file->second->buffer());
+    }
+
+    const Value& Interpreter::operand(const Expr_Ptr& expression, Array_Expression::Node& node, Value& slot,
+            const bool borrow) {
+        _array_operand = expression.get();
+        const auto& value = borrow ? read(expression, slot) : (slot = evaluate(expression));
+        // Only a deferred operand returns void; any other void value is an error further on anyway.
+        if(value.type == Value::Type::VOID && _operand_node != NO_NODE) {
+            node = std::exchange(_operand_node, NO_NODE);
+        }
+        return value;
+    }
+
+    Value Interpreter::evaluate_operand(const Expr_Ptr& expression, Array_Expression::Node& node) {
+        _array_operand = expression.get();
+        auto value = evaluate(expression);
+        if(value.type == Value::Type::VOID && _operand_node != NO_NODE) {
+            node = std::exchange(_operand_node, NO_NODE);
+        }
+        return value;
+    }
+
+    const Value& Interpreter::leaf_operand(const Expr& expression, const Binary_Operation::Operand kind) {
+        if(kind == Binary_Operation::Operand::LITERAL) {
+            return read_literal(static_cast<const Literal&>(expression));
+        }
+        return read_identifier(static_cast<const Identifier&>(expression));
+    }
+
+    Array_Expression::Node Interpreter::to_node(const Value& value, Value& slot, const Array_Expression::Node node) {
+        if(node != NO_NODE) {
+            return node;
+        }
+        if(&value == &slot) {
+            return _array_expression.leaf(std::move(slot));
+        }
+        return _array_expression.leaf(value);
+    }
+
+    // 'base' is the size of _array_expression before the operands were evaluated. A deferred result stays on top
+    // of it for the parent to pick up; anything else is computed and popped.
+    Value Interpreter::element_wise(const Expr& expression, const Array_Expression::Node left,
+            const Token::Type operator_, const Array_Expression::Node right, const std::size_t base) {
+        const auto node = _array_expression.operation(operator_, left, right);
+        if(std::exchange(_array_operand, nullptr) == &expression) {
+            _operand_node = node;
+            return Value{Value::Type::VOID, std::monostate{}};
+        }
+        auto result = _array_expression.evaluate(node);
+        _array_expression.truncate(base);
+        return result;
+    }
+
+    Value Interpreter::reduce(const Expr_Ptr& expression, const Array_Expression::Reduction reduction) {
+        const auto base = _array_expression.size();
+        auto node = NO_NODE;
+        Value slot;
+        const auto& argument = operand(expression, node, slot, true);
+        if(node == NO_NODE && argument.type != Value::Type::ARRAY) {
+            throw std::runtime_error{"'sum', 'min' and 'max' expect an array"};
+        }
+        auto result = _array_expression.reduce(to_node(argument, slot, node), reduction);
+        _array_expression.truncate(base);
+        return result;
+    }
+
+    bool Interpreter::next_element(const Value& source, std::size_t& position, Value& element) {
+        if(source.type == Value::Type::MAP) {
+            const auto& entries = std::get<std::shared_ptr<Map>>(source.data)->entries();
+            if(position == entries.size()) {
+                return false;
+            }
+            element = entries[position++].key;
+            return true;
+        }
+        if(source.type == Value::Type::ARRAY) {
+            const auto& array = to_array(source);
+            if(position == array.size()) {
+                return false;
+            }
+            element = array.load(static_cast<long long>(position++));
+            return true;
+        }
+        auto& generator = *std::get<std::shared_ptr<Generator>>(source.data);
+        if(generator.reader != nullptr) {
+            const auto piece = generator.reader->next();
+            if(!piece.has_value()) {
+                return false;
+            }
+            element = make_string(*piece);
+            return true;
+        }
+        if(!resume(generator)) {
+            return false;
+        }
+        element = std::move(generator.value);
+        return true;
+    }
+
+    void Interpreter::push_arguments(const Call& call) {
+        for(const auto& argument : call.arguments) {
+            _arguments.push_back(evaluate(argument));
+        }
+    }
+
+    // Frames live on _call_stack and the environment's symbol stack. A 'return' of a call doesn't recurse: it leaves
+    // its arguments on _arguments and the loop below rebinds the current frame. Any other call does nest in the
+    // native frames of its caller, but those move to a segment of their own before they grow the thread's stack.
+    Value Interpreter::call_function(const Function_Declaration& function) {
+        if(_call_stack.size() >= _max_call_depth) {
+            throw std::runtime_error{"Stack overflow, call depth exceeded " + std::to_string(_max_call_depth)};
+        }
+        if(_native_stack.exhausted()) {
+            return call_on_segment(function);
+        }
+        const auto arguments_begin = _arguments.size() - function.parameters.size();
+        _call_stack.push_back(Call_Frame{&function});
+        _environment.push_frame();
+        if(_profiler != nullptr) {
+            _profiler->enter_function(function);
+        }
+        const Function_Declaration* current = &function;
+        while(true) {
+            step();
+            for(std::size_t i = 0; i < current->parameters.size(); ++i) {
+                auto& argument = _arguments[arguments_begin + i];
+                check_argument(argument, current->parameters[i], *current);
+                _environment.define(current->parameters[i].name, std::move(argument));
+            }
+            _arguments.erase(_arguments.begin() + arguments_begin, _arguments.end());
+            execute_block(static_cast<const Block&>(*current->body));
+            if(_control != Control::TAIL_CALL) {
+                break;
+            }
+            _control = Control::NORMAL;
+            current = _tail_call;
+            _call_stack.back().function = current;
+            _environment.reset_frame();
+            if(_profiler != nullptr) {
+                _profiler->replace_function(*current);
+            }
+        }
+        if(_profiler != nullptr) {
+            _profiler->leave_function();
+        }
+        _environment.pop_frame();
+        _call_stack.pop_back();
+        // A tail call returns for both the function it called and the one that made it.
+        if(_control == Control::RETURN) {
+            _control = Control::NORMAL;
+            check_return(_return_value, *current);
+            if(current != &function) {
+                check_return(_return_value, function);
+            }
+            return std::move(_return_value);
+        }
+        Value none{Value::Type::VOID, std::monostate{}};
+        check_return(none, *current);
+        if(current != &function) {
+            check_return(none, function);
+        }
+        return none;
+    }
 
+    Value Interpreter::call_on_segment(const Function_Declaration& function) {
+        Value result;
+        auto call = [&] {
+            result = call_function(function);
+        };
+        _native_stack.run(call);
+        return result;
+    }
+
+    Value Interpreter::make_generator(const Function_Declaration& function) {
+        auto generator = make_managed<Generator>(function);
+        const auto arguments_begin = _arguments.size() - function.parameters.size();
+        for(std::size_t i = 0; i < function.parameters.size(); ++i) {
+            auto& argument = _arguments[arguments_begin + i];
+            check_argument(argument, function.parameters[i], function);
+            generator->frame.symbols.push_back(Environment::Binding{function.parameters[i].name, std::move(argument)});
+        }
+        _arguments.erase(_arguments.begin() + arguments_begin, _arguments.end());
+        generator->cursors.push_back(Generator::Cursor{Generator::Cursor::Kind::BLOCK, function.body.get(), 0});
+        return Value{Value::Type::GENERATOR, std::move(generator)};
+    }
+
+    bool Interpreter::resume(Generator& generator) {
+        if(generator.finished()) {
+            return false;
+        }
+        if(generator.running) {
+            throw std::runtime_error{"Generator '" + generator.function->name.value + "' is already running"};
+        }
+        if(_call_stack.size() >= _max_call_depth) {
+            throw std::runtime_error{"Stack overflow, call depth exceeded " + std::to_string(_max_call_depth)};
+        }
+        if(_native_stack.exhausted()) {
+            auto yielded = false;
+            auto resume_generator = [&] {
+                yielded = resume(generator);
+            };
+            _native_stack.run(resume_generator);
+            return yielded;
+        }
+        step();
+        generator.running = true;
+        _call_stack.push_back(Call_Frame{generator.function});
+        _environment.push_frame();
+        _environment.restore_frame(generator.frame);
+        std::size_t line{};
+        if(_profiler != nullptr) {
+            _profiler->enter_function(*generator.function);
+            line = _profiler->enter_line(generator.function->line);
+        }
+        const auto yielded = run_generator(generator);
+        if(_profiler != nullptr) {
+            _profiler->leave_line(line);
+            _profiler->leave_function();
+        }
+        if(yielded) {
+            _environment.save_frame(generator.frame);
+        } else {
+            generator.cursors.clear();
+            generator.frame = Environment::Saved_Frame{};
+            _control = Control::NORMAL;
+        }
+        _environment.pop_frame();
+        _call_stack.pop_back();
+        generator.running = false;
+        return yielded;
+    }
+
+    // Loops and blocks of a generator's body are driven from its cursors rather than by recursive visits, so
+    // suspending only has to stop this loop. Statements that can't contain a 'yield' are executed as usual.
+    bool Interpreter::run_generator(Generator& generator) {
+        using Kind = Generator::Cursor::Kind;
+        auto& cursors = generator.cursors;
+        while(!cursors.empty()) {
+            // 'cursor' is invalidated by enter(), so it may not be used after it.
+            auto& cursor = cursors.back();
+            switch(cursor.kind) {
+                case Kind::BLOCK: {
+                    const auto& block = static_cast<const Block&>(*cursor.statement);
+                    if(cursor.position == block.statements.size()) {
+                        cursors.pop_back();
+                        // The body itself runs in the frame's scope, only nested blocks open their own.
+                        if(!cursors.empty()) {
+                            _environment.pop_scope();
+                        }
+                        break;
+                    }
+                    auto& statement = *block.statements[cursor.position++];
+                    if(enter(generator, statement)) {
+                        return true;
+                    }
+                    if(_control != Control::NORMAL) {
+                        return false;
+                    }
+                    break;
+                }
+                case Kind::WHILE: {
+                    const auto& while_stmt = static_cast<const While&>(*cursor.statement);
+                    if(!is_truthy(evaluate(while_stmt.condition))) {
+                        cursors.pop_back();
+                        break;
+                    }
+                    open_block(generator, static_cast<const Block&>(*while_stmt.block));
+                    break;
+                }
+                case Kind::DO_WHILE: {
+                    const auto& do_while = static_cast<const Do_While&>(*cursor.statement);
+                    if(cursor.position++ > 0 && !is_truthy(evaluate(do_while.condition))) {
+                        cursors.pop_back();
+                        break;
+                    }
+                    open_block(generator, static_cast<const Block&>(*do_while.block));
+                    break;
+                }
+                case Kind::FOR: {
+                    const auto& for_stmt = static_cast<const For&>(*cursor.statement);
+                    if(cursor.position++ > 0) {
+                        evaluate(for_stmt.iteration_expression);
+                    }
+                    if(!is_truthy(evaluate(for_stmt.condition))) {
+                        cursors.pop_back();
+                        break;
+                    }
+                    open_block(generator, static_cast<const Block&>(*for_stmt.block));
+                    break;
+                }
+                case Kind::FOR_IN: {
+                    const auto& for_in = static_cast<const For_In&>(*cursor.statement);
+                    Value element{Value::Type::VOID, std::monostate{}};
+                    if(!next_element(cursor.source, cursor.position, element)) {
+                        cursors.pop_back();
+                        _environment.pop_scope();
+                        break;
+                    }
+                    _environment.lookup(for_in.variable.value) = std::move(element);
+                    open_block(generator, static_cast<const Block&>(*for_in.block));
+                    break;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Loop bodies are always blocks, so loops open them directly instead of going through enter().
+    void Interpreter::open_block(Generator& generator, const Block& block) {
+        step();
+        _environment.push_scope();
+        generator.cursors.push_back(Generator::Cursor{Generator::Cursor::Kind::BLOCK, &block, 0});
+    }
+
+    bool Interpreter::enter(Generator& generator, Statement& statement) {
+        using Kind = Generator::Cursor::Kind;
+        // The generator's own statements are flat, so there is no line to go back to.
+        if(_profiler != nullptr) {
+            _profiler->enter_line(statement.line);
+        }
+        if(auto expression = dynamic_cast<const Expression*>(&statement); expression != nullptr) {
+            LYNX_COUNT(EXPRESSION);
+            evaluate(expression->expression);
+            return false;
+        }
+        if(auto yield = dynamic_cast<const Yield*>(&statement); yield != nullptr) {
+            LYNX_COUNT(YIELD);
+            generator.value = evaluate(yield->value);
+            return true;
+        }
+        if(auto block = dynamic_cast<const Block*>(&statement); block != nullptr) {
+            LYNX_COUNT(BLOCK);
+            open_block(generator, *block);
+            return false;
+        }
+        if(auto if_stmt = dynamic_cast<const If*>(&statement); if_stmt != nullptr) {
+            LYNX_COUNT(IF);
+            if(is_truthy(evaluate(if_stmt->condition))) {
+                return enter(generator, *if_stmt->then_block);
+            }
+            return if_stmt->else_block != nullptr && enter(generator, *if_stmt->else_block);
+        }
+        if(auto if_compare = dynamic_cast<const If_Compare*>(&statement); if_compare != nullptr) {
+            LYNX_COUNT(IF_COMPARE);
+            count(Fused_Pattern::IF_COMPARE);
+            const auto left = evaluate(if_compare->left);
+            const auto right = evaluate(if_compare->right);
+            if(compare(left, if_compare->operator_.type, right)) {
+                return enter(generator, *if_compare->then_block);
+            }
+            return if_compare->else_block != nullptr && enter(generator, *if_compare->else_block);
+        }
+        if(auto while_stmt = dynamic_cast<const While*>(&statement); while_stmt != nullptr) {
+            LYNX_COUNT(WHILE);
+            generator.cursors.push_back(Generator::Cursor{Kind::WHILE, while_stmt, 0});
+            return false;
+        }
+        if(auto do_while = dynamic_cast<const Do_While*>(&statement); do_while != nullptr) {
+            LYNX_COUNT(DO_WHILE);
+            generator.cursors.push_back(Generator::Cursor{Kind::DO_WHILE, do_while, 0});
+            return false;
+        }
+        if(auto for_stmt = dynamic_cast<const For*>(&statement); for_stmt != nullptr) {
+            LYNX_COUNT(FOR);
+            if(for_stmt->init_statement != nullptr) {
+                evaluate(for_stmt->init_statement);
+            }
+            generator.cursors.push_back(Generator::Cursor{Kind::FOR, for_stmt, 0});
+            return false;
+        }
+        if(auto for_in = dynamic_cast<const For_In*>(&statement); for_in != nullptr) {
+            LYNX_COUNT(FOR_IN);
+            auto source = evaluate(for_in->iterable);
+            check_iterable(source);
+            _environment.push_scope();
+            _environment.define(for_in->variable.value, Value{Value::Type::VOID, std::monostate{}});
+            generator.cursors.push_back(Generator::Cursor{Kind::FOR_IN, for_in, 0, std::move(source)});
+            return false;
+        }
+        execute(statement);
+        return false;
+    }
+
+}
@@ -1,23 +1,83 @@
 #ifndef LYNX_INTERPRETER_H
 #define LYNX_INTERPRETER_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "array_expression.h"
 #include "environment.h"
+#include "file.h"
+#include "fusion.h"
+#include "generator.h"
+#include "native_stack.h"
+#include "output.h"
+#include "profiler.h"
+#include "program.h"
+#include "snapshot.h"
 #include "statement.h"
 
 namespace lynx {
 
+    // Outcome of Interpreter::run. Errors are reported here instead of being printed.
+    struct Run_Result {
+        enum class Status {
+            OK, RUNTIME_ERROR, LIMIT_EXCEEDED
+        };
+
+        bool ok() const noexcept {
+            return status == Status::OK;
+        }
+
+        Status      status = Status::OK;
+        std::string error;
+    };
+
+    // Budgets of a single run, none of which is enforced while it is zero. Steps are loop iterations and calls,
+    // the heap is the value heap held by the run, along with the stack segments of its deepest calls. Going over
+    // one ends the run with Status::LIMIT_EXCEEDED.
+    struct Limits {
+        std::uint64_t             steps{};
+        std::size_t               heap_bytes{};
+        std::chrono::milliseconds time{};
+    };
+
+    // Interpreter is the execution context of a Program: it holds all the mutable state of a run (environment,
+    // call frames, counters) while the Program itself stays read-only. It is cheap to create and can run any
+    // number of programs one after another, but must be used by a single thread at a time. Any number of
+    // interpreters may run the same Program concurrently.
     class Interpreter final : public Expression_Visitor, public Statement_Visitor {
     public:
-        Interpreter(const std::vector<Statement_Ptr>& statements);
+        explicit Interpreter(Output_Buffer& output);
         ~Interpreter() = default;
 
-        bool interpret();
+        Run_Result run(const Program& program);
+        // Runs the statements in front of the program's 'snapshot()' and stores the globals they left in 'snapshot'.
+        Run_Result run_to_snapshot(const Program& program, Snapshot& snapshot);
+        // Runs the statements after the program's 'snapshot()' with the globals of 'snapshot', which has to be taken
+        // of the same source.
+        Run_Result run_from_snapshot(const Program& program, const Snapshot& snapshot);
+
+        // Calls that don't return a tail call hold on to their frames, so their nesting is capped.
+        void set_max_call_depth(const std::size_t max_call_depth) noexcept;
+        // Applies to the runs that start from now on. Each chunk of a 'parallel for' gets the steps and time that
+        // were left when the loop started, and a heap budget of its own.
+        void set_limits(const Limits& limits) noexcept;
+        // Reports statements and calls to 'profiler' from now on, or to none if it is null.
+        void set_profiler(Profiler* profiler) noexcept;
+
+        // How many times each superinstruction has been executed.
+        const Fusion_Counters& fusion_counters() const noexcept;
 
         void execute(Statement& expression);
         void execute_block(const Block& block);
         Value evaluate(const Expr_Ptr& expression);
+        // Evaluates into 'slot' only what isn't a literal or a variable, see Expr::read().
+        const Value& read(const Expr_Ptr& expression, Value& slot);
 
         void visit_block(const Block& block) override;
         void visit_expression(const Expression& expression) override;
@@ -25,24 +85,194 @@ namespace lynx {
         void visit_variable_declaration(const Variable_Declaration& variable_declaration) override;
         void visit_if(const If& if_stmt) override;
         void visit_for(const For& for_stmt) override;
+        void visit_for_in(const For_In& for_in) override;
+        void visit_parallel_for(const Parallel_For& parallel_for) override;
         void visit_while(const While& while_stmt) override;
         void visit_do_while(const Do_While& do_while) override;
         void visit_print(const Print& print) override;
+        void visit_return(const Return& return_stmt) override;
+        void visit_yield(const Yield& yield) override;
+        void visit_if_compare(const If_Compare& if_compare) override;
         
         Value visit_literal(const Literal& literal) override;
         Value visit_identifier(const Identifier& identifier) override;
+        const Value& read_literal(const Literal& literal) override;
+        const Value& read_identifier(const Identifier& identifier) override;
         Value visit_unary(const Unary_Operation& unary) override;
         Value visit_binary(const Binary_Operation& binary) override;
+        Value visit_assignment(const Assignment& assignment) override;
+        Value visit_call(const Call& call) override;
+        Value visit_array_literal(const Array_Literal& array_literal) override;
+        Value visit_map_literal(const Map_Literal& map_literal) override;
+        Value visit_index(const Index& index) override;
+        Value visit_index_assignment(const Index_Assignment& assignment) override;
+        Value visit_compare_identifier_literal(const Compare_Identifier_Literal& compare) override;
+        Value visit_arithmetic_identifier_literal(const Arithmetic_Identifier_Literal& arithmetic) override;
+        Value visit_compound_assignment(const Compound_Assignment& assignment) override;
 
     private:
+        // How the innermost running statement finished. Anything but NORMAL unwinds blocks and loops up to the
+        // nearest call frame.
+        enum class Control {
+            NORMAL, RETURN, TAIL_CALL
+        };
+
+        struct Call_Frame {
+            const Function_Declaration* function;
+        };
+
+        // Results of one chunk of a 'parallel for', merged into the parent interpreter in chunk order.
+        struct Parallel_Chunk {
+            std::string        output;
+            std::vector<Value> reductions;
+            std::string        error;
+            bool               limit_exceeded{false};
+            Fusion_Counters    fusion_counters{};
+            // Steps the chunk took, which the 'parallel for' adds to its own.
+            std::uint64_t      steps{};
+        };
+
+        // What the chunks of a 'parallel for', and those of any nested in them, share of the run's limits: the
+        // steps left, handed out a slice at a time, and the value heap they hold together.
+        struct Parallel_Budget {
+            // Next slice of a chunk that has used up the one it had, or zero if the run certainly goes over its
+            // limit. Sets 'borrowed' if the slice is taken on credit, see credit.
+            std::uint64_t take_steps(const std::uint64_t used, bool& borrowed) noexcept;
+            // Gives back what a chunk didn't use of its last slice.
+            void return_steps(const std::uint64_t slice, const std::uint64_t unused, const bool borrowed) noexcept;
+
+            std::atomic<std::uint64_t>  steps{};
+            // Steps of the slices the chunks are still using.
+            std::atomic<std::uint64_t>  held{};
+            // Steps taken once none were left, against those the other chunks held. Whether the run went over its
+            // limit is only known when every chunk is done and it is clear how many of those they used.
+            std::atomic<std::uint64_t>  credit{};
+            std::atomic<std::ptrdiff_t> heap_bytes{};
+        };
+
+        // Node of an operand that isn't waiting in _array_expression.
+        static constexpr Array_Expression::Node NO_NODE = static_cast<Array_Expression::Node>(-1);
+
         bool is_truthy(const Value& value) const;
+        void count(const Fused_Pattern pattern) noexcept;
+        void print_value(const Value& value, Output_Buffer& output);
+        void print_array(const Array& array, Output_Buffer& output);
+        void print_map(const Map& map, Output_Buffer& output);
+        // Appends 'value' to the file at 'path', which the first write of a run creates or truncates.
+        void write_file(const std::string& path, const Value& value);
+
+        void reset() noexcept;
+
+        // Evaluates an expression whose result isn't used, so an assignment doesn't copy the value it stores.
+        void discard(const Expr_Ptr& expression);
 
-        const std::vector<Statement_Ptr>& _statements;
+        // Counts a loop iteration or a call. Limits are only checked when the countdown runs out, so with no
+        // limits set this is a decrement and a branch that is never taken.
+        void step() {
+            if(_countdown == 0) {
+                check_limits();
+            }
+            --_countdown;
+        }
+        void start_limits(const Limits& limits);
+        void check_limits();
+        std::uint64_t steps_taken() const noexcept;
+
+        // Runs the top-level statements [begin, end). Globals are defined from 'restore' first and stored in 'save'
+        // last, if given.
+        Run_Result run(const Program& program, const std::size_t begin, const std::size_t end, Snapshot* save,
+                const Snapshot* restore);
+
+        void run_chunk(const Parallel_For& parallel_for, const long long begin, const long long end,
+                const std::vector<Environment::Binding>& bindings, Parallel_Budget& shared,
+                Parallel_Chunk& chunk) const;
+
+        // Compiles the body of a function that Program::compile() left for its first call. Has to come before
+        // anything reads the body or whether the function is a generator.
+        static void compile_body(const Function_Declaration& function) {
+            if(function.lazy != nullptr) {
+                function.lazy->compile(function);
+            }
+        }
+        void push_arguments(const Call& call);
+        Value call_function(const Function_Declaration& function);
+        // Continues a call whose callers have used up their share of the native stack on a segment, see Native_Stack.
+        Value call_on_segment(const Function_Declaration& function);
+
+        Value call_builtin(const Call& call);
+
+        // Evaluates an operand of a binary operation into 'slot', or borrows it if 'borrow' is set. If it is an
+        // element-wise operation on arrays, it isn't computed but left in _array_expression as 'node', and the value
+        // returned is void.
+        const Value& operand(const Expr_Ptr& expression, Array_Expression::Node& node, Value& slot,
+                const bool borrow);
+        // Like operand(), but always evaluates it and returns the value.
+        Value evaluate_operand(const Expr_Ptr& expression, Array_Expression::Node& node);
+        // Reads an operand the Resolver found to be a literal or a variable, without a call through read().
+        const Value& leaf_operand(const Expr& expression, const Binary_Operation::Operand kind);
+        // An operand that was evaluated into its slot is moved to the leaf, a borrowed one is shared with it.
+        Array_Expression::Node to_node(const Value& value, Value& slot, const Array_Expression::Node node);
+        // Records 'left <operator> right' of which at least one is an array. Computes it, unless 'expression' is
+        // the operand its parent is waiting for.
+        Value element_wise(const Expr& expression, const Array_Expression::Node left, const Token::Type operator_,
+                const Array_Expression::Node right, const std::size_t base);
+        Value reduce(const Expr_Ptr& expression, const Array_Expression::Reduction reduction);
+
+        // Advances a 'for in' over an array or a generator. Returns false when there are no more elements.
+        bool next_element(const Value& source, std::size_t& position, Value& element);
+
+        Value make_generator(const Function_Declaration& function);
+        // Runs the generator until its next 'yield'. Returns false once its body has finished.
+        bool resume(Generator& generator);
+        bool run_generator(Generator& generator);
+        // Starts a statement of a generator's body. Returns true if it was a 'yield'.
+        bool enter(Generator& generator, Statement& statement);
+        void open_block(Generator& generator, const Block& block);
+
+        Output_Buffer& _output;
 
         Environment _environment;
+
+        std::vector<Call_Frame> _call_stack;
+        // Evaluated arguments wait here until the callee's frame is opened, so they are never visible to the
+        // caller's remaining argument expressions.
+        std::vector<Value>      _arguments;
+        std::size_t             _max_call_depth{100000};
+        Native_Stack            _native_stack;
+
+        Control                     _control{Control::NORMAL};
+        Value                       _return_value{Value::Type::VOID, std::monostate{}};
+        const Function_Declaration* _tail_call{};
+
+        Fusion_Counters _fusion_counters{};
+        Profiler*       _profiler{};
+
+        Limits                                _limits{};
+        // Limits of the current run, the steps taken before the current countdown started, the countdown's
+        // length, and the steps left in it.
+        Limits                                _budget{};
+        std::uint64_t                         _steps{};
+        std::uint64_t                         _slice{};
+        std::uint64_t                         _countdown{};
+        std::chrono::steady_clock::time_point _deadline{};
+        // Set in the interpreters that run the chunks of a 'parallel for', whose steps come from here.
+        Parallel_Budget*                      _parallel_budget{};
+        // Whether the current slice was taken on credit.
+        bool                                  _borrowed{};
+
+        Array_Expression       _array_expression;
+        // Expression whose element-wise result should be left in _array_expression, and the node it left there.
+        const Expr*            _array_operand{};
+        Array_Expression::Node _operand_node{NO_NODE};
+        // Expression run by discard(), whose result nobody reads.
+        const Expr*            _discarded{};
+
+        // Files written by the current run, flushed and closed when it ends.
+        std::unordered_map<std::string, std::unique_ptr<Output_File>> _files;
+        // Set in the interpreters that run the chunks of a 'parallel for'.
+        bool                                                          _is_worker{false};
     };
 
 }
 
 #endif //LYNX_INTERPRETER_H
-
@@ -0,0 +1,145 @@
+#include "kernels.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+namespace lynx {
+
+    namespace {
+
+        bool cpu_supports(const Simd_Level level) {
+            switch(level) {
+                case Simd_Level::SCALAR:
+                    return true;
+#if defined(__x86_64__) || defined(__i386__)
+                case Simd_Level::SSE2:
+                    return __builtin_cpu_supports("sse2");
+                case Simd_Level::AVX2:
+                    return __builtin_cpu_supports("avx2");
+#endif
+                default:
+                    return false;
+            }
+        }
+
+        Simd_Level highest_allowed() {
+            const auto cap = std::getenv("LYNX_SIMD");
+            if(cap == nullptr) {
+                return Simd_Level::AVX2;
+            }
+            for(const auto level : {Simd_Level::SCALAR, Simd_Level::SSE2, Simd_Level::AVX2}) {
+                if(std::strcmp(cap, to_string(level)) == 0) {
+                    return level;
+                }
+            }
+            return Simd_Level::AVX2;
+        }
+
+        const Kernels& select_kernels() {
+            const auto cap = highest_allowed();
+            for(const auto level : {Simd_Level::AVX2, Simd_Level::SSE2}) {
+                if(level > cap) {
+                    continue;
+                }
+                if(const auto selected = kernels(level); selected != nullptr) {
+                    return *selected;
+                }
+            }
+            return scalar_kernels();
+        }
+
+        template<typename T>
+        T pairwise_sum(const T* lanes) {
+            return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+        }
+
+        template<typename T, typename Compare>
+        T fold(const T* lanes, const Compare keep_left) {
+            auto result = lanes[0];
+            for(std::size_t i = 1; i < KERNEL_LANES; ++i) {
+                result = keep_left(result, lanes[i]) ? result : lanes[i];
+            }
+            return result;
+        }
+
+    }
+
+    Comparison swapped(const Comparison comparison) noexcept {
+        switch(comparison) {
+            case Comparison::LESS:
+                return Comparison::GREATER;
+            case Comparison::LESS_EQUAL:
+                return Comparison::GREATER_EQUAL;
+            case Comparison::GREATER:
+                return Comparison::LESS;
+            case Comparison::GREATER_EQUAL:
+                return Comparison::LESS_EQUAL;
+            default:
+                return comparison;
+        }
+    }
+
+    const char* to_string(const Simd_Level level) noexcept {
+        switch(level) {
+            case Simd_Level::SCALAR:
+                return "scalar";
+            case Simd_Level::SSE2:
+                return "sse2";
+            case Simd_Level::AVX2:
+                return "avx2";
+        }
+        return "unknown";
+    }
+
+    double sum_lanes(const double* lanes) noexcept {
+        return pairwise_sum(lanes);
+    }
+
+    bool sum_lanes(const long long* lanes, long long& sum) noexcept {
+        sum = 0;
+        for(std::size_t i = 0; i < KERNEL_LANES; ++i) {
+            if(__builtin_add_overflow(sum, lanes[i], &sum)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double min_lanes(const double* lanes) noexcept {
+        return fold(lanes, [](const double a, const double b) { return a < b; });
+    }
+
+    long long min_lanes(const long long* lanes) noexcept {
+        return fold(lanes, [](const long long a, const long long b) { return a < b; });
+    }
+
+    double max_lanes(const double* lanes) noexcept {
+        return fold(lanes, [](const double a, const double b) { return a > b; });
+    }
+
+    long long max_lanes(const long long* lanes) noexcept {
+        return fold(lanes, [](const long long a, const long long b) { return a > b; });
+    }
+
+    const Kernels& kernels() {
+        static const Kernels& selected = select_kernels();
+        return selected;
+    }
+
+    const Kernels* kernels(const Simd_Level level) {
+        if(!cpu_supports(level)) {
+            return nullptr;
+        }
+        switch(level) {
+            case Simd_Level::SCALAR:
+                return &scalar_kernels();
+            case Simd_Level::SSE2:
+                return sse2_kernels();
+            case Simd_Level::AVX2:
+                return avx2_kernels();
+        }
+        return nullptr;
+    }
+
+}
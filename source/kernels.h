@@ -0,0 +1,92 @@
+#ifndef LYNX_KERNELS_H
+#define LYNX_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lynx {
+
+    enum class Arithmetic {
+        ADD, SUBTRACT, MULTIPLY, DIVIDE
+    };
+
+    enum class Comparison {
+        EQUAL, NOT_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL
+    };
+
+    // Comparison that gives the same result with its operands swapped.
+    Comparison swapped(const Comparison comparison) noexcept;
+
+    enum class Simd_Level {
+        SCALAR, SSE2, AVX2
+    };
+
+    const char* to_string(const Simd_Level level) noexcept;
+
+    // Loops over whole arrays, compiled once for every instruction set in its own translation unit. All of them
+    // accept unaligned data and 'out' may alias an input.
+    // Reductions accumulate into 8 lanes, where element i always goes to lane i % 8 whatever the vector width.
+    // Results are therefore the same on every level, and a reduction can be split into calls over consecutive
+    // parts of an array as long as every part but the last has a multiple of 8 elements.
+    // Integer arithmetic throws std::runtime_error on a result that doesn't fit in 64 bits, and division also on a
+    // zero divisor. Integer sums and dot products don't throw but return false when they may have overflowed, and
+    // their lanes are then meaningless.
+    struct Kernels {
+        Simd_Level level;
+
+        // out[i] = a[i] <operation> b[i]
+        void (*arithmetic_f64)(Arithmetic operation, const double* a, const double* b, double* out, std::size_t n);
+        void (*arithmetic_i64)(Arithmetic operation, const long long* a, const long long* b, long long* out,
+                std::size_t n);
+        // out[i] = a[i] <operation> b, or b <operation> a[i] if 'reversed'.
+        void (*arithmetic_scalar_f64)(Arithmetic operation, const double* a, double b, bool reversed, double* out,
+                std::size_t n);
+        void (*arithmetic_scalar_i64)(Arithmetic operation, const long long* a, long long b, bool reversed,
+                long long* out, std::size_t n);
+
+        // out[i] = a[i] <comparison> b[i] ? 1 : 0
+        void (*compare_f64)(Comparison comparison, const double* a, const double* b, std::uint8_t* out,
+                std::size_t n);
+        void (*compare_i64)(Comparison comparison, const long long* a, const long long* b, std::uint8_t* out,
+                std::size_t n);
+        // out[i] = a[i] <comparison> b ? 1 : 0
+        void (*compare_scalar_f64)(Comparison comparison, const double* a, double b, std::uint8_t* out,
+                std::size_t n);
+        void (*compare_scalar_i64)(Comparison comparison, const long long* a, long long b, std::uint8_t* out,
+                std::size_t n);
+
+        // lanes[i % 8] = lanes[i % 8] <reduction> a[i]; dot accumulates a[i] * b[i].
+        void (*sum_f64)(const double* a, std::size_t n, double* lanes);
+        bool (*sum_i64)(const long long* a, std::size_t n, long long* lanes);
+        void (*min_f64)(const double* a, std::size_t n, double* lanes);
+        void (*min_i64)(const long long* a, std::size_t n, long long* lanes);
+        void (*max_f64)(const double* a, std::size_t n, double* lanes);
+        void (*max_i64)(const long long* a, std::size_t n, long long* lanes);
+        void (*dot_f64)(const double* a, const double* b, std::size_t n, double* lanes);
+        bool (*dot_i64)(const long long* a, const long long* b, std::size_t n, long long* lanes);
+    };
+
+    constexpr std::size_t KERNEL_LANES = 8;
+
+    // Combine the lanes of a reduction, always in the same order.
+    double sum_lanes(const double* lanes) noexcept;
+    // False if the sum doesn't fit in a 'long long'.
+    bool sum_lanes(const long long* lanes, long long& sum) noexcept;
+    double min_lanes(const double* lanes) noexcept;
+    long long min_lanes(const long long* lanes) noexcept;
+    double max_lanes(const double* lanes) noexcept;
+    long long max_lanes(const long long* lanes) noexcept;
+
+    // Best level the CPU supports, chosen on first use. Setting LYNX_SIMD to 'scalar', 'sse2' or 'avx2' caps it.
+    const Kernels& kernels();
+    // Kernels of a particular level, or nullptr if this build or CPU doesn't support it.
+    const Kernels* kernels(const Simd_Level level);
+
+    // Tables of each level, defined in kernels_<level>.cc.
+    const Kernels& scalar_kernels();
+    const Kernels* sse2_kernels();
+    const Kernels* avx2_kernels();
+
+}
+
+#endif //LYNX_KERNELS_H
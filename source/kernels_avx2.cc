@@ -0,0 +1,16 @@
+// Built with -mavx2 on x86 targets. Nothing here may run before kernels() has checked that the CPU supports it.
+
+#include "kernels_impl.h"
+
+namespace lynx {
+
+    const Kernels* avx2_kernels() {
+#if defined(__AVX2__)
+        static const Kernels kernels = make_kernels<4>(Simd_Level::AVX2);
+        return &kernels;
+#else
+        return nullptr;
+#endif
+    }
+
+}
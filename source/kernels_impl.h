@@ -0,0 +1,575 @@
+#ifndef LYNX_KERNELS_IMPL_H
+#define LYNX_KERNELS_IMPL_H
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include "kernels.h"
+
+// Bodies of the kernels, written once with GCC/Clang vector extensions and parametrized by the vector width.
+// Only kernels_<level>.cc include this, each compiled with the flags of its instruction set. Everything here has
+// internal linkage, so copies built for different instruction sets are never merged by the linker.
+
+namespace lynx {
+
+    namespace {
+
+        template<typename T, std::size_t WIDTH>
+        struct Vector_Type {
+            typedef T type __attribute__((vector_size(sizeof(T) * WIDTH)));
+        };
+
+        template<typename T, std::size_t WIDTH>
+        using Vector = typename Vector_Type<T, WIDTH>::type;
+
+        template<typename V, typename T>
+        V load(const T* data) {
+            V vector;
+            std::memcpy(&vector, data, sizeof(V));
+            return vector;
+        }
+
+        template<typename T, typename V>
+        void store(T* data, const V vector) {
+            std::memcpy(data, &vector, sizeof(V));
+        }
+
+        template<typename V, typename T>
+        V broadcast(const T value) {
+            return V{} + value;
+        }
+
+        struct Add {
+            template<typename V>
+            V operator()(const V a, const V b) const {
+                return a + b;
+            }
+        };
+
+        struct Subtract {
+            template<typename V>
+            V operator()(const V a, const V b) const {
+                return a - b;
+            }
+        };
+
+        struct Multiply {
+            template<typename V>
+            V operator()(const V a, const V b) const {
+                return a * b;
+            }
+        };
+
+        struct Divide {
+            template<typename V>
+            V operator()(const V a, const V b) const {
+                return a / b;
+            }
+        };
+
+        struct Minimum {
+            template<typename V>
+            V operator()(const V a, const V b) const {
+                return a < b ? a : b;
+            }
+        };
+
+        struct Maximum {
+            template<typename V>
+            V operator()(const V a, const V b) const {
+                return a > b ? a : b;
+            }
+        };
+
+        // Integers are added and subtracted as unsigned, where overflow is defined, and an overflow is told from the
+        // signs: the top bit of a lane of 'overflow' is set once an operation in that lane overflowed.
+        struct Checked_Add {
+            template<typename V>
+            V operator()(const V a, const V b, V& overflow) const {
+                const auto result = a + b;
+                overflow |= (a ^ result) & (b ^ result);
+                return result;
+            }
+        };
+
+        struct Checked_Subtract {
+            template<typename V>
+            V operator()(const V a, const V b, V& overflow) const {
+                const auto result = a - b;
+                overflow |= (a ^ b) & (a ^ result);
+                return result;
+            }
+        };
+
+        template<std::size_t WIDTH, typename V>
+        bool overflowed(const V overflow) {
+            for(std::size_t j = 0; j < WIDTH; ++j) {
+                if((overflow[j] >> 63) != 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        [[noreturn]] void throw_overflow() {
+            throw std::runtime_error{"Integer overflow in an element-wise operation"};
+        }
+
+        // Calls 'function' with the functor of the operation, so the loops are instantiated once per operation
+        // and never branch on it.
+        template<typename Function>
+        void with_operation(const Arithmetic operation, Function function) {
+            switch(operation) {
+                case Arithmetic::ADD:
+                    return function(Add{});
+                case Arithmetic::SUBTRACT:
+                    return function(Subtract{});
+                case Arithmetic::MULTIPLY:
+                    return function(Multiply{});
+                case Arithmetic::DIVIDE:
+                    return function(Divide{});
+            }
+        }
+
+        template<typename Function>
+        void with_comparison(const Comparison comparison, Function function) {
+            switch(comparison) {
+                case Comparison::EQUAL:
+                    return function([](const auto a, const auto b) { return a == b; });
+                case Comparison::NOT_EQUAL:
+                    return function([](const auto a, const auto b) { return a != b; });
+                case Comparison::LESS:
+                    return function([](const auto a, const auto b) { return a < b; });
+                case Comparison::LESS_EQUAL:
+                    return function([](const auto a, const auto b) { return a <= b; });
+                case Comparison::GREATER:
+                    return function([](const auto a, const auto b) { return a > b; });
+                case Comparison::GREATER_EQUAL:
+                    return function([](const auto a, const auto b) { return a >= b; });
+            }
+        }
+
+        void check_divisor(const long long dividend, const long long divisor) {
+            if(divisor == 0) {
+                throw std::runtime_error{"Division by zero"};
+            }
+            if(divisor == -1 && dividend == LLONG_MIN) {
+                throw std::runtime_error{"Integer overflow in division"};
+            }
+        }
+
+        // Element-wise loops run over full vectors and finish the tail one element at a time. 'A' is the type the
+        // elements are computed in.
+        template<std::size_t WIDTH, typename A, typename T, typename Operation>
+        void element_wise(const T* a, const T* b, T* out, const std::size_t n, const Operation operation) {
+            using V = Vector<A, WIDTH>;
+            using V1 = Vector<A, 1>;
+            std::size_t i = 0;
+            for(; i + WIDTH <= n; i += WIDTH) {
+                store(out + i, operation(load<V>(a + i), load<V>(b + i)));
+            }
+            for(; i < n; ++i) {
+                store(out + i, operation(load<V1>(a + i), load<V1>(b + i)));
+            }
+        }
+
+        template<std::size_t WIDTH, typename A, typename T, typename Operation>
+        void element_wise_scalar(const T* a, const T b, const bool reversed, T* out, const std::size_t n,
+                const Operation operation) {
+            using V = Vector<A, WIDTH>;
+            using V1 = Vector<A, 1>;
+            const auto vector_b = broadcast<V>(static_cast<A>(b));
+            const auto scalar_b = broadcast<V1>(static_cast<A>(b));
+            std::size_t i = 0;
+            if(reversed) {
+                for(; i + WIDTH <= n; i += WIDTH) {
+                    store(out + i, operation(vector_b, load<V>(a + i)));
+                }
+                for(; i < n; ++i) {
+                    store(out + i, operation(scalar_b, load<V1>(a + i)));
+                }
+                return;
+            }
+            for(; i + WIDTH <= n; i += WIDTH) {
+                store(out + i, operation(load<V>(a + i), vector_b));
+            }
+            for(; i < n; ++i) {
+                store(out + i, operation(load<V1>(a + i), scalar_b));
+            }
+        }
+
+        template<std::size_t WIDTH, typename Operation>
+        void checked_element_wise(const long long* a, const long long* b, long long* out, const std::size_t n,
+                const Operation operation) {
+            using V = Vector<unsigned long long, WIDTH>;
+            using V1 = Vector<unsigned long long, 1>;
+            V overflow{};
+            V1 tail_overflow{};
+            std::size_t i = 0;
+            for(; i + WIDTH <= n; i += WIDTH) {
+                store(out + i, operation(load<V>(a + i), load<V>(b + i), overflow));
+            }
+            for(; i < n; ++i) {
+                store(out + i, operation(load<V1>(a + i), load<V1>(b + i), tail_overflow));
+            }
+            if(overflowed<WIDTH>(overflow) || overflowed<1>(tail_overflow)) {
+                throw_overflow();
+            }
+        }
+
+        template<std::size_t WIDTH, typename Operation>
+        void checked_element_wise_scalar(const long long* a, const long long b, const bool reversed, long long* out,
+                const std::size_t n, const Operation operation) {
+            using V = Vector<unsigned long long, WIDTH>;
+            using V1 = Vector<unsigned long long, 1>;
+            const auto vector_b = broadcast<V>(static_cast<unsigned long long>(b));
+            const auto scalar_b = broadcast<V1>(static_cast<unsigned long long>(b));
+            V overflow{};
+            V1 tail_overflow{};
+            std::size_t i = 0;
+            if(reversed) {
+                for(; i + WIDTH <= n; i += WIDTH) {
+                    store(out + i, operation(vector_b, load<V>(a + i), overflow));
+                }
+                for(; i < n; ++i) {
+                    store(out + i, operation(scalar_b, load<V1>(a + i), tail_overflow));
+                }
+            } else {
+                for(; i + WIDTH <= n; i += WIDTH) {
+                    store(out + i, operation(load<V>(a + i), vector_b, overflow));
+                }
+                for(; i < n; ++i) {
+                    store(out + i, operation(load<V1>(a + i), scalar_b, tail_overflow));
+                }
+            }
+            if(overflowed<WIDTH>(overflow) || overflowed<1>(tail_overflow)) {
+                throw_overflow();
+            }
+        }
+
+        // Whether every element of 'a' and 'b', or of 'a' and the scalar 'b' if 'b' is null, fits in 32 bits, so that no
+        // product of two of them can overflow.
+        template<std::size_t WIDTH>
+        bool narrow(const long long* a, const long long* b, const long long scalar_b, const std::size_t n) {
+            using V = Vector<unsigned long long, WIDTH>;
+            constexpr unsigned long long HALF = 1ULL << 31;
+            if(b == nullptr && ((static_cast<unsigned long long>(scalar_b) + HALF) >> 32) != 0) {
+                return false;
+            }
+            V wide{};
+            unsigned long long tail_wide{};
+            std::size_t i = 0;
+            if(b == nullptr) {
+                for(; i + WIDTH <= n; i += WIDTH) {
+                    wide |= load<V>(a + i) + HALF;
+                }
+                for(; i < n; ++i) {
+                    tail_wide |= static_cast<unsigned long long>(a[i]) + HALF;
+                }
+            } else {
+                for(; i + WIDTH <= n; i += WIDTH) {
+                    wide |= (load<V>(a + i) + HALF) | (load<V>(b + i) + HALF);
+                }
+                for(; i < n; ++i) {
+                    tail_wide |= (static_cast<unsigned long long>(a[i]) + HALF)
+                            | (static_cast<unsigned long long>(b[i]) + HALF);
+                }
+            }
+            for(std::size_t j = 0; j < WIDTH; ++j) {
+                tail_wide |= wide[j];
+            }
+            return (tail_wide >> 32) == 0;
+        }
+
+        // Products of 32-bit factors are multiplied in the vectors, any others checked one at a time.
+        template<std::size_t WIDTH>
+        void checked_multiply(const long long* a, const long long* b, long long* out, const std::size_t n) {
+            if(narrow<WIDTH>(a, b, 0, n)) {
+                return element_wise<WIDTH, unsigned long long>(a, b, out, n, Multiply{});
+            }
+            bool overflow = false;
+            for(std::size_t i = 0; i < n; ++i) {
+                overflow |= __builtin_mul_overflow(a[i], b[i], out + i);
+            }
+            if(overflow) {
+                throw_overflow();
+            }
+        }
+
+        template<std::size_t WIDTH>
+        void checked_multiply_scalar(const long long* a, const long long b, long long* out, const std::size_t n) {
+            if(narrow<WIDTH>(a, nullptr, b, n)) {
+                return element_wise_scalar<WIDTH, unsigned long long>(a, b, false, out, n, Multiply{});
+            }
+            bool overflow = false;
+            for(std::size_t i = 0; i < n; ++i) {
+                overflow |= __builtin_mul_overflow(a[i], b, out + i);
+            }
+            if(overflow) {
+                throw_overflow();
+            }
+        }
+
+        template<std::size_t WIDTH, typename T>
+        void arithmetic(const Arithmetic operation, const T* a, const T* b, T* out, const std::size_t n) {
+            if constexpr(std::is_integral_v<T>) {
+                switch(operation) {
+                    case Arithmetic::ADD:
+                        return checked_element_wise<WIDTH>(a, b, out, n, Checked_Add{});
+                    case Arithmetic::SUBTRACT:
+                        return checked_element_wise<WIDTH>(a, b, out, n, Checked_Subtract{});
+                    case Arithmetic::MULTIPLY:
+                        return checked_multiply<WIDTH>(a, b, out, n);
+                    case Arithmetic::DIVIDE:
+                        for(std::size_t i = 0; i < n; ++i) {
+                            check_divisor(a[i], b[i]);
+                        }
+                        return element_wise<WIDTH, T>(a, b, out, n, Divide{});
+                }
+            } else {
+                with_operation(operation, [&](const auto functor) {
+                    element_wise<WIDTH, T>(a, b, out, n, functor);
+                });
+            }
+        }
+
+        template<std::size_t WIDTH, typename T>
+        void arithmetic_scalar(const Arithmetic operation, const T* a, const T b, const bool reversed, T* out,
+                const std::size_t n) {
+            if constexpr(std::is_integral_v<T>) {
+                switch(operation) {
+                    case Arithmetic::ADD:
+                        return checked_element_wise_scalar<WIDTH>(a, b, reversed, out, n, Checked_Add{});
+                    case Arithmetic::SUBTRACT:
+                        return checked_element_wise_scalar<WIDTH>(a, b, reversed, out, n, Checked_Subtract{});
+                    case Arithmetic::MULTIPLY:
+                        return checked_multiply_scalar<WIDTH>(a, b, out, n);
+                    case Arithmetic::DIVIDE:
+                        for(std::size_t i = 0; i < n; ++i) {
+                            reversed ? check_divisor(b, a[i]) : check_divisor(a[i], b);
+                        }
+                        return element_wise_scalar<WIDTH, T>(a, b, reversed, out, n, Divide{});
+                }
+            } else {
+                with_operation(operation, [&](const auto functor) {
+                    element_wise_scalar<WIDTH, T>(a, b, reversed, out, n, functor);
+                });
+            }
+        }
+
+        template<std::size_t WIDTH, typename Mask>
+        void store_mask(std::uint8_t* out, const Mask mask) {
+            for(std::size_t j = 0; j < WIDTH; ++j) {
+                out[j] = mask[j] != 0;
+            }
+        }
+
+        template<std::size_t WIDTH, typename T>
+        void compare(const Comparison comparison, const T* a, const T* b, std::uint8_t* out, const std::size_t n) {
+            using V = Vector<T, WIDTH>;
+            using V1 = Vector<T, 1>;
+            with_comparison(comparison, [&](const auto compare) {
+                std::size_t i = 0;
+                for(; i + WIDTH <= n; i += WIDTH) {
+                    store_mask<WIDTH>(out + i, compare(load<V>(a + i), load<V>(b + i)));
+                }
+                for(; i < n; ++i) {
+                    store_mask<1>(out + i, compare(load<V1>(a + i), load<V1>(b + i)));
+                }
+            });
+        }
+
+        template<std::size_t WIDTH, typename T>
+        void compare_scalar(const Comparison comparison, const T* a, const T b, std::uint8_t* out,
+                const std::size_t n) {
+            using V = Vector<T, WIDTH>;
+            using V1 = Vector<T, 1>;
+            const auto vector_b = broadcast<V>(b);
+            const auto scalar_b = broadcast<V1>(b);
+            with_comparison(comparison, [&](const auto compare) {
+                std::size_t i = 0;
+                for(; i + WIDTH <= n; i += WIDTH) {
+                    store_mask<WIDTH>(out + i, compare(load<V>(a + i), vector_b));
+                }
+                for(; i < n; ++i) {
+                    store_mask<1>(out + i, compare(load<V1>(a + i), scalar_b));
+                }
+            });
+        }
+
+        // Keeps KERNEL_LANES / WIDTH vectors of accumulators, so element i lands in lane i % KERNEL_LANES for any
+        // width. The tail is added lane by lane in the same positions.
+        template<std::size_t WIDTH, typename A, typename T, typename Reduction>
+        void reduce(const T* a, const std::size_t n, T* lanes, const Reduction reduction) {
+            using V = Vector<A, WIDTH>;
+            using V1 = Vector<A, 1>;
+            constexpr auto VECTORS = KERNEL_LANES / WIDTH;
+            V accumulators[VECTORS];
+            for(std::size_t k = 0; k < VECTORS; ++k) {
+                accumulators[k] = load<V>(lanes + k * WIDTH);
+            }
+            std::size_t i = 0;
+            for(; i + KERNEL_LANES <= n; i += KERNEL_LANES) {
+                for(std::size_t k = 0; k < VECTORS; ++k) {
+                    accumulators[k] = reduction(accumulators[k], load<V>(a + i + k * WIDTH));
+                }
+            }
+            for(std::size_t k = 0; k < VECTORS; ++k) {
+                store(lanes + k * WIDTH, accumulators[k]);
+            }
+            for(; i < n; ++i) {
+                auto lane = lanes + i % KERNEL_LANES;
+                store(lane, reduction(load<V1>(lane), load<V1>(a + i)));
+            }
+        }
+
+        template<std::size_t WIDTH>
+        void dot(const double* a, const double* b, const std::size_t n, double* lanes) {
+            using V = Vector<double, WIDTH>;
+            using V1 = Vector<double, 1>;
+            constexpr auto VECTORS = KERNEL_LANES / WIDTH;
+            V accumulators[VECTORS];
+            for(std::size_t k = 0; k < VECTORS; ++k) {
+                accumulators[k] = load<V>(lanes + k * WIDTH);
+            }
+            std::size_t i = 0;
+            for(; i + KERNEL_LANES <= n; i += KERNEL_LANES) {
+                for(std::size_t k = 0; k < VECTORS; ++k) {
+                    const auto offset = i + k * WIDTH;
+                    accumulators[k] += load<V>(a + offset) * load<V>(b + offset);
+                }
+            }
+            for(std::size_t k = 0; k < VECTORS; ++k) {
+                store(lanes + k * WIDTH, accumulators[k]);
+            }
+            for(; i < n; ++i) {
+                auto lane = lanes + i % KERNEL_LANES;
+                store(lane, load<V1>(lane) + load<V1>(a + i) * load<V1>(b + i));
+            }
+        }
+
+        // Products are only computed in the vectors while both factors fit in 32 bits, which their product then
+        // can't overflow. Anything else is reported like an overflowing sum.
+        template<std::size_t WIDTH>
+        bool dot(const long long* a, const long long* b, const std::size_t n, long long* lanes) {
+            using V = Vector<unsigned long long, WIDTH>;
+            constexpr auto VECTORS = KERNEL_LANES / WIDTH;
+            constexpr unsigned long long HALF = 1ULL << 31;
+            const Checked_Add add;
+            const auto half = broadcast<V>(HALF);
+            V accumulators[VECTORS];
+            for(std::size_t k = 0; k < VECTORS; ++k) {
+                accumulators[k] = load<V>(lanes + k * WIDTH);
+            }
+            V overflow[VECTORS]{};
+            V wide[VECTORS]{};
+            std::size_t i = 0;
+            for(; i + KERNEL_LANES <= n; i += KERNEL_LANES) {
+                for(std::size_t k = 0; k < VECTORS; ++k) {
+                    const auto offset = i + k * WIDTH;
+                    const auto x = load<V>(a + offset);
+                    const auto y = load<V>(b + offset);
+                    wide[k] |= (x + half) | (y + half);
+                    accumulators[k] = add(accumulators[k], x * y, overflow[k]);
+                }
+            }
+            for(std::size_t k = 1; k < VECTORS; ++k) {
+                overflow[0] |= overflow[k];
+                wide[0] |= wide[k];
+            }
+            for(std::size_t k = 0; k < VECTORS; ++k) {
+                store(lanes + k * WIDTH, accumulators[k]);
+            }
+            bool tail_overflow = false;
+            for(; i < n; ++i) {
+                auto lane = lanes + i % KERNEL_LANES;
+                long long product;
+                tail_overflow |= __builtin_mul_overflow(a[i], b[i], &product);
+                tail_overflow |= __builtin_add_overflow(*lane, product, lane);
+            }
+            for(std::size_t j = 0; j < WIDTH; ++j) {
+                if((wide[0][j] >> 32) != 0) {
+                    return false;
+                }
+            }
+            return !overflowed<WIDTH>(overflow[0]) && !tail_overflow;
+        }
+
+        template<std::size_t WIDTH>
+        void sum(const double* a, const std::size_t n, double* lanes) {
+            reduce<WIDTH, double>(a, n, lanes, Add{});
+        }
+
+        template<std::size_t WIDTH>
+        bool sum(const long long* a, const std::size_t n, long long* lanes) {
+            using V = Vector<unsigned long long, WIDTH>;
+            using V1 = Vector<unsigned long long, 1>;
+            constexpr auto VECTORS = KERNEL_LANES / WIDTH;
+            const Checked_Add add;
+            V accumulators[VECTORS];
+            for(std::size_t k = 0; k < VECTORS; ++k) {
+                accumulators[k] = load<V>(lanes + k * WIDTH);
+            }
+            // One per accumulator, so they don't make a chain of their own.
+            V overflow[VECTORS]{};
+            std::size_t i = 0;
+            for(; i + KERNEL_LANES <= n; i += KERNEL_LANES) {
+                for(std::size_t k = 0; k < VECTORS; ++k) {
+                    accumulators[k] = add(accumulators[k], load<V>(a + i + k * WIDTH), overflow[k]);
+                }
+            }
+            for(std::size_t k = 1; k < VECTORS; ++k) {
+                overflow[0] |= overflow[k];
+            }
+            for(std::size_t k = 0; k < VECTORS; ++k) {
+                store(lanes + k * WIDTH, accumulators[k]);
+            }
+            V1 tail_overflow{};
+            for(; i < n; ++i) {
+                auto lane = lanes + i % KERNEL_LANES;
+                store(lane, add(load<V1>(lane), load<V1>(a + i), tail_overflow));
+            }
+            return !overflowed<WIDTH>(overflow[0]) && !overflowed<1>(tail_overflow);
+        }
+
+        template<std::size_t WIDTH, typename T>
+        void minimum(const T* a, const std::size_t n, T* lanes) {
+            reduce<WIDTH, T>(a, n, lanes, Minimum{});
+        }
+
+        template<std::size_t WIDTH, typename T>
+        void maximum(const T* a, const std::size_t n, T* lanes) {
+            reduce<WIDTH, T>(a, n, lanes, Maximum{});
+        }
+
+        template<std::size_t WIDTH>
+        Kernels make_kernels(const Simd_Level level) {
+            static_assert(KERNEL_LANES % WIDTH == 0);
+            Kernels kernels{};
+            kernels.level = level;
+            kernels.arithmetic_f64 = &arithmetic<WIDTH, double>;
+            kernels.arithmetic_i64 = &arithmetic<WIDTH, long long>;
+            kernels.arithmetic_scalar_f64 = &arithmetic_scalar<WIDTH, double>;
+            kernels.arithmetic_scalar_i64 = &arithmetic_scalar<WIDTH, long long>;
+            kernels.compare_f64 = &compare<WIDTH, double>;
+            kernels.compare_i64 = &compare<WIDTH, long long>;
+            kernels.compare_scalar_f64 = &compare_scalar<WIDTH, double>;
+            kernels.compare_scalar_i64 = &compare_scalar<WIDTH, long long>;
+            kernels.sum_f64 = &sum<WIDTH>;
+            kernels.sum_i64 = &sum<WIDTH>;
+            kernels.min_f64 = &minimum<WIDTH, double>;
+            kernels.min_i64 = &minimum<WIDTH, long long>;
+            kernels.max_f64 = &maximum<WIDTH, double>;
+            kernels.max_i64 = &maximum<WIDTH, long long>;
+            kernels.dot_f64 = &dot<WIDTH>;
+            kernels.dot_i64 = &dot<WIDTH>;
+            return kernels;
+        }
+
+    }
+
+}
+
+#endif //LYNX_KERNELS_IMPL_H
@@ -0,0 +1,12 @@
+// Built with auto-vectorization disabled: this is the fallback for CPUs without any of the other levels.
+
+#include "kernels_impl.h"
+
+namespace lynx {
+
+    const Kernels& scalar_kernels() {
+        static const Kernels kernels = make_kernels<1>(Simd_Level::SCALAR);
+        return kernels;
+    }
+
+}
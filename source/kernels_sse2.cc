@@ -0,0 +1,16 @@
+// Built with -msse2 on x86 targets.
+
+#include "kernels_impl.h"
+
+namespace lynx {
+
+    const Kernels* sse2_kernels() {
+#if defined(__SSE2__)
+        static const Kernels kernels = make_kernels<2>(Simd_Level::SSE2);
+        return &kernels;
+#else
+        return nullptr;
+#endif
+    }
+
+}
@@ -0,0 +1,69 @@
+#include "lazy_bodies.h"
+
+#include <stdexcept>
+
+#include "fusion.h"
+
+namespace lynx {
+
+    namespace {
+
+        // Like to_string(Diagnostic), but as the message of a runtime error.
+        std::string to_error(const Diagnostic& diagnostic) {
+            return diagnostic.filename + ':' + std::to_string(diagnostic.line) + ':' + std::to_string(diagnostic.column)
+                    + ": " + diagnostic.message;
+        }
+
+    }
+
+    Lazy_Bodies::Lazy_Bodies(std::unique_ptr<Lexer> lexer, std::unique_ptr<Resolver> resolver,
+            const std::vector<Deferred_Body>& deferred)
+            : _lexer{std::move(lexer)}, _resolver{std::move(resolver)}, _bodies(deferred.size()) {
+        for(std::size_t i = 0; i < deferred.size(); ++i) {
+            _bodies[i].deferred = deferred[i];
+            deferred[i].function->lazy = this;
+            deferred[i].function->lazy_index = i;
+        }
+    }
+
+    void Lazy_Bodies::compile(const Function_Declaration& function) {
+        auto& body = _bodies[function.lazy_index];
+        if(!body.compiled.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock{_mutex};
+            if(!body.compiled.load(std::memory_order_relaxed)) {
+                compile(body);
+                ++_compiled;
+                body.compiled.store(true, std::memory_order_release);
+            }
+        }
+        if(!body.error.empty()) {
+            throw std::runtime_error{body.error};
+        }
+    }
+
+    std::size_t Lazy_Bodies::compiled() const noexcept {
+        return _compiled.load();
+    }
+
+    std::size_t Lazy_Bodies::size() const noexcept {
+        return _bodies.size();
+    }
+
+    void Lazy_Bodies::compile(Body& body) {
+        auto& function = *body.deferred.function;
+        Parser parser{*_lexer};
+        auto block = parser.deferred_body(body.deferred);
+        if(block == nullptr) {
+            body.error = to_error(parser.diagnostics().front());
+            return;
+        }
+        Fusion_Pass fusion;
+        fusion.fuse(static_cast<Block&>(*block).statements);
+        function.body = std::move(block);
+        if(const auto diagnostics = _resolver->resolve_body(function); !diagnostics.empty()) {
+            body.error = to_error(diagnostics.front());
+            function.body = nullptr;
+        }
+    }
+
+}
@@ -0,0 +1,53 @@
+#ifndef LYNX_LAZY_BODIES_H
+#define LYNX_LAZY_BODIES_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "lexer.h"
+#include "parser.h"
+#include "resolver.h"
+
+namespace lynx {
+
+    // Lazy_Bodies keeps the tokens of a file whose function bodies Parser skipped, and compiles each body the first
+    // time its function is called. Functions that are never called cost only the matching of their braces.
+    class Lazy_Bodies {
+    public:
+        // 'resolver' is the one that resolved the rest of the file, so it already knows every function the bodies
+        // can call. Sets Function_Declaration::lazy of every function in 'deferred'.
+        Lazy_Bodies(std::unique_ptr<Lexer> lexer, std::unique_ptr<Resolver> resolver,
+                const std::vector<Deferred_Body>& deferred);
+
+        // Parses, fuses and resolves the body of the function, unless that's already done. If the body has an
+        // error, throws std::runtime_error with it on this and every later call. Safe to call from any thread.
+        void compile(const Function_Declaration& function);
+
+        // Bodies compiled so far, out of size().
+        std::size_t compiled() const noexcept;
+        std::size_t size() const noexcept;
+
+    private:
+        struct Body {
+            Deferred_Body     deferred{};
+            std::atomic<bool> compiled{};
+            // Of the first error, if the body doesn't compile.
+            std::string       error;
+        };
+
+        void compile(Body& body);
+
+        // Parsing moves the lexer, so bodies are compiled one at a time.
+        std::mutex                _mutex;
+        std::unique_ptr<Lexer>    _lexer;
+        std::unique_ptr<Resolver> _resolver;
+        std::vector<Body>         _bodies;
+        std::atomic<std::size_t>  _compiled{};
+    };
+
+}
+
+#endif //LYNX_LAZY_BODIES_H
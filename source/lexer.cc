@@ -2,31 +2,110 @@
 
 #include <cctype>
 
-#include <iostream>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <limits>
 #include <stdexcept>
 
+#include "big_integer.h"
+#include "instrumentation.h"
+
 namespace {
 
     class Lexer_Error : public std::runtime_error {
         using std::runtime_error::runtime_error;
     };
 
+    // 10^k is exact in a long double up to this k: 5^27 still fits in the 64-bit significand of x87 long doubles,
+    // 5^22 in the 53 bits of a double.
+    constexpr int EXACT_POWERS = std::numeric_limits<long double>::digits >= 64 ? 27 : 22;
+
+    // Clinger's fast path: if the digits without the point and the power of ten are both exact, their quotient
+    // is rounded once and is the correctly rounded value. That covers most literals, and from_chars, which is
+    // much slower for long doubles, only sees the rest.
+    std::optional<long double> exact_decimal(const char* first, const char* const last) noexcept {
+        constexpr auto DIGITS = std::numeric_limits<long double>::digits;
+        static const auto powers = [] {
+            std::array<long double, EXACT_POWERS + 1> powers{1.0L};
+            for(std::size_t k = 1; k < powers.size(); ++k) {
+                powers[k] = powers[k - 1] * 10;
+            }
+            return powers;
+        }();
+        std::uint64_t digits = 0;
+        int fraction_digits = -1;
+        for(; first != last; ++first) {
+            if(*first == '.') {
+                fraction_digits = 0;
+                continue;
+            }
+            if(digits > (std::numeric_limits<std::uint64_t>::max() - 9) / 10) {
+                return std::nullopt;
+            }
+            digits = digits * 10 + static_cast<std::uint64_t>(*first - '0');
+            fraction_digits += fraction_digits >= 0;
+        }
+        if constexpr(DIGITS < 64) {
+            if(digits >> DIGITS != 0) {
+                return std::nullopt;
+            }
+        }
+        if(fraction_digits > EXACT_POWERS) {
+            return std::nullopt;
+        }
+        return static_cast<long double>(digits) / powers[std::max(fraction_digits, 0)];
+    }
+
+    // Character that a backslash followed by 'escape' stands for, or 0 if that isn't an escape sequence.
+    char unescape(const char escape) noexcept {
+        switch(escape) {
+            case '\'':
+            case '"':
+            case '?':
+            case '\\':
+                return escape;
+            case 'a':
+                return '\a';
+            case 'b':
+                return '\b';
+            case 'f':
+                return '\f';
+            case 'n':
+                return '\n';
+            case 'r':
+                return '\r';
+            case 't':
+                return '\t';
+            case 'v':
+                return '\v';
+            default:
+                return 0;
+        }
+    }
+
 }
 
 namespace lynx {
 
     const std::map<std::string, Token::Type> Lexer::_KEYWORDS {
-        {"func",  Token::Type::FUNC},
-        {"let",   Token::Type::LET},
-        {"var",   Token::Type::VAR},
-        {"if",    Token::Type::IF},
-        {"else",  Token::Type::ELSE},
-        {"for",   Token::Type::FOR},
-        {"while", Token::Type::WHILE},
-        {"do",    Token::Type::DO},
-        {"true",  Token::Type::TRUE},
-        {"false", Token::Type::FALSE},
-        {"print", Token::Type::PRINT},
+        {"func",     Token::Type::FUNC},
+        {"let",      Token::Type::LET},
+        {"var",      Token::Type::VAR},
+        {"if",       Token::Type::IF},
+        {"else",     Token::Type::ELSE},
+        {"for",      Token::Type::FOR},
+        {"while",    Token::Type::WHILE},
+        {"do",       Token::Type::DO},
+        {"true",     Token::Type::TRUE},
+        {"false",    Token::Type::FALSE},
+        {"print",    Token::Type::PRINT},
+        {"return",   Token::Type::RETURN},
+        {"parallel", Token::Type::PARALLEL},
+        {"in",       Token::Type::IN},
+        {"reduce",   Token::Type::REDUCE},
+        {"yield",    Token::Type::YIELD},
+        {"import",   Token::Type::IMPORT},
     };
 
     const std::map<std::string, Token::Type> Lexer::_OPERATORS{
@@ -37,6 +116,8 @@ namespace lynx {
         {"[",  Token::Type::L_BRACKET},
         {"]",  Token::Type::R_BRACKET},
         {":",  Token::Type::COLON},
+        {",",  Token::Type::COMMA},
+        {"..", Token::Type::DOT_DOT},
         {";",  Token::Type::SEMICOLON},
         {"=",  Token::Type::EQUALS},
         {"+",  Token::Type::PLUS},
@@ -53,8 +134,13 @@ namespace lynx {
     };
 
     Lexer::Lexer(const std::string& filename, std::string&& code)
-            : _code{std::move(code)}, _filename{filename} {
+            : _code{std::move(code)}, _source_map{filename, _code} {
+        if(_code.length() > std::numeric_limits<std::uint32_t>::max()) {
+            _diagnostics.push_back(Diagnostic{"Source files can't be larger than 4 GiB", filename, 1, 1});
+            _code_pos = _code.length();
+        }
         while(_code_pos < _code.length()) {
+            const auto start = _code_pos;
             try {
                 const char c = _code[_code_pos];
                 if(is_whitespace(c)) {
@@ -82,17 +168,23 @@ namespace lynx {
                     continue;
                 }
             } catch(const Lexer_Error& e) {
-                ++_errors_reported;
-                std::cerr << "Error: " << e.what() << ".\n";
+                LYNX_COUNT(EXCEPTIONS);
+                _diagnostics.push_back(_source_map.diagnostic(e.what(), static_cast<std::uint32_t>(start)));
                 continue;
             }
         }
-        _tokens.push_back(Token{Token::Type::END_OF_FILE, "", _filename, _line, _code_pos - _last_newline});
+        const auto end = std::min<std::size_t>(_code_pos, std::numeric_limits<std::uint32_t>::max());
+        _tokens.push_back(Token{Token::Type::END_OF_FILE, "", static_cast<std::uint32_t>(end)});
         _tokens.shrink_to_fit();
+        _literals.shrink_to_fit();
     }
 
     std::size_t Lexer::errors_reported() const noexcept {
-        return _errors_reported;
+        return _diagnostics.size();
+    }
+
+    const std::vector<Diagnostic>& Lexer::diagnostics() const noexcept {
+        return _diagnostics;
     }
 
     Token Lexer::next_token() noexcept {
@@ -109,100 +201,140 @@ namespace lynx {
         return _tokens.back();
     }
 
+    std::size_t Lexer::token_count() const noexcept {
+        return _tokens.size() - 1;
+    }
+
+    const Source_Map& Lexer::source_map() const noexcept {
+        return _source_map;
+    }
+
+    const Value& Lexer::literal(const Token& token) const noexcept {
+        return _literals[token.literal];
+    }
+
     bool Lexer::is_at_end() const {
         return peek_token(0).type == Token::Type::END_OF_FILE;
     }
 
+    std::size_t Lexer::position() const noexcept {
+        return _current_token;
+    }
+
+    void Lexer::seek(const std::size_t position) noexcept {
+        _current_token = position;
+    }
+
+    Token::Type Lexer::type_at(const std::size_t position) const noexcept {
+        return _tokens[std::min(position, _tokens.size() - 1)].type;
+    }
+
     char Lexer::get_next_character() {
         char c;
         try {
             c = _code.at(++_code_pos);
         } catch(const std::out_of_range& e) {
+            LYNX_COUNT(EXCEPTIONS);
             c = 0;
         }
         return c;
     }
 
-    void Lexer::handle_whitespace(const char c) {
-        if(c == '\n') {
-            ++_line;
-            _last_newline = _code_pos + 1;
-        }
+    void Lexer::handle_whitespace(const char) {
         ++_code_pos;
     }
 
     void Lexer::handle_comment(char c) {
-        while(c != '\n') {
+        while(c != '\n' && c != 0) {
             c = get_next_character();
         }
     }
 
-    void Lexer::tokenize_string(char c) {
-        static std::map<char, char> escape_sequences{
-                {'\'', '\''},
-                {'\"', '\"'},
-                {'\?', '\?'},
-                {'\\', '\\'},
-                {'a', '\a'},
-                {'b', '\b'},
-                {'f', '\f'},
-                {'n', '\n'},
-                {'r', '\r'},
-                {'t', '\t'},
-                {'v', '\v'},
-        };
-        std::string str{};
-        c = get_next_character();
-        while(c != '"') {
-            if(c == '\\') {
-                c = get_next_character();
-                if(auto result = escape_sequences.find(c); result != escape_sequences.cend()) {
-                    str += result->second;
-                } else {
-                    ++_code_pos;
-                    throw Lexer_Error{"Unknown escape sequence '\\" + std::string{c} + "'"};
-                }
+    void Lexer::tokenize_string(char) {
+        const auto start = _code_pos;
+        auto run = start + 1;
+        auto stop = _code.find_first_of("\"\\", run);
+        // Most strings have no escape sequences and are copied out of the source in one piece.
+        if(stop != std::string::npos && _code[stop] == '"') {
+            _code_pos = stop + 1;
+            add_literal(Token::Type::STRING, make_string(std::string_view{_code}.substr(run, stop - run)), start);
+            return;
+        }
+        String text;
+        while(stop != std::string::npos && _code[stop] != '"') {
+            text.append(_code, run, stop - run);
+            if(stop + 1 == _code.length()) {
+                break;
+            }
+            const auto escape = _code[stop + 1];
+            if(const auto character = unescape(escape); character != 0) {
+                text += character;
             } else {
-                str += c;
+                _code_pos = stop + 2;
+                throw Lexer_Error{"Unknown escape sequence '\\" + std::string{escape} + "'"};
             }
-            c = get_next_character();
+            run = stop + 2;
+            stop = _code.find_first_of("\"\\", run);
+        }
+        if(stop == std::string::npos || _code[stop] != '"') {
+            _code_pos = _code.length();
+            throw Lexer_Error{"Unterminated string"};
         }
-        get_next_character();
-        _tokens.push_back(Token{Token::Type::STRING, str, _filename, _line, _code_pos - _last_newline});
+        text.append(_code, run, stop - run);
+        _code_pos = stop + 1;
+        LYNX_COUNT(STRING_ALLOCATIONS);
+        add_literal(Token::Type::STRING, Value{Value::Type::STRING, make_managed<String>(std::move(text))}, start);
     }
 
-    // FIXME: Hangs when more than one dot.
-    void Lexer::tokenize_number(char c) {
-        std::string number{};
+    void Lexer::tokenize_number(char) {
+        const auto start = _code_pos;
+        auto stop = start;
         bool is_float = false;
-        while(is_digit(c) || c == '.') {
-            if(c == '.') {
-                if(is_float) {
-                    ++_code_pos;    // Skip dot.
-                    throw Lexer_Error{"Too many decimal points"};
-                }
-                is_float = true;
+        for(; stop < _code.length() && (is_digit(_code[stop]) || _code[stop] == '.'); ++stop) {
+            if(_code[stop] != '.') {
+                continue;
             }
-            number += c;
-            c = get_next_character();
+            if(stop + 1 < _code.length() && _code[stop + 1] == '.') {
+                break;  // Range operator, '0..10'.
+            }
+            if(is_float) {
+                _code_pos = stop + 1;   // Skip dot.
+                throw Lexer_Error{"Too many decimal points"};
+            }
+            is_float = true;
         }
+        _code_pos = stop;
+        const auto first = _code.data() + start;
+        const auto last = _code.data() + stop;
         if(is_float) {
-            _tokens.push_back(Token{Token::Type::FLOAT, number, _filename, _line, _code_pos - _last_newline});
-        } else {
-            _tokens.push_back(Token{Token::Type::INTEGER, number, _filename, _line, _code_pos - _last_newline});
+            auto number = exact_decimal(first, last);
+            if(!number.has_value() && std::from_chars(first, last, number.emplace()).ec != std::errc{}) {
+                throw Lexer_Error{"Number is out of range"};
+            }
+            add_literal(Token::Type::FLOAT, Value{Value::Type::FLOAT, *number}, start);
+            return;
+        }
+        long long number;
+        if(std::from_chars(first, last, number).ec == std::errc{}) {
+            add_literal(Token::Type::INTEGER, Value{Value::Type::INTEGER, number}, start);
+            return;
         }
+        // Too large for a 'long long'.
+        add_literal(Token::Type::INTEGER, make_integer(Big_Integer::parse(std::string_view{first, stop - start})),
+                start);
     }
 
     void Lexer::tokenize_identifier(char c) {
+        const auto start = _code_pos;
         std::string identifier{};
         while(is_identifier_character(c)) {
             identifier += c;
             c = get_next_character();
         }
         if(auto keyword = is_keyword(identifier); keyword.has_value()) {
-            _tokens.push_back(Token{*keyword, "", _filename, _line, _code_pos - _last_newline});
+            add_token(*keyword, "", start);
         } else {
-            _tokens.push_back(Token{Token::Type::IDENTIFIER, identifier, _filename, _line, _code_pos - _last_newline});
+            add_token(Token::Type::IDENTIFIER, std::move(identifier), start);
         }
     }
 
@@ -215,19 +347,31 @@ namespace lynx {
             try {
                 c = _code.at(_code_pos + length);
             } catch(const std::out_of_range& e) {
+                LYNX_COUNT(EXCEPTIONS);
                 break;
             }
         }
         while(length > 0) {
             if(auto result = is_valid_opearator(operator_); result.has_value()) {
+                add_token(*result, "", _code_pos);
                 _code_pos += length;
-                _tokens.push_back(Token{*result, "", _filename, _line, _code_pos - _last_newline});
                 return;
             }
             operator_.pop_back();
             --length;
         }
-        throw Lexer_Error{"Uknown operator \"" + operator_ + "\""};
+        const char unknown = _code[_code_pos++];    // Skip the unknown character.
+        throw Lexer_Error{"Uknown operator \"" + std::string{unknown} + "\""};
+    }
+
+    void Lexer::add_token(const Token::Type type, std::string value, const std::size_t start) {
+        _tokens.push_back(Token{type, std::move(value), static_cast<std::uint32_t>(start)});
+    }
+
+    void Lexer::add_literal(const Token::Type type, Value literal, const std::size_t start) {
+        _tokens.push_back(Token{type, {}, static_cast<std::uint32_t>(start),
+                static_cast<std::uint32_t>(_literals.size())});
+        _literals.push_back(std::move(literal));
     }
 
     bool Lexer::is_whitespace(const char c) const noexcept {
@@ -245,7 +389,7 @@ namespace lynx {
         if(c >= 'A' && c <= 'Z') {
             return true;
         }
-        if(c >= '0' && c <= '0') {
+        if(c >= '0' && c <= '9') {
             return true;
         }
         if(c == '_') {
@@ -2,10 +2,14 @@
 #define LYNX_LEXER_H
 
 #include <map>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "diagnostic.h"
+#include "source_map.h"
 #include "token.h"
+#include "value.h"
 
 namespace lynx {
 
@@ -14,11 +18,23 @@ namespace lynx {
         Lexer(const std::string& filename, std::string&& code);
 
         std::size_t errors_reported() const noexcept;
+        const std::vector<Diagnostic>& diagnostics() const noexcept;
 
         Token next_token() noexcept;
         Token peek_token(int depth = 1) const noexcept;
 
         bool is_at_end() const;
+        // Index of the next token, which seek() can return to later.
+        std::size_t position() const noexcept;
+        void seek(const std::size_t position) noexcept;
+        // Type of the token at 'position', without moving to it.
+        Token::Type type_at(const std::size_t position) const noexcept;
+        // Tokens of the whole input, not counting the end of file.
+        std::size_t token_count() const noexcept;
+        // Locations of the tokens, which keep only their offset.
+        const Source_Map& source_map() const noexcept;
+        // Value of an INTEGER, FLOAT or STRING token, decoded once when the token was read.
+        const Value& literal(const Token& token) const noexcept;
 
     private:
         char get_next_character();
@@ -30,6 +46,9 @@ namespace lynx {
         void tokenize_identifier(char c);
         void tokenize_operator(char c);
 
+        void add_token(const Token::Type type, std::string value, const std::size_t start);
+        void add_literal(const Token::Type type, Value literal, const std::size_t start);
+
         bool is_whitespace(const char c) const noexcept;
         bool is_digit(const char c) const noexcept;
         bool is_identifier_character(const char c) const noexcept;
@@ -40,12 +59,12 @@ namespace lynx {
 
         std::string _code;
         std::size_t _code_pos{};
-        std::string _filename;
-        std::size_t _line{1};
-        std::size_t _last_newline{1};
-        std::size_t _errors_reported{};
+        Source_Map  _source_map;
+
+        std::vector<Diagnostic> _diagnostics;
 
         std::vector<Token> _tokens;
+        std::vector<Value> _literals;
         std::size_t        _current_token{};
 
         static const std::map<std::string, Token::Type> _KEYWORDS;
@@ -1,57 +1,345 @@
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <vector>
 
+#include <unistd.h>
+
+#include "batch.h"
+#include "file.h"
+#include "heap.h"
+#include "instrumentation.h"
 #include "interpreter.h"
-#include "parser.h"
+#include "profiler.h"
+#include "output.h"
+#include "program.h"
+#include "server.h"
+#include "snapshot.h"
+#include "stats.h"
 
 namespace lynx {
 
+    struct Options {
+        std::vector<std::string> paths;
+        bool                     fusion_stats = false;
+        bool                     heap_stats = false;
+        bool                     direct_io = false;
+        bool                     lazy = false;
+        bool                     profile = false;
+        std::string              profile_stacks;
+        bool                     stats = false;
+        bool                     stats_json = false;
+        std::string              snapshot;
+        std::string              restore;
+        Limits                   limits;
+        // Batch mode.
+        std::size_t              jobs{};
+        std::string              manifest;
+        bool                     streamed = false;
+        // Server mode, and running a script through a server.
+        std::string              serve;
+        std::string              connect;
+
+        Body_Compilation bodies() const noexcept {
+            return lazy ? Body_Compilation::LAZY : Body_Compilation::EAGER;
+        }
+
+        bool is_batch() const noexcept {
+            return jobs > 0 || !manifest.empty() || paths.size() > 1;
+        }
+    };
+
     void print_usage() {
-        std::cout << "Usage: lync <source_file.lnx>\n";
+        std::cout << "Usage: lync [--fusion-stats] [--heap-stats] [--direct-io] [--lazy] [--profile] "
+                "[--profile-stacks <file>] [--stats | --stats-json]\n"
+                "            [--max-steps <n>] [--max-heap <bytes>] [--max-time <ms>]\n"
+                "            [--snapshot <file> | --restore <file>] <source_file.lnx>\n"
+                "       lync [--jobs <n>] [--stream] [--lazy] [--max-steps <n>] [--max-heap <bytes>] [--max-time <ms>]\n"
+                "            [--manifest <file>] <source_file.lnx>...\n"
+                "       lync --serve <socket> [--jobs <n>] [--max-steps <n>] [--max-heap <bytes>] [--max-time <ms>]\n"
+                "       lync --connect <socket> <source_file.lnx>\n"
+                "Exit status: 0 once the script ran, even into a runtime error, 1 if a file can't be read, the output\n"
+                "can't be written or a script of a batch failed, 2 on lexer, parser and resolver errors, 3 if the\n"
+                "script exceeded one of its limits.\n";
+    }
+
+    // Reads a whole argument as a number in [1, max]. Anything else, like "abc", "-5" or "10k", is rejected.
+    template<typename Number>
+    bool parse_number(const char* text, const Number max, Number& value) {
+        const auto end = text + std::strlen(text);
+        const auto [stop, error] = std::from_chars(text, end, value);
+        return error == std::errc{} && stop == end && value > 0 && value <= max;
+    }
+
+    bool parse_options(int argc, char** argv, Options& options) {
+        for(int i = 1; i < argc; ++i) {
+            const std::string argument{argv[i]};
+            if(argument == "--fusion-stats") {
+                options.fusion_stats = true;
+            } else if(argument == "--heap-stats") {
+                options.heap_stats = true;
+            } else if(argument == "--stats") {
+                options.stats = true;
+            } else if(argument == "--stats-json") {
+                options.stats_json = true;
+            } else if(argument == "--profile") {
+                options.profile = true;
+            } else if(argument == "--profile-stacks" && i + 1 < argc) {
+                options.profile = true;
+                options.profile_stacks = argv[++i];
+            } else if(argument == "--max-steps" && i + 1 < argc) {
+                if(!parse_number(argv[++i], std::numeric_limits<std::uint64_t>::max(), options.limits.steps)) {
+                    return false;
+                }
+            } else if(argument == "--max-heap" && i + 1 < argc) {
+                if(!parse_number(argv[++i], Heap_Budget::UNLIMITED, options.limits.heap_bytes)) {
+                    return false;
+                }
+            } else if(argument == "--max-time" && i + 1 < argc) {
+                // The deadline is a time point of the steady clock, which has to be able to hold it.
+                const auto max_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::duration::max()).count() / 2;
+                std::chrono::milliseconds::rep milliseconds{};
+                if(!parse_number(argv[++i], max_time, milliseconds)) {
+                    return false;
+                }
+                options.limits.time = std::chrono::milliseconds{milliseconds};
+            } else if(argument == "--snapshot" && i + 1 < argc) {
+                options.snapshot = argv[++i];
+            } else if(argument == "--restore" && i + 1 < argc) {
+                options.restore = argv[++i];
+            } else if(argument == "--direct-io") {
+                options.direct_io = true;
+            } else if(argument == "--lazy") {
+                options.lazy = true;
+            } else if(argument == "--stream") {
+                options.streamed = true;
+            } else if(argument == "--jobs" && i + 1 < argc) {
+                if(!parse_number(argv[++i], std::numeric_limits<std::size_t>::max(), options.jobs)) {
+                    return false;
+                }
+            } else if(argument == "--manifest" && i + 1 < argc) {
+                options.manifest = argv[++i];
+            } else if(argument == "--serve" && i + 1 < argc) {
+                options.serve = argv[++i];
+            } else if(argument == "--connect" && i + 1 < argc) {
+                options.connect = argv[++i];
+            } else if(argument.rfind("--", 0) == 0) {
+                return false;
+            } else {
+                options.paths.push_back(argument);
+            }
+        }
+        if(!options.serve.empty()) {
+            return options.paths.empty() && options.manifest.empty();
+        }
+        if(!options.connect.empty()) {
+            return options.paths.size() == 1;
+        }
+        return !options.paths.empty() || !options.manifest.empty();
     }
 
-    std::string get_file_content(const std::string& path) {
-        std::stringstream buffer;
-        std::ifstream file{path};
-        if(!file.good()) {
-            std::cerr << "Error: File \"" << path << "\" not found. Exiting...\n";
-            return "";
+    // Nothing if the file can't be read, which is reported. An empty file is read as an empty script.
+    std::optional<std::string> get_file_content(const std::string& path) {
+        auto content = read_file(path);
+        if(!content.has_value()) {
+            std::cerr << "Error: Can't read file \"" << path << "\". Exiting...\n";
         }
-        while(!file.eof()) {
-            std::string line{};
-            std::getline(file, line);
-            buffer << line << '\n';
+        return content;
+    }
+
+    void print_fusion_stats(const Program& program, const Interpreter& interpreter) {
+        std::cerr << "Fusion statistics (pattern: rewritten, executed):\n";
+        for(std::size_t i = 0; i < static_cast<std::size_t>(Fused_Pattern::COUNT); ++i) {
+            std::cerr << "  " << to_string(static_cast<Fused_Pattern>(i)) << ": " << program.fusion_rewrites()[i] << ", "
+                    << interpreter.fusion_counters()[i] << '\n';
+        }
+    }
+
+    void print_profile(const Profiler& profiler, const Options& options) {
+        profiler.write_report(std::cerr);
+        if(options.profile_stacks.empty()) {
+            return;
+        }
+        std::ofstream stacks{options.profile_stacks};
+        profiler.write_collapsed_stacks(stacks);
+        if(!stacks) {
+            std::cerr << "Error: Can't write \"" << options.profile_stacks << "\".\n";
+        }
+    }
+
+#if LYNX_DEBUG
+    // Debug builds report their instrumentation counters when the process exits, to the file named by
+    // LYNX_COUNTERS or to stderr.
+    void dump_counters() {
+        if(const auto path = std::getenv("LYNX_COUNTERS"); path != nullptr) {
+            std::ofstream file{path};
+            write_counters_json(file);
+            return;
+        }
+        write_counters_json(std::cerr);
+    }
+#endif
+
+    // Output that couldn't be written fails a run that would otherwise have succeeded.
+    int check_output(const Output_Buffer& output, const int status) {
+        if(!output.failed()) {
+            return status;
         }
-        return buffer.str();
+        std::cerr << "Error: Can't write the output, some of it was lost. Exiting...\n";
+        return status == 0 ? 1 : status;
+    }
+
+    int run_batch(Options& options, Output_Buffer& output) {
+        if(!options.manifest.empty()) {
+            const auto manifest = get_file_content(options.manifest);
+            if(!manifest.has_value()) {
+                return 1;
+            }
+            for(auto& path : read_manifest(*manifest)) {
+                options.paths.push_back(std::move(path));
+            }
+        }
+        Batch_Options batch_options;
+        if(options.jobs > 0) {
+            batch_options.jobs = options.jobs;
+        }
+        batch_options.streamed = options.streamed;
+        batch_options.bodies = options.bodies();
+        batch_options.limits = options.limits;
+        const auto summary = run_batch(options.paths, batch_options, output, error_output());
+        output.flush();
+        print_summary(summary, error_output());
+        error_output().flush();
+        return check_output(output, summary.failed > 0 ? 1 : 0);
+    }
+
+    // Runs the whole script, or with --snapshot only up to its 'snapshot()' and with --restore only after it.
+    Run_Result run_script(const Options& options, const Program& program, Interpreter& interpreter) {
+        try {
+            if(!options.snapshot.empty()) {
+                Snapshot snapshot;
+                auto result = interpreter.run_to_snapshot(program, snapshot);
+                if(result.ok()) {
+                    write_snapshot(options.snapshot, snapshot);
+                }
+                return result;
+            }
+            if(!options.restore.empty()) {
+                return interpreter.run_from_snapshot(program, read_snapshot(options.restore));
+            }
+        } catch(const std::runtime_error& e) {
+            return Run_Result{Run_Result::Status::RUNTIME_ERROR, e.what()};
+        }
+        return interpreter.run(program);
+    }
+
+    int serve(const Options& options) {
+        Server server{options.serve, options.jobs > 0 ? options.jobs : std::thread::hardware_concurrency(),
+                options.limits};
+        try {
+            server.serve();
+        } catch(const std::runtime_error& e) {
+            std::cerr << "Error: " << e.what() << ".\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    int run_remote(const Options& options, Output_Buffer& output) {
+        // The server resolves paths against its own working directory, not ours.
+        std::error_code error;
+        const auto path = std::filesystem::absolute(options.paths[0], error);
+        const auto status = run_remote(options.connect, error ? options.paths[0] : path.string(), output,
+                error_output());
+        if(status < 0) {
+            std::cerr << "Error: Can't reach the server at \"" << options.connect << "\". Exiting...\n";
+            return 1;
+        }
+        output.flush();
+        return check_output(output, status);
     }
 
 }
 
 int main(int argc, char** argv) {
-    if(argc != 2) {
+#if LYNX_DEBUG
+    std::atexit(lynx::dump_counters);
+#endif
+    lynx::Options options;
+    if(!lynx::parse_options(argc, argv, options)) {
         lynx::print_usage();
         return 0;
     }
-    auto code = lynx::get_file_content(argv[1]);
-    if(code == "") {
+    // Script output bypasses iostreams entirely; --direct-io even skips std::cout's own buffer.
+    auto output = options.direct_io ? std::make_unique<lynx::Output_Buffer>(STDOUT_FILENO)
+            : std::make_unique<lynx::Output_Buffer>(std::cout);
+    if(!options.serve.empty()) {
+        return lynx::serve(options);
+    }
+    if(!options.connect.empty()) {
+        return lynx::run_remote(options, *output);
+    }
+    if(options.is_batch()) {
+        return lynx::run_batch(options, *output);
+    }
+    // The heap only keeps a peak for budgets, an unlimited one measures the whole run.
+    std::optional<lynx::Heap_Budget> heap_peak;
+    if(options.heap_stats || options.stats_json) {
+        heap_peak.emplace(lynx::Heap_Budget::UNLIMITED);
+    }
+    lynx::Phase_Recorder phases;
+    phases.begin("load");
+    auto code = lynx::get_file_content(options.paths[0]);
+    if(!code.has_value()) {
         return 1;
     }
-    lynx::Lexer lexer{argv[1], std::move(code)};
-    if(const auto errors_reported = lexer.errors_reported()) {
-        std::cout << "Reported " << errors_reported << " errors. Exiting...\n";
+    const auto compiled = lynx::Program::compile(options.paths[0], std::move(*code), &phases, options.bodies());
+    if(!compiled.diagnostics.empty()) {
+        for(const auto& diagnostic : compiled.diagnostics) {
+            lynx::error_output() << to_string(diagnostic) << '\n';
+        }
+        lynx::error_output().flush();
+        std::cout << "Reported " << compiled.diagnostics.size() << " errors. Exiting...\n";
         return 2;
     }
-    lynx::Parser parser{lexer};
-    auto statements = parser.parse();
-    if(auto errors_reported = parser.errors_reported()) {
-        std::cout << "Reported " << errors_reported << " errors. Exiting...\n";
-        return 3;
+    lynx::Interpreter interpreter{*output};
+    interpreter.set_limits(options.limits);
+    lynx::Profiler profiler;
+    if(options.profile) {
+        interpreter.set_profiler(&profiler);
+        profiler.start();
+    }
+    phases.begin("run");
+    int status = 0;
+    if(const auto result = lynx::run_script(options, *compiled.program, interpreter); !result.ok()) {
+        *output << "Error: " << result.error << ".\nError reported. Exiting...\n";
+        // Runtime errors are the script's own business, running out of budget is reported to the caller.
+        status = result.status == lynx::Run_Result::Status::LIMIT_EXCEEDED ? 3 : 0;
+    }
+    profiler.stop();
+    output->flush();
+    status = lynx::check_output(*output, status);
+    phases.end();
+    if(options.fusion_stats) {
+        lynx::print_fusion_stats(*compiled.program, interpreter);
     }
-    lynx::Interpreter interpreter{statements};
-    if(!interpreter.interpret()) {
-        std::cout << "Error reported. Exiting...\n";
+    if(options.profile) {
+        lynx::print_profile(profiler, options);
     }
-    return 0;
+    if(options.stats || options.stats_json) {
+        const lynx::Run_Stats stats{phases.phases(), compiled.program->tokens(), compiled.program->nodes()};
+        options.stats_json ? lynx::write_stats_json(std::cerr, stats) : lynx::write_stats(std::cerr, stats);
+    }
+    if(options.heap_stats) {
+        std::cerr << lynx::heap_stats();
+    }
+    return status;
 }
-
@@ -0,0 +1,271 @@
+#include "map.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+
+#include "big_integer.h"
+
+namespace lynx {
+
+    namespace {
+
+        constexpr std::size_t MIN_SLOTS = 8;
+
+        // Entries per slot is kept below 7/8; Robin Hood probing keeps probe sequences short even that full.
+        bool over_loaded(const std::size_t entries, const std::size_t slots) noexcept {
+            return entries * 8 > slots * 7;
+        }
+
+        std::size_t slots_for(const std::size_t entries) noexcept {
+            auto slots = MIN_SLOTS;
+            while(over_loaded(entries, slots)) {
+                slots *= 2;
+            }
+            return slots;
+        }
+
+        // Final step of splitmix64, which spreads every input bit over the low bits used to pick a slot.
+        std::uint64_t mix(std::uint64_t x) noexcept {
+            x ^= x >> 30;
+            x *= 0xBF58476D1CE4E5B9ULL;
+            x ^= x >> 27;
+            x *= 0x94D049BB133111EBULL;
+            x ^= x >> 31;
+            return x;
+        }
+
+        bool is_key_type(const Value::Type type) noexcept {
+            return type == Value::Type::INTEGER || type == Value::Type::STRING;
+        }
+
+        bool is_value_type(const Value::Type type) noexcept {
+            return type == Value::Type::INTEGER || type == Value::Type::FLOAT || type == Value::Type::BOOL
+                    || type == Value::Type::STRING;
+        }
+
+        Value default_value(const Value::Type type) {
+            switch(type) {
+                case Value::Type::INTEGER:
+                    return Value{Value::Type::INTEGER, 0LL};
+                case Value::Type::FLOAT:
+                    return Value{Value::Type::FLOAT, 0.0L};
+                case Value::Type::BOOL:
+                    return Value{Value::Type::BOOL, false};
+                case Value::Type::STRING:
+                    return make_string({});
+                default:
+                    return Value{Value::Type::VOID, std::monostate{}};
+            }
+        }
+
+        bool same_key(const Value& left, const Value& right) {
+            if(left.type == Value::Type::INTEGER) {
+                const auto small_left = std::get_if<long long>(&left.data);
+                const auto small_right = std::get_if<long long>(&right.data);
+                if(small_left != nullptr && small_right != nullptr) {
+                    return *small_left == *small_right;
+                }
+                return compare_integers(left, right) == 0;
+            }
+            return string_of(left) == string_of(right);
+        }
+
+        const char* name(const Value::Type type) noexcept {
+            switch(type) {
+                case Value::Type::INTEGER:
+                    return "int";
+                case Value::Type::FLOAT:
+                    return "float";
+                case Value::Type::BOOL:
+                    return "bool";
+                case Value::Type::STRING:
+                    return "string";
+                default:
+                    return "void";
+            }
+        }
+
+        Value::Type scalar_type(const std::string_view name) noexcept {
+            if(name == "int") {
+                return Value::Type::INTEGER;
+            }
+            if(name == "float") {
+                return Value::Type::FLOAT;
+            }
+            if(name == "bool") {
+                return Value::Type::BOOL;
+            }
+            if(name == "string") {
+                return Value::Type::STRING;
+            }
+            return Value::Type::VOID;
+        }
+
+    }
+
+    Map::Map(const Value::Type key_type, const Value::Type value_type, const std::size_t capacity)
+            : _key_type{key_type}, _value_type{value_type} {
+        reserve(capacity);
+    }
+
+    Value::Type Map::key_type() const noexcept {
+        return _key_type;
+    }
+
+    Value::Type Map::value_type() const noexcept {
+        return _value_type;
+    }
+
+    void Map::set_types(const Value::Type key_type, const Value::Type value_type) {
+        if(!is_key_type(key_type)) {
+            throw std::runtime_error{"Map keys can only be 'int' or 'string'"};
+        }
+        if(!is_value_type(value_type)) {
+            throw std::runtime_error{"Map values can only be 'int', 'float', 'bool' or 'string'"};
+        }
+        _key_type = key_type;
+        _value_type = value_type;
+    }
+
+    std::size_t Map::size() const noexcept {
+        return _entries.size();
+    }
+
+    void Map::reserve(const std::size_t size) {
+        _entries.reserve(size);
+        if(const auto slots = slots_for(size); slots > _slots.size()) {
+            rehash(slots);
+        }
+    }
+
+    Value Map::load(const Value& key, const std::uint64_t hash) const {
+        check_key(key);
+        if(const auto entry = find(key, hash); entry != EMPTY) {
+            return _entries[entry].value;
+        }
+        return default_value(_value_type);
+    }
+
+    Value Map::load(const Value& key) const {
+        return load(key, Map::hash(key));
+    }
+
+    bool Map::contains(const Value& key) const {
+        check_key(key);
+        return find(key, Map::hash(key)) != EMPTY;
+    }
+
+    void Map::store(const Value& key, const std::uint64_t hash, Value value) {
+        if(_key_type == Value::Type::VOID) {
+            set_types(key.type, value.type);
+        }
+        check_key(key);
+        if(value.type != _value_type) {
+            throw std::runtime_error{"Can't store this value in a map of type '" + type_name(*this) + "'"};
+        }
+        if(const auto entry = find(key, hash); entry != EMPTY) {
+            _entries[entry].value = std::move(value);
+            return;
+        }
+        if(_entries.size() >= EMPTY) {
+            throw std::runtime_error{"Map is too large"};
+        }
+        if(over_loaded(_entries.size() + 1, _slots.size())) {
+            rehash(std::max(MIN_SLOTS, _slots.size() * 2));
+        }
+        _entries.push_back(Entry{hash, key, std::move(value)});
+        place(Slot{static_cast<std::uint32_t>(_entries.size() - 1), static_cast<std::uint32_t>(hash)});
+    }
+
+    void Map::store(const Value& key, Value value) {
+        store(key, Map::hash(key), std::move(value));
+    }
+
+    const std::vector<Map::Entry, Heap_Allocator<Map::Entry>>& Map::entries() const noexcept {
+        return _entries;
+    }
+
+    std::uint64_t Map::hash(const Value& key) {
+        if(key.type == Value::Type::INTEGER) {
+            if(const auto small = std::get_if<long long>(&key.data); small != nullptr) {
+                return mix(static_cast<std::uint64_t>(*small));
+            }
+            return mix(std::get<std::shared_ptr<const Big_Integer>>(key.data)->hash());
+        }
+        if(key.type == Value::Type::STRING) {
+            return mix(std::hash<std::string_view>{}(string_of(key)));
+        }
+        throw std::runtime_error{"Map keys can only be 'int' or 'string'"};
+    }
+
+    std::uint32_t Map::find(const Value& key, const std::uint64_t hash) const {
+        if(_slots.empty()) {
+            return EMPTY;
+        }
+        const auto mask = _slots.size() - 1;
+        const auto low = static_cast<std::uint32_t>(hash);
+        for(std::size_t position = low & mask, distance = 0;; position = (position + 1) & mask, ++distance) {
+            const auto slot = _slots[position];
+            // An entry further from home than this slot's would have taken it, so the key isn't here.
+            if(slot.entry == EMPTY || ((position - slot.hash) & mask) < distance) {
+                return EMPTY;
+            }
+            if(slot.hash == low) {
+                const auto& entry = _entries[slot.entry];
+                if(entry.hash == hash && same_key(entry.key, key)) {
+                    return slot.entry;
+                }
+            }
+        }
+    }
+
+    void Map::check_key(const Value& key) const {
+        if(key.type != _key_type) {
+            throw std::runtime_error{"Can't use this key with a map of type '" + type_name(*this) + "'"};
+        }
+    }
+
+    void Map::rehash(const std::size_t slots) {
+        _slots.assign(slots, Slot{EMPTY, 0});
+        for(std::size_t i = 0; i < _entries.size(); ++i) {
+            place(Slot{static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(_entries[i].hash)});
+        }
+    }
+
+    void Map::place(Slot slot) noexcept {
+        const auto mask = _slots.size() - 1;
+        for(std::size_t position = slot.hash & mask, distance = 0;; position = (position + 1) & mask, ++distance) {
+            auto& current = _slots[position];
+            if(current.entry == EMPTY) {
+                current = slot;
+                return;
+            }
+            const auto current_distance = (position - current.hash) & mask;
+            if(current_distance < distance) {
+                std::swap(current, slot);
+                distance = current_distance;
+            }
+        }
+    }
+
+    std::string type_name(const Map& map) {
+        return std::string{name(map.value_type())} + "[" + name(map.key_type()) + "]";
+    }
+
+    std::pair<Value::Type, Value::Type> map_types(const std::string& type) {
+        const auto bracket = type.find('[');
+        if(bracket == std::string::npos || type.back() != ']' || bracket + 2 >= type.size()) {
+            return {Value::Type::VOID, Value::Type::VOID};
+        }
+        const std::string_view view{type};
+        const auto value = scalar_type(view.substr(0, bracket));
+        const auto key = scalar_type(view.substr(bracket + 1, type.size() - bracket - 2));
+        if(!is_key_type(key) || !is_value_type(value)) {
+            return {Value::Type::VOID, Value::Type::VOID};
+        }
+        return {key, value};
+    }
+
+}
@@ -0,0 +1,80 @@
+#ifndef LYNX_MAP_H
+#define LYNX_MAP_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "value.h"
+
+namespace lynx {
+
+    // Map is a hash table from 'int' or 'string' keys to values of one type, written 'value[key]' ('int[string]').
+    // Entries are kept densely in insertion order, which is also the order 'for in' and 'print' see them in. An
+    // open-addressing index with Robin Hood probing points into them: every slot holds the entry's position and
+    // the low half of its hash, so a probe mostly walks one array of 8-byte slots and compares keys only when the
+    // hashes match. Entries keep their full hash, so growing the table never hashes a key again.
+    // Like arrays, maps are values that are copied on the first write to a shared one.
+    class Map {
+    public:
+        struct Entry {
+            std::uint64_t hash;
+            Value         key;
+            Value         value;
+        };
+
+        // An empty map whose types are still VOID takes the types of its first entry, or of the variable it
+        // initializes.
+        Map(const Value::Type key_type, const Value::Type value_type, const std::size_t capacity = 0);
+
+        Value::Type key_type() const noexcept;
+        Value::Type value_type() const noexcept;
+        void set_types(const Value::Type key_type, const Value::Type value_type);
+
+        std::size_t size() const noexcept;
+        // Makes room for 'size' entries without growing again.
+        void reserve(const std::size_t size);
+
+        // Value of 'key', or the default value of the value type if there is none.
+        Value load(const Value& key, const std::uint64_t hash) const;
+        Value load(const Value& key) const;
+        bool contains(const Value& key) const;
+        void store(const Value& key, const std::uint64_t hash, Value value);
+        void store(const Value& key, Value value);
+
+        const std::vector<Entry, Heap_Allocator<Entry>>& entries() const noexcept;
+
+        // Hash of a key, the same in every run, so that the hashes of literal keys can be computed by the parser.
+        static std::uint64_t hash(const Value& key);
+
+    private:
+        struct Slot {
+            std::uint32_t entry;
+            std::uint32_t hash;
+        };
+
+        static constexpr std::uint32_t EMPTY = 0xFFFFFFFF;
+
+        // Position of the key's entry, or EMPTY.
+        std::uint32_t find(const Value& key, const std::uint64_t hash) const;
+        void check_key(const Value& key) const;
+        void rehash(const std::size_t slots);
+        // Puts an entry in the index, displacing entries that are closer to their ideal slot.
+        void place(Slot slot) noexcept;
+
+        Value::Type        _key_type;
+        Value::Type        _value_type;
+        std::vector<Entry, Heap_Allocator<Entry>> _entries;
+        std::vector<Slot, Heap_Allocator<Slot>>   _slots;
+    };
+
+    // 'int[string]' and similar.
+    std::string type_name(const Map& map);
+
+    // Key and value type of a map type name. Both are VOID if 'type' isn't one.
+    std::pair<Value::Type, Value::Type> map_types(const std::string& type);
+
+}
+
+#endif //LYNX_MAP_H
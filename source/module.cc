@@ -0,0 +1,350 @@
+#include "module.h"
+
+#include <algorithm>
+
+#include "file.h"
+#include "fusion.h"
+#include "resolver.h"
+#include "thread_pool.h"
+
+namespace lynx {
+
+    namespace {
+
+        // Canonical path of an import, relative to the directory of the importing file, or "" if there's no
+        // such file.
+        std::string locate(const Import& import, const std::string& importer) {
+            std::error_code error;
+            const auto directory = std::filesystem::path{importer}.parent_path();
+            const auto path = std::filesystem::canonical(directory / import.path, error);
+            return error || !std::filesystem::is_regular_file(path, error) ? "" : path.string();
+        }
+
+    }
+
+    bool Module::is_current() const {
+        std::error_code error;
+        const auto current_modified = std::filesystem::last_write_time(path, error);
+        const auto current_size = error ? 0 : std::filesystem::file_size(path, error);
+        return !error && current_modified == modified && current_size == size;
+    }
+
+    // Module_Loader gathers the modules of one Module_Cache::load(). Files are visited a level of imports at a
+    // time: a level is parsed in parallel, and the imports it finds make the next one.
+    class Module_Loader {
+    public:
+        explicit Module_Loader(Module_Cache& cache)
+                : _cache{cache} {
+        }
+
+        Module_Set load(const std::vector<Import>& imports, const Source_Map& source_map) {
+            Module_Set set;
+            const auto paths = locate_all(imports, source_map, set.diagnostics);
+            discover(paths);
+            revalidate();
+            for(const auto& path : _visited) {
+                const auto& file = _files[path];
+                set.diagnostics.insert(set.diagnostics.end(), file.diagnostics.begin(), file.diagnostics.end());
+            }
+            if(!set.diagnostics.empty()) {
+                return set;
+            }
+            // A module that imports the importing file is a cycle as well.
+            std::error_code error;
+            const auto root = std::filesystem::canonical(source_map.filename(), error);
+            if(!error) {
+                _states[root.string()] = State::VISITING;
+            }
+            for(std::size_t i = 0; i < paths.size(); ++i) {
+                order(paths[i], imports[i], source_map, set.diagnostics);
+            }
+            if(!set.diagnostics.empty()) {
+                return set;
+            }
+            compile(set.diagnostics);
+            if(!set.diagnostics.empty()) {
+                return set;
+            }
+            set.functions = imported_functions(imports, paths, source_map, set.diagnostics);
+            for(const auto& path : _order) {
+                set.modules.push_back(_files[path].module);
+            }
+            std::lock_guard<std::mutex> lock{_cache._mutex};
+            for(const auto& [path, file] : _files) {
+                if(file.fresh != nullptr) {
+                    _cache._modules.insert_or_assign(path, file.module);
+                }
+            }
+            return set;
+        }
+
+    private:
+        enum class State {
+            NEW, VISITING, DONE
+        };
+
+        struct File {
+            std::shared_ptr<const Module> module;
+            // Set if this load compiles the module, which it then still may modify.
+            std::shared_ptr<Module>       fresh;
+            std::vector<Import>           imports;
+            std::vector<std::string>      paths;    // Of the imports, "" if there's no such file.
+            std::vector<Diagnostic>       diagnostics;
+        };
+
+        static std::vector<std::string> locate_all(const std::vector<Import>& imports, const Source_Map& source_map,
+                std::vector<Diagnostic>& diagnostics) {
+            std::vector<std::string> paths;
+            for(const auto& import : imports) {
+                paths.push_back(locate(import, source_map.filename()));
+                if(paths.back().empty()) {
+                    diagnostics.push_back(source_map.diagnostic("Can't find module \"" + import.path + "\"",
+                            import.token.offset));
+                }
+            }
+            return paths;
+        }
+
+        void discover(std::vector<std::string> level) {
+            while(!level.empty()) {
+                std::vector<std::string> reached;
+                std::vector<std::string> parsed;
+                for(const auto& path : level) {
+                    if(path.empty() || _files.count(path) > 0) {
+                        continue;
+                    }
+                    _visited.push_back(path);
+                    reached.push_back(path);
+                    auto& file = _files[path];
+                    if(const auto cached = find(path); cached != nullptr && cached->is_current()) {
+                        ++_cache._hits;
+                        file.module = cached;
+                        for(const auto& import : cached->imports) {
+                            file.paths.push_back(import->path);
+                        }
+                        continue;
+                    }
+                    parsed.push_back(path);
+                }
+                parse(parsed);
+                std::vector<std::string> next;
+                for(const auto& path : reached) {
+                    const auto& paths = _files[path].paths;
+                    next.insert(next.end(), paths.begin(), paths.end());
+                }
+                level = std::move(next);
+            }
+        }
+
+        // A cached module is only valid with the very modules it was resolved against, so it has to be compiled
+        // again once one of those is.
+        void revalidate() {
+            std::vector<std::string> stale;
+            for(bool changed = true; changed;) {
+                changed = false;
+                for(auto& [path, file] : _files) {
+                    if(file.fresh != nullptr || file.module == nullptr
+                            || std::find(stale.begin(), stale.end(), path) != stale.end()) {
+                        continue;
+                    }
+                    for(std::size_t i = 0; i < file.paths.size(); ++i) {
+                        const auto& import = _files.at(file.paths[i]);
+                        if(import.module != file.module->imports[i]
+                                || std::find(stale.begin(), stale.end(), file.paths[i]) != stale.end()) {
+                            stale.push_back(path);
+                            changed = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            for(const auto& path : stale) {
+                _files[path] = File{};
+            }
+            parse(stale);
+        }
+
+        std::shared_ptr<const Module> find(const std::string& path) {
+            std::lock_guard<std::mutex> lock{_cache._mutex};
+            const auto module = _cache._modules.find(path);
+            return module == _cache._modules.end() ? nullptr : module->second;
+        }
+
+        void parse(const std::vector<std::string>& paths) {
+            auto& pool = Thread_Pool::shared();
+            Task_Group group;
+            for(const auto& path : paths) {
+                ++_cache._misses;
+                pool.submit(group, [&file = _files[path], path] {
+                    read_module(path, file);
+                });
+            }
+            pool.wait(group);
+        }
+
+        static void read_module(const std::string& path, File& file) {
+            auto module = std::make_shared<Module>();
+            module->path = path;
+            std::error_code error;
+            module->modified = std::filesystem::last_write_time(path, error);
+            module->size = error ? 0 : std::filesystem::file_size(path, error);
+            auto code = read_file(path);
+            if(error || !code.has_value()) {
+                file.diagnostics.push_back(Diagnostic{"Can't read the module", path, 1, 1});
+                return;
+            }
+            module->source_hash = hash_source(*code);
+            Lexer lexer{path, std::move(*code)};
+            if(lexer.errors_reported() > 0) {
+                file.diagnostics = lexer.diagnostics();
+                return;
+            }
+            Parser parser{lexer};
+            module->statements = parser.parse();
+            if(parser.errors_reported() > 0) {
+                file.diagnostics = parser.diagnostics();
+                return;
+            }
+            // Taken before fusion, which replaces statements, so that modules importing this one can read them
+            // while it is being fused.
+            for(const auto& statement : module->statements) {
+                if(auto function = dynamic_cast<const Function_Declaration*>(statement.get()); function != nullptr) {
+                    module->functions.push_back(function);
+                }
+            }
+            module->source_map = lexer.source_map();
+            file.imports = parser.imports();
+            file.paths = locate_all(file.imports, module->source_map, file.diagnostics);
+            file.module = module;
+            file.fresh = std::move(module);
+        }
+
+        // Puts the modules reachable from 'path' in _order, each after the ones it imports.
+        void order(const std::string& path, const Import& import, const Source_Map& source_map,
+                std::vector<Diagnostic>& diagnostics) {
+            auto& state = _states[path];
+            if(state == State::DONE) {
+                return;
+            }
+            if(state == State::VISITING) {
+                diagnostics.push_back(source_map.diagnostic("Circular import of \"" + import.path + "\"",
+                        import.token.offset));
+                return;
+            }
+            state = State::VISITING;
+            const auto& file = _files[path];
+            for(std::size_t i = 0; i < file.paths.size(); ++i) {
+                // Cached modules were checked when they were compiled, and all the files that import a fresh one
+                // are fresh too, so a cycle is always closed by an import of a fresh module.
+                if(file.fresh != nullptr) {
+                    order(file.paths[i], file.imports[i], file.module->source_map, diagnostics);
+                } else {
+                    order(file.paths[i], Import{file.paths[i], Token{}}, source_map, diagnostics);
+                }
+            }
+            _states[path] = State::DONE;
+            _order.push_back(path);
+        }
+
+        // Fuses and resolves the fresh modules, in parallel: each only reads the functions of others, which were
+        // taken when they were parsed.
+        void compile(std::vector<Diagnostic>& diagnostics) {
+            std::vector<File*> fresh;
+            std::vector<std::vector<const Function_Declaration*>> functions;
+            for(const auto& path : _order) {
+                auto& file = _files[path];
+                if(file.fresh == nullptr) {
+                    continue;
+                }
+                for(const auto& import : file.paths) {
+                    const auto& module = _files[import].module;
+                    if(std::find(file.fresh->imports.begin(), file.fresh->imports.end(), module)
+                            == file.fresh->imports.end()) {
+                        file.fresh->imports.push_back(module);
+                    }
+                }
+                functions.push_back(imported_functions(file.imports, file.paths, file.fresh->source_map,
+                        diagnostics));
+                fresh.push_back(&file);
+            }
+            if(!diagnostics.empty()) {
+                return;
+            }
+            auto& pool = Thread_Pool::shared();
+            Task_Group group;
+            for(std::size_t i = 0; i < fresh.size(); ++i) {
+                pool.submit(group, [file = fresh[i], &functions = functions[i]] {
+                    Fusion_Pass fusion;
+                    fusion.fuse(file->fresh->statements);
+                    Resolver resolver{file->fresh->source_map};
+                    file->diagnostics = resolver.resolve(file->fresh->statements, functions);
+                });
+            }
+            pool.wait(group);
+            for(const auto file : fresh) {
+                diagnostics.insert(diagnostics.end(), file->diagnostics.begin(), file->diagnostics.end());
+            }
+        }
+
+        // Top-level functions of the imported modules. Two different modules can't have a function of the same
+        // name.
+        std::vector<const Function_Declaration*> imported_functions(const std::vector<Import>& imports,
+                const std::vector<std::string>& paths, const Source_Map& source_map,
+                std::vector<Diagnostic>& diagnostics) {
+            std::vector<const Function_Declaration*> functions;
+            std::unordered_map<std::string_view, std::size_t> origins;
+            std::vector<const Module*> modules;
+            for(std::size_t i = 0; i < imports.size(); ++i) {
+                const auto module = _files[paths[i]].module.get();
+                if(std::find(modules.begin(), modules.end(), module) != modules.end()) {
+                    continue;
+                }
+                modules.push_back(module);
+                for(const auto function : module->functions) {
+                    const auto [origin, inserted] = origins.emplace(function->name.value, i);
+                    if(!inserted) {
+                        diagnostics.push_back(source_map.diagnostic("Function '" + function->name.value
+                                + "' is imported from both \"" + imports[origin->second].path + "\" and \""
+                                + imports[i].path + "\"", imports[i].token.offset));
+                        continue;
+                    }
+                    functions.push_back(function);
+                }
+            }
+            return functions;
+        }
+
+        Module_Cache&                          _cache;
+        std::unordered_map<std::string, File>  _files;
+        // In the order they were first reached, which is the order their diagnostics are reported in.
+        std::vector<std::string>               _visited;
+        std::unordered_map<std::string, State> _states;
+        std::vector<std::string>               _order;
+    };
+
+    Module_Set Module_Cache::load(const std::vector<Import>& imports, const Source_Map& source_map) {
+        return Module_Loader{*this}.load(imports, source_map);
+    }
+
+    std::size_t Module_Cache::hits() const noexcept {
+        return _hits.load();
+    }
+
+    std::size_t Module_Cache::misses() const noexcept {
+        return _misses.load();
+    }
+
+    Module_Cache& Module_Cache::shared() {
+        static Module_Cache cache;
+        return cache;
+    }
+
+    std::uint64_t hash_source(const std::string_view code) noexcept {
+        std::uint64_t hash = 14695981039346656037ULL;
+        for(const auto c : code) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+}
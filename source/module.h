@@ -0,0 +1,77 @@
+#ifndef LYNX_MODULE_H
+#define LYNX_MODULE_H
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "diagnostic.h"
+#include "parser.h"
+#include "source_map.h"
+#include "statement.h"
+
+namespace lynx {
+
+    // Module is a file brought in with 'import "file.lnx";'. It is compiled on its own and its calls are bound
+    // only to its own functions and to the top-level functions of the modules it imports, so one compiled copy
+    // can be shared by every program of the process that imports it. Its top-level statements run once per run,
+    // after those of the modules it imports and before those of the file that imports it.
+    struct Module {
+        // Whether the file still has the modification time and size it was compiled from.
+        bool is_current() const;
+
+        std::string                                path;   // Canonical.
+        std::filesystem::file_time_type            modified;
+        std::uintmax_t                             size{};
+        std::uint64_t                              source_hash{};
+        Source_Map                                 source_map{"", ""};
+        std::vector<Statement_Ptr>                 statements;
+        // Top-level functions, the ones an import makes visible.
+        std::vector<const Function_Declaration*>   functions;
+        std::vector<std::shared_ptr<const Module>> imports;
+    };
+
+    struct Module_Set {
+        // Every module needed, directly or not, each once and after all the modules it imports.
+        std::vector<std::shared_ptr<const Module>> modules;
+        // Functions that the imports asked for make visible.
+        std::vector<const Function_Declaration*>   functions;
+        std::vector<Diagnostic>                    diagnostics;
+    };
+
+    // Module_Cache keeps every module the process has compiled, and compiles one again only once its file, or
+    // one of the modules it imports, changes. Safe to use from any number of threads.
+    class Module_Cache {
+    public:
+        // Modules needed by the imports of the file that 'source_map' belongs to. Paths are relative to the
+        // directory of that file. The files that aren't cached are lexed and parsed concurrently on the shared
+        // Thread_Pool, one level of imports at a time, so a level costs about as much as its largest file.
+        Module_Set load(const std::vector<Import>& imports, const Source_Map& source_map);
+
+        std::size_t hits() const noexcept;
+        std::size_t misses() const noexcept;
+
+        // Cache shared by every compilation in the process.
+        static Module_Cache& shared();
+
+    private:
+        friend class Module_Loader;
+
+        std::mutex                                                     _mutex;
+        std::unordered_map<std::string, std::shared_ptr<const Module>> _modules;
+        std::atomic<std::size_t>                                       _hits{};
+        std::atomic<std::size_t>                                       _misses{};
+    };
+
+    // 64-bit FNV-1a of a file's code.
+    std::uint64_t hash_source(const std::string_view code) noexcept;
+
+}
+
+#endif //LYNX_MODULE_H
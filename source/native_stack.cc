@@ -0,0 +1,84 @@
+#include "native_stack.h"
+
+#include <ucontext.h>
+
+#include <utility>
+
+#include "heap.h"
+
+namespace lynx {
+
+    struct Native_Stack::Segment {
+        Segment()
+                : memory{static_cast<char*>(heap_allocate(SEGMENT_SIZE))} {
+        }
+
+        Segment(const Segment&) = delete;
+        Segment& operator=(const Segment&) = delete;
+
+        ~Segment() {
+            heap_deallocate(memory, SEGMENT_SIZE);
+        }
+
+        char*              memory;
+        ucontext_t         context{};
+        ucontext_t         caller{};
+        void               (*function)(void*){};
+        void*              argument{};
+        std::exception_ptr error;
+        // Start of the share the caller was on.
+        char*              enclosing{};
+    };
+
+    namespace {
+
+        // Segment that start() is about to run on.
+        thread_local void* starting{};
+
+    }
+
+    Native_Stack::Native_Stack() = default;
+
+    Native_Stack::~Native_Stack() = default;
+
+    void Native_Stack::reset() noexcept {
+        _segments.clear();
+    }
+
+    // Bottom frame of a segment. It never returns, the caller's context is restored instead, and by then nothing
+    // is left on the segment that would have to be destroyed.
+    void Native_Stack::start() {
+        auto& segment = *static_cast<Segment*>(starting);
+        try {
+            segment.function(segment.argument);
+        } catch(...) {
+            // Exceptions can't unwind into another stack, they are rethrown by the caller.
+            segment.error = std::current_exception();
+        }
+        setcontext(&segment.caller);
+    }
+
+    void Native_Stack::run(void (*function)(void*), void* argument) {
+        if(_depth == _segments.size()) {
+            _segments.push_back(std::make_unique<Segment>());
+        }
+        auto& segment = *_segments[_depth];
+        segment.function = function;
+        segment.argument = argument;
+        getcontext(&segment.context);
+        segment.context.uc_stack.ss_sp = segment.memory;
+        segment.context.uc_stack.ss_size = SEGMENT_SIZE;
+        segment.context.uc_link = nullptr;
+        makecontext(&segment.context, start, 0);
+        segment.enclosing = std::exchange(_base, segment.memory + SEGMENT_SIZE);
+        starting = &segment;
+        ++_depth;
+        swapcontext(&segment.caller, &segment.context);
+        --_depth;
+        _base = segment.enclosing;
+        if(segment.error != nullptr) {
+            std::rethrow_exception(std::exchange(segment.error, nullptr));
+        }
+    }
+
+}
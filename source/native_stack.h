@@ -0,0 +1,67 @@
+#ifndef LYNX_NATIVE_STACK_H
+#define LYNX_NATIVE_STACK_H
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <vector>
+
+namespace lynx {
+
+    // Native_Stack keeps the recursion of a script off the native stack of the thread that runs it. Calls ask
+    // exhausted() first, and once the calls nested on the current stack have used up their share of it, the next
+    // one continues on a segment of its own. Every call nested in that one runs on the segment as usual, so only
+    // entering and leaving a segment costs a switch of stacks. Segments come from the value heap and are kept for
+    // the rest of the run, which can be bounded with a Heap_Budget.
+    class Native_Stack {
+    public:
+        // Stack the calls nested on the thread's own stack or on a segment may use before they move to a new one.
+        static constexpr std::ptrdiff_t SHARE = 256 * 1024;
+        // Leaves the last call on a segment room for what it does without calling, e.g. printing or throwing.
+        static constexpr std::size_t SEGMENT_SIZE = 1024 * 1024;
+
+        Native_Stack();
+        Native_Stack(const Native_Stack&) = delete;
+        Native_Stack& operator=(const Native_Stack&) = delete;
+        ~Native_Stack();
+
+        // Whether the caller should move to a new segment. The first call on a thread marks where the share of the
+        // thread's own stack starts.
+        bool exhausted() noexcept {
+            const auto frame = static_cast<char*>(__builtin_frame_address(0));
+            if(_base == nullptr) {
+                _base = frame;
+                return false;
+            }
+            return _base - frame > SHARE;
+        }
+
+        // Runs 'function' on a new segment, then returns or rethrows what it threw.
+        template<typename Function>
+        void run(Function& function) {
+            run([](void* argument) {
+                (*static_cast<Function*>(argument))();
+            }, &function);
+        }
+
+        // Frees the segments, none of which may be in use.
+        void reset() noexcept;
+
+    private:
+        struct Segment;
+
+        static void start();
+
+        void run(void (*function)(void*), void* argument);
+
+        // Start of the share of the stack the thread is on, shared by all the interpreters it runs.
+        static inline thread_local char*      _base{};
+
+        std::vector<std::unique_ptr<Segment>> _segments;
+        // Segments in use, innermost last.
+        std::size_t                           _depth{};
+    };
+
+}
+
+#endif //LYNX_NATIVE_STACK_H
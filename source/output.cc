@@ -0,0 +1,122 @@
+#include "output.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <unistd.h>
+
+namespace lynx {
+
+    Output_Buffer::Output_Buffer(std::ostream& stream, const std::size_t capacity)
+            : _buffer{std::make_unique<char[]>(capacity)}, _capacity{capacity}, _stream{&stream} {
+    }
+
+    Output_Buffer::Output_Buffer(const int file_descriptor, const std::size_t capacity)
+            : _buffer{std::make_unique<char[]>(capacity)}, _capacity{capacity}, _file_descriptor{file_descriptor} {
+    }
+
+    Output_Buffer::Output_Buffer(std::string& destination, const std::size_t capacity)
+            : _buffer{std::make_unique<char[]>(capacity)}, _capacity{capacity}, _destination{&destination} {
+    }
+
+    Output_Buffer::Output_Buffer(Sink sink, const std::size_t capacity)
+            : _buffer{std::make_unique<char[]>(capacity)}, _capacity{capacity}, _sink{std::move(sink)} {
+    }
+
+    Output_Buffer::~Output_Buffer() {
+        flush();
+    }
+
+    void Output_Buffer::write(std::string_view text) {
+        if(text.size() > _capacity - _size) {
+            flush();
+            if(text.size() >= _capacity) {
+                write_through(text);
+                return;
+            }
+        }
+        std::memcpy(_buffer.get() + _size, text.data(), text.size());
+        _size += text.size();
+    }
+
+    void Output_Buffer::write(const char* text) {
+        write(std::string_view{text});
+    }
+
+    void Output_Buffer::write(const char c) {
+        reserve(1);
+        _buffer[_size++] = c;
+    }
+
+    void Output_Buffer::write(const bool value) {
+        write(value ? std::string_view{"true"} : std::string_view{"false"});
+    }
+
+    void Output_Buffer::write(const double value) {
+        reserve(32);
+        _size = std::to_chars(_buffer.get() + _size, _buffer.get() + _capacity, value).ptr - _buffer.get();
+    }
+
+    void Output_Buffer::write(const long double value) {
+        // Shortest representation that round-trips, never longer than this for an 80-bit long double.
+        reserve(64);
+        _size = std::to_chars(_buffer.get() + _size, _buffer.get() + _capacity, value).ptr - _buffer.get();
+    }
+
+    void Output_Buffer::flush() {
+        if(_size > 0) {
+            write_through(std::string_view{_buffer.get(), _size});
+            _size = 0;
+        }
+        if(_stream != nullptr && !_failed) {
+            _failed = !_stream->flush();
+        }
+    }
+
+    bool Output_Buffer::failed() const noexcept {
+        return _failed;
+    }
+
+    void Output_Buffer::reserve(const std::size_t bytes) {
+        if(_capacity - _size < bytes) {
+            flush();
+        }
+    }
+
+    void Output_Buffer::write_through(std::string_view text) {
+        // Once output was lost, what follows would only make it look complete.
+        if(_failed) {
+            return;
+        }
+        if(_stream != nullptr) {
+            _failed = !_stream->write(text.data(), static_cast<std::streamsize>(text.size()));
+            return;
+        }
+        if(_destination != nullptr) {
+            _destination->append(text);
+            return;
+        }
+        if(_sink) {
+            _sink(text);
+            return;
+        }
+        while(!text.empty()) {
+            const auto written = ::write(_file_descriptor, text.data(), text.size());
+            if(written < 0 && errno == EINTR) {
+                continue;
+            }
+            if(written <= 0) {
+                _failed = true;
+                return;
+            }
+            text.remove_prefix(static_cast<std::size_t>(written));
+        }
+    }
+
+    Output_Buffer& error_output() {
+        static Output_Buffer output{std::cerr, 16 * 1024};
+        return output;
+    }
+
+}
@@ -0,0 +1,76 @@
+#ifndef LYNX_OUTPUT_H
+#define LYNX_OUTPUT_H
+
+#include <charconv>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace lynx {
+
+    // Output_Buffer gathers everything written to it in one large buffer and hands it over in big chunks, either to
+    // a std::ostream or, when constructed with a file descriptor, straight to write(2). Numbers are formatted with
+    // std::to_chars, so writing doesn't allocate and doesn't depend on the locale. Output can also be captured
+    // into a std::string, or handed to a function chunk by chunk.
+    // Buffer is flushed when it fills up, on flush() and on destruction.
+    class Output_Buffer {
+    public:
+        static constexpr std::size_t DEFAULT_CAPACITY = 256 * 1024;
+
+        explicit Output_Buffer(std::ostream& stream, const std::size_t capacity = DEFAULT_CAPACITY);
+        explicit Output_Buffer(const int file_descriptor, const std::size_t capacity = DEFAULT_CAPACITY);
+        explicit Output_Buffer(std::string& destination, const std::size_t capacity = DEFAULT_CAPACITY);
+        using Sink = std::function<void(std::string_view)>;
+        explicit Output_Buffer(Sink sink, const std::size_t capacity = DEFAULT_CAPACITY);
+        Output_Buffer(const Output_Buffer&) = delete;
+        Output_Buffer& operator=(const Output_Buffer&) = delete;
+        ~Output_Buffer();
+
+        void write(std::string_view text);
+        void write(const char* text);
+        void write(const char c);
+        void write(const bool value);
+        void write(const double value);
+        void write(const long double value);
+
+        template<typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer>>>
+        void write(const Integer value) {
+            reserve(24);
+            _size = std::to_chars(_buffer.get() + _size, _buffer.get() + _capacity, value).ptr - _buffer.get();
+        }
+
+        template<typename T>
+        Output_Buffer& operator<<(const T& value) {
+            write(value);
+            return *this;
+        }
+
+        void flush();
+        // Whether writing to the stream or file descriptor failed, e.g. with EPIPE or ENOSPC. Everything written from
+        // then on is dropped, the owner has to report the loss.
+        bool failed() const noexcept;
+
+    private:
+        void reserve(const std::size_t bytes);
+        void write_through(std::string_view text);
+
+        std::unique_ptr<char[]> _buffer;
+        std::size_t             _capacity;
+        std::size_t             _size{};
+
+        std::ostream* _stream{};
+        std::string*  _destination{};
+        Sink          _sink;
+        int           _file_descriptor{-1};
+        bool          _failed{};
+    };
+
+    // Buffered standard error, for diagnostics of the front end. Flushed at exit.
+    Output_Buffer& error_output();
+
+}
+
+#endif //LYNX_OUTPUT_H
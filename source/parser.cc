@@ -1,8 +1,9 @@
 #include "parser.h"
 
-#include <iostream>
 #include <stdexcept>
 
+#include "instrumentation.h"
+
 namespace lynx {
 
     namespace {
@@ -23,55 +24,115 @@ namespace lynx {
 
     }
 
-    Parser::Parser(Lexer& lexer)
-            : _lexer{lexer} {
+    Parser::Parser(Lexer& lexer, const bool defer_bodies)
+            : _lexer{lexer}, _defer_bodies{defer_bodies} {
     }
 
     std::size_t Parser::errors_reported() const noexcept {
-        return _errors_reported;
+        return _diagnostics.size();
+    }
+
+    const std::vector<Diagnostic>& Parser::diagnostics() const noexcept {
+        return _diagnostics;
     }
 
     std::vector<std::unique_ptr<Statement>> Parser::parse() {
         std::vector<std::unique_ptr<Statement>> statements;
+        _imports.clear();
+        _deferred.clear();
         while(!_lexer.is_at_end()) {
             try {
+                if(match_token(Token::Type::IMPORT)) {
+                    import_declaration();
+                    continue;
+                }
                 statements.push_back(declaration());
             } catch(const Parse_Error& e) {
-                std::cerr << "Error: " << e.token().filename << ':' << e.token().line << ':' << e.token().column << ": "
-                        << e.what() << ".\n";
-                ++_errors_reported;
+                LYNX_COUNT(EXCEPTIONS);
+                _diagnostics.push_back(_lexer.source_map().diagnostic(e.what(), e.token().offset));
                 synchronize();
             }
         }
         return statements;
     }
 
+    const std::vector<Import>& Parser::imports() const noexcept {
+        return _imports;
+    }
+
+    const std::vector<Deferred_Body>& Parser::deferred() const noexcept {
+        return _deferred;
+    }
+
+    Statement_Ptr Parser::deferred_body(const Deferred_Body& deferred) {
+        _lexer.seek(deferred.token);
+        try {
+            return block();
+        } catch(const Parse_Error& e) {
+            LYNX_COUNT(EXCEPTIONS);
+            _diagnostics.push_back(_lexer.source_map().diagnostic(e.what(), e.token().offset));
+            return nullptr;
+        }
+    }
+
+    void Parser::import_declaration() {
+        const auto path = consume(Token::Type::STRING, "Expected a file name after 'import'");
+        consume(Token::Type::SEMICOLON, "Expected ';' after import");
+        const auto& file = string_of(_lexer.literal(path));
+        _imports.push_back(Import{std::string{file.data(), file.size()}, path});
+    }
+
     Statement_Ptr Parser::declaration() {
+        const auto line = _lexer.source_map().line(_lexer.peek_token(0).offset);
+        Statement_Ptr declaration;
         if(match_token(Token::Type::FUNC)) {
-            return function_declaration();
+            declaration = function_declaration();
+        } else if(match_token(Token::Type::LET)) {
+            declaration = variable_declaration(true);
+        } else if(match_token(Token::Type::VAR)) {
+            declaration = variable_declaration(false);
+        } else {
+            declaration = statement();
         }
-        if(match_token(Token::Type::LET)) {
-            return variable_declaration(true);
-        }
-        if(match_token(Token::Type::VAR)) {
-            return variable_declaration(false);
-        }
-        return statement();
+        declaration->line = line;
+        return declaration;
     }
 
     Statement_Ptr Parser::function_declaration() {
         auto name = consume(Token::Type::IDENTIFIER, "Expected an identifier after 'func' declaration");
-        consume(Token::Type::L_PAREN, "");
-        consume(Token::Type::R_PAREN, "");
+        consume(Token::Type::L_PAREN, "Expected '(' after function name");
+        std::vector<Parameter> parameters;
+        if(_lexer.peek_token(0).type != Token::Type::R_PAREN) {
+            do {
+                auto parameter = consume(Token::Type::IDENTIFIER, "Expected parameter name").value;
+                consume(Token::Type::COLON, "Expected ':' after parameter name");
+                auto type = type_name("Expected parameter type");
+                parameters.push_back(Parameter{parameter, type});
+            } while(match_token(Token::Type::COMMA));
+        }
+        consume(Token::Type::R_PAREN, "Expected ')' after parameter list");
+        std::string return_type{};
+        if(match_token(Token::Type::COLON)) {
+            return_type = type_name("Expected return type after ':'");
+        }
+        bool generator = false;
+        if(const auto end = _defer_bodies ? skip_body(generator) : std::nullopt; end.has_value()) {
+            auto function = std::make_unique<Function_Declaration>(name, std::move(parameters), return_type, nullptr);
+            function->is_generator = generator;
+            _deferred.push_back(Deferred_Body{function.get(), _lexer.position()});
+            _lexer.seek(*end);
+            return function;
+        }
         auto body = block();
-        return std::make_unique<Function_Declaration>(name.value, std::move(body));
+        return std::make_unique<Function_Declaration>(name, std::move(parameters), return_type,
+                std::move(body));
     }
 
     Statement_Ptr Parser::variable_declaration(const bool is_constant) {
         auto identifier = consume(Token::Type::IDENTIFIER, "Expected identifier after 'var' and 'let'").value;
         // TODO: Does not support type inference yet.
         consume(Token::Type::COLON, "");
-        auto type = consume(Token::Type::IDENTIFIER, "").value;
+        auto type = type_name("");
         Expr_Ptr initializer{};
         if(match_token(Token::Type::EQUALS)) {
             initializer = std::move(expression());
@@ -87,6 +148,9 @@ namespace lynx {
         if(match_token(Token::Type::FOR)) {
             return for_statement();
         }
+        if(match_token(Token::Type::PARALLEL)) {
+            return parallel_for_statement();
+        }
         if(match_token(Token::Type::WHILE)) {
             return while_statement();
         }
@@ -96,6 +160,15 @@ namespace lynx {
         if(match_token(Token::Type::PRINT)) {
             return print_statement();
         }
+        if(match_token(Token::Type::RETURN)) {
+            return return_statement();
+        }
+        if(match_token(Token::Type::YIELD)) {
+            return yield_statement();
+        }
+        if(const auto token = _lexer.peek_token(0); token.type == Token::Type::IMPORT) {
+            throw Parse_Error{"'import' has to be at the top level", token};
+        }
         if(_lexer.peek_token(0).type == Token::Type::L_BRACE) {
             return block();
         }
@@ -115,6 +188,9 @@ namespace lynx {
     }
 
     Statement_Ptr Parser::for_statement() {
+        if(_lexer.peek_token(0).type == Token::Type::IDENTIFIER && _lexer.peek_token(1).type == Token::Type::IN) {
+            return for_in_statement();
+        }
         auto init_statement = expression();
         consume(Token::Type::SEMICOLON, "");
         auto condition = expression();
@@ -125,6 +201,42 @@ namespace lynx {
                 std::move(body));
     }
 
+    Statement_Ptr Parser::for_in_statement() {
+        auto variable = consume(Token::Type::IDENTIFIER, "Expected loop variable after 'for'");
+        consume(Token::Type::IN, "Expected 'in' after loop variable");
+        auto iterable = expression();
+        auto body = block();
+        return std::make_unique<For_In>(variable, std::move(iterable), std::move(body));
+    }
+
+    Statement_Ptr Parser::parallel_for_statement() {
+        consume(Token::Type::FOR, "Expected 'for' after 'parallel'");
+        auto variable = consume(Token::Type::IDENTIFIER, "Expected loop variable after 'parallel for'");
+        consume(Token::Type::IN, "Expected 'in' after loop variable");
+        auto begin = expression();
+        consume(Token::Type::DOT_DOT, "Expected '..' between the bounds of the range");
+        auto end = expression();
+        std::vector<Reduction> reductions;
+        if(match_token(Token::Type::REDUCE)) {
+            do {
+                auto operation = consume(Token::Type::IDENTIFIER, "Expected 'sum', 'min' or 'max' after 'reduce'");
+                auto target = consume(Token::Type::IDENTIFIER, "Expected variable name after reduction");
+                if(operation.value == "sum") {
+                    reductions.push_back(Reduction{Reduction::Operation::SUM, target});
+                } else if(operation.value == "min") {
+                    reductions.push_back(Reduction{Reduction::Operation::MIN, target});
+                } else if(operation.value == "max") {
+                    reductions.push_back(Reduction{Reduction::Operation::MAX, target});
+                } else {
+                    throw Parse_Error{"Unknown reduction '" + operation.value + "'", operation};
+                }
+            } while(match_token(Token::Type::COMMA));
+        }
+        auto body = block();
+        return std::make_unique<Parallel_For>(variable, std::move(begin), std::move(end), std::move(reductions),
+                std::move(body));
+    }
+
     Statement_Ptr Parser::while_statement() {
         auto condition = expression();
         auto body = block();
@@ -145,6 +257,23 @@ namespace lynx {
         return std::make_unique<Print>(std::move(expr));
     }
 
+    Statement_Ptr Parser::return_statement() {
+        auto keyword = _lexer.peek_token(-1);
+        Expr_Ptr value{};
+        if(_lexer.peek_token(0).type != Token::Type::SEMICOLON) {
+            value = expression();
+        }
+        consume(Token::Type::SEMICOLON, "Expected ';' after 'return' statement");
+        return std::make_unique<Return>(keyword, std::move(value));
+    }
+
+    Statement_Ptr Parser::yield_statement() {
+        auto keyword = _lexer.peek_token(-1);
+        auto value = expression();
+        consume(Token::Type::SEMICOLON, "Expected ';' after 'yield' statement");
+        return std::make_unique<Yield>(keyword, std::move(value));
+    }
+
     Expr_Ptr Parser::expression() {
         return assignment();
     }
@@ -152,73 +281,95 @@ namespace lynx {
     Expr_Ptr Parser::assignment() {
         auto left = equality();
         if(match_token(Token::Type::EQUALS)) {
-            auto operator_ = _lexer.peek_token(-1);
-            auto right = factor();
-            return std::make_unique<Binary_Operation>(std::move(left), operator_, std::move(right));
+            auto equals = _lexer.peek_token(-1);
+            auto value = assignment();
+            if(auto identifier = dynamic_cast<Identifier*>(left.get()); identifier != nullptr) {
+                return std::make_unique<Assignment>(identifier->name, std::move(value));
+            }
+            if(auto index = dynamic_cast<Index*>(left.get()); index != nullptr) {
+                if(auto array = dynamic_cast<Identifier*>(index->array.get()); array != nullptr) {
+                    return std::make_unique<Index_Assignment>(array->name, std::move(index->index), std::move(value));
+                }
+            }
+            throw Parse_Error{"Invalid assignment target", equals};
         }
         return left;
     }
 
     Expr_Ptr Parser::equality() {
         auto left = comparison();
-        if(match_token(Token::Type::EQUALS) || match_token(Token::Type::BANG_EQUALS)) {
+        while(match_token(Token::Type::EQUALS_EQUALS) || match_token(Token::Type::BANG_EQUALS)) {
             auto operator_ = _lexer.peek_token(-1);
-            auto right = factor();
-            return std::make_unique<Binary_Operation>(std::move(left), operator_, std::move(right));
+            auto right = comparison();
+            left = std::make_unique<Binary_Operation>(std::move(left), operator_, std::move(right));
         }
         return left;
     }
 
     Expr_Ptr Parser::comparison() {
-        auto left = factor();
-        if(match_token(Token::Type::LESS) || match_token(Token::Type::GREATER) || match_token(Token::Type::LESS_EQUALS)
-                || match_token(Token::Type::GREATER_EQUALS)) {
+        auto left = term();
+        while(match_token(Token::Type::LESS) || match_token(Token::Type::GREATER)
+                || match_token(Token::Type::LESS_EQUALS) || match_token(Token::Type::GREATER_EQUALS)) {
             auto operator_ = _lexer.peek_token(-1);
-            auto right = factor();
-            return std::make_unique<Binary_Operation>(std::move(left), operator_, std::move(right));
+            auto right = term();
+            left = std::make_unique<Binary_Operation>(std::move(left), operator_, std::move(right));
         }
         return left;
     }
 
     Expr_Ptr Parser::factor() {
-        auto left = term();
+        auto left = unary();
         while(match_token(Token::Type::STAR) || match_token(Token::Type::SLASH)) {
             auto operator_ = _lexer.peek_token(-1);
-            auto right = factor();
-            return std::make_unique<Binary_Operation>(std::move(left), operator_, std::move(right));
+            auto right = unary();
+            left = std::make_unique<Binary_Operation>(std::move(left), operator_, std::move(right));
         }
         return left;
     }
 
     Expr_Ptr Parser::term() {
-        auto left = unary();
+        auto left = factor();
         while(match_token(Token::Type::PLUS) || match_token(Token::Type::MINUS)) {
             auto operator_ = _lexer.peek_token(-1);
             auto right = factor();
-            return std::make_unique<Binary_Operation>(std::move(left), operator_, std::move(right));
+            left = std::make_unique<Binary_Operation>(std::move(left), operator_, std::move(right));
         }
         return left;
     }
 
     Expr_Ptr Parser::unary() {
-        while(match_token(Token::Type::MINUS) || match_token(Token::Type::BANG)) {
+        if(match_token(Token::Type::MINUS) || match_token(Token::Type::BANG)) {
             auto operator_ = _lexer.peek_token(-1);
-            auto operand = factor();
+            auto operand = unary();
             return std::make_unique<Unary_Operation>(operator_, std::move(operand));
         }
-        return primary();
+        return call();
     }
 
-    Expr_Ptr Parser::primary() {
-        auto token = _lexer.peek_token(0);
-        if(match_token(Token::Type::INTEGER)) {
-            return std::make_unique<Literal>(Value{Value::Type::INTEGER, std::stoll(token.value)});
+    Expr_Ptr Parser::call() {
+        auto callee = _lexer.peek_token(0);
+        auto expr = primary();
+        if(match_token(Token::Type::L_PAREN)) {
+            if(callee.type != Token::Type::IDENTIFIER) {
+                throw Parse_Error{"Only named functions can be called", callee};
+            }
+            auto arguments = expression_list(Token::Type::R_PAREN);
+            consume(Token::Type::R_PAREN, "Expected ')' after arguments");
+            expr = std::make_unique<Call>(callee, std::move(arguments));
         }
-        if(match_token(Token::Type::FLOAT)) {
-            return std::make_unique<Literal>(Value{Value::Type::FLOAT, std::stold(token.value)});
+        while(match_token(Token::Type::L_BRACKET)) {
+            auto bracket = _lexer.peek_token(-1);
+            auto index = expression();
+            consume(Token::Type::R_BRACKET, "Expected ']' after index");
+            expr = std::make_unique<Index>(std::move(expr), bracket, std::move(index));
         }
-        if(match_token(Token::Type::STRING)) {
-            return std::make_unique<Literal>(Value{Value::Type::STRING,token.value});
+        return expr;
+    }
+
+    Expr_Ptr Parser::primary() {
+        auto token = _lexer.peek_token(0);
+        if(match_token(Token::Type::INTEGER) || match_token(Token::Type::FLOAT) || match_token(Token::Type::STRING)) {
+            return std::make_unique<Literal>(_lexer.literal(token));
         }
         if(match_token(Token::Type::TRUE)) {
             return std::make_unique<Literal>(Value{Value::Type::BOOL, true});
@@ -229,17 +380,68 @@ namespace lynx {
         if(match_token(Token::Type::IDENTIFIER)) {
             return std::make_unique<Identifier>(token);
         }
+        if(match_token(Token::Type::L_PAREN)) {
+            auto expr = expression();
+            consume(Token::Type::R_PAREN, "Expected ')' after expression");
+            return expr;
+        }
+        if(match_token(Token::Type::L_BRACKET)) {
+            auto elements = expression_list(Token::Type::R_BRACKET);
+            consume(Token::Type::R_BRACKET, "Expected ']' after array elements");
+            return std::make_unique<Array_Literal>(token, std::move(elements));
+        }
+        if(match_token(Token::Type::L_BRACE)) {
+            std::vector<Expr_Ptr> keys;
+            std::vector<Expr_Ptr> values;
+            if(_lexer.peek_token(0).type != Token::Type::R_BRACE) {
+                do {
+                    keys.push_back(expression());
+                    consume(Token::Type::COLON, "Expected ':' after map key");
+                    values.push_back(expression());
+                } while(match_token(Token::Type::COMMA));
+            }
+            consume(Token::Type::R_BRACE, "Expected '}' after map entries");
+            return std::make_unique<Map_Literal>(token, std::move(keys), std::move(values));
+        }
         throw Parse_Error{"Not a primary expression", token};
     }
 
+    std::vector<Expr_Ptr> Parser::expression_list(const Token::Type end) {
+        std::vector<Expr_Ptr> expressions;
+        if(_lexer.peek_token(0).type != end) {
+            do {
+                expressions.push_back(expression());
+            } while(match_token(Token::Type::COMMA));
+        }
+        return expressions;
+    }
+
+    std::string Parser::type_name(const std::string& fail_msg) {
+        auto type = consume(Token::Type::IDENTIFIER, fail_msg).value;
+        if(match_token(Token::Type::L_BRACKET)) {
+            // 'value[key]' is a map, 'element[]' an array.
+            if(match_token(Token::Type::IDENTIFIER)) {
+                type += "[" + _lexer.peek_token(-1).value + "]";
+                consume(Token::Type::R_BRACKET, "Expected ']' after the key type of a map type");
+            } else {
+                consume(Token::Type::R_BRACKET, "Expected ']' after '[' in array type");
+                type += "[]";
+            }
+        }
+        return type;
+    }
+
     Statement_Ptr Parser::block() {
         std::vector<Statement_Ptr> statements;
-        consume(Token::Type::L_BRACE, "Every block should start with '{'");
+        const auto brace = consume(Token::Type::L_BRACE, "Every block should start with '{'");
+        const auto line = _lexer.source_map().line(brace.offset);
         while(_lexer.peek_token(0).type != Token::Type::R_BRACE && !_lexer.is_at_end()) {
             statements.push_back(declaration());
         }
         consume(Token::Type::R_BRACE, "No matching '}'");
-        return std::make_unique<Block>(std::move(statements));
+        auto block = std::make_unique<Block>(std::move(statements));
+        block->line = line;
+        return block;
     }
 
     bool Parser::match_token(const Token::Type type) {
@@ -258,6 +460,38 @@ namespace lynx {
         return token;
     }
 
+    std::optional<std::size_t> Parser::skip_body(bool& generator) const {
+        std::size_t depth = 0;
+        for(auto position = _lexer.position(); ; ++position) {
+            switch(_lexer.type_at(position)) {
+                case Token::Type::L_BRACE:
+                    ++depth;
+                    break;
+                case Token::Type::R_BRACE:
+                    if(depth == 0) {
+                        return std::nullopt;
+                    }
+                    if(--depth == 0) {
+                        return position + 1;
+                    }
+                    break;
+                case Token::Type::YIELD:
+                    generator = true;
+                    break;
+                // Nested functions are visible to the whole file, so they can't wait for a call. An unclosed body
+                // is reported right away.
+                case Token::Type::FUNC:
+                case Token::Type::END_OF_FILE:
+                    return std::nullopt;
+                default:
+                    if(depth == 0) {
+                        return std::nullopt;
+                    }
+                    break;
+            }
+        }
+    }
+
     void Parser::synchronize() {
         _lexer.next_token();
         while(!_lexer.is_at_end()) {
@@ -270,8 +504,13 @@ namespace lynx {
                 case Token::Type::VAR:
                 case Token::Type::IF:
                 case Token::Type::FOR:
+                case Token::Type::PARALLEL:
                 case Token::Type::WHILE:
-                case Token::Type::DO: {
+                case Token::Type::DO:
+                case Token::Type::PRINT:
+                case Token::Type::RETURN:
+                case Token::Type::YIELD:
+                case Token::Type::IMPORT: {
                     return;
                 }
                 default: {
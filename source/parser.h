@@ -1,20 +1,44 @@
 #ifndef LYNX_PARSER_H
 #define LYNX_PARSER_H
 
+#include <optional>
+
 #include "lexer.h"
 #include "statement.h"
 
 namespace lynx {
 
+    // 'import "path";', which may only be a statement of its own at the top level of a file.
+    struct Import {
+        std::string path;
+        Token       token;
+    };
+
+    // Function whose body parse() skipped, and the index of the body's '{' token.
+    struct Deferred_Body {
+        Function_Declaration* function;
+        std::size_t           token;
+    };
+
     // Parser is using recursive descent parsing to parse both statements and expressions.
     class Parser {
     public:
-        Parser(Lexer& lexer);
+        // With 'defer_bodies' set, parse() only matches the braces of function bodies, see deferred().
+        explicit Parser(Lexer& lexer, const bool defer_bodies = false);
 
         std::size_t errors_reported() const noexcept;
+        const std::vector<Diagnostic>& diagnostics() const noexcept;
 
         std::vector<Statement_Ptr> parse();
+        // Imports found by the last parse(), in the order they appear. They aren't statements of the AST.
+        const std::vector<Import>& imports() const noexcept;
+        // Functions of the last parse() whose body is still null, in the order they appear. A body that declares a
+        // function is never deferred, since that function has to be visible to the whole file.
+        const std::vector<Deferred_Body>& deferred() const noexcept;
+        // Parses a body that parse() skipped. Returns null if it has an error, which is added to diagnostics().
+        Statement_Ptr deferred_body(const Deferred_Body& deferred);
 
+        void import_declaration();
         Statement_Ptr declaration();
         Statement_Ptr function_declaration();
         Statement_Ptr variable_declaration(const bool is_constant);
@@ -22,9 +46,13 @@ namespace lynx {
         Statement_Ptr statement();
         Statement_Ptr if_statement();
         Statement_Ptr for_statement();
+        Statement_Ptr for_in_statement();
+        Statement_Ptr parallel_for_statement();
         Statement_Ptr while_statement();
         Statement_Ptr do_while_statement();
         Statement_Ptr print_statement();
+        Statement_Ptr return_statement();
+        Statement_Ptr yield_statement();
 
         Expr_Ptr expression();
         Expr_Ptr assignment();
@@ -33,18 +61,28 @@ namespace lynx {
         Expr_Ptr factor();
         Expr_Ptr term();
         Expr_Ptr unary();
+        Expr_Ptr call();
         Expr_Ptr primary();
+        std::vector<Expr_Ptr> expression_list(const Token::Type end);
 
         Statement_Ptr block();
 
     private:
         bool match_token(const Token::Type type);
         Token consume(const Token::Type type, const std::string& fail_msg);
+        // A type name, with '[]' appended for array types.
+        std::string type_name(const std::string& fail_msg);
+        // Index of the token after the '}' that closes the function body at the current token, if it can be
+        // deferred. 'generator' is set if the body has a 'yield'.
+        std::optional<std::size_t> skip_body(bool& generator) const;
 
         void synchronize();
         
-        Lexer&      _lexer;
-        std::size_t _errors_reported{};
+        Lexer&                     _lexer;
+        std::vector<Diagnostic>    _diagnostics;
+        std::vector<Import>        _imports;
+        bool                       _defer_bodies;
+        std::vector<Deferred_Body> _deferred;
     };
 
 }
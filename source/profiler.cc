@@ -0,0 +1,265 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+
+#include <signal.h>
+
+namespace lynx {
+
+    namespace {
+
+        // Ticks of the SIGPROF timer that no profiler has taken yet. Lock-free, so the handler may touch it.
+        std::atomic<std::uint32_t> pending_ticks{};
+        std::atomic<bool>          profiler_started{false};
+
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+        void on_tick(int) {
+            pending_ticks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void set_timer(timer_t timer, const std::chrono::microseconds interval) noexcept {
+            itimerspec period{};
+            period.it_interval.tv_sec = static_cast<time_t>(interval.count() / 1000000);
+            period.it_interval.tv_nsec = static_cast<long>(interval.count() % 1000000 * 1000);
+            period.it_value = period.it_interval;
+            timer_settime(timer, 0, &period, nullptr);
+        }
+
+        std::uint64_t sample_key(const std::uint32_t path, const std::size_t line) noexcept {
+            return static_cast<std::uint64_t>(path) << 32 | static_cast<std::uint32_t>(line);
+        }
+
+        template<typename Key>
+        std::vector<std::pair<Key, std::size_t>> most_first(std::vector<std::pair<Key, std::size_t>> entries) {
+            std::stable_sort(entries.begin(), entries.end(), [](const auto& left, const auto& right) {
+                return left.second > right.second;
+            });
+            return entries;
+        }
+
+    }
+
+    Profiler::Profiler(const std::chrono::microseconds interval)
+            : _interval{std::max(interval, std::chrono::microseconds{1})} {
+        _paths.push_back(Path{ROOT, nullptr, {}});
+    }
+
+    Profiler::~Profiler() {
+        stop();
+    }
+
+    void Profiler::start() {
+        if(_started) {
+            return;
+        }
+        if(profiler_started.exchange(true)) {
+            throw std::runtime_error{"Another profiler is already running"};
+        }
+        struct sigaction action{};
+        action.sa_handler = on_tick;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGPROF, &action, nullptr);
+        sigevent event{};
+        event.sigev_notify = SIGEV_SIGNAL;
+        event.sigev_signo = SIGPROF;
+        if(timer_create(CLOCK_MONOTONIC, &event, &_timer) != 0) {
+            signal(SIGPROF, SIG_DFL);
+            profiler_started.store(false);
+            throw std::runtime_error{"Can't create the profiling timer"};
+        }
+        pending_ticks.store(0, std::memory_order_relaxed);
+        set_timer(_timer, _interval);
+        _started = true;
+    }
+
+    void Profiler::stop() {
+        if(!_started) {
+            return;
+        }
+        timer_delete(_timer);
+        // The last ticks belong to whatever ran last.
+        take_samples(pending_ticks.exchange(0, std::memory_order_relaxed));
+        signal(SIGPROF, SIG_DFL);
+        _started = false;
+        profiler_started.store(false);
+    }
+
+    std::size_t Profiler::enter_line(const std::size_t line) {
+        if(pending_ticks.load(std::memory_order_relaxed) != 0) {
+            take_samples(pending_ticks.exchange(0, std::memory_order_relaxed));
+        }
+        if(line >= _executions.size()) {
+            _executions.resize(line + 1);
+        }
+        ++_executions[line];
+        return std::exchange(_line, line);
+    }
+
+    void Profiler::leave_line(const std::size_t line) {
+        if(pending_ticks.load(std::memory_order_relaxed) != 0) {
+            take_samples(pending_ticks.exchange(0, std::memory_order_relaxed));
+        }
+        _line = line;
+    }
+
+    void Profiler::enter_function(const Function_Declaration& function) {
+        ++_calls[&function];
+        _path = child(_path, function);
+    }
+
+    void Profiler::replace_function(const Function_Declaration& function) {
+        ++_calls[&function];
+        _path = child(_paths[_path].parent, function);
+    }
+
+    void Profiler::leave_function() {
+        _path = _paths[_path].parent;
+    }
+
+    void Profiler::reset() noexcept {
+        _path = ROOT;
+        _line = 0;
+    }
+
+    std::size_t Profiler::samples() const noexcept {
+        return _sample_count;
+    }
+
+    std::size_t Profiler::executions(const std::size_t line) const noexcept {
+        return line < _executions.size() ? _executions[line] : 0;
+    }
+
+    std::size_t Profiler::calls(const std::string& function) const {
+        std::size_t calls = 0;
+        for(const auto& [declaration, count] : _calls) {
+            if(declaration->name.value == function) {
+                calls += count;
+            }
+        }
+        return calls;
+    }
+
+    void Profiler::write_report(std::ostream& stream) const {
+        std::unordered_map<std::size_t, std::size_t> line_samples;
+        std::unordered_map<std::string, std::pair<std::size_t, std::size_t>> function_samples;
+        for(const auto& [key, count] : _samples) {
+            const auto leaf = static_cast<std::uint32_t>(key >> 32);
+            line_samples[static_cast<std::uint32_t>(key)] += count;
+            function_samples[function_name(leaf)].first += count;
+            // A recursive function is on the path many times, but only spends the time once.
+            std::vector<std::string> seen;
+            for(auto path = leaf;; path = _paths[path].parent) {
+                auto name = function_name(path);
+                if(std::find(seen.begin(), seen.end(), name) == seen.end()) {
+                    function_samples[name].second += count;
+                    seen.push_back(std::move(name));
+                }
+                if(path == ROOT) {
+                    break;
+                }
+            }
+        }
+
+        std::vector<std::pair<std::size_t, std::size_t>> lines;
+        for(std::size_t line = 0; line < _executions.size(); ++line) {
+            const auto samples = line_samples.find(line);
+            if(_executions[line] > 0 || samples != line_samples.end()) {
+                lines.emplace_back(line, samples == line_samples.end() ? 0 : samples->second);
+            }
+        }
+        std::stable_sort(lines.begin(), lines.end(), [this](const auto& left, const auto& right) {
+            if(left.second != right.second) {
+                return left.second > right.second;
+            }
+            return executions(left.first) > executions(right.first);
+        });
+
+        std::unordered_map<std::string, std::size_t> calls_by_name;
+        for(const auto& [declaration, count] : _calls) {
+            calls_by_name[declaration->name.value] += count;
+        }
+        std::vector<std::pair<std::string, std::size_t>> functions;
+        for(const auto& [name, samples] : function_samples) {
+            functions.emplace_back(name, samples.second);
+        }
+        for(const auto& [name, count] : calls_by_name) {
+            if(function_samples.count(name) == 0) {
+                functions.emplace_back(name, 0);
+            }
+        }
+        std::sort(functions.begin(), functions.end());
+
+        char buffer[128];
+        std::snprintf(buffer, sizeof(buffer), "Profile: %zu samples, one every %lld us\n", _sample_count,
+                static_cast<long long>(_interval.count()));
+        stream << buffer << "\nLines (self ms, executions):\n";
+        for(const auto& [line, samples] : lines) {
+            std::snprintf(buffer, sizeof(buffer), "  line %5zu: %10.1f %12zu\n", line, milliseconds(samples),
+                    executions(line));
+            stream << buffer;
+        }
+        stream << "\nFunctions (total ms, self ms, calls):\n";
+        for(const auto& [name, total] : most_first(std::move(functions))) {
+            const auto samples = function_samples.find(name);
+            const auto calls = calls_by_name.find(name);
+            std::snprintf(buffer, sizeof(buffer), "  %-20s %10.1f %10.1f %12zu\n", name.c_str(), milliseconds(total),
+                    milliseconds(samples == function_samples.end() ? 0 : samples->second.first),
+                    calls == calls_by_name.end() ? 0 : calls->second);
+            stream << buffer;
+        }
+    }
+
+    void Profiler::write_collapsed_stacks(std::ostream& stream) const {
+        std::vector<std::pair<std::string, std::size_t>> stacks;
+        for(const auto& [key, count] : _samples) {
+            std::vector<std::uint32_t> frames;
+            for(auto path = static_cast<std::uint32_t>(key >> 32); path != ROOT; path = _paths[path].parent) {
+                frames.push_back(path);
+            }
+            std::string stack{function_name(ROOT)};
+            for(auto frame = frames.rbegin(); frame != frames.rend(); ++frame) {
+                stack += ';' + function_name(*frame);
+            }
+            stack += ";line " + std::to_string(static_cast<std::uint32_t>(key));
+            stacks.emplace_back(std::move(stack), count);
+        }
+        std::sort(stacks.begin(), stacks.end());
+        for(const auto& [stack, count] : stacks) {
+            stream << stack << ' ' << count << '\n';
+        }
+    }
+
+    void Profiler::take_samples(const std::uint32_t ticks) {
+        if(ticks == 0) {
+            return;
+        }
+        _samples[sample_key(_path, _line)] += ticks;
+        _sample_count += ticks;
+    }
+
+    std::uint32_t Profiler::child(const std::uint32_t parent, const Function_Declaration& function) {
+        for(const auto& [declaration, path] : _paths[parent].children) {
+            if(declaration == &function) {
+                return path;
+            }
+        }
+        const auto path = static_cast<std::uint32_t>(_paths.size());
+        _paths.push_back(Path{parent, &function, {}});
+        _paths[parent].children.emplace_back(&function, path);
+        return path;
+    }
+
+    std::string Profiler::function_name(const std::uint32_t path) const {
+        return path == ROOT ? "main" : _paths[path].function->name.value;
+    }
+
+    double Profiler::milliseconds(const std::size_t samples) const noexcept {
+        return static_cast<double>(samples) * static_cast<double>(_interval.count()) / 1000.0;
+    }
+
+}
@@ -0,0 +1,88 @@
+#ifndef LYNX_PROFILER_H
+#define LYNX_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <time.h>
+
+#include "statement.h"
+
+namespace lynx {
+
+    // Profiler attributes the time and executions of a run to source lines and functions.
+    // Executions are exact: the Interpreter reports every statement it starts and every call it makes. Time is
+    // sampled: while the profiler is started, a timer raises SIGPROF every 'interval' of wall time and the
+    // handler only counts the tick. The Interpreter hands pending ticks to the profiler at the next statement
+    // boundary, which charges them to the line and call path that were running, so the signal handler never
+    // touches any data structure and the overhead of a run is a few counters per statement.
+    // Only one profiler can be started at a time, and it samples only the interpreter that it is attached to.
+    // Functions are kept by their declaration, so the Program has to outlive the reports.
+    class Profiler {
+    public:
+        explicit Profiler(const std::chrono::microseconds interval = std::chrono::milliseconds{1});
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+        ~Profiler();
+
+        void start();
+        void stop();
+
+        // The Interpreter's side. enter_line returns the line that was running, to be restored by leave_line once
+        // the statement is done.
+        std::size_t enter_line(const std::size_t line);
+        void leave_line(const std::size_t line);
+        void enter_function(const Function_Declaration& function);
+        // A tail call, which replaces the running function instead of nesting in it.
+        void replace_function(const Function_Declaration& function);
+        void leave_function();
+        // Back to the top level after a run, even if it ended with an error.
+        void reset() noexcept;
+
+        std::size_t samples() const noexcept;
+        std::size_t executions(const std::size_t line) const noexcept;
+        std::size_t calls(const std::string& function) const;
+
+        // Lines and functions, the most expensive first.
+        void write_report(std::ostream& stream) const;
+        // One line per call path: 'main;outer;inner;line 12 <samples>', as read by flame graph tools.
+        void write_collapsed_stacks(std::ostream& stream) const;
+
+    private:
+        struct Path {
+            std::uint32_t                                                      parent;
+            const Function_Declaration*                                        function;
+            std::vector<std::pair<const Function_Declaration*, std::uint32_t>> children;
+        };
+
+        static constexpr std::uint32_t ROOT = 0;
+
+        void take_samples(const std::uint32_t ticks);
+        std::uint32_t child(const std::uint32_t parent, const Function_Declaration& function);
+        std::string function_name(const std::uint32_t path) const;
+        double milliseconds(const std::size_t samples) const noexcept;
+
+        std::chrono::microseconds _interval;
+        timer_t                   _timer{};
+        bool                      _started{false};
+
+        std::uint32_t _path{ROOT};
+        std::size_t   _line{};
+
+        // Indexed by line.
+        std::vector<std::size_t> _executions;
+        std::vector<Path>        _paths;
+        std::unordered_map<const Function_Declaration*, std::size_t> _calls;
+        // Keyed by path << 32 | line.
+        std::unordered_map<std::uint64_t, std::size_t> _samples;
+        std::size_t                                    _sample_count{};
+    };
+
+}
+
+#endif //LYNX_PROFILER_H
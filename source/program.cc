@@ -0,0 +1,123 @@
+#include "program.h"
+
+#include "parser.h"
+#include "resolver.h"
+
+namespace lynx {
+
+    namespace {
+
+        void begin(Phase_Recorder* phases, const char* name) {
+            if(phases != nullptr) {
+                phases->begin(name);
+            }
+        }
+
+        // The Resolver allows 'snapshot()' only as a statement of its own at the top level.
+        bool is_snapshot(const Statement& statement) {
+            const auto expression = dynamic_cast<const Expression*>(&statement);
+            if(expression == nullptr) {
+                return false;
+            }
+            const auto call = dynamic_cast<const Call*>(expression->expression.get());
+            return call != nullptr && call->builtin == Builtin::SNAPSHOT;
+        }
+
+    }
+
+    Compile_Result Program::compile(const std::string& filename, std::string code, Phase_Recorder* phases,
+            const Body_Compilation bodies) {
+        auto source_hash = hash_source(code);
+        begin(phases, "lex");
+        // Lazily compiled bodies keep the tokens, and with them the lexer, for as long as the program lives.
+        auto owned_lexer = std::make_unique<Lexer>(filename, std::move(code));
+        auto& lexer = *owned_lexer;
+        if(lexer.errors_reported() > 0) {
+            return Compile_Result{nullptr, lexer.diagnostics()};
+        }
+        begin(phases, "parse");
+        Parser parser{lexer, bodies == Body_Compilation::LAZY};
+        auto statements = parser.parse();
+        if(parser.errors_reported() > 0) {
+            return Compile_Result{nullptr, parser.diagnostics()};
+        }
+        Module_Set imported;
+        if(!parser.imports().empty()) {
+            begin(phases, "import");
+            imported = Module_Cache::shared().load(parser.imports(), lexer.source_map());
+            if(!imported.diagnostics.empty()) {
+                return Compile_Result{nullptr, std::move(imported.diagnostics)};
+            }
+        }
+        begin(phases, "fuse");
+        Fusion_Pass fusion;
+        fusion.fuse(statements);
+        begin(phases, "resolve");
+        auto resolver = std::make_unique<Resolver>(lexer.source_map());
+        if(auto diagnostics = resolver->resolve(statements, imported.functions); !diagnostics.empty()) {
+            return Compile_Result{nullptr, std::move(diagnostics)};
+        }
+        if(phases != nullptr) {
+            phases->end();
+        }
+        std::shared_ptr<Program> program{new Program{}};
+        program->_filename = filename;
+        program->_statements = std::move(statements);
+        for(const auto& module : imported.modules) {
+            source_hash = (source_hash ^ module->source_hash) * 1099511628211ULL;
+        }
+        program->_modules = std::move(imported.modules);
+        program->_fusion_rewrites = fusion.rewrites();
+        program->_tokens = lexer.token_count();
+        program->_nodes = resolver->nodes();
+        program->_source_hash = source_hash;
+        for(std::size_t i = 0; i < program->_statements.size(); ++i) {
+            if(is_snapshot(*program->_statements[i])) {
+                program->_snapshot_point = i;
+                break;
+            }
+        }
+        if(!parser.deferred().empty()) {
+            program->_lazy_bodies = std::make_unique<Lazy_Bodies>(std::move(owned_lexer), std::move(resolver),
+                    parser.deferred());
+        }
+        return Compile_Result{std::move(program), {}};
+    }
+
+    const std::string& Program::filename() const noexcept {
+        return _filename;
+    }
+
+    const std::vector<Statement_Ptr>& Program::statements() const noexcept {
+        return _statements;
+    }
+
+    const std::vector<std::shared_ptr<const Module>>& Program::modules() const noexcept {
+        return _modules;
+    }
+
+    const Fusion_Counters& Program::fusion_rewrites() const noexcept {
+        return _fusion_rewrites;
+    }
+
+    std::size_t Program::tokens() const noexcept {
+        return _tokens;
+    }
+
+    std::size_t Program::nodes() const noexcept {
+        return _nodes;
+    }
+
+    std::uint64_t Program::source_hash() const noexcept {
+        return _source_hash;
+    }
+
+    std::size_t Program::snapshot_point() const noexcept {
+        return _snapshot_point;
+    }
+
+    const Lazy_Bodies* Program::lazy_bodies() const noexcept {
+        return _lazy_bodies.get();
+    }
+
+}
@@ -0,0 +1,78 @@
+#ifndef LYNX_PROGRAM_H
+#define LYNX_PROGRAM_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "diagnostic.h"
+#include "fusion.h"
+#include "lazy_bodies.h"
+#include "module.h"
+#include "stats.h"
+#include "statement.h"
+
+namespace lynx {
+
+    class Program;
+
+    // When function bodies are compiled. LAZY only matches the braces of a body, and compiles it when the function
+    // is first called, so a script pays only for the functions it runs. An error in such a body is reported by
+    // that call, as a runtime error, and not at all if the function is never called. Bodies that declare
+    // functions, and the modules a script imports, are always compiled right away.
+    enum class Body_Compilation {
+        EAGER, LAZY
+    };
+
+    struct Compile_Result {
+        std::shared_ptr<const Program> program;     // Null if there were errors.
+        std::vector<Diagnostic>        diagnostics;
+    };
+
+    // Program is a script that has been lexed, parsed, fused and resolved, together with the modules it imports.
+    // Nothing modifies it afterwards, so a single instance can be shared read-only by any number of threads, each
+    // running it in its own Interpreter.
+    class Program {
+    public:
+        // Lexing, parsing, fusion and resolution are recorded as phases of 'phases', if given. Imports are loaded
+        // through Module_Cache::shared().
+        static Compile_Result compile(const std::string& filename, std::string code,
+                Phase_Recorder* phases = nullptr, const Body_Compilation bodies = Body_Compilation::EAGER);
+
+        const std::string& filename() const noexcept;
+        const std::vector<Statement_Ptr>& statements() const noexcept;
+        // Modules the script imports, directly or not, in the order their statements run before its own.
+        const std::vector<std::shared_ptr<const Module>>& modules() const noexcept;
+        // How many times Fusion_Pass has rewritten each pattern. This and the counts below are of the script's own
+        // file, not of its modules, and don't include function bodies that are compiled lazily.
+        const Fusion_Counters& fusion_rewrites() const noexcept;
+        std::size_t tokens() const noexcept;
+        // Statements and expressions, with each superinstruction counted as one.
+        std::size_t nodes() const noexcept;
+        // Hash of the source code and of the modules, which a Snapshot has to match.
+        std::uint64_t source_hash() const noexcept;
+        // Index of the top-level 'snapshot()' statement, or NO_SNAPSHOT.
+        std::size_t snapshot_point() const noexcept;
+        // Function bodies left for their first call, null if there are none.
+        const Lazy_Bodies* lazy_bodies() const noexcept;
+
+        static constexpr std::size_t NO_SNAPSHOT = static_cast<std::size_t>(-1);
+
+    private:
+        Program() = default;
+
+        std::string                                _filename;
+        std::vector<Statement_Ptr>                 _statements;
+        std::vector<std::shared_ptr<const Module>> _modules;
+        Fusion_Counters                            _fusion_rewrites{};
+        std::size_t                                _tokens{};
+        std::size_t                                _nodes{};
+        std::uint64_t                              _source_hash{};
+        std::size_t                                _snapshot_point{NO_SNAPSHOT};
+        std::unique_ptr<Lazy_Bodies>               _lazy_bodies;
+    };
+
+}
+
+#endif //LYNX_PROGRAM_H
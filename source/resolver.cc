@@ -0,0 +1,361 @@
+#include "resolver.h"
+
+#include <algorithm>
+
+#include "array.h"
+#include "map.h"
+
+namespace lynx {
+
+    namespace {
+
+        // Void if 'type' names no type.
+        Value::Type declared_type(const std::string& type) {
+            if(type == "int") {
+                return Value::Type::INTEGER;
+            }
+            if(type == "float") {
+                return Value::Type::FLOAT;
+            }
+            if(type == "bool") {
+                return Value::Type::BOOL;
+            }
+            if(type == "string") {
+                return Value::Type::STRING;
+            }
+            if(element_type(type) != Value::Type::VOID) {
+                return Value::Type::ARRAY;
+            }
+            if(map_types(type).first != Value::Type::VOID) {
+                return Value::Type::MAP;
+            }
+            return Value::Type::VOID;
+        }
+
+        Binary_Operation::Operand operand_kind(const Expr& expression) {
+            if(dynamic_cast<const Literal*>(&expression) != nullptr) {
+                return Binary_Operation::Operand::LITERAL;
+            }
+            if(dynamic_cast<const Identifier*>(&expression) != nullptr) {
+                return Binary_Operation::Operand::IDENTIFIER;
+            }
+            return Binary_Operation::Operand::OTHER;
+        }
+
+    }
+
+    Resolver::Resolver(const Source_Map& source_map)
+            : _source_map{source_map} {
+    }
+
+    std::vector<Diagnostic> Resolver::resolve(std::vector<Statement_Ptr>& statements,
+            const std::vector<const Function_Declaration*>& imported) {
+        _functions.clear();
+        // The loader has already reported imports that clash with each other.
+        for(const auto function : imported) {
+            _functions.emplace(function->name.value, function);
+        }
+        _diagnostics.clear();
+        _nodes = 0;
+        _top_level_calls.clear();
+        _snapshot = nullptr;
+        for(const auto& statement : statements) {
+            if(auto expression = dynamic_cast<const Expression*>(statement.get()); expression != nullptr) {
+                if(auto call = dynamic_cast<const Call*>(expression->expression.get()); call != nullptr) {
+                    _top_level_calls.push_back(call);
+                }
+            }
+        }
+        declare(statements);
+        bind(statements);
+        return std::move(_diagnostics);
+    }
+
+    std::vector<Diagnostic> Resolver::resolve_body(Function_Declaration& function) {
+        _diagnostics.clear();
+        bind_function(function);
+        return std::move(_diagnostics);
+    }
+
+    std::size_t Resolver::nodes() const noexcept {
+        return _nodes;
+    }
+
+    void Resolver::declare(const std::vector<Statement_Ptr>& statements) {
+        for(const auto& statement : statements) {
+            declare(statement);
+        }
+    }
+
+    void Resolver::declare(const Statement_Ptr& statement) {
+        if(statement == nullptr) {
+            return;
+        }
+        if(auto function = dynamic_cast<const Function_Declaration*>(statement.get()); function != nullptr) {
+            if(!_functions.emplace(function->name.value, function).second) {
+                _diagnostics.push_back(diagnostic("Redefinition of function '" + function->name.value + "'",
+                        function->name));
+            }
+            declare(function->body);
+            return;
+        }
+        if(auto block = dynamic_cast<const Block*>(statement.get()); block != nullptr) {
+            declare(block->statements);
+            return;
+        }
+        if(auto if_stmt = dynamic_cast<const If*>(statement.get()); if_stmt != nullptr) {
+            declare(if_stmt->then_block);
+            declare(if_stmt->else_block);
+            return;
+        }
+        if(auto if_compare = dynamic_cast<const If_Compare*>(statement.get()); if_compare != nullptr) {
+            declare(if_compare->then_block);
+            declare(if_compare->else_block);
+            return;
+        }
+        if(auto for_stmt = dynamic_cast<const For*>(statement.get()); for_stmt != nullptr) {
+            declare(for_stmt->block);
+            return;
+        }
+        if(auto for_in = dynamic_cast<const For_In*>(statement.get()); for_in != nullptr) {
+            declare(for_in->block);
+            return;
+        }
+        if(auto parallel_for = dynamic_cast<const Parallel_For*>(statement.get()); parallel_for != nullptr) {
+            declare(parallel_for->block);
+            return;
+        }
+        if(auto while_stmt = dynamic_cast<const While*>(statement.get()); while_stmt != nullptr) {
+            declare(while_stmt->block);
+            return;
+        }
+        if(auto do_while = dynamic_cast<const Do_While*>(statement.get()); do_while != nullptr) {
+            declare(do_while->block);
+            return;
+        }
+    }
+
+    void Resolver::bind(std::vector<Statement_Ptr>& statements) {
+        for(auto& statement : statements) {
+            bind(statement);
+        }
+    }
+
+    void Resolver::bind(Statement_Ptr& statement) {
+        if(statement == nullptr) {
+            return;
+        }
+        ++_nodes;
+        if(auto block = dynamic_cast<Block*>(statement.get()); block != nullptr) {
+            bind(block->statements);
+            return;
+        }
+        if(auto expression = dynamic_cast<Expression*>(statement.get()); expression != nullptr) {
+            bind(expression->expression);
+            return;
+        }
+        if(auto function = dynamic_cast<Function_Declaration*>(statement.get()); function != nullptr) {
+            bind_function(*function);
+            return;
+        }
+        if(auto variable = dynamic_cast<Variable_Declaration*>(statement.get()); variable != nullptr) {
+            bind(variable->initializer);
+            return;
+        }
+        if(auto if_stmt = dynamic_cast<If*>(statement.get()); if_stmt != nullptr) {
+            bind(if_stmt->condition);
+            bind(if_stmt->then_block);
+            bind(if_stmt->else_block);
+            return;
+        }
+        if(auto if_compare = dynamic_cast<If_Compare*>(statement.get()); if_compare != nullptr) {
+            bind(if_compare->left);
+            bind(if_compare->right);
+            bind(if_compare->then_block);
+            bind(if_compare->else_block);
+            return;
+        }
+        if(auto for_stmt = dynamic_cast<For*>(statement.get()); for_stmt != nullptr) {
+            bind(for_stmt->init_statement);
+            bind(for_stmt->condition);
+            bind(for_stmt->iteration_expression);
+            bind(for_stmt->block);
+            return;
+        }
+        if(auto for_in = dynamic_cast<For_In*>(statement.get()); for_in != nullptr) {
+            bind(for_in->iterable);
+            bind(for_in->block);
+            return;
+        }
+        if(auto parallel_for = dynamic_cast<Parallel_For*>(statement.get()); parallel_for != nullptr) {
+            bind(parallel_for->begin);
+            bind(parallel_for->end);
+            ++_parallel_depth;
+            bind(parallel_for->block);
+            --_parallel_depth;
+            return;
+        }
+        if(auto while_stmt = dynamic_cast<While*>(statement.get()); while_stmt != nullptr) {
+            bind(while_stmt->condition);
+            bind(while_stmt->block);
+            return;
+        }
+        if(auto do_while = dynamic_cast<Do_While*>(statement.get()); do_while != nullptr) {
+            bind(do_while->condition);
+            bind(do_while->block);
+            return;
+        }
+        if(auto print = dynamic_cast<Print*>(statement.get()); print != nullptr) {
+            bind(print->expression);
+            return;
+        }
+        if(auto return_stmt = dynamic_cast<Return*>(statement.get()); return_stmt != nullptr) {
+            bind(return_stmt->value);
+            if(return_stmt->value != nullptr && _function != nullptr) {
+                _value_returns.push_back(return_stmt);
+            }
+            return;
+        }
+        if(auto yield = dynamic_cast<Yield*>(statement.get()); yield != nullptr) {
+            bind(yield->value);
+            if(_function == nullptr) {
+                _diagnostics.push_back(diagnostic("'yield' outside of a function", yield->keyword));
+                return;
+            }
+            if(_parallel_depth > 0) {
+                _diagnostics.push_back(diagnostic("'yield' inside a 'parallel for'", yield->keyword));
+                return;
+            }
+            _function->is_generator = true;
+            return;
+        }
+    }
+
+    void Resolver::bind(Expr_Ptr& expression) {
+        if(expression == nullptr) {
+            return;
+        }
+        ++_nodes;
+        if(auto unary = dynamic_cast<Unary_Operation*>(expression.get()); unary != nullptr) {
+            bind(unary->operand);
+            return;
+        }
+        if(auto binary = dynamic_cast<Binary_Operation*>(expression.get()); binary != nullptr) {
+            bind(binary->left);
+            bind(binary->right);
+            binary->left_operand = operand_kind(*binary->left);
+            binary->right_operand = operand_kind(*binary->right);
+            return;
+        }
+        if(auto assignment = dynamic_cast<Assignment*>(expression.get()); assignment != nullptr) {
+            bind(assignment->value);
+            return;
+        }
+        if(auto call = dynamic_cast<Call*>(expression.get()); call != nullptr) {
+            for(auto& argument : call->arguments) {
+                bind(argument);
+            }
+            auto function = _functions.find(call->callee.value);
+            if(function == _functions.cend()) {
+                bind_builtin(*call);
+                return;
+            }
+            if(call->arguments.size() != function->second->parameters.size()) {
+                _diagnostics.push_back(diagnostic("Function '" + call->callee.value + "' expects "
+                        + std::to_string(function->second->parameters.size()) + " arguments, "
+                        + std::to_string(call->arguments.size()) + " given", call->callee));
+                return;
+            }
+            call->function = function->second;
+            return;
+        }
+        if(auto array = dynamic_cast<Array_Literal*>(expression.get()); array != nullptr) {
+            for(auto& element : array->elements) {
+                bind(element);
+            }
+            return;
+        }
+        if(auto map = dynamic_cast<Map_Literal*>(expression.get()); map != nullptr) {
+            for(std::size_t i = 0; i < map->keys.size(); ++i) {
+                bind(map->keys[i]);
+                bind(map->values[i]);
+            }
+            return;
+        }
+        if(auto index = dynamic_cast<Index*>(expression.get()); index != nullptr) {
+            bind(index->array);
+            bind(index->index);
+            return;
+        }
+        if(auto assignment = dynamic_cast<Index_Assignment*>(expression.get()); assignment != nullptr) {
+            bind(assignment->index);
+            bind(assignment->value);
+            return;
+        }
+    }
+
+    void Resolver::bind_function(Function_Declaration& function) {
+        auto enclosing = _function;
+        auto enclosing_returns = std::move(_value_returns);
+        auto enclosing_parallel_depth = _parallel_depth;
+        _function = &function;
+        _value_returns.clear();
+        _parallel_depth = 0;
+        for(auto& parameter : function.parameters) {
+            parameter.value_type = declared_type(parameter.type);
+            if(parameter.value_type == Value::Type::VOID) {
+                _diagnostics.push_back(diagnostic("Unknown type '" + parameter.type + "' of parameter '"
+                        + parameter.name + "'", function.name));
+            }
+        }
+        if(!function.return_type.empty()) {
+            function.returns = declared_type(function.return_type);
+            if(function.returns == Value::Type::VOID) {
+                _diagnostics.push_back(diagnostic("Unknown return type '" + function.return_type + "'",
+                        function.name));
+            }
+        }
+        bind(function.body);
+        if(function.is_generator) {
+            for(const auto return_stmt : _value_returns) {
+                _diagnostics.push_back(diagnostic("Generator '" + function.name.value + "' can't return a value",
+                        return_stmt->keyword));
+            }
+        }
+        _function = enclosing;
+        _value_returns = std::move(enclosing_returns);
+        _parallel_depth = enclosing_parallel_depth;
+    }
+
+    void Resolver::bind_builtin(Call& call) {
+        const auto builtin = find_builtin(call.callee.value);
+        if(builtin == Builtin::NONE) {
+            _diagnostics.push_back(diagnostic("'" + call.callee.value + "' is not a function", call.callee));
+            return;
+        }
+        if(call.arguments.size() != arity(builtin)) {
+            _diagnostics.push_back(diagnostic("Function '" + call.callee.value + "' expects "
+                    + std::to_string(arity(builtin)) + " arguments, " + std::to_string(call.arguments.size())
+                    + " given", call.callee));
+            return;
+        }
+        if(builtin == Builtin::SNAPSHOT) {
+            if(std::find(_top_level_calls.cbegin(), _top_level_calls.cend(), &call) == _top_level_calls.cend()) {
+                _diagnostics.push_back(diagnostic("'snapshot()' has to be a statement at the top level",
+                        call.callee));
+                return;
+            }
+            if(_snapshot != nullptr) {
+                _diagnostics.push_back(diagnostic("A script can have only one 'snapshot()'", call.callee));
+                return;
+            }
+            _snapshot = &call;
+        }
+        call.builtin = builtin;
+    }
+
+    Diagnostic Resolver::diagnostic(const std::string& message, const Token& token) const {
+        return _source_map.diagnostic(message, token.offset);
+    }
+
+}
@@ -0,0 +1,62 @@
+#ifndef LYNX_RESOLVER_H
+#define LYNX_RESOLVER_H
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "diagnostic.h"
+#include "source_map.h"
+#include "statement.h"
+
+namespace lynx {
+
+    // Resolver binds every call to its function declaration before the program runs, so the Interpreter never
+    // looks functions up by name and never has to modify the AST. Functions are visible in the whole file,
+    // regardless of where they are declared, and hide builtins of the same name. So do the functions of the
+    // modules the file imports.
+    class Resolver {
+    public:
+        // Diagnostics are located with the map of the file the statements were parsed from.
+        explicit Resolver(const Source_Map& source_map);
+
+        std::vector<Diagnostic> resolve(std::vector<Statement_Ptr>& statements,
+                const std::vector<const Function_Declaration*>& imported = {});
+
+        // Binds the body of a function that was parsed after resolve(), with the functions resolve() declared.
+        std::vector<Diagnostic> resolve_body(Function_Declaration& function);
+
+        // Statements and expressions bound by resolve() and resolve_body(), which visit every node they're given.
+        std::size_t nodes() const noexcept;
+
+    private:
+        void declare(const std::vector<Statement_Ptr>& statements);
+        void declare(const Statement_Ptr& statement);
+
+        void bind(std::vector<Statement_Ptr>& statements);
+        void bind(Statement_Ptr& statement);
+        void bind(Expr_Ptr& expression);
+        void bind_function(Function_Declaration& function);
+        // Binds a call that doesn't name a function of the script to a builtin.
+        void bind_builtin(Call& call);
+
+        Diagnostic diagnostic(const std::string& message, const Token& token) const;
+
+        const Source_Map&                                                 _source_map;
+        std::unordered_map<std::string_view, const Function_Declaration*> _functions;
+        std::vector<Diagnostic>                                           _diagnostics;
+        std::size_t                                                       _nodes{};
+
+        // Function whose body is being bound and its 'return' statements with a value, which generators can't have.
+        Function_Declaration*      _function{};
+        std::vector<const Return*> _value_returns;
+        std::size_t                _parallel_depth{};
+
+        // Calls that are statements of their own at the top level, the only place 'snapshot()' may be.
+        std::vector<const Call*> _top_level_calls;
+        const Call*              _snapshot{};
+    };
+
+}
+
+#endif //LYNX_RESOLVER_H
@@ -0,0 +1,277 @@
+#include "server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "file.h"
+
+namespace lynx {
+
+    namespace {
+
+        constexpr std::size_t MAX_REQUEST = 4096;
+
+        // A cached program is stale once one of the modules it imports has changed, too.
+        bool modules_current(const Compile_Result& compiled) {
+            if(compiled.program == nullptr) {
+                return true;
+            }
+            const auto& modules = compiled.program->modules();
+            return std::all_of(modules.begin(), modules.end(), [](const auto& module) {
+                return module->is_current();
+            });
+        }
+
+        bool send_all(const int socket, const char* data, std::size_t size) noexcept {
+            while(size > 0) {
+                // A client that went away mustn't kill the server with SIGPIPE.
+                const auto sent = ::send(socket, data, size, MSG_NOSIGNAL);
+                if(sent < 0) {
+                    if(errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += sent;
+                size -= static_cast<std::size_t>(sent);
+            }
+            return true;
+        }
+
+        bool receive_all(const int socket, char* data, std::size_t size) noexcept {
+            while(size > 0) {
+                const auto received = ::recv(socket, data, size, 0);
+                if(received < 0 && errno == EINTR) {
+                    continue;
+                }
+                if(received <= 0) {
+                    return false;
+                }
+                data += received;
+                size -= static_cast<std::size_t>(received);
+            }
+            return true;
+        }
+
+        void send_frame(const int socket, const Server::Frame frame, std::string_view data) noexcept {
+            char header[1 + sizeof(std::uint32_t)];
+            header[0] = static_cast<char>(frame);
+            const auto size = static_cast<std::uint32_t>(data.size());
+            std::memcpy(header + 1, &size, sizeof(size));
+            if(send_all(socket, header, sizeof(header))) {
+                send_all(socket, data.data(), data.size());
+            }
+        }
+
+        void send_exit(const int socket, const std::int32_t status) noexcept {
+            send_frame(socket, Server::Frame::EXIT, std::string_view{reinterpret_cast<const char*>(&status),
+                    sizeof(status)});
+        }
+
+        sockaddr_un socket_address(const std::string& path) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if(path.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error{"Socket path '" + path + "' is too long"};
+            }
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            return address;
+        }
+
+        // Everything a worker thread needs to run a script, created once per thread instead of once per request.
+        // The output goes to whichever connection the thread is serving.
+        struct Worker_Context {
+            int           connection{-1};
+            Output_Buffer output{[this](std::string_view text) {
+                send_frame(connection, Server::Frame::OUTPUT, text);
+            }, 64 * 1024};
+            Interpreter   interpreter{output};
+        };
+
+    }
+
+    Compile_Result Program_Cache::get(const std::string& path) {
+        std::error_code error;
+        const auto modified = std::filesystem::last_write_time(path, error);
+        const auto size = error ? 0 : std::filesystem::file_size(path, error);
+        if(error) {
+            return Compile_Result{};
+        }
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            if(const auto entry = _entries.find(path); entry != _entries.end() && entry->second.modified == modified
+                    && entry->second.size == size && modules_current(entry->second.compiled)) {
+                ++_hits;
+                return entry->second.compiled;
+            }
+        }
+        ++_misses;
+        auto code = read_file(path);
+        if(!code.has_value()) {
+            return Compile_Result{};
+        }
+        // Compiled outside the lock, so a slow script doesn't hold up requests for the others.
+        auto compiled = Program::compile(path, std::move(*code));
+        std::lock_guard<std::mutex> lock{_mutex};
+        _entries.insert_or_assign(path, Entry{modified, size, compiled});
+        return compiled;
+    }
+
+    std::size_t Program_Cache::hits() const noexcept {
+        return _hits.load();
+    }
+
+    std::size_t Program_Cache::misses() const noexcept {
+        return _misses.load();
+    }
+
+    Server::Server(std::string socket_path, const std::size_t jobs, const Limits& limits)
+            : _socket_path{std::move(socket_path)}, _limits{limits}, _pool{jobs} {
+    }
+
+    Server::~Server() {
+        stop();
+    }
+
+    void Server::serve() {
+        const auto address = socket_address(_socket_path);
+        const int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(listener < 0) {
+            throw std::runtime_error{"Can't create a socket: " + std::string{std::strerror(errno)}};
+        }
+        // A socket file left behind by a server that didn't shut down cleanly would make bind() fail.
+        ::unlink(_socket_path.c_str());
+        if(::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+                || ::listen(listener, 128) != 0) {
+            const std::string reason{std::strerror(errno)};
+            ::close(listener);
+            throw std::runtime_error{"Can't listen on '" + _socket_path + "': " + reason};
+        }
+        _listener = listener;
+        Task_Group group;
+        while(!_stopping) {
+            const int connection = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if(connection < 0) {
+                if(_stopping) {
+                    break;
+                }
+                if(errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                _pool.wait(group);
+                ::close(listener);
+                throw std::runtime_error{"Can't accept connections: " + std::string{std::strerror(errno)}};
+            }
+            _pool.submit(group, [this, connection] {
+                handle(connection);
+                ::close(connection);
+            });
+        }
+        _pool.wait(group);
+        _listener = -1;
+        ::close(listener);
+        ::unlink(_socket_path.c_str());
+    }
+
+    void Server::stop() {
+        _stopping = true;
+        // Wakes up accept() in serve().
+        if(const auto listener = _listener.load(); listener >= 0) {
+            ::shutdown(listener, SHUT_RDWR);
+        }
+    }
+
+    const Program_Cache& Server::cache() const noexcept {
+        return _cache;
+    }
+
+    // Replies the way 'lynx <path>' would have run the script.
+    void Server::handle(const int connection) {
+        std::string path;
+        char c = 0;
+        while(path.size() < MAX_REQUEST && receive_all(connection, &c, 1) && c != '\n') {
+            path += c;
+        }
+        if(c != '\n') {
+            return;
+        }
+        const auto compiled = _cache.get(path);
+        if(compiled.program == nullptr && compiled.diagnostics.empty()) {
+            send_frame(connection, Frame::ERRORS, "Error: File \"" + path + "\" not found. Exiting...\n");
+            send_exit(connection, 1);
+            return;
+        }
+        if(compiled.program == nullptr) {
+            std::string errors;
+            for(const auto& diagnostic : compiled.diagnostics) {
+                errors += to_string(diagnostic) + '\n';
+            }
+            send_frame(connection, Frame::ERRORS, errors);
+            send_frame(connection, Frame::OUTPUT, "Reported " + std::to_string(compiled.diagnostics.size())
+                    + " errors. Exiting...\n");
+            send_exit(connection, 2);
+            return;
+        }
+        thread_local Worker_Context context;
+        context.connection = connection;
+        context.interpreter.set_limits(_limits);
+        std::int32_t status = 0;
+        if(const auto result = context.interpreter.run(*compiled.program); !result.ok()) {
+            context.output << "Error: " << result.error << ".\nError reported. Exiting...\n";
+            status = result.status == Run_Result::Status::LIMIT_EXCEEDED ? 3 : 0;
+        }
+        context.output.flush();
+        send_exit(connection, status);
+    }
+
+    int run_remote(const std::string& socket_path, const std::string& script_path, Output_Buffer& output,
+            Output_Buffer& errors) {
+        const auto address = socket_address(socket_path);
+        const int connection = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(connection < 0) {
+            return -1;
+        }
+        const auto request = script_path + '\n';
+        if(::connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+                || !send_all(connection, request.data(), request.size())) {
+            ::close(connection);
+            return -1;
+        }
+        int status = -1;
+        std::string data;
+        char header[1 + sizeof(std::uint32_t)];
+        while(receive_all(connection, header, sizeof(header))) {
+            std::uint32_t size;
+            std::memcpy(&size, header + 1, sizeof(size));
+            data.resize(size);
+            if(!receive_all(connection, data.data(), size)) {
+                break;
+            }
+            const auto frame = static_cast<Server::Frame>(header[0]);
+            if(frame == Server::Frame::OUTPUT) {
+                output << data;
+            } else if(frame == Server::Frame::ERRORS) {
+                // Diagnostics are rare, keep them in order with what was printed before them.
+                output.flush();
+                errors << data;
+                errors.flush();
+            } else if(frame == Server::Frame::EXIT && size == sizeof(std::int32_t)) {
+                std::int32_t exit_status;
+                std::memcpy(&exit_status, data.data(), sizeof(exit_status));
+                status = exit_status;
+                break;
+            }
+        }
+        ::close(connection);
+        output.flush();
+        errors.flush();
+        return status;
+    }
+
+}
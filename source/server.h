@@ -0,0 +1,84 @@
+#ifndef LYNX_SERVER_H
+#define LYNX_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "interpreter.h"
+#include "output.h"
+#include "program.h"
+#include "thread_pool.h"
+
+namespace lynx {
+
+    // Program_Cache keeps the compiled Program of every script it was asked for, and compiles a script again
+    // only once its modification time or size changes. Safe to use from any number of threads.
+    class Program_Cache {
+    public:
+        // Compile_Result of the script, with no program and no diagnostics if it can't be read.
+        Compile_Result get(const std::string& path);
+
+        std::size_t hits() const noexcept;
+        std::size_t misses() const noexcept;
+
+    private:
+        struct Entry {
+            std::filesystem::file_time_type modified;
+            std::uintmax_t                  size;
+            Compile_Result                  compiled;
+        };
+
+        std::mutex                             _mutex;
+        std::unordered_map<std::string, Entry> _entries;
+        std::atomic<std::size_t>               _hits{};
+        std::atomic<std::size_t>               _misses{};
+    };
+
+    // Server runs scripts on behalf of clients connecting to a Unix domain socket, so that each run costs only
+    // its execution: programs come from a Program_Cache and run on a Thread_Pool, in an Interpreter that every
+    // worker thread keeps for all the requests it serves.
+    // A request is the absolute path of a script followed by '\n'. The reply is a sequence of frames, each a
+    // Frame byte, a 32-bit length in native byte order and that many bytes: OUTPUT frames as the script prints,
+    // ERRORS for diagnostics, and a final EXIT with the 32-bit exit status the script would have had as 'lynx'.
+    class Server {
+    public:
+        enum class Frame : char {
+            OUTPUT = 'O', ERRORS = 'E', EXIT = 'X'
+        };
+
+        // Every script runs under 'limits'.
+        Server(std::string socket_path, const std::size_t jobs, const Limits& limits = {});
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+        ~Server();
+
+        // Accepts connections until stop() is called. Throws if the socket can't be created.
+        void serve();
+        // Makes serve() return once the requests it has accepted are done. Can be called from any thread.
+        void stop();
+
+        const Program_Cache& cache() const noexcept;
+
+    private:
+        void handle(const int connection);
+
+        std::string       _socket_path;
+        Limits            _limits;
+        Thread_Pool       _pool;
+        Program_Cache     _cache;
+        std::atomic<int>  _listener{-1};
+        std::atomic<bool> _stopping{false};
+    };
+
+    // Asks the server at 'socket_path' to run a script, writing what it prints to 'output' and its diagnostics to
+    // 'errors' as they arrive. Returns the script's exit status, or -1 if the server couldn't be reached.
+    int run_remote(const std::string& socket_path, const std::string& script_path, Output_Buffer& output,
+            Output_Buffer& errors);
+
+}
+
+#endif //LYNX_SERVER_H
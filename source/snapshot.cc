@@ -0,0 +1,264 @@
+#include "snapshot.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "array.h"
+#include "big_integer.h"
+#include "file.h"
+#include "map.h"
+
+namespace lynx {
+
+    namespace {
+
+        // Bumped whenever the layout changes. Values are stored in native byte order and representation, so a
+        // snapshot is only meant to be read by the build that wrote it.
+        constexpr char MAGIC[8] = {'L', 'Y', 'N', 'X', 'S', 'N', 'P', '2'};
+
+        class Encoder {
+        public:
+            template<typename T>
+            void write(const T value) {
+                _data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+
+            void write(const void* data, const std::size_t size) {
+                _data.append(static_cast<const char*>(data), size);
+            }
+
+            void write_text(const std::string_view text) {
+                write<std::uint64_t>(text.size());
+                write(text.data(), text.size());
+            }
+
+            void write_value(const Value& value) {
+                write<std::uint8_t>(static_cast<std::uint8_t>(value.type));
+                switch(value.type) {
+                    case Value::Type::INTEGER:
+                        // A flag tells a 'long long' from the decimal digits of a Big_Integer.
+                        if(const auto small = std::get_if<long long>(&value.data); small != nullptr) {
+                            write<std::uint8_t>(0);
+                            write(*small);
+                        } else {
+                            write<std::uint8_t>(1);
+                            write_text(std::get<std::shared_ptr<const Big_Integer>>(value.data)->to_string());
+                        }
+                        return;
+                    case Value::Type::FLOAT:
+                        write(std::get<long double>(value.data));
+                        return;
+                    case Value::Type::BOOL:
+                        write<std::uint8_t>(std::get<bool>(value.data));
+                        return;
+                    case Value::Type::STRING: {
+                        const auto& string = string_of(value);
+                        write_text(std::string_view{string.data(), string.size()});
+                        return;
+                    }
+                    case Value::Type::VOID:
+                        return;
+                    case Value::Type::ARRAY:
+                        write_array(*std::get<std::shared_ptr<Array>>(value.data));
+                        return;
+                    case Value::Type::MAP:
+                        write_map(*std::get<std::shared_ptr<Map>>(value.data));
+                        return;
+                    case Value::Type::GENERATOR:
+                        break;
+                }
+                throw std::runtime_error{"A generator can't be stored in a snapshot"};
+            }
+
+            const std::string& data() const noexcept {
+                return _data;
+            }
+
+        private:
+            void write_array(const Array& array) {
+                write<std::uint8_t>(static_cast<std::uint8_t>(array.element_type()));
+                write<std::uint64_t>(array.size());
+                std::visit([this](const auto& elements) {
+                    write(elements.data(), elements.size() * sizeof(elements[0]));
+                }, array.elements);
+            }
+
+            void write_map(const Map& map) {
+                write<std::uint8_t>(static_cast<std::uint8_t>(map.key_type()));
+                write<std::uint8_t>(static_cast<std::uint8_t>(map.value_type()));
+                write<std::uint64_t>(map.size());
+                // Hashes are the same in every run, storing them spares hashing every key again.
+                for(const auto& entry : map.entries()) {
+                    write(entry.hash);
+                    write_value(entry.key);
+                    write_value(entry.value);
+                }
+            }
+
+            std::string _data;
+        };
+
+        class Decoder {
+        public:
+            Decoder(const char* data, const std::size_t size)
+                    : _data{data}, _end{data + size} {
+            }
+
+            template<typename T>
+            T read() {
+                T value;
+                std::memcpy(&value, take(sizeof(value)), sizeof(value));
+                return value;
+            }
+
+            std::string_view read_text() {
+                const auto size = read<std::uint64_t>();
+                return std::string_view{take(size), size};
+            }
+
+            Value read_value() {
+                const auto type = read_type();
+                switch(type) {
+                    case Value::Type::INTEGER:
+                        if(read<std::uint8_t>() == 0) {
+                            return Value{type, read<long long>()};
+                        }
+                        return read_big_integer();
+                    case Value::Type::FLOAT:
+                        return Value{type, read<long double>()};
+                    case Value::Type::BOOL:
+                        return Value{type, read<std::uint8_t>() != 0};
+                    case Value::Type::STRING:
+                        return make_string(read_text());
+                    case Value::Type::VOID:
+                        return Value{type, std::monostate{}};
+                    case Value::Type::ARRAY:
+                        return Value{type, read_array()};
+                    case Value::Type::MAP:
+                        return Value{type, read_map()};
+                    case Value::Type::GENERATOR:
+                        break;
+                }
+                throw corrupt();
+            }
+
+            const char* take(const std::size_t size) {
+                if(static_cast<std::size_t>(_end - _data) < size) {
+                    throw corrupt();
+                }
+                return std::exchange(_data, _data + size);
+            }
+
+            bool at_end() const noexcept {
+                return _data == _end;
+            }
+
+            static std::runtime_error corrupt() {
+                return std::runtime_error{"The snapshot is corrupt"};
+            }
+
+        private:
+            Value read_big_integer() {
+                try {
+                    return make_integer(Big_Integer::parse(read_text()));
+                } catch(const std::invalid_argument&) {
+                    throw corrupt();
+                }
+            }
+
+            Value::Type read_type() {
+                const auto type = read<std::uint8_t>();
+                if(type > static_cast<std::uint8_t>(Value::Type::MAP)) {
+                    throw corrupt();
+                }
+                return static_cast<Value::Type>(type);
+            }
+
+            template<typename Elements>
+            Elements read_elements(const std::size_t size) {
+                using Element = typename Elements::value_type;
+                if(size > static_cast<std::size_t>(_end - _data) / sizeof(Element)) {
+                    throw corrupt();
+                }
+                Elements elements(size);
+                std::memcpy(elements.data(), take(size * sizeof(Element)), size * sizeof(Element));
+                return elements;
+            }
+
+            std::shared_ptr<Array> read_array() {
+                const auto element_type = read_type();
+                const auto size = read<std::uint64_t>();
+                switch(element_type) {
+                    case Value::Type::INTEGER:
+                        return make_managed<Array>(read_elements<Array::Integers>(size));
+                    case Value::Type::FLOAT:
+                        return make_managed<Array>(read_elements<Array::Floats>(size));
+                    case Value::Type::BOOL:
+                        return make_managed<Array>(read_elements<Array::Bools>(size));
+                    default:
+                        throw corrupt();
+                }
+            }
+
+            std::shared_ptr<Map> read_map() {
+                const auto key_type = read_type();
+                const auto value_type = read_type();
+                const auto size = read<std::uint64_t>();
+                // Every entry takes at least a hash and two type bytes.
+                if(size > static_cast<std::size_t>(_end - _data) / (sizeof(std::uint64_t) + 2)) {
+                    throw corrupt();
+                }
+                auto map = make_managed<Map>(key_type, value_type, size);
+                for(std::uint64_t i = 0; i < size; ++i) {
+                    const auto hash = read<std::uint64_t>();
+                    const auto key = read_value();
+                    map->store(key, hash, read_value());
+                }
+                return map;
+            }
+
+            const char* _data;
+            const char* _end;
+        };
+
+    }
+
+    void write_snapshot(const std::string& path, const Snapshot& snapshot) {
+        Encoder encoder;
+        encoder.write(MAGIC, sizeof(MAGIC));
+        encoder.write(snapshot.source_hash);
+        encoder.write<std::uint64_t>(snapshot.globals.size());
+        for(const auto& global : snapshot.globals) {
+            encoder.write_text(global.name);
+            encoder.write_value(global.value);
+        }
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        file.write(encoder.data().data(), static_cast<std::streamsize>(encoder.data().size()));
+        if(!file) {
+            throw std::runtime_error{"Can't write the snapshot '" + path + "'"};
+        }
+    }
+
+    Snapshot read_snapshot(const std::string& path) {
+        // An empty file fails the check of its magic number like any other truncated snapshot.
+        const Mapped_File file{path};
+        const auto content = file.content();
+        Decoder decoder{content.data(), content.size()};
+        if(std::memcmp(decoder.take(sizeof(MAGIC)), MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error{"'" + path + "' isn't a snapshot of this version of Lynx"};
+        }
+        Snapshot snapshot;
+        snapshot.source_hash = decoder.read<std::uint64_t>();
+        const auto globals = decoder.read<std::uint64_t>();
+        for(std::uint64_t i = 0; i < globals; ++i) {
+            std::string name{decoder.read_text()};
+            snapshot.globals.push_back(Snapshot::Global{std::move(name), decoder.read_value()});
+        }
+        if(!decoder.at_end()) {
+            throw Decoder::corrupt();
+        }
+        return snapshot;
+    }
+
+}
@@ -0,0 +1,34 @@
+#ifndef LYNX_SNAPSHOT_H
+#define LYNX_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "value.h"
+
+namespace lynx {
+
+    // Snapshot is the state of a run at the script's top-level 'snapshot()' statement: the globals defined by
+    // everything before it. Functions are bound when the program is compiled and nothing else survives between
+    // top-level statements, so restoring the globals and running the statements after the marker is the same as
+    // running the whole script. A snapshot belongs to the exact source it was taken of.
+    struct Snapshot {
+        struct Global {
+            std::string name;
+            Value       value;
+        };
+
+        std::uint64_t       source_hash{};
+        // In the order they were defined.
+        std::vector<Global> globals;
+    };
+
+    // Both throw std::runtime_error if the file can't be written or read, or isn't a valid snapshot.
+    void write_snapshot(const std::string& path, const Snapshot& snapshot);
+    // Maps the file into memory and decodes it in a single pass; arrays are copied out with one memcpy each.
+    Snapshot read_snapshot(const std::string& path);
+
+}
+
+#endif //LYNX_SNAPSHOT_H
@@ -0,0 +1,36 @@
+#include "source_map.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lynx {
+
+    Source_Map::Source_Map(std::string filename, const std::string_view code)
+            : _filename{std::move(filename)} {
+        _line_starts.push_back(0);
+        const char* const begin = code.data();
+        const char* const end = begin + code.size();
+        for(auto newline = begin; (newline = static_cast<const char*>(std::memchr(newline, '\n', end - newline)))
+                != nullptr; ++newline) {
+            _line_starts.push_back(static_cast<std::uint32_t>(newline - begin + 1));
+        }
+    }
+
+    const std::string& Source_Map::filename() const noexcept {
+        return _filename;
+    }
+
+    std::uint32_t Source_Map::line(const std::uint32_t offset) const noexcept {
+        const auto next = std::upper_bound(_line_starts.cbegin(), _line_starts.cend(), offset);
+        return static_cast<std::uint32_t>(next - _line_starts.cbegin());
+    }
+
+    std::uint32_t Source_Map::column(const std::uint32_t offset) const noexcept {
+        return offset - _line_starts[line(offset) - 1] + 1;
+    }
+
+    Diagnostic Source_Map::diagnostic(const std::string& message, const std::uint32_t offset) const {
+        return Diagnostic{message, _filename, line(offset), column(offset)};
+    }
+
+}
@@ -0,0 +1,34 @@
+#ifndef LYNX_SOURCE_MAP_H
+#define LYNX_SOURCE_MAP_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "diagnostic.h"
+
+namespace lynx {
+
+    // Source_Map turns the byte offsets that tokens and nodes keep into lines and columns. It indexes where every
+    // line of a file starts, so a location is only decoded, with a binary search, when something asks for it.
+    class Source_Map {
+    public:
+        Source_Map(std::string filename, std::string_view code);
+
+        const std::string& filename() const noexcept;
+
+        // Both start at 1.
+        std::uint32_t line(const std::uint32_t offset) const noexcept;
+        std::uint32_t column(const std::uint32_t offset) const noexcept;
+
+        Diagnostic diagnostic(const std::string& message, const std::uint32_t offset) const;
+
+    private:
+        std::string                _filename;
+        std::vector<std::uint32_t> _line_starts;
+    };
+
+}
+
+#endif //LYNX_SOURCE_MAP_H
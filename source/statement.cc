@@ -18,8 +18,9 @@ namespace lynx {
         visitor.visit_expression(*this);
     }
 
-    Function_Declaration::Function_Declaration(const std::string& name, Statement_Ptr&& body)
-            : name{name}, body{std::move(body)} {
+    Function_Declaration::Function_Declaration(const Token name, std::vector<Parameter>&& parameters,
+            const std::string& return_type, Statement_Ptr&& body)
+            : name{name}, parameters{std::move(parameters)}, return_type{return_type}, body{std::move(body)} {
     }
 
     void Function_Declaration::accept(Statement_Visitor& visitor) {
@@ -52,6 +53,24 @@ namespace lynx {
         visitor.visit_for(*this);
     }
 
+    For_In::For_In(const Token variable, Expr_Ptr&& iterable, Statement_Ptr&& block)
+            : variable{variable}, iterable{std::move(iterable)}, block{std::move(block)} {
+    }
+
+    void For_In::accept(Statement_Visitor& visitor) {
+        visitor.visit_for_in(*this);
+    }
+
+    Parallel_For::Parallel_For(const Token variable, Expr_Ptr&& begin, Expr_Ptr&& end,
+            std::vector<Reduction>&& reductions, Statement_Ptr&& block)
+            : variable{variable}, begin{std::move(begin)}, end{std::move(end)}, reductions{std::move(reductions)},
+              block{std::move(block)} {
+    }
+
+    void Parallel_For::accept(Statement_Visitor& visitor) {
+        visitor.visit_parallel_for(*this);
+    }
+
     While::While(Expr_Ptr&& condition, Statement_Ptr&& block)
             : condition{std::move(condition)}, block{std::move(block)} {
     }
@@ -76,5 +95,30 @@ namespace lynx {
         return visitor.visit_print(*this);
     }
 
-}
+    Return::Return(const Token keyword, Expr_Ptr&& value)
+            : keyword{keyword}, value{std::move(value)}, tail_call{dynamic_cast<const Call*>(this->value.get())} {
+    }
 
+    void Return::accept(Statement_Visitor& visitor) {
+        visitor.visit_return(*this);
+    }
+
+    Yield::Yield(const Token keyword, Expr_Ptr&& value)
+            : keyword{keyword}, value{std::move(value)} {
+    }
+
+    void Yield::accept(Statement_Visitor& visitor) {
+        visitor.visit_yield(*this);
+    }
+
+    If_Compare::If_Compare(Expr_Ptr&& left, const Token operator_, Expr_Ptr&& right, Statement_Ptr&& then_block,
+            Statement_Ptr&& else_block)
+            : left{std::move(left)}, operator_{operator_}, right{std::move(right)}, then_block{std::move(then_block)},
+              else_block{std::move(else_block)}, borrow_left{reads_only(*this->right)} {
+    }
+
+    void If_Compare::accept(Statement_Visitor& visitor) {
+        visitor.visit_if_compare(*this);
+    }
+
+}
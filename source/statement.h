@@ -7,11 +7,15 @@
 
 namespace lynx {
 
+    class Lazy_Bodies;
     class Statement_Visitor;
 
     struct Statement {
         virtual ~Statement() = default;
         virtual void accept(Statement_Visitor& visitor) = 0;
+
+        // Source line of the statement's first token.
+        std::size_t line{};
     };
     using Statement_Ptr = std::unique_ptr<Statement>;
 
@@ -29,13 +33,30 @@ namespace lynx {
         Expr_Ptr expression;
     };
 
+    struct Parameter {
+        std::string name;
+        std::string type;
+        // What 'type' is, set by the Resolver.
+        Value::Type value_type{Value::Type::VOID};
+    };
+
     struct Function_Declaration : Statement {
-        Function_Declaration(const std::string& name, Statement_Ptr&& body);
+        Function_Declaration(const Token name, std::vector<Parameter>&& parameters, const std::string& return_type,
+                Statement_Ptr&& body);
         void accept(Statement_Visitor& visitor) override;
 
-        std::string   name;
-        Statement_Ptr body;
-        // TODO: Param list.
+        Token                  name;
+        std::vector<Parameter> parameters;
+        std::string            return_type;
+        Statement_Ptr          body;
+        // What 'return_type' is, set by the Resolver. Void when the function doesn't declare one.
+        Value::Type            returns{Value::Type::VOID};
+        // Set by the Resolver when the body contains 'yield'. Calling a generator returns a suspended call
+        // instead of running its body.
+        bool                   is_generator{false};
+        // Set when the body is null until the first call compiles it, see Body_Compilation::LAZY.
+        Lazy_Bodies*           lazy{};
+        std::size_t            lazy_index{};
     };
 
     struct Variable_Declaration : Statement {
@@ -68,6 +89,40 @@ namespace lynx {
         Statement_Ptr block;
     };
 
+    // for <variable> in <generator> <block>
+    // Resumes the generator once per iteration, so values are produced only as they are consumed.
+    struct For_In : Statement {
+        For_In(const Token variable, Expr_Ptr&& iterable, Statement_Ptr&& block);
+        void accept(Statement_Visitor& visitor) override;
+
+        Token         variable;
+        Expr_Ptr      iterable;
+        Statement_Ptr block;
+    };
+
+    struct Reduction {
+        enum class Operation {
+            SUM, MIN, MAX
+        };
+        Operation operation;
+        Token     variable;
+    };
+
+    // parallel for <variable> in <begin> .. <end> [reduce <operation> <variable>, ...] <block>
+    // Iterates over [begin, end) in chunks that run concurrently. Every chunk sees a private copy of the
+    // variables visible at the loop, so only the reduction variables carry results out of it.
+    struct Parallel_For : Statement {
+        Parallel_For(const Token variable, Expr_Ptr&& begin, Expr_Ptr&& end, std::vector<Reduction>&& reductions,
+                Statement_Ptr&& block);
+        void accept(Statement_Visitor& visitor) override;
+
+        Token                  variable;
+        Expr_Ptr               begin;
+        Expr_Ptr               end;
+        std::vector<Reduction> reductions;
+        Statement_Ptr          block;
+    };
+
     struct While : Statement {
         While(Expr_Ptr&& condition, Statement_Ptr&& block);
         void accept(Statement_Visitor& visitor) override;
@@ -91,6 +146,40 @@ namespace lynx {
         Expr_Ptr expression;
     };
 
+    struct Return : Statement {
+        Return(const Token keyword, Expr_Ptr&& value);
+        void accept(Statement_Visitor& visitor) override;
+
+        Token       keyword;
+        Expr_Ptr    value;
+        // Set when the returned expression is a call, so the interpreter can reuse the current frame for it.
+        const Call* tail_call;
+    };
+
+    struct Yield : Statement {
+        Yield(const Token keyword, Expr_Ptr&& value);
+        void accept(Statement_Visitor& visitor) override;
+
+        Token    keyword;
+        Expr_Ptr value;
+    };
+
+    // Superinstruction produced by Fusion_Pass: an 'if' whose condition is a comparison, tested without
+    // materializing the intermediate 'bool' value.
+    struct If_Compare : Statement {
+        If_Compare(Expr_Ptr&& left, const Token operator_, Expr_Ptr&& right, Statement_Ptr&& then_block,
+                Statement_Ptr&& else_block);
+        void accept(Statement_Visitor& visitor) override;
+
+        Expr_Ptr      left;
+        Token         operator_;
+        Expr_Ptr      right;
+        Statement_Ptr then_block;
+        Statement_Ptr else_block;
+        // Set when 'left' can stay borrowed while 'right' is evaluated.
+        bool          borrow_left;
+    };
+
     class Statement_Visitor {
     public:
         virtual ~Statement_Visitor() = default;
@@ -100,9 +189,14 @@ namespace lynx {
         virtual void visit_variable_declaration(const Variable_Declaration& variable_declaration) = 0;
         virtual void visit_if(const If& if_stmt) = 0;
         virtual void visit_for(const For& for_stmt) = 0;
+        virtual void visit_for_in(const For_In& for_in) = 0;
+        virtual void visit_parallel_for(const Parallel_For& parallel_for) = 0;
         virtual void visit_while(const While& while_stmt) = 0;
         virtual void visit_do_while(const Do_While& do_while) = 0;
         virtual void visit_print(const Print& print) = 0;
+        virtual void visit_return(const Return& return_stmt) = 0;
+        virtual void visit_yield(const Yield& yield) = 0;
+        virtual void visit_if_compare(const If_Compare& if_compare) = 0;
     };
 
 }
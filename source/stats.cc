@@ -0,0 +1,120 @@
+#include "stats.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include "heap.h"
+
+namespace {
+
+    std::atomic<std::size_t> allocations{};
+
+}
+
+// Replaces the global allocation functions of any program linking this file, only to count the calls. The
+// other forms of operator new (arrays, nothrow) call this one.
+void* operator new(std::size_t bytes) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(auto pointer = std::malloc(bytes == 0 ? 1 : bytes); pointer != nullptr) {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+namespace lynx {
+
+    namespace {
+
+        double cpu_seconds() noexcept {
+            timespec time{};
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+            return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) / 1e9;
+        }
+
+        std::size_t peak_rss_bytes() noexcept {
+            rusage usage{};
+            getrusage(RUSAGE_SELF, &usage);
+            // Kilobytes on Linux.
+            return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+        }
+
+    }
+
+    void Phase_Recorder::begin(std::string name) {
+        end();
+        _phases.push_back(Phase_Stats{std::move(name)});
+        _running = true;
+        _start = sample();
+    }
+
+    void Phase_Recorder::end() {
+        if(!_running) {
+            return;
+        }
+        const auto now = sample();
+        auto& phase = _phases.back();
+        phase.wall_seconds = std::chrono::duration<double>(now.wall - _start.wall).count();
+        phase.cpu_seconds = now.cpu_seconds - _start.cpu_seconds;
+        phase.allocations = now.allocations - _start.allocations;
+        phase.peak_rss_bytes = peak_rss_bytes();
+        _running = false;
+    }
+
+    const std::vector<Phase_Stats>& Phase_Recorder::phases() const noexcept {
+        return _phases;
+    }
+
+    Phase_Recorder::Sample Phase_Recorder::sample() {
+        return Sample{std::chrono::steady_clock::now(), cpu_seconds(), allocation_count() + heap_stats().allocations};
+    }
+
+    std::size_t allocation_count() noexcept {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    void write_stats(std::ostream& stream, const Run_Stats& stats) {
+        char buffer[128];
+        stream << "Phase statistics:\n";
+        std::snprintf(buffer, sizeof(buffer), "  %-10s %12s %12s %12s %14s\n", "phase", "wall ms", "cpu ms",
+                "allocations", "peak RSS KiB");
+        stream << buffer;
+        for(const auto& phase : stats.phases) {
+            std::snprintf(buffer, sizeof(buffer), "  %-10s %12.3f %12.3f %12zu %14zu\n", phase.name.c_str(),
+                    phase.wall_seconds * 1000, phase.cpu_seconds * 1000, phase.allocations,
+                    phase.peak_rss_bytes / 1024);
+            stream << buffer;
+        }
+        stream << "  tokens: " << stats.tokens << ", nodes: " << stats.nodes << '\n';
+    }
+
+    void write_stats_json(std::ostream& stream, const Run_Stats& stats) {
+        char buffer[256];
+        stream << "{\n  \"phases\": [\n";
+        for(std::size_t i = 0; i < stats.phases.size(); ++i) {
+            const auto& phase = stats.phases[i];
+            std::snprintf(buffer, sizeof(buffer), "    {\"name\": \"%s\", \"wall_seconds\": %.9f, "
+                    "\"cpu_seconds\": %.9f, \"allocations\": %zu, \"peak_rss_bytes\": %zu}%s\n", phase.name.c_str(),
+                    phase.wall_seconds, phase.cpu_seconds, phase.allocations, phase.peak_rss_bytes,
+                    i + 1 < stats.phases.size() ? "," : "");
+            stream << buffer;
+        }
+        const auto heap = heap_stats();
+        stream << "  ],\n  \"tokens\": " << stats.tokens << ",\n  \"nodes\": " << stats.nodes
+                << ",\n  \"heap\": {\"allocations\": " << heap.allocations << ", \"allocated_bytes\": "
+                << heap.allocated_bytes << ", \"peak_bytes\": " << heap.peak_bytes << "}\n}\n";
+    }
+
+}
@@ -0,0 +1,61 @@
+#ifndef LYNX_STATS_H
+#define LYNX_STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lynx {
+
+    // Resources used by one phase of compiling or running a script.
+    struct Phase_Stats {
+        std::string name;
+        double      wall_seconds{};
+        double      cpu_seconds{};
+        // Calls to operator new and allocations of values' storage, by every thread of the process.
+        std::size_t allocations{};
+        // Highest resident set size of the process by the end of the phase. The kernel only tracks the peak of
+        // the whole run, so a phase can't be seen to use less than the phases before it.
+        std::size_t peak_rss_bytes{};
+    };
+
+    // Phase_Recorder measures consecutive phases: beginning one ends the phase before it.
+    class Phase_Recorder {
+    public:
+        void begin(std::string name);
+        void end();
+
+        const std::vector<Phase_Stats>& phases() const noexcept;
+
+    private:
+        struct Sample {
+            std::chrono::steady_clock::time_point wall;
+            double                                cpu_seconds;
+            std::size_t                           allocations;
+        };
+
+        static Sample sample();
+
+        std::vector<Phase_Stats> _phases;
+        Sample                   _start{};
+        bool                     _running{false};
+    };
+
+    // Calls to operator new since the process started.
+    std::size_t allocation_count() noexcept;
+
+    // What the driver reports with '--stats': the phases, and the size of the program they went through.
+    struct Run_Stats {
+        std::vector<Phase_Stats> phases;
+        std::size_t              tokens{};
+        std::size_t              nodes{};
+    };
+
+    void write_stats(std::ostream& stream, const Run_Stats& stats);
+    void write_stats_json(std::ostream& stream, const Run_Stats& stats);
+
+}
+
+#endif //LYNX_STATS_H
@@ -0,0 +1,138 @@
+#include "thread_pool.h"
+
+#include <chrono>
+
+namespace lynx {
+
+    namespace {
+
+        // Pool and index of the worker running on this thread, if it's a pool worker at all.
+        thread_local const void*  current_pool = nullptr;
+        thread_local std::size_t current_worker = static_cast<std::size_t>(-1);
+
+    }
+
+    bool Task_Group::done() const noexcept {
+        return _pending.load(std::memory_order_acquire) == 0;
+    }
+
+    Thread_Pool::Thread_Pool(const std::size_t threads) {
+        const auto count = threads == 0 ? 1 : threads;
+        for(std::size_t i = 0; i < count; ++i) {
+            _queues.push_back(std::make_unique<Worker_Queue>());
+        }
+        for(std::size_t i = 0; i < count; ++i) {
+            _threads.emplace_back([this, i] {
+                work(i);
+            });
+        }
+    }
+
+    Thread_Pool::~Thread_Pool() {
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for(auto& thread : _threads) {
+            thread.join();
+        }
+    }
+
+    std::size_t Thread_Pool::size() const noexcept {
+        return _threads.size();
+    }
+
+    void Thread_Pool::submit(Task_Group& group, Task task) {
+        group._pending.fetch_add(1, std::memory_order_relaxed);
+        // Workers keep what they spawn, so nested work stays on the core that has its data in cache.
+        const auto index = current_pool == this ? current_worker
+                : _next_queue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+        {
+            std::lock_guard<std::mutex> lock{_queues[index]->mutex};
+            _queues[index]->tasks.push_back(Queued_Task{std::move(task), &group});
+        }
+        _queued.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+        }
+        _wake.notify_one();
+    }
+
+    void Thread_Pool::wait(Task_Group& group) {
+        const auto index = current_pool == this ? current_worker : 0;
+        while(!group.done()) {
+            Queued_Task task;
+            if((current_pool == this && pop(index, task)) || steal(index, task)) {
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock{_mutex};
+            _finished.wait_for(lock, std::chrono::milliseconds{1}, [&group] {
+                return group.done();
+            });
+        }
+    }
+
+    Thread_Pool& Thread_Pool::shared() {
+        static Thread_Pool pool;
+        return pool;
+    }
+
+    void Thread_Pool::work(const std::size_t index) {
+        current_pool = this;
+        current_worker = index;
+        while(true) {
+            Queued_Task task;
+            if(pop(index, task) || steal(index, task)) {
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock{_mutex};
+            _wake.wait_for(lock, std::chrono::milliseconds{100}, [this] {
+                return _stopping || _queued.load(std::memory_order_acquire) > 0;
+            });
+            if(_stopping && _queued.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+
+    bool Thread_Pool::pop(const std::size_t index, Queued_Task& task) {
+        auto& queue = *_queues[index];
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        if(queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        _queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool Thread_Pool::steal(const std::size_t thief, Queued_Task& task) {
+        for(std::size_t i = 1; i <= _queues.size(); ++i) {
+            auto& queue = *_queues[(thief + i) % _queues.size()];
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            if(queue.tasks.empty()) {
+                continue;
+            }
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            _queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void Thread_Pool::run(Queued_Task& task) {
+        task.task();
+        if(task.group->_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+            }
+            _finished.notify_all();
+        }
+    }
+
+}
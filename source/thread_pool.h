@@ -0,0 +1,76 @@
+#ifndef LYNX_THREAD_POOL_H
+#define LYNX_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lynx {
+
+    // Counts the unfinished tasks submitted as one group, so their submitter can wait for just them.
+    class Task_Group {
+    public:
+        bool done() const noexcept;
+
+    private:
+        friend class Thread_Pool;
+
+        std::atomic<std::size_t> _pending{};
+    };
+
+    // Thread_Pool runs tasks on a fixed set of worker threads. Every worker owns a deque of tasks: it takes its
+    // own work from the back and, once that runs dry, steals from the front of the others' deques, so groups of
+    // unevenly sized tasks still keep all cores busy. A thread waiting for a group helps by running queued tasks,
+    // which makes it safe to submit and wait from inside a task. Tasks must not throw.
+    class Thread_Pool {
+    public:
+        using Task = std::function<void()>;
+
+        explicit Thread_Pool(const std::size_t threads = std::thread::hardware_concurrency());
+        Thread_Pool(const Thread_Pool&) = delete;
+        Thread_Pool& operator=(const Thread_Pool&) = delete;
+        ~Thread_Pool();
+
+        std::size_t size() const noexcept;
+
+        void submit(Task_Group& group, Task task);
+        void wait(Task_Group& group);
+
+        // Pool shared by everything in the process that doesn't need one of its own.
+        static Thread_Pool& shared();
+
+    private:
+        struct Queued_Task {
+            Task        task;
+            Task_Group* group;
+        };
+
+        struct Worker_Queue {
+            std::mutex              mutex;
+            std::deque<Queued_Task> tasks;
+        };
+
+        void work(const std::size_t index);
+        bool pop(const std::size_t index, Queued_Task& task);
+        bool steal(const std::size_t thief, Queued_Task& task);
+        void run(Queued_Task& task);
+
+        std::vector<std::unique_ptr<Worker_Queue>> _queues;
+        std::vector<std::thread>                   _threads;
+
+        std::atomic<std::size_t> _queued{};
+        std::atomic<std::size_t> _next_queue{};
+        std::mutex               _mutex;
+        std::condition_variable  _wake;
+        std::condition_variable  _finished;
+        bool                     _stopping{};
+    };
+
+}
+
+#endif //LYNX_THREAD_POOL_H
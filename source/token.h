@@ -1,6 +1,9 @@
 #ifndef LYNX_TOKEN_H
 #define LYNX_TOKEN_H
 
+#include <cstdint>
+#include <string>
+
 namespace lynx {
 
     struct Token {
@@ -23,6 +26,12 @@ namespace lynx {
             WHILE,
             DO,
             PRINT,
+            RETURN,
+            PARALLEL,
+            IN,
+            REDUCE,
+            YIELD,
+            IMPORT,
             // Operators.
             L_PAREN,
             R_PAREN,
@@ -31,6 +40,8 @@ namespace lynx {
             L_BRACKET,
             R_BRACKET,
             COLON,
+            COMMA,
+            DOT_DOT,
             SEMICOLON,
             EQUALS,
             PLUS,
@@ -46,11 +57,13 @@ namespace lynx {
             GREATER_EQUALS,
             END_OF_FILE
         };
-        Type        type = Token::Type::UNDEFINED;
-        std::string value;
-        std::string filename;
-        std::size_t line;
-        std::size_t column;
+        Type          type = Token::Type::UNDEFINED;
+        std::string   value;
+        // Byte offset of the token's first character, decoded into a line and column by the file's Source_Map.
+        std::uint32_t offset{};
+        // Position of the decoded value of an INTEGER, FLOAT or STRING token among its Lexer's literals. Their
+        // 'value' stays empty.
+        std::uint32_t literal{};
     };
 
 }
@@ -1,24 +1,108 @@
 #include "value.h"
 
+#include <climits>
+#include <optional>
 #include <stdexcept>
 
+#include "big_integer.h"
+#include "instrumentation.h"
+
 namespace lynx {
 
+#if LYNX_DEBUG
+    Value::Value(const Value& other)
+            : type{other.type}, data{other.data} {
+        LYNX_COUNT(VALUE_COPIES);
+    }
+
+    Value& Value::operator=(const Value& other) {
+        LYNX_COUNT(VALUE_COPIES);
+        type = other.type;
+        data = other.data;
+        return *this;
+    }
+#endif
+
+    namespace {
+
+        using Big_Pointer = std::shared_ptr<const Big_Integer>;
+
+        // An 'int' as a Big_Integer. A small one is converted on the stack, a big one isn't copied.
+        class Big_Operand {
+        public:
+            explicit Big_Operand(const Value& value) {
+                if(const auto small = std::get_if<long long>(&value.data); small != nullptr) {
+                    _converted.emplace(*small);
+                    _integer = &*_converted;
+                } else {
+                    _integer = std::get<Big_Pointer>(value.data).get();
+                }
+            }
+            Big_Operand(const Big_Operand&) = delete;
+            Big_Operand& operator=(const Big_Operand&) = delete;
+
+            const Big_Integer& operator*() const noexcept {
+                return *_integer;
+            }
+
+        private:
+            std::optional<Big_Integer> _converted;
+            const Big_Integer*         _integer;
+        };
+
+    }
+
+    Value make_string(const std::string_view text) {
+        LYNX_COUNT(STRING_ALLOCATIONS);
+        return Value{Value::Type::STRING, make_managed<String>(text)};
+    }
+
+    Value make_integer(Big_Integer&& integer) {
+        if(const auto small = integer.to_small(); small.has_value()) {
+            return Value{Value::Type::INTEGER, *small};
+        }
+        return Value{Value::Type::INTEGER, Big_Pointer{make_managed<Big_Integer>(std::move(integer))}};
+    }
+
+    long long small_integer(const Value& value) {
+        if(const auto small = std::get_if<long long>(&value.data); small != nullptr) {
+            return *small;
+        }
+        throw std::runtime_error{"Integer " + std::get<Big_Pointer>(value.data)->to_string()
+                + " doesn't fit in 64 bits"};
+    }
+
+    int compare_integers(const Value& left, const Value& right) {
+        const auto small_left = std::get_if<long long>(&left.data);
+        const auto small_right = std::get_if<long long>(&right.data);
+        if(small_left != nullptr && small_right != nullptr) {
+            return (*small_left > *small_right) - (*small_left < *small_right);
+        }
+        // A big integer is outside the range of 'long long', so only its sign matters against a small one.
+        if(small_left != nullptr) {
+            return std::get<Big_Pointer>(right.data)->negative() ? 1 : -1;
+        }
+        if(small_right != nullptr) {
+            return std::get<Big_Pointer>(left.data)->negative() ? -1 : 1;
+        }
+        return compare(*std::get<Big_Pointer>(left.data), *std::get<Big_Pointer>(right.data));
+    }
+
     Value operator==(const Value& left, const Value& right) {
         if(left.type != right.type) {
             throw Incompatible_Value_Types{};
         }
         if(left.type == Value::Type::INTEGER) {
-            return Value{left.type, std::get<long long>(left.data) == std::get<long long>(right.data)};
+            return Value{Value::Type::BOOL, compare_integers(left, right) == 0};
         }
         if(left.type == Value::Type::FLOAT) {
-            return Value{left.type, std::get<long double>(left.data) == std::get<long double>(right.data)};
+            return Value{Value::Type::BOOL, std::get<long double>(left.data) == std::get<long double>(right.data)};
         }
         if(left.type == Value::Type::STRING) {
-            return Value{left.type, std::get<std::string>(left.data) == std::get<std::string>(right.data)};
+            return Value{Value::Type::BOOL, string_of(left) == string_of(right)};
         }
         if(left.type == Value::Type::BOOL) {
-            return Value{left.type, std::get<bool>(left.data) == std::get<bool>(right.data)};
+            return Value{Value::Type::BOOL, std::get<bool>(left.data) == std::get<bool>(right.data)};
         }
         throw std::runtime_error{"Should never reach this point."};
     }
@@ -28,16 +112,16 @@ namespace lynx {
             throw Incompatible_Value_Types{};
         }
         if(left.type == Value::Type::INTEGER) {
-            return Value{left.type, std::get<long long>(left.data) != std::get<long long>(right.data)};
+            return Value{Value::Type::BOOL, compare_integers(left, right) != 0};
         }
-        if(left.type != Value::Type::FLOAT) {
-            return Value{left.type, std::get<long double>(left.data) != std::get<long double>(right.data)};
+        if(left.type == Value::Type::FLOAT) {
+            return Value{Value::Type::BOOL, std::get<long double>(left.data) != std::get<long double>(right.data)};
         }
-        if(left.type != Value::Type::STRING) {
-            return Value{left.type, std::get<std::string>(left.data) != std::get<std::string>(right.data)};
+        if(left.type == Value::Type::STRING) {
+            return Value{Value::Type::BOOL, string_of(left) != string_of(right)};
         }
-        if(left.type != Value::Type::BOOL) {
-            return Value{left.type, std::get<bool>(left.data) != std::get<bool>(right.data)};
+        if(left.type == Value::Type::BOOL) {
+            return Value{Value::Type::BOOL, std::get<bool>(left.data) != std::get<bool>(right.data)};
         }
         throw std::runtime_error{"Should never reach this point."};
     }
@@ -47,10 +131,10 @@ namespace lynx {
             throw Incompatible_Value_Types{};
         }
         if(left.type == Value::Type::INTEGER) {
-            return Value{left.type, std::get<long long>(left.data) < std::get<long long>(right.data)};
+            return Value{Value::Type::BOOL, compare_integers(left, right) < 0};
         }
         if(left.type == Value::Type::FLOAT) {
-            return Value{left.type, std::get<long double>(left.data) < std::get<long double>(right.data)};
+            return Value{Value::Type::BOOL, std::get<long double>(left.data) < std::get<long double>(right.data)};
         }
         throw std::runtime_error{"Should never reach this point."};
     }
@@ -59,11 +143,11 @@ namespace lynx {
         if(left.type != right.type) {
             throw Incompatible_Value_Types{};
         }
-        if(left.type > Value::Type::INTEGER) {
-            return Value{left.type, std::get<long long>(left.data) > std::get<long long>(right.data)};
+        if(left.type == Value::Type::INTEGER) {
+            return Value{Value::Type::BOOL, compare_integers(left, right) > 0};
         }
-        if(left.type > Value::Type::FLOAT) {
-            return Value{left.type, std::get<long double>(left.data) > std::get<long double>(right.data)};
+        if(left.type == Value::Type::FLOAT) {
+            return Value{Value::Type::BOOL, std::get<long double>(left.data) > std::get<long double>(right.data)};
         }
         throw std::runtime_error{"Should never reach this point."};
     }
@@ -72,11 +156,11 @@ namespace lynx {
         if(left.type != right.type) {
             throw Incompatible_Value_Types{};
         }
-        if(left.type <= Value::Type::INTEGER) {
-            return Value{left.type, std::get<long long>(left.data) <= std::get<long long>(right.data)};
+        if(left.type == Value::Type::INTEGER) {
+            return Value{Value::Type::BOOL, compare_integers(left, right) <= 0};
         }
-        if(left.type <= Value::Type::FLOAT) {
-            return Value{left.type, std::get<long double>(left.data) <= std::get<long double>(right.data)};
+        if(left.type == Value::Type::FLOAT) {
+            return Value{Value::Type::BOOL, std::get<long double>(left.data) <= std::get<long double>(right.data)};
         }
         throw std::runtime_error{"Should never reach this point."};
     }
@@ -85,11 +169,11 @@ namespace lynx {
         if(left.type != right.type) {
             throw Incompatible_Value_Types{};
         }
-        if(left.type >= Value::Type::INTEGER) {
-            return Value{left.type, std::get<long long>(left.data) >= std::get<long long>(right.data)};
+        if(left.type == Value::Type::INTEGER) {
+            return Value{Value::Type::BOOL, compare_integers(left, right) >= 0};
         }
-        if(left.type >= Value::Type::FLOAT) {
-            return Value{left.type, std::get<long double>(left.data) >= std::get<long double>(right.data)};
+        if(left.type == Value::Type::FLOAT) {
+            return Value{Value::Type::BOOL, std::get<long double>(left.data) >= std::get<long double>(right.data)};
         }
         throw std::runtime_error{"Should never reach this point."};
     }
@@ -99,13 +183,24 @@ namespace lynx {
             throw Incompatible_Value_Types{};
         }
         if(left.type == Value::Type::INTEGER) {
-            return Value{left.type, std::get<long long>(left.data) + std::get<long long>(right.data)};
+            const auto small_left = std::get_if<long long>(&left.data);
+            const auto small_right = std::get_if<long long>(&right.data);
+            long long result;
+            if(small_left != nullptr && small_right != nullptr && !__builtin_add_overflow(*small_left, *small_right,
+                    &result)) {
+                return Value{left.type, result};
+            }
+            return make_integer(*Big_Operand{left} + *Big_Operand{right});
         }
         if(left.type == Value::Type::FLOAT) {
             return Value{left.type, std::get<long double>(left.data) + std::get<long double>(right.data)};
         }
         if(left.type == Value::Type::STRING) {
-            return Value{left.type, std::get<std::string>(left.data) + std::get<std::string>(right.data)};
+            LYNX_COUNT(STRING_ALLOCATIONS);
+            auto result = make_managed<String>();
+            result->reserve(string_of(left).size() + string_of(right).size());
+            result->append(string_of(left)).append(string_of(right));
+            return Value{left.type, std::move(result)};
         }
         throw std::runtime_error{"Should never reach this point."};
     }
@@ -115,7 +210,14 @@ namespace lynx {
             throw Incompatible_Value_Types{};
         }
         if(left.type == Value::Type::INTEGER) {
-            return Value{left.type, std::get<long long>(left.data) - std::get<long long>(right.data)};
+            const auto small_left = std::get_if<long long>(&left.data);
+            const auto small_right = std::get_if<long long>(&right.data);
+            long long result;
+            if(small_left != nullptr && small_right != nullptr && !__builtin_sub_overflow(*small_left, *small_right,
+                    &result)) {
+                return Value{left.type, result};
+            }
+            return make_integer(*Big_Operand{left} - *Big_Operand{right});
         }
         if(left.type == Value::Type::FLOAT) {
             return Value{left.type, std::get<long double>(left.data) - std::get<long double>(right.data)};
@@ -131,7 +233,14 @@ namespace lynx {
             throw Incompatible_Value_Types{};
         }
         if(left.type == Value::Type::INTEGER) {
-            return Value{left.type, std::get<long long>(left.data) * std::get<long long>(right.data)};
+            const auto small_left = std::get_if<long long>(&left.data);
+            const auto small_right = std::get_if<long long>(&right.data);
+            long long result;
+            if(small_left != nullptr && small_right != nullptr && !__builtin_mul_overflow(*small_left, *small_right,
+                    &result)) {
+                return Value{left.type, result};
+            }
+            return make_integer(*Big_Operand{left} * *Big_Operand{right});
         }
         if(left.type == Value::Type::FLOAT) {
             return Value{left.type, std::get<long double>(left.data) * std::get<long double>(right.data)};
@@ -147,7 +256,18 @@ namespace lynx {
             throw Incompatible_Value_Types{};
         }
         if(left.type == Value::Type::INTEGER) {
-            return Value{left.type, std::get<long long>(left.data) / std::get<long long>(right.data)};
+            const auto small_left = std::get_if<long long>(&left.data);
+            const auto small_right = std::get_if<long long>(&right.data);
+            if(small_left != nullptr && small_right != nullptr) {
+                if(*small_right == 0) {
+                    throw std::runtime_error{"Division by zero"};
+                }
+                // The only quotient of two 'long long's that doesn't fit in one.
+                if(*small_left != LLONG_MIN || *small_right != -1) {
+                    return Value{left.type, *small_left / *small_right};
+                }
+            }
+            return make_integer(*Big_Operand{left} / *Big_Operand{right});
         }
         if(left.type == Value::Type::FLOAT) {
             return Value{left.type, std::get<long double>(left.data) / std::get<long double>(right.data)};
@@ -1,23 +1,51 @@
 #ifndef LYNX_VALUE_H
 #define LYNX_VALUE_H
 
-#include <exception>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <variant>
 
+#include "heap.h"
+
 namespace lynx {
 
     // TODO: Add strings and objects (if I decide to add operators overloading).
 
+    struct Array;
+    class Big_Integer;
+    struct Generator;
+    class Map;
+
+    // Characters of a string value, allocated on the accounted heap.
+    using String = std::basic_string<char, std::char_traits<char>, Heap_Allocator<char>>;
+
     struct Value {
         enum class Type {
-            INTEGER, FLOAT, BOOL, STRING
+            INTEGER, FLOAT, BOOL, STRING, VOID, GENERATOR, ARRAY, MAP
         };
-        using Data = std::variant<long long, long double, bool, std::string>;
+        // Generators are shared: copying one copies a reference to the same suspended call. Strings, arrays and
+        // maps are shared only until they are written to. An 'int' is a 'long long' unless it doesn't fit in one,
+        // then it is an immutable Big_Integer, so every integer has exactly one representation.
+        using Data = std::variant<long long, long double, bool, std::shared_ptr<String>, std::monostate,
+                std::shared_ptr<Generator>, std::shared_ptr<Array>, std::shared_ptr<Map>,
+                std::shared_ptr<const Big_Integer>>;
 
         Value(const Type type, const Data data)
                 : type{type}, data{data} {
         }
+        // A 'void' value.
+        Value() noexcept
+                : type{Type::VOID}, data{std::monostate{}} {
+        }
+#if LYNX_DEBUG
+        // Counted by the instrumentation.
+        Value(const Value& other);
+        Value(Value&& other) noexcept = default;
+        Value& operator=(const Value& other);
+        Value& operator=(Value&& other) noexcept = default;
+#endif
         
         Type type;
         Data data;
@@ -25,9 +53,27 @@ namespace lynx {
 
     static_assert(std::is_copy_constructible<Value>());
 
-    class Incompatible_Value_Types : public std::exception {
+    Value make_string(const std::string_view text);
+
+    inline const String& string_of(const Value& value) {
+        return *std::get<std::shared_ptr<String>>(value.data);
+    }
+
+    // An 'int' of any size: a 'long long' if the integer fits in one.
+    Value make_integer(Big_Integer&& integer);
+
+    // An 'int' that is used as an index, a size or a bound, where only a 'long long' makes sense. Throws
+    // std::runtime_error if the integer is too large.
+    long long small_integer(const Value& value);
+
+    // Negative, zero or positive as the 'int' 'left' is less than, equal to or greater than 'right'.
+    int compare_integers(const Value& left, const Value& right);
+
+    class Incompatible_Value_Types : public std::runtime_error {
     public:
-        Incompatible_Value_Types() noexcept = default;
+        Incompatible_Value_Types()
+                : std::runtime_error{"Incompatible value types"} {
+        }
     };
 
     Value operator==(const Value& left, const Value& right);
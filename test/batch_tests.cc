@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "batch.h"
+
+TEST(Batch, Manifest) {
+    const auto paths = lynx::read_manifest("a.lnx\n\n# comment\n  b.lnx \r\n");
+    ASSERT_EQ(paths.size(), 2);
+    ASSERT_EQ(paths[0], "a.lnx");
+    ASSERT_EQ(paths[1], "b.lnx");
+}
+
+TEST(Batch, Ordered_Output) {
+    const auto directory = std::filesystem::temp_directory_path();
+    std::vector<std::string> paths;
+    for(int i = 0; i < 16; ++i) {
+        paths.push_back((directory / ("lynx_batch_" + std::to_string(i) + ".lnx")).string());
+        std::ofstream{paths.back()} << "print " << i << ";\n";
+    }
+    paths.push_back((directory / "lynx_batch_missing.lnx").string());
+    std::string output_text;
+    std::string errors_text;
+    lynx::Batch_Summary summary;
+    {
+        lynx::Output_Buffer output{output_text};
+        lynx::Output_Buffer errors{errors_text};
+        lynx::Batch_Options options;
+        options.jobs = 4;
+        summary = lynx::run_batch(paths, options, output, errors);
+    }
+    for(std::size_t i = 0; i + 1 < paths.size(); ++i) {
+        std::filesystem::remove(paths[i]);
+    }
+    ASSERT_EQ(output_text, "0123456789101112131415");
+    ASSERT_EQ(summary.scripts, 17);
+    ASSERT_EQ(summary.failed, 1);
+    // The four workers, and the caller while it waits.
+    ASSERT_GE(summary.threads, 1);
+    ASSERT_LE(summary.threads, 5);
+    ASSERT_NE(errors_text.find("lynx_batch_missing.lnx"), std::string::npos);
+}
+
+TEST(Batch, Limits_Apply_To_Every_Script) {
+    const auto directory = std::filesystem::temp_directory_path();
+    const std::vector<std::string> paths{(directory / "lynx_batch_loop.lnx").string(),
+            (directory / "lynx_batch_one.lnx").string()};
+    std::ofstream{paths[0]} << "while true { }\n";
+    std::ofstream{paths[1]} << "print 1;\n";
+    std::string output_text;
+    std::string errors_text;
+    lynx::Batch_Summary summary;
+    {
+        lynx::Output_Buffer output{output_text};
+        lynx::Output_Buffer errors{errors_text};
+        lynx::Batch_Options options;
+        options.jobs = 2;
+        options.limits.steps = 1000;
+        summary = lynx::run_batch(paths, options, output, errors);
+    }
+    for(const auto& path : paths) {
+        std::filesystem::remove(path);
+    }
+    ASSERT_EQ(output_text, "1");
+    ASSERT_EQ(summary.failed, 1);
+    ASSERT_NE(errors_text.find("Step limit of 1000 exceeded"), std::string::npos);
+}
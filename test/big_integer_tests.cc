@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <climits>
+#include <sstream>
+
+#include "big_integer.h"
+#include "interpreter.h"
+
+namespace {
+
+    std::string run(const std::string& input) {
+        const auto compiled = lynx::Program::compile("", input);
+        if(compiled.program == nullptr) {
+            return "Error: " + compiled.diagnostics[0].message;
+        }
+        std::ostringstream stream;
+        lynx::Output_Buffer output{stream};
+        lynx::Interpreter interpreter{output};
+        if(const auto result = interpreter.run(*compiled.program); !result.ok()) {
+            output << "Error: " << result.error;
+        }
+        output.flush();
+        return stream.str();
+    }
+
+    lynx::Big_Integer big(const std::string& text) {
+        return lynx::Big_Integer::parse(text);
+    }
+
+}
+
+TEST(Big_Integer, Decimal_Round_Trip) {
+    for(const std::string text : {"0", "-1", "4294967296", "-9223372036854775808", "18446744073709551616",
+            "-123456789012345678901234567890123456789"}) {
+        ASSERT_EQ(big(text).to_string(), text);
+    }
+    ASSERT_EQ(big("-0").to_string(), "0");
+    ASSERT_EQ(big("000123").to_string(), "123");
+    ASSERT_THROW(big("12a"), std::invalid_argument);
+    ASSERT_THROW(big("-"), std::invalid_argument);
+    ASSERT_EQ(lynx::Big_Integer{LLONG_MIN}.to_string(), "-9223372036854775808");
+}
+
+TEST(Big_Integer, Small_Range) {
+    ASSERT_EQ(big("9223372036854775807").to_small(), LLONG_MAX);
+    ASSERT_EQ(big("-9223372036854775808").to_small(), LLONG_MIN);
+    ASSERT_FALSE(big("9223372036854775808").to_small().has_value());
+    ASSERT_FALSE(big("-9223372036854775809").to_small().has_value());
+}
+
+TEST(Big_Integer, Arithmetic) {
+    const auto a = big("123456789012345678901234567890");
+    const auto b = big("-987654321098765432109876543210");
+    ASSERT_EQ((a + b).to_string(), "-864197532086419753208641975320");
+    ASSERT_EQ((a - b).to_string(), "1111111110111111111011111111100");
+    ASSERT_EQ((b - b).to_string(), "0");
+    ASSERT_EQ((a * b).to_string(), "-121932631137021795226185032733622923332237463801111263526900");
+    ASSERT_EQ((b / a).to_string(), "-8");
+    ASSERT_EQ((a * b / b).to_string(), a.to_string());
+    ASSERT_EQ((a / big("7")).to_string(), "17636684144620811271604938270");
+    ASSERT_THROW(a / big("0"), std::runtime_error);
+    ASSERT_LT(compare(b, a), 0);
+    ASSERT_EQ(compare(a, big(a.to_string())), 0);
+    ASSERT_EQ(a.hash(), big(a.to_string()).hash());
+}
+
+TEST(Big_Integer, Karatsuba_Product) {
+    // (10^k - 1)^2 = 10^2k - 2 * 10^k + 1, which has hundreds of limbs.
+    const std::size_t k = 3000;
+    const auto nines = big(std::string(k, '9'));
+    const auto expected = std::string(k - 1, '9') + "8" + std::string(k - 1, '0') + "1";
+    ASSERT_EQ((nines * nines).to_string(), expected);
+    // Operands of very different sizes.
+    const auto short_operand = big(std::string(400, '7'));
+    const auto product = nines * short_operand;
+    ASSERT_EQ((product / short_operand).to_string(), nines.to_string());
+    ASSERT_EQ((product / nines).to_string(), short_operand.to_string());
+}
+
+TEST(Big_Integer, Overflow_Promotes) {
+    ASSERT_EQ(run("var x: int = 9223372036854775807; print x + 1;"), "9223372036854775808");
+    ASSERT_EQ(run("var x: int = -9223372036854775807; x = x - 2; print x;"), "-9223372036854775809");
+    ASSERT_EQ(run("var f: int = 1; var i: int = 1; while i <= 30 { f = f * i; i = i + 1; } print f;"),
+            "265252859812191058636308480000000");
+    ASSERT_EQ(run("var x: int = -9223372036854775808; print x / -1; print -x;"),
+            "92233720368547758089223372036854775808");
+}
+
+TEST(Big_Integer, Results_Back_In_Range_Are_Small) {
+    ASSERT_EQ(run("var x: int = 9223372036854775807 + 1; var y: int = x - 1; print y == 9223372036854775807;"
+            "var a: int[] = [0, 0]; a[y - 9223372036854775806] = 5; print a;"), "true[0, 5]");
+    ASSERT_EQ(run("print 100000000000000000000 / 10000000000;"), "10000000000");
+}
+
+TEST(Big_Integer, Comparisons_And_Keys) {
+    ASSERT_EQ(run("var x: int = 100000000000000000000; print x > 5; print -x < -5; print x == x + 0; print x != 5;"),
+            "truetruetruetrue");
+    ASSERT_EQ(run("var m: string[int] = {100000000000000000000: \"big\", 1: \"small\"};"
+            "print m[10000000000 * 10000000000];"), "big");
+}
+
+TEST(Big_Integer, Array_Sums_Promote) {
+    ASSERT_EQ(run("print sum([9223372036854775807, 1]);"), "9223372036854775808");
+    ASSERT_EQ(run("var a: int[] = [9223372036854775807, 1]; print dot(a, a); print \" \"; print sum(a * 1);"),
+            "85070591730234615847396907784232501250 9223372036854775808");
+    ASSERT_EQ(run("var a: int[] = array(1000, -9223372036854775807); print sum(a) == -9223372036854775807 * 1000;"
+            "print sum(a + 1) == -9223372036854775806 * 1000;"), "truetrue");
+    ASSERT_EQ(run("var a: int[] = [3000000000, -3000000000, 5]; print dot(a, a);"), "18000000000000000025");
+}
+
+TEST(Big_Integer, Array_Overflow_Is_An_Error) {
+    for(const std::string expression : {"[9223372036854775807] + 1", "[-9223372036854775807] - 2",
+            "array(9, 4611686018427387904) * 2", "3 - [-9223372036854775807]"}) {
+        ASSERT_EQ(run("print " + expression + ";"), "Error: Integer overflow in an element-wise operation")
+                << expression;
+    }
+    ASSERT_EQ(run("print [9223372036854775807] - 1;"), "[9223372036854775806]");
+}
+
+TEST(Big_Integer, Errors) {
+    ASSERT_EQ(run("var a: int[] = [1]; print a[100000000000000000000];"),
+            "Error: Integer 100000000000000000000 doesn't fit in 64 bits");
+    ASSERT_EQ(run("var a: int[] = [1]; a[0] = 100000000000000000000;"),
+            "Error: Integer 100000000000000000000 doesn't fit in 64 bits");
+    ASSERT_EQ(run("var x: int = 0; print 1 / x;"), "Error: Division by zero");
+}
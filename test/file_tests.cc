@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "file.h"
+#include "interpreter.h"
+
+namespace {
+
+    // Directory of data files that is removed with the fixture.
+    class Data_Files {
+    public:
+        explicit Data_Files(const std::string& name)
+                : _directory{std::filesystem::temp_directory_path() / ("lynx_files_" + name)} {
+            std::filesystem::remove_all(_directory);
+            std::filesystem::create_directories(_directory);
+        }
+
+        ~Data_Files() {
+            std::filesystem::remove_all(_directory);
+        }
+
+        void write(const std::string& name, const std::string& content) const {
+            std::ofstream{_directory / name, std::ios::binary} << content;
+        }
+
+        std::string read(const std::string& name) const {
+            return lynx::read_file(path(name)).value_or("<missing>");
+        }
+
+        std::string path(const std::string& name) const {
+            return (_directory / name).string();
+        }
+
+    private:
+        std::filesystem::path _directory;
+    };
+
+    std::string run(const std::string& code) {
+        const auto compiled = lynx::Program::compile("", code);
+        if(compiled.program == nullptr) {
+            return "Error: " + compiled.diagnostics[0].message;
+        }
+        std::ostringstream stream;
+        lynx::Output_Buffer output{stream};
+        lynx::Interpreter interpreter{output};
+        if(const auto result = interpreter.run(*compiled.program); !result.ok()) {
+            output << "Error: " << result.error;
+        }
+        output.flush();
+        return stream.str();
+    }
+
+    std::vector<std::string> read_all(const std::string& path, const std::size_t chunk_size) {
+        lynx::File_Reader reader{path, chunk_size};
+        std::vector<std::string> pieces;
+        while(const auto piece = reader.next()) {
+            pieces.emplace_back(*piece);
+        }
+        return pieces;
+    }
+
+}
+
+TEST(File, Read_File_Tells_Empty_From_Missing) {
+    const Data_Files files{"read"};
+    files.write("empty.txt", "");
+    ASSERT_EQ(lynx::read_file(files.path("empty.txt")), std::optional<std::string>{""});
+    ASSERT_FALSE(lynx::read_file(files.path("missing.txt")).has_value());
+    ASSERT_FALSE(lynx::read_file(files.path("")).has_value());
+}
+
+TEST(File, Reader_Splits_Lines) {
+    const Data_Files files{"lines"};
+    files.write("a.txt", "one\r\ntwo\n\nthree");
+    files.write("b.txt", "last\n");
+    files.write("empty.txt", "");
+    ASSERT_EQ(read_all(files.path("a.txt"), 0), (std::vector<std::string>{"one", "two", "", "three"}));
+    ASSERT_EQ(read_all(files.path("b.txt"), 0), std::vector<std::string>{"last"});
+    ASSERT_TRUE(read_all(files.path("empty.txt"), 0).empty());
+    ASSERT_THROW(read_all(files.path("missing.txt"), 0), std::runtime_error);
+}
+
+TEST(File, Reader_Splits_Chunks) {
+    const Data_Files files{"chunks"};
+    files.write("a.txt", "abcdefg\n");
+    ASSERT_EQ(read_all(files.path("a.txt"), 3), (std::vector<std::string>{"abc", "def", "g\n"}));
+    ASSERT_EQ(read_all(files.path("a.txt"), 100), std::vector<std::string>{"abcdefg\n"});
+}
+
+TEST(File, Reader_Crosses_Prefetch_Windows) {
+    const Data_Files files{"large"};
+    const std::string line(999, 'x');
+    std::string content;
+    for(int i = 0; i < 10000; ++i) {
+        content += line + '\n';
+    }
+    ASSERT_GT(content.size(), 2 * lynx::File_Reader::PREFETCH_WINDOW);
+    files.write("a.txt", content);
+    const auto lines = read_all(files.path("a.txt"), 0);
+    ASSERT_EQ(lines.size(), 10000);
+    ASSERT_EQ(lines.back(), line);
+}
+
+TEST(File, Lines_And_Chunks_Builtins) {
+    const Data_Files files{"builtins"};
+    files.write("a.txt", "3\n4\n5\n");
+    const auto path = "\"" + files.path("a.txt") + "\"";
+    ASSERT_EQ(run("var total: int = 0; for line in lines(" + path + ") { print line; total = total + len(line); }"
+            "print total;"), "3453");
+    ASSERT_EQ(run("for chunk in chunks(" + path + ", 4) { print len(chunk); }"), "42");
+    ASSERT_EQ(run("func numbered(path: string) { var i: int = 0; for line in lines(path) { yield i; i = i + 1; } }"
+            "for i in numbered(" + path + ") { print i; }"), "012");
+    ASSERT_EQ(run("for line in lines(\"" + files.path("missing.txt") + "\") { print line; }"),
+            "Error: Can't open file \"" + files.path("missing.txt") + "\"");
+    ASSERT_EQ(run("for chunk in chunks(" + path + ", 0) { print chunk; }"),
+            "Error: Size of a chunk has to be a positive 'int'");
+}
+
+TEST(File, Write_Builtin) {
+    const Data_Files files{"write"};
+    const auto path = "\"" + files.path("out.txt") + "\"";
+    files.write("out.txt", "old content");
+    ASSERT_EQ(run("var i: int = 0; while i < 3 { write(" + path + ", i); write(" + path + ", \",\"); i = i + 1; }"
+            "write(" + path + ", [1.5, 2.5]); print \"done\";"), "done");
+    ASSERT_EQ(files.read("out.txt"), "0,1,2,[1.5, 2.5]");
+    // Flushed even when the run fails.
+    ASSERT_EQ(run("write(" + path + ", \"partial\"); print 1 / 0;"), "Error: Division by zero");
+    ASSERT_EQ(files.read("out.txt"), "partial");
+    ASSERT_EQ(run("parallel for i in 0 .. 4 { write(" + path + ", i); }"),
+            "Error: 'write' can't be used inside a 'parallel for'");
+}
+
+TEST(File, Failed_Writes_Are_Reported) {
+    // Every write to /dev/full fails with ENOSPC.
+    const auto file_descriptor = ::open("/dev/full", O_WRONLY | O_CLOEXEC);
+    ASSERT_GE(file_descriptor, 0);
+    {
+        lynx::Output_Buffer output{file_descriptor, 16};
+        output << "short";
+        ASSERT_FALSE(output.failed());
+        output.flush();
+        ASSERT_TRUE(output.failed());
+        output << "more than the whole buffer holds";
+        ASSERT_TRUE(output.failed());
+    }
+    ::close(file_descriptor);
+    std::string text;
+    lynx::Output_Buffer output{text};
+    output << "fine";
+    output.flush();
+    ASSERT_FALSE(output.failed());
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "fusion.h"
+#include "interpreter.h"
+#include "parser.h"
+
+namespace {
+
+    std::size_t rewrites(const lynx::Fusion_Pass& fusion, const lynx::Fused_Pattern pattern) {
+        return fusion.rewrites()[static_cast<std::size_t>(pattern)];
+    }
+
+}
+
+TEST(Fusion, Rewrites_Patterns) {
+    std::string input{"var x: int = 0; while x < 10 { x = x + 1; } if x == 10 { print x * 2; }"};
+    lynx::Lexer lexer{"", std::move(input)};
+    lynx::Parser parser{lexer};
+    auto statements = parser.parse();
+    ASSERT_EQ(parser.errors_reported(), 0);
+    lynx::Fusion_Pass fusion;
+    fusion.fuse(statements);
+    ASSERT_EQ(rewrites(fusion, lynx::Fused_Pattern::COMPARE_IDENTIFIER_LITERAL), 1);
+    ASSERT_EQ(rewrites(fusion, lynx::Fused_Pattern::COMPOUND_ASSIGNMENT), 1);
+    ASSERT_EQ(rewrites(fusion, lynx::Fused_Pattern::IF_COMPARE), 1);
+    ASSERT_EQ(rewrites(fusion, lynx::Fused_Pattern::ARITHMETIC_IDENTIFIER_LITERAL), 1);
+}
+
+TEST(Fusion, Fused_Program_Runs) {
+    std::string input{"var x: int = 0; while x < 10 { x = x + 1; } if x == 10 { print x * 2; } else { print 0; }"};
+    const auto compiled = lynx::Program::compile("", std::move(input));
+    ASSERT_NE(compiled.program, nullptr);
+    std::ostringstream stream;
+    lynx::Output_Buffer output{stream};
+    lynx::Interpreter interpreter{output};
+    ASSERT_TRUE(interpreter.run(*compiled.program).ok());
+    output.flush();
+    ASSERT_EQ(stream.str(), "20");
+    const auto& executed = interpreter.fusion_counters();
+    ASSERT_EQ(executed[static_cast<std::size_t>(lynx::Fused_Pattern::COMPARE_IDENTIFIER_LITERAL)], 11);
+    ASSERT_EQ(executed[static_cast<std::size_t>(lynx::Fused_Pattern::COMPOUND_ASSIGNMENT)], 10);
+    ASSERT_EQ(executed[static_cast<std::size_t>(lynx::Fused_Pattern::IF_COMPARE)], 1);
+}
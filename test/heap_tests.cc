@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+
+#include "array.h"
+#include "heap.h"
+#include "interpreter.h"
+#include "map.h"
+
+TEST(Heap, Values_Release_Their_Storage) {
+    const auto before = lynx::heap_stats();
+    {
+        auto text = lynx::make_string("a string long enough not to fit in the string itself");
+        lynx::Value array{lynx::Value::Type::ARRAY, lynx::make_managed<lynx::Array>(lynx::Value::Type::FLOAT, 1000)};
+        auto map = lynx::make_managed<lynx::Map>(lynx::Value::Type::STRING, lynx::Value::Type::STRING, 100);
+        map->store(text, text);
+        ASSERT_GT(lynx::heap_stats().live_bytes, before.live_bytes + 1000 * sizeof(double));
+    }
+    const auto after = lynx::heap_stats();
+    ASSERT_EQ(after.live_bytes, before.live_bytes);
+    ASSERT_EQ(after.live_allocations(), before.live_allocations());
+}
+
+TEST(Heap, Copies_Share_Strings) {
+    const auto text = lynx::make_string("shared by every copy of the value, never duplicated");
+    const auto before = lynx::heap_stats();
+    const auto copy = text;
+    ASSERT_EQ(&lynx::string_of(copy), &lynx::string_of(text));
+    ASSERT_EQ(lynx::heap_stats().allocations, before.allocations);
+}
+
+TEST(Heap, Scripts_Leave_Nothing_Behind) {
+    const auto before = lynx::heap_stats();
+    {
+        const auto compiled = lynx::Program::compile("", "var s: string = \"\"; var i: int = 0;"
+                "while i < 1000 { var t: string = s; s = s + \"x\"; i = i + 1; } print len(s);");
+        ASSERT_TRUE(compiled.diagnostics.empty());
+        std::ostringstream stream;
+        lynx::Output_Buffer output{stream};
+        lynx::Interpreter interpreter{output};
+        ASSERT_TRUE(interpreter.run(*compiled.program).ok());
+        output.flush();
+        ASSERT_EQ(stream.str(), "1000");
+    }
+    ASSERT_EQ(lynx::heap_stats().live_bytes, before.live_bytes);
+}
+
+TEST(Heap, Threads_Add_Up) {
+    const auto before = lynx::heap_stats();
+    lynx::Value kept;
+    std::thread{[&kept] {
+        const lynx::Heap_Budget budget{lynx::Heap_Budget::UNLIMITED};
+        const auto temporary = lynx::make_managed<lynx::Array>(lynx::Value::Type::FLOAT, 1000);
+        kept = lynx::Value{lynx::Value::Type::ARRAY, lynx::make_managed<lynx::Array>(lynx::Value::Type::INTEGER, 10)};
+        ASSERT_GE(budget.peak(), static_cast<std::ptrdiff_t>(1010 * sizeof(double)));
+    }}.join();
+    const auto after = lynx::heap_stats();
+    // Each array and its elements.
+    ASSERT_EQ(after.allocations, before.allocations + 4);
+    ASSERT_GT(after.live_bytes, before.live_bytes);
+    ASSERT_GE(after.peak_bytes, 1010 * sizeof(double));
+    // Freed by another thread than the one that allocated it.
+    kept = lynx::Value{};
+    ASSERT_EQ(lynx::heap_stats().live_bytes, before.live_bytes);
+}
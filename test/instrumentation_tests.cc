@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "instrumentation.h"
+#include "interpreter.h"
+
+namespace {
+
+    std::array<std::uint64_t, static_cast<std::size_t>(lynx::Counter::COUNT)> snapshot() {
+        std::array<std::uint64_t, static_cast<std::size_t>(lynx::Counter::COUNT)> values{};
+        for(std::size_t i = 0; i < values.size(); ++i) {
+            values[i] = lynx::counter(static_cast<lynx::Counter>(i));
+        }
+        return values;
+    }
+
+#if LYNX_DEBUG
+    std::uint64_t delta(const std::array<std::uint64_t, static_cast<std::size_t>(lynx::Counter::COUNT)>& before,
+            const lynx::Counter counter) {
+        return lynx::counter(counter) - before[static_cast<std::size_t>(counter)];
+    }
+#endif
+
+    void run(std::string input) {
+        const auto compiled = lynx::Program::compile("", std::move(input));
+        ASSERT_TRUE(compiled.diagnostics.empty());
+        std::ostringstream stream;
+        lynx::Output_Buffer output{stream};
+        lynx::Interpreter interpreter{output};
+        interpreter.run(*compiled.program);
+    }
+
+}
+
+TEST(Instrumentation, Counts_Hot_Paths) {
+    const auto before = snapshot();
+    run("var s: string = \"\"; var i: int = 0;"
+            "while i < 10 { s = s + \"a string too long for the small buffer\"; i = i + 1; } print undefined;");
+#if LYNX_DEBUG
+    ASSERT_EQ(delta(before, lynx::Counter::WHILE), 1u);
+    // Both assignments in the loop are fused.
+    ASSERT_EQ(delta(before, lynx::Counter::COMPOUND_ASSIGNMENT), 20u);
+    // The string is appended to in place, so its buffer grows geometrically.
+    ASSERT_GT(delta(before, lynx::Counter::STRING_ALLOCATIONS), 1u);
+    ASSERT_LT(delta(before, lynx::Counter::STRING_ALLOCATIONS), 10u);
+    ASSERT_GE(delta(before, lynx::Counter::ENVIRONMENT_PROBES), delta(before, lynx::Counter::ENVIRONMENT_LOOKUPS));
+    ASSERT_GT(delta(before, lynx::Counter::ENVIRONMENT_LOOKUPS), 20u);
+    // The undefined variable, and the lexer running into the end of the input.
+    ASSERT_EQ(delta(before, lynx::Counter::EXCEPTIONS), 2u);
+#else
+    // Compiled out: nothing is counted.
+    ASSERT_EQ(snapshot(), before);
+#endif
+}
+
+TEST(Instrumentation, Arithmetic_Does_Not_Copy_Values) {
+    const auto loop = [](const int iterations) {
+        return "var total: int = 0; var x: float = 1.5; var i: int = 0; while i < " + std::to_string(iterations)
+                + " { total = total + i * 2; x = x * 1.5 - x; if total > i { total = total - i; } i = i + 1; }"
+                + "print total; print x;";
+    };
+    const auto before = snapshot();
+    run(loop(10));
+#if LYNX_DEBUG
+    const auto few = delta(before, lynx::Counter::VALUE_COPIES);
+    const auto middle = snapshot();
+    run(loop(1000));
+    // Only the declarations copy their initial values.
+    ASSERT_EQ(delta(middle, lynx::Counter::VALUE_COPIES), few);
+#else
+    ASSERT_EQ(snapshot(), before);
+#endif
+}
+
+TEST(Instrumentation, Writes_Json) {
+    std::ostringstream stream;
+    lynx::write_counters_json(stream);
+    const auto json = stream.str();
+    ASSERT_EQ(json.rfind("{\n  \"statements\": {\n    \"block\": ", 0), 0u);
+    ASSERT_NE(json.find("\"expressions\": {\n    \"literal\": "), std::string::npos);
+    ASSERT_NE(json.find("  \"exceptions\": "), std::string::npos);
+    ASSERT_EQ(json.substr(json.size() - 2), "}\n");
+}
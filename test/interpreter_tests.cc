@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "interpreter.h"
+
+namespace {
+
+    std::string run(std::string input) {
+        const auto compiled = lynx::Program::compile("", std::move(input));
+        EXPECT_TRUE(compiled.diagnostics.empty());
+        if(compiled.program == nullptr) {
+            return "";
+        }
+        std::ostringstream stream;
+        lynx::Output_Buffer output{stream};
+        lynx::Interpreter interpreter{output};
+        const auto result = interpreter.run(*compiled.program);
+        if(!result.ok()) {
+            output << "Error: " << result.error << ".\n";
+        }
+        output.flush();
+        return stream.str();
+    }
+
+}
+
+TEST(Interpreter, Function_Call) {
+    ASSERT_EQ(run("func add(a: int, b: int): int { return a + b; } print add(2, 3);"), "5");
+}
+
+TEST(Interpreter, Recursion) {
+    ASSERT_EQ(run("func fib(n: int): int { if n < 2 { return n; } return fib(n - 1) + fib(n - 2); } print fib(15);"),
+            "610");
+}
+
+TEST(Interpreter, Tail_Call_Runs_In_Constant_Stack) {
+    std::string input{"func count(n: int, acc: int): int { if n == 0 { return acc; } return count(n - 1, acc + 1); }"
+            "print count(200000, 0);"};
+    ASSERT_EQ(run(std::move(input)), "200000");
+}
+
+TEST(Interpreter, Deep_Recursion_Runs_Off_The_Native_Stack) {
+    ASSERT_EQ(run("func deep(n: int): int { if n == 0 { return 0; } return 1 + deep(n - 1); } print deep(50000);"),
+            "50000");
+    // Errors get out of every segment the calls moved to.
+    ASSERT_EQ(run("func deep(n: int): int { if n == 0 { return 1 / 0; } return 1 + deep(n - 1); } print deep(50000);"),
+            "Error: Division by zero.\n");
+    ASSERT_EQ(run("func nested(n: int) { if n > 0 { for x in nested(n - 1) { yield x; } } yield n; }"
+            "var total: int = 0; for x in nested(700) { total = total + x; } print total;"), "245350");
+    ASSERT_EQ(run("func deep(n: int): int { if n == 0 { return 0; } return 1 + deep(n - 1); }"
+            "func far(n: int): int { if n == 0 { var total: int = 0;"
+            "    parallel for i in 0 .. 8 reduce sum total { total = total + deep(5000); } return total; }"
+            "return 0 + far(n - 1); } print far(5000);"), "40000");
+}
+
+TEST(Interpreter, Call_Depth_Is_Limited) {
+    std::string input{"func deep(n: int): int { if n == 0 { return 0; } return 1 + deep(n - 1); } print deep(200000);"};
+    ASSERT_EQ(run(std::move(input)), "Error: Stack overflow, call depth exceeded 100000.\n");
+}
+
+TEST(Interpreter, Declared_Types_Are_Enforced) {
+    ASSERT_EQ(run("func g(n: int): int { return n; } print g(\"hello\");"),
+            "Error: Argument 'n' of 'g' has to be of type 'int'.\n");
+    ASSERT_EQ(run("func f(): int { return \"hello\"; } print f();"),
+            "Error: 'f' has to return a value of type 'int'.\n");
+    ASSERT_EQ(run("func f(n: int): int { if n > 0 { return n; } } print f(1); print f(0);"),
+            "1Error: 'f' has to return a value of type 'int'.\n");
+    ASSERT_EQ(run("func s(): string { return \"x\"; } func f(): int { return s(); } print f();"),
+            "Error: 'f' has to return a value of type 'int'.\n");
+    ASSERT_EQ(run("func g(xs: float[]) { yield len(xs); } for n in g([1, 2]) { print n; }"),
+            "Error: Argument 'xs' of 'g' has to be of type 'float[]'.\n");
+    ASSERT_EQ(run("func f(xs: float[], m: int[string]): float[int] { return {}; }"
+            "print f([], {}); print f([], map(4));"), "{}{}");
+}
+
+TEST(Interpreter, Arguments_Do_Not_Leak_Into_Caller) {
+    ASSERT_EQ(run("var n: int = 1; func id(n: int): int { return n; } print id(n + 1) + n;"), "3");
+}
+
+TEST(Interpreter, While_Loop) {
+    ASSERT_EQ(run("var i: int = 0; while i < 3 { print i; i = i + 1; }"), "012");
+}
+
+TEST(Interpreter, Print_Formatting) {
+    ASSERT_EQ(run("print 42; print \" \"; print -7; print \" \"; print 2.5; print \" \"; print true;"), "42 -7 2.5 true");
+    // A 'float' needs more digits than the nearest double does.
+    ASSERT_EQ(run("var x: float = 760248775231530.25; print x; print \" \"; print x - 760248775231530.0;"),
+            "760248775231530.25 0.25");
+    ASSERT_EQ(run("var f: float[] = [0.1, 2.5]; print f;"), "[0.1, 2.5]");
+}
+
+TEST(Interpreter, Parallel_For_Reductions) {
+    std::string input{"var total: int = 5; var low: int = 100; var high: int = 0;"
+            "parallel for i in 0 .. 10000 reduce sum total, min low, max high {"
+            "    total = total + i; if i < low { low = i; } if i > high { high = i; } }"
+            "print total; print \" \"; print low; print \" \"; print high;"};
+    ASSERT_EQ(run(std::move(input)), "49995005 0 9999");
+}
+
+TEST(Interpreter, Parallel_For_Output_Is_Ordered) {
+    ASSERT_EQ(run("parallel for i in 0 .. 100 { if i > 94 { print i; } }"), "9596979899");
+}
+
+TEST(Interpreter, Generator) {
+    std::string input{"func numbers(n: int) { var i: int = 0; while i < n { yield i; i = i + 1; } }"
+            "func evens(n: int) { for x in numbers(n) { if x / 2 * 2 == x { yield x; } } }"
+            "for x in evens(10) { print x; }"};
+    ASSERT_EQ(run(std::move(input)), "02468");
+}
+
+TEST(Interpreter, Generator_Is_Lazy) {
+    std::string input{"func naturals() { var i: int = 0; while true { yield i; i = i + 1; } }"
+            "func first(n: int): int { var total: int = 0; for x in naturals() { if x == n { return total; }"
+            "    total = total + x; } return total; }"
+            "print first(100000);"};
+    ASSERT_EQ(run(std::move(input)), "4999950000");
+}
+
+TEST(Interpreter, Generator_Return_Ends_It) {
+    std::string input{"func until(n: int) { var i: int = 0; do { { var k: int = i; if k == n { return; } yield k; }"
+            "    i = i + 1; } while i < 10; }"
+            "for x in until(3) { print x; } print \" \"; for x in until(20) { print x; }"};
+    ASSERT_EQ(run(std::move(input)), "012 0123456789");
+}
+
+TEST(Interpreter, Arrays) {
+    std::string input{"var a: int[] = [1, 2, 3]; a[1] = a[0] + a[2]; print a; print len(a);"
+            "var f: float[] = array(2, 0.5); f[0] = 0.25; print f;"
+            "var b: bool[] = [true, false]; print b[1];"};
+    ASSERT_EQ(run(std::move(input)), "[1, 4, 3]3[0.25, 0.5]false");
+}
+
+TEST(Interpreter, Arrays_Are_Values) {
+    std::string input{"func set(xs: int[]): int[] { xs[0] = 9; return xs; }"
+            "var a: int[] = [1, 2]; var b: int[] = a; b[1] = 7; var c: int[] = set(a);"
+            "print a; print b; print c;"};
+    ASSERT_EQ(run(std::move(input)), "[1, 2][1, 7][9, 2]");
+}
+
+TEST(Interpreter, For_In_Array) {
+    ASSERT_EQ(run("var total: int = 0; for x in [1, 2, 3] { total = total + x; } print total;"), "6");
+}
+
+TEST(Interpreter, Array_Errors) {
+    const auto compiled = lynx::Program::compile("", "var a: int[] = [1, 2]; a[0] = 1.5;");
+    std::string output;
+    lynx::Output_Buffer buffer{output};
+    lynx::Interpreter interpreter{buffer};
+    ASSERT_EQ(interpreter.run(*compiled.program).error, "Can't store this value in an array of type 'int[]'");
+    const auto out_of_bounds = lynx::Program::compile("", "var a: int[] = [1, 2]; print a[2];");
+    ASSERT_EQ(interpreter.run(*out_of_bounds.program).error, "Index 2 is out of bounds of an array of size 2");
+    ASSERT_EQ(run("print len(array(9000000000000000000, 0));"),
+            "Error: Array of 9000000000000000000 elements is too large.\n");
+    // Within the size an array can have, but more memory than there is.
+    ASSERT_EQ(run("print len(array(1000000000000000000, 0));"), "Error: Out of memory.\n");
+    ASSERT_EQ(run("parallel for i in 0 .. 2 { print len(array(1000000000000000000, 0)); }"),
+            "Error: Out of memory.\n");
+}
+
+TEST(Interpreter, Element_Wise_Arrays) {
+    ASSERT_EQ(run("var a: float[] = [1.0, 2.0, 3.0]; var b: float[] = [0.5, 0.5, 0.5]; print a * 2.0 + b;"),
+            "[2.5, 4.5, 6.5]");
+    ASSERT_EQ(run("var a: int[] = [1, 2, 3]; print 10 - a; print a >= 2;"), "[9, 8, 7][false, true, true]");
+    ASSERT_EQ(run("var a: int[] = [1, 2, 3]; var b: int[] = a; a = a * 3; print a; print b;"), "[3, 6, 9][1, 2, 3]");
+    ASSERT_EQ(run("var a: int[] = [1, 2, 3]; var b: int[] = [4, 5, 6]; print (a + b) * (b - a); print 2 * (a + 1);"),
+            "[15, 21, 27][4, 6, 8]");
+    ASSERT_EQ(run("var a: int[] = [1, 2]; var b: int[] = [1, 2, 3]; print a + b;"),
+            "Error: Arrays of different sizes (2 and 3) in an element-wise operation.\n");
+}
+
+TEST(Interpreter, Array_Reductions) {
+    ASSERT_EQ(run("var a: int[] = array(3000, 2); a[1234] = -5; print sum(a * a + 1); print min(a); print max(a);"),
+            "15021-52");
+    ASSERT_EQ(run("var a: float[] = [1.0, 2.0, 3.0]; print dot(a, a); print sum(a > 1.5);"), "142");
+    ASSERT_EQ(run("var a: int[] = []; print sum(a); print min(a);"), "0Error: 'min' of an empty array.\n");
+}
+
+TEST(Interpreter, Maps) {
+    ASSERT_EQ(run("var counts: int[string] = map(16);"
+            "counts[\"b\"] = counts[\"b\"] + 1; counts[\"a\"] = 5; counts[\"b\"] = counts[\"b\"] + 1;"
+            "print counts; print len(counts); print has(counts, \"c\");"), "{b: 2, a: 5}2false");
+    ASSERT_EQ(run("var m: float[int] = {1: 0.5, 2: 1.5}; var copy: float[int] = m; m[3] = 2.5;"
+            "for key in m { print key; } print copy;"), "123{1: 0.5, 2: 1.5}");
+    ASSERT_EQ(run("var m: int[string] = {}; print m[\"missing\"]; m = {}; m[\"x\"] = 1; print m;"), "0{x: 1}");
+}
+
+TEST(Interpreter, Map_Errors) {
+    ASSERT_EQ(run("var m: int[string] = {}; m[1] = 2;"),
+            "Error: Can't use this key with a map of type 'int[string]'.\n");
+    ASSERT_EQ(run("var m: int[string] = {\"a\": 1}; m[\"b\"] = true;"),
+            "Error: Can't store this value in a map of type 'int[string]'.\n");
+}
+
+TEST(Interpreter, Operands_Are_Read_Before_Calls_Change_Them) {
+    ASSERT_EQ(run("var x: int = 1; func bump(): int { x = 10; return 0; } print x + bump(); print x;"), "110");
+    ASSERT_EQ(run("var a: int[] = [0, 0]; var i: int = 0; func next(): int { i = 1; return 7; }"
+            "a[i] = next(); print a; if i == 1 { print (i = 2) + i; }"), "[7, 0]4");
+}
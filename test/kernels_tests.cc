@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "kernels.h"
+
+namespace {
+
+    std::vector<const lynx::Kernels*> available_levels() {
+        std::vector<const lynx::Kernels*> levels;
+        for(const auto level : {lynx::Simd_Level::SCALAR, lynx::Simd_Level::SSE2, lynx::Simd_Level::AVX2}) {
+            if(const auto kernels = lynx::kernels(level); kernels != nullptr) {
+                levels.push_back(kernels);
+            }
+        }
+        return levels;
+    }
+
+    // Values whose sums depend on the order they are added in.
+    std::vector<double> floats(const std::size_t size) {
+        std::vector<double> values(size);
+        for(std::size_t i = 0; i < size; ++i) {
+            values[i] = std::sin(static_cast<double>(i)) * std::pow(10.0, static_cast<double>(i % 7));
+        }
+        return values;
+    }
+
+}
+
+TEST(Kernels, Levels_Agree_On_Arithmetic) {
+    const auto a = floats(1001);
+    const auto b = floats(1002);
+    std::vector<double> expected(a.size());
+    lynx::scalar_kernels().arithmetic_f64(lynx::Arithmetic::DIVIDE, a.data(), b.data() + 1, expected.data(),
+            a.size());
+    for(const auto kernels : available_levels()) {
+        std::vector<double> out(a.size());
+        kernels->arithmetic_f64(lynx::Arithmetic::DIVIDE, a.data(), b.data() + 1, out.data(), a.size());
+        ASSERT_EQ(out, expected) << lynx::to_string(kernels->level);
+    }
+}
+
+TEST(Kernels, Levels_Agree_On_Reductions) {
+    const auto a = floats(12345);
+    double expected_lanes[lynx::KERNEL_LANES]{};
+    lynx::scalar_kernels().sum_f64(a.data(), a.size(), expected_lanes);
+    const auto expected = lynx::sum_lanes(expected_lanes);
+    for(const auto kernels : available_levels()) {
+        double lanes[lynx::KERNEL_LANES]{};
+        // Split into parts of a multiple of 8 elements, which must not change the result either.
+        kernels->sum_f64(a.data(), 4096, lanes);
+        kernels->sum_f64(a.data() + 4096, a.size() - 4096, lanes);
+        ASSERT_EQ(lynx::sum_lanes(lanes), expected) << lynx::to_string(kernels->level);
+    }
+}
+
+TEST(Kernels, Integer_Overflow_Is_Detected) {
+    const long long a[]{9223372036854775807LL, 1, 2};
+    const long long b[]{2, 2, 3};
+    long long out[3];
+    std::vector<long long> large(1001, 4611686018427387904LL);
+    for(const auto kernels : available_levels()) {
+        const auto level = lynx::to_string(kernels->level);
+        ASSERT_THROW(kernels->arithmetic_scalar_i64(lynx::Arithmetic::ADD, a, 1, false, out, 3), std::runtime_error)
+                << level;
+        ASSERT_THROW(kernels->arithmetic_scalar_i64(lynx::Arithmetic::SUBTRACT, a, -2, true, out, 3),
+                std::runtime_error) << level;
+        ASSERT_THROW(kernels->arithmetic_i64(lynx::Arithmetic::MULTIPLY, a, b, out, 3), std::runtime_error) << level;
+        ASSERT_THROW(kernels->arithmetic_scalar_i64(lynx::Arithmetic::DIVIDE, a, 0, false, out, 3),
+                std::runtime_error) << level;
+        kernels->arithmetic_i64(lynx::Arithmetic::SUBTRACT, a, b, out, 3);
+        ASSERT_EQ(out[0], 9223372036854775805LL) << level;
+        long long lanes[lynx::KERNEL_LANES]{};
+        ASSERT_FALSE(kernels->sum_i64(large.data(), large.size(), lanes)) << level;
+        std::fill(lanes, lanes + lynx::KERNEL_LANES, 0);
+        ASSERT_FALSE(kernels->dot_i64(a, b, 3, lanes)) << level;
+        std::fill(lanes, lanes + lynx::KERNEL_LANES, 0);
+        ASSERT_TRUE(kernels->dot_i64(b, b, 3, lanes)) << level;
+        long long sum{};
+        ASSERT_TRUE(lynx::sum_lanes(lanes, sum));
+        ASSERT_EQ(sum, 17) << level;
+    }
+}
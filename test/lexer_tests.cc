@@ -23,10 +23,36 @@ TEST(Lexer, Numbers) {
     lynx::Lexer lexer{"", std::move(input)};
     const auto token1 = lexer.next_token();
     ASSERT_EQ(token1.type, lynx::Token::Type::INTEGER);
-    ASSERT_EQ(token1.value, "6453");
+    ASSERT_EQ(std::get<long long>(lexer.literal(token1).data), 6453);
     const auto token2 = lexer.next_token();
     ASSERT_EQ(token2.type, lynx::Token::Type::FLOAT);
-    ASSERT_EQ(token2.value, "23.6");
+    ASSERT_EQ(std::get<long double>(lexer.literal(token2).data), 23.6L);
+}
+
+TEST(Lexer, Floats_Are_Correctly_Rounded) {
+    // Short ones take the exact fast path, long ones the general conversion.
+    for(const std::string text : {"0.1", "2.5", "123456.789", "0.000000000000000000000000001", "9007199254740993.0",
+            "18446744073709551615.5", "3.14159265358979323846264338327950288", "1.00000000000000000000000000000001"}) {
+        lynx::Lexer lexer{"", std::string{text}};
+        const auto token = lexer.next_token();
+        ASSERT_EQ(token.type, lynx::Token::Type::FLOAT);
+        ASSERT_EQ(std::get<long double>(lexer.literal(token).data), std::stold(text)) << text;
+    }
+}
+
+TEST(Lexer, Strings) {
+    std::string input{"\"plain\" \"tab\\there \\\"quoted\\\"\" \"\""};
+    lynx::Lexer lexer{"", std::move(input)};
+    ASSERT_EQ(lexer.errors_reported(), 0);
+    ASSERT_EQ(lynx::string_of(lexer.literal(lexer.next_token())), "plain");
+    ASSERT_EQ(lynx::string_of(lexer.literal(lexer.next_token())), "tab\there \"quoted\"");
+    const auto empty = lexer.next_token();
+    ASSERT_EQ(empty.type, lynx::Token::Type::STRING);
+    ASSERT_EQ(lynx::string_of(lexer.literal(empty)), "");
+    lynx::Lexer unknown{"", std::string{"\"a\\qb\""}};
+    ASSERT_EQ(unknown.diagnostics()[0].message, "Unknown escape sequence '\\q'");
+    lynx::Lexer unterminated{"", std::string{"\"abc\\\"def"}};
+    ASSERT_EQ(unterminated.diagnostics()[0].message, "Unterminated string");
 }
 
 TEST(Lexer, Brackets) {
@@ -40,3 +66,34 @@ TEST(Lexer, Brackets) {
     ASSERT_EQ(lexer.next_token().type, lynx::Token::Type::R_BRACKET);
 }
 
+
+TEST(Lexer, Range) {
+    std::string input{"0..10"};
+    lynx::Lexer lexer{"", std::move(input)};
+    ASSERT_EQ(lexer.next_token().type, lynx::Token::Type::INTEGER);
+    ASSERT_EQ(lexer.next_token().type, lynx::Token::Type::DOT_DOT);
+    ASSERT_EQ(std::get<long long>(lexer.literal(lexer.next_token()).data), 10);
+}
+
+TEST(Lexer, Source_Locations) {
+    std::string input{"var x: int = 1;\n\n  print \"a\nb\" x;\n"};
+    lynx::Lexer lexer{"script.lnx", std::move(input)};
+    const auto& source_map = lexer.source_map();
+    const auto var = lexer.next_token();
+    ASSERT_EQ(source_map.line(var.offset), 1);
+    ASSERT_EQ(source_map.column(var.offset), 1);
+    for(int i = 0; i < 6; ++i) {
+        lexer.next_token();
+    }
+    const auto print = lexer.next_token();
+    ASSERT_EQ(print.type, lynx::Token::Type::PRINT);
+    ASSERT_EQ(source_map.line(print.offset), 3);
+    ASSERT_EQ(source_map.column(print.offset), 3);
+    lexer.next_token();
+    // Newlines inside strings count too.
+    const auto x = lexer.next_token();
+    ASSERT_EQ(source_map.line(x.offset), 4);
+    ASSERT_EQ(source_map.column(x.offset), 4);
+    const auto diagnostic = source_map.diagnostic("message", x.offset);
+    ASSERT_EQ(to_string(diagnostic), "Error: script.lnx:4:4: message.");
+}
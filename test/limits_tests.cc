@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "interpreter.h"
+
+namespace {
+
+    lynx::Run_Result run(const std::string& input, const lynx::Limits& limits, std::string* printed = nullptr) {
+        const auto compiled = lynx::Program::compile("", input);
+        std::ostringstream stream;
+        lynx::Output_Buffer output{stream};
+        lynx::Interpreter interpreter{output};
+        interpreter.set_limits(limits);
+        auto result = interpreter.run(*compiled.program);
+        output.flush();
+        if(printed != nullptr) {
+            *printed = stream.str();
+        }
+        return result;
+    }
+
+}
+
+TEST(Limits, Steps) {
+    const std::string loop{"var i: int = 0; while i < 100 { i = i + 1; } print i;"};
+    std::string printed;
+    ASSERT_TRUE(run(loop, lynx::Limits{100, 0, {}}, &printed).ok());
+    ASSERT_EQ(printed, "100");
+    const auto result = run(loop, lynx::Limits{99, 0, {}});
+    ASSERT_EQ(result.status, lynx::Run_Result::Status::LIMIT_EXCEEDED);
+    ASSERT_EQ(result.error, "Step limit of 99 exceeded");
+    // Calls are steps too.
+    const std::string recursion{"func f(n: int): int { if n == 0 { return 0; } return 1 + f(n - 1); } print f(50);"};
+    ASSERT_TRUE(run(recursion, lynx::Limits{51, 0, {}}).ok());
+    ASSERT_EQ(run(recursion, lynx::Limits{50, 0, {}}).status, lynx::Run_Result::Status::LIMIT_EXCEEDED);
+}
+
+TEST(Limits, Heap) {
+    const std::string growth{"var s: string = \"x\"; while true { s = s + s; }"};
+    const auto result = run(growth, lynx::Limits{0, 1 << 20, {}});
+    ASSERT_EQ(result.status, lynx::Run_Result::Status::LIMIT_EXCEEDED);
+    ASSERT_EQ(result.error, "Heap limit of 1048576 bytes exceeded");
+    ASSERT_EQ(run("var a: int[] = array(1000000, 0);", lynx::Limits{0, 1 << 20, {}}).status,
+            lynx::Run_Result::Status::LIMIT_EXCEEDED);
+    ASSERT_TRUE(run("var a: int[] = array(1000, 0); print sum(a);", lynx::Limits{0, 1 << 20, {}}).ok());
+    // The stack segments of deep calls are held by the run too.
+    const std::string recursion{"func f(n: int): int { if n == 0 { return 0; } return 1 + f(n - 1); } print f(50000);"};
+    ASSERT_TRUE(run(recursion, lynx::Limits{0, 1 << 30, {}}).ok());
+    ASSERT_EQ(run(recursion, lynx::Limits{0, 1 << 20, {}}).error, "Heap limit of 1048576 bytes exceeded");
+}
+
+TEST(Limits, Time) {
+    const auto result = run("while true { }", lynx::Limits{0, 0, std::chrono::milliseconds{20}});
+    ASSERT_EQ(result.status, lynx::Run_Result::Status::LIMIT_EXCEEDED);
+    ASSERT_EQ(result.error, "Time limit of 20 ms exceeded");
+}
+
+TEST(Limits, Parallel_For) {
+    const std::string loop{"var total: int = 0; parallel for i in 0 .. 1000 reduce sum total { total = total + i; }"
+            "print total;"};
+    std::string printed;
+    ASSERT_TRUE(run(loop, lynx::Limits{2000, 0, {}}, &printed).ok());
+    ASSERT_EQ(printed, "499500");
+    ASSERT_EQ(run("parallel for i in 0 .. 10 { while true { } }", lynx::Limits{10000, 0, {}}).status,
+            lynx::Run_Result::Status::LIMIT_EXCEEDED);
+}
+
+TEST(Limits, Parallel_For_Shares_The_Budget) {
+    // 100 while steps, 100 'parallel for' steps and 640000 iterations, the same count as a serial loop.
+    const std::string loop{"var total: int = 0; var k: int = 0; while k < 100 {"
+            "parallel for i in 0 .. 6400 reduce sum total { total = total + i; } k = k + 1; } print total;"};
+    std::string printed;
+    ASSERT_TRUE(run(loop, lynx::Limits{640200, 0, {}}, &printed).ok());
+    ASSERT_EQ(printed, "2047680000");
+    const auto result = run(loop, lynx::Limits{640199, 0, {}});
+    ASSERT_EQ(result.status, lynx::Run_Result::Status::LIMIT_EXCEEDED);
+    ASSERT_EQ(result.error, "Step limit of 640199 exceeded");
+    ASSERT_EQ(run(loop, lynx::Limits{1000, 0, {}}).status, lynx::Run_Result::Status::LIMIT_EXCEEDED);
+    // Steps of the chunks count after the loop too.
+    ASSERT_EQ(run("parallel for i in 0 .. 1000 { } var i: int = 0; while i < 10 { i = i + 1; }",
+            lynx::Limits{1005, 0, {}}).status, lynx::Run_Result::Status::LIMIT_EXCEEDED);
+    // The chunks' heap counts with what the script held before the loop.
+    const std::string heap{"var held: int[] = array(100000, 0);"
+            "parallel for i in 0 .. 2 { var a: int[] = array(60000, 0); }"};
+    ASSERT_TRUE(run(heap, lynx::Limits{0, 2 << 20, {}}).ok());
+    const auto heap_result = run(heap, lynx::Limits{0, 1 << 20, {}});
+    ASSERT_EQ(heap_result.status, lynx::Run_Result::Status::LIMIT_EXCEEDED);
+    ASSERT_EQ(heap_result.error, "Heap limit of 1048576 bytes exceeded");
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "map.h"
+
+namespace {
+
+    lynx::Value integer(const long long value) {
+        return lynx::Value{lynx::Value::Type::INTEGER, value};
+    }
+
+}
+
+TEST(Map, Grows_And_Keeps_Insertion_Order) {
+    lynx::Map map{lynx::Value::Type::INTEGER, lynx::Value::Type::INTEGER};
+    // Multiples of a large power of two share their low bits, which only a good hash spreads over the slots.
+    for(long long i = 0; i < 100000; ++i) {
+        map.store(integer(i << 32), integer(i));
+    }
+    ASSERT_EQ(map.size(), 100000u);
+    for(long long i = 0; i < 100000; ++i) {
+        ASSERT_EQ(std::get<long long>(map.load(integer(i << 32)).data), i);
+    }
+    ASSERT_FALSE(map.contains(integer(1)));
+    ASSERT_EQ(std::get<long long>(map.entries()[12345].key.data), 12345LL << 32);
+}
+
+TEST(Map, Overwrites_And_Defaults) {
+    lynx::Map map{lynx::Value::Type::STRING, lynx::Value::Type::STRING, 1000};
+    const auto key = lynx::make_string("key");
+    ASSERT_EQ(lynx::string_of(map.load(key)), "");
+    map.store(key, lynx::make_string("first"));
+    map.store(key, lynx::make_string("second"));
+    ASSERT_EQ(map.size(), 1u);
+    ASSERT_EQ(lynx::string_of(map.load(key)), "second");
+    ASSERT_EQ(lynx::type_name(map), "string[string]");
+}
+
+TEST(Map, Type_Names) {
+    ASSERT_EQ(lynx::map_types("float[string]").first, lynx::Value::Type::STRING);
+    ASSERT_EQ(lynx::map_types("float[string]").second, lynx::Value::Type::FLOAT);
+    ASSERT_EQ(lynx::map_types("int[]").first, lynx::Value::Type::VOID);
+    ASSERT_EQ(lynx::map_types("int[float]").first, lynx::Value::Type::VOID);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "interpreter.h"
+#include "module.h"
+
+namespace {
+
+    // Directory of module files that is removed with the fixture.
+    class Module_Files {
+    public:
+        explicit Module_Files(const std::string& name)
+                : _directory{std::filesystem::temp_directory_path() / ("lynx_modules_" + name)} {
+            std::filesystem::remove_all(_directory);
+            std::filesystem::create_directories(_directory);
+        }
+
+        ~Module_Files() {
+            std::filesystem::remove_all(_directory);
+        }
+
+        void write(const std::string& name, const std::string& code) const {
+            std::ofstream{_directory / name} << code;
+        }
+
+        std::string path(const std::string& name) const {
+            return (_directory / name).string();
+        }
+
+    private:
+        std::filesystem::path _directory;
+    };
+
+    std::string run(const Module_Files& files, const std::string& code) {
+        const auto compiled = lynx::Program::compile(files.path("main.lnx"), code);
+        if(compiled.program == nullptr) {
+            return "Error: " + compiled.diagnostics[0].message;
+        }
+        std::ostringstream stream;
+        lynx::Output_Buffer output{stream};
+        lynx::Interpreter interpreter{output};
+        if(const auto result = interpreter.run(*compiled.program); !result.ok()) {
+            output << "Error: " << result.error;
+        }
+        output.flush();
+        return stream.str();
+    }
+
+}
+
+TEST(Module, Modules_Run_First_And_Once) {
+    const Module_Files files{"run"};
+    files.write("a.lnx", "var greeting: string = \"hi\"; func twice(n: int): int { return n * 2; } print \"a \";");
+    files.write("b.lnx", "import \"a.lnx\"; func quad(n: int): int { return twice(twice(n)); } print \"b \";");
+    ASSERT_EQ(run(files, "import \"b.lnx\"; import \"a.lnx\"; print quad(3); print twice(1); print greeting;"),
+            "a b 122hi");
+}
+
+TEST(Module, Only_Direct_Imports_Are_Visible) {
+    const Module_Files files{"visible"};
+    files.write("a.lnx", "func twice(n: int): int { return n * 2; }");
+    files.write("b.lnx", "import \"a.lnx\"; func quad(n: int): int { return twice(twice(n)); }");
+    ASSERT_EQ(run(files, "import \"b.lnx\"; print twice(1);"), "Error: 'twice' is not a function");
+    files.write("c.lnx", "func twice(n: int): int { return n + n; }");
+    ASSERT_EQ(run(files, "import \"a.lnx\"; import \"c.lnx\";"),
+            "Error: Function 'twice' is imported from both \"a.lnx\" and \"c.lnx\"");
+    ASSERT_EQ(run(files, "import \"a.lnx\"; func twice(n: int): int { return n; }"),
+            "Error: Redefinition of function 'twice'");
+}
+
+TEST(Module, Errors) {
+    const Module_Files files{"errors"};
+    ASSERT_EQ(run(files, "import \"missing.lnx\";"), "Error: Can't find module \"missing.lnx\"");
+    files.write("a.lnx", "import \"b.lnx\";");
+    files.write("b.lnx", "import \"a.lnx\";");
+    ASSERT_EQ(run(files, "import \"a.lnx\";"), "Error: Circular import of \"a.lnx\"");
+    files.write("broken.lnx", "var x: int = ;");
+    const auto compiled = lynx::Program::compile(files.path("main.lnx"), "import \"broken.lnx\";");
+    ASSERT_EQ(compiled.diagnostics.size(), 1);
+    ASSERT_EQ(compiled.diagnostics[0].filename, files.path("broken.lnx"));
+    ASSERT_EQ(run(files, "func f() { import \"a.lnx\"; }"), "Error: 'import' has to be at the top level");
+}
+
+TEST(Module, Cached_Until_Changed) {
+    const Module_Files files{"cache"};
+    files.write("a.lnx", "func value(): int { return 1; }");
+    files.write("b.lnx", "import \"a.lnx\"; func twice(): int { return 2 * value(); }");
+    auto& cache = lynx::Module_Cache::shared();
+    const auto misses = cache.misses();
+    const auto hits = cache.hits();
+    const std::string main{"import \"b.lnx\"; print twice();"};
+    ASSERT_EQ(run(files, main), "2");
+    ASSERT_EQ(cache.misses(), misses + 2);
+    ASSERT_EQ(run(files, main), "2");
+    ASSERT_EQ(cache.misses(), misses + 2);
+    ASSERT_EQ(cache.hits(), hits + 2);
+    // b is unchanged but was bound to the old a, so it is compiled again as well.
+    files.write("a.lnx", "func value(): int { return 21; }");
+    ASSERT_EQ(run(files, main), "42");
+    ASSERT_EQ(cache.misses(), misses + 4);
+}
+
+TEST(Module, Many_Modules) {
+    const Module_Files files{"many"};
+    std::string main;
+    std::string expected;
+    for(int i = 0; i < 50; ++i) {
+        const auto name = "m" + std::to_string(i) + ".lnx";
+        files.write(name, "import \"common.lnx\"; func f" + std::to_string(i) + "(): int { return base() + "
+                + std::to_string(i) + "; }");
+        main += "import \"" + name + "\"; print f" + std::to_string(i) + "();";
+        expected += std::to_string(100 + i);
+    }
+    files.write("common.lnx", "func base(): int { return 100; }");
+    ASSERT_EQ(run(files, main), expected);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "map.h"
 #include "parser.h"
 
 TEST(Parser, Free_Expression) {
@@ -20,3 +21,58 @@ TEST(Parser, Function_Declaration) {
     ASSERT_EQ(parser.errors_reported(), 0);
 }
 
+
+TEST(Parser, Function_Parameters) {
+    std::string input{"func add(a: int, b: int): int { return a + b; }"};
+    lynx::Lexer lexer{"", std::move(input)};
+    lynx::Parser parser{lexer};
+    auto result = parser.parse();
+    ASSERT_EQ(lexer.errors_reported(), 0);
+    ASSERT_EQ(parser.errors_reported(), 0);
+    ASSERT_EQ(result.size(), 1);
+    const auto& function = dynamic_cast<const lynx::Function_Declaration&>(*result[0]);
+    ASSERT_EQ(function.parameters.size(), 2);
+    ASSERT_EQ(function.parameters[1].name, "b");
+    ASSERT_EQ(function.return_type, "int");
+}
+
+TEST(Parser, Tail_Call) {
+    std::string input{"func loop(n: int) { return loop(n); }"};
+    lynx::Lexer lexer{"", std::move(input)};
+    lynx::Parser parser{lexer};
+    auto result = parser.parse();
+    ASSERT_EQ(parser.errors_reported(), 0);
+    const auto& function = dynamic_cast<const lynx::Function_Declaration&>(*result[0]);
+    const auto& body = dynamic_cast<const lynx::Block&>(*function.body);
+    const auto& return_stmt = dynamic_cast<const lynx::Return&>(*body.statements[0]);
+    ASSERT_NE(return_stmt.tail_call, nullptr);
+}
+
+TEST(Parser, Arrays) {
+    std::string input{"func f(xs: float[]): int[] { xs[0] = 1.0; return [len(xs), 2]; }"};
+    lynx::Lexer lexer{"", std::move(input)};
+    lynx::Parser parser{lexer};
+    auto result = parser.parse();
+    ASSERT_EQ(parser.errors_reported(), 0);
+    const auto& function = dynamic_cast<const lynx::Function_Declaration&>(*result[0]);
+    ASSERT_EQ(function.parameters[0].type, "float[]");
+    ASSERT_EQ(function.return_type, "int[]");
+    const auto& body = dynamic_cast<const lynx::Block&>(*function.body);
+    const auto& store = dynamic_cast<const lynx::Expression&>(*body.statements[0]);
+    ASSERT_NE(dynamic_cast<const lynx::Index_Assignment*>(store.expression.get()), nullptr);
+}
+
+TEST(Parser, Maps) {
+    std::string input{"func f(m: int[string]): float[int] { m[\"a\"] = 1; return {1: 2.0}; }"};
+    lynx::Lexer lexer{"", std::move(input)};
+    lynx::Parser parser{lexer};
+    auto result = parser.parse();
+    ASSERT_EQ(parser.errors_reported(), 0);
+    const auto& function = dynamic_cast<const lynx::Function_Declaration&>(*result[0]);
+    ASSERT_EQ(function.parameters[0].type, "int[string]");
+    ASSERT_EQ(function.return_type, "float[int]");
+    const auto& body = dynamic_cast<const lynx::Block&>(*function.body);
+    const auto& store = dynamic_cast<const lynx::Expression&>(*body.statements[0]);
+    const auto& assignment = dynamic_cast<const lynx::Index_Assignment&>(*store.expression);
+    ASSERT_EQ(assignment.key_hash, lynx::Map::hash(lynx::make_string("a")));
+}
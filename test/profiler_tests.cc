@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "interpreter.h"
+#include "profiler.h"
+
+namespace {
+
+    // The program is returned in 'compiled' because the profiler's reports refer to its functions.
+    void profile(std::string input, lynx::Profiler& profiler, lynx::Compile_Result& compiled) {
+        compiled = lynx::Program::compile("", std::move(input));
+        ASSERT_TRUE(compiled.diagnostics.empty());
+        std::ostringstream stream;
+        lynx::Output_Buffer output{stream};
+        lynx::Interpreter interpreter{output};
+        interpreter.set_profiler(&profiler);
+        profiler.start();
+        ASSERT_TRUE(interpreter.run(*compiled.program).ok());
+        profiler.stop();
+    }
+
+}
+
+TEST(Profiler, Counts_Lines_And_Calls) {
+    lynx::Profiler profiler;
+    lynx::Compile_Result compiled;
+    profile("func fib(n: int): int {\n"
+            "    if n < 2 { return n; }\n"
+            "    return fib(n - 1) + fib(n - 2);\n"
+            "}\n"
+            "func count(n: int, acc: int): int { if n == 0 { return acc; } return count(n - 1, acc + 1); }\n"
+            "print fib(10);\n"
+            "print count(5, 0);\n", profiler, compiled);
+    ASSERT_EQ(profiler.calls("fib"), 177u);
+    // Tail calls still count as calls.
+    ASSERT_EQ(profiler.calls("count"), 6u);
+    // The 'if', and the block and 'return' of the calls that take it.
+    ASSERT_EQ(profiler.executions(2), 177u + 2 * 89u);
+    ASSERT_EQ(profiler.executions(3), 88u);
+    ASSERT_EQ(profiler.executions(6), 1u);
+}
+
+TEST(Profiler, Samples_Call_Paths) {
+    lynx::Profiler profiler{std::chrono::microseconds{200}};
+    lynx::Compile_Result compiled;
+    profile("func spin(n: int): int {\n"
+            "    var i: int = 0; var total: int = 0;\n"
+            "    while i < n { total = total + i; i = i + 1; }\n"
+            "    return total;\n"
+            "}\n"
+            "var k: int = 0;\n"
+            "while k < 4 { spin(50000); k = k + 1; }\n", profiler, compiled);
+    ASSERT_GT(profiler.samples(), 0u);
+    std::ostringstream stacks;
+    profiler.write_collapsed_stacks(stacks);
+    ASSERT_NE(stacks.str().find("main;spin;line 3 "), std::string::npos);
+    std::ostringstream report;
+    profiler.write_report(report);
+    ASSERT_NE(report.str().find("\n  spin  "), std::string::npos);
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+
+#include "interpreter.h"
+
+TEST(Program, Compile_Errors_Are_Returned) {
+    const auto compiled = lynx::Program::compile("script.lnx", "var x: int = ;\nprint missing(1);");
+    ASSERT_EQ(compiled.program, nullptr);
+    ASSERT_EQ(compiled.diagnostics.size(), 1);
+    ASSERT_EQ(compiled.diagnostics[0].filename, "script.lnx");
+    ASSERT_EQ(compiled.diagnostics[0].line, 1);
+}
+
+TEST(Program, Unknown_Function) {
+    const auto compiled = lynx::Program::compile("script.lnx", "print missing(1);");
+    ASSERT_EQ(compiled.program, nullptr);
+    ASSERT_EQ(compiled.diagnostics.size(), 1);
+    ASSERT_EQ(compiled.diagnostics[0].message, "'missing' is not a function");
+}
+
+TEST(Program, Runtime_Errors_Are_Returned) {
+    const auto compiled = lynx::Program::compile("", "print undefined;");
+    ASSERT_NE(compiled.program, nullptr);
+    std::ostringstream stream;
+    lynx::Output_Buffer output{stream};
+    lynx::Interpreter interpreter{output};
+    const auto result = interpreter.run(*compiled.program);
+    output.flush();
+    ASSERT_EQ(result.status, lynx::Run_Result::Status::RUNTIME_ERROR);
+    ASSERT_EQ(result.error, "'undefined' is undefined");
+    ASSERT_EQ(stream.str(), "");
+}
+
+TEST(Program, Interpreter_Is_Reusable) {
+    const auto compiled = lynx::Program::compile("", "var x: int = 1; print x;");
+    std::ostringstream stream;
+    lynx::Output_Buffer output{stream};
+    lynx::Interpreter interpreter{output};
+    ASSERT_TRUE(interpreter.run(*compiled.program).ok());
+    ASSERT_TRUE(interpreter.run(*compiled.program).ok());
+    output.flush();
+    ASSERT_EQ(stream.str(), "11");
+}
+
+TEST(Program, Shared_Between_Threads) {
+    const auto compiled = lynx::Program::compile("", "func fib(n: int): int { if n < 2 { return n; } "
+            "return fib(n - 1) + fib(n - 2); } var i: int = 0; while i < 10 { i = i + 1; } print fib(15) + i;");
+    ASSERT_NE(compiled.program, nullptr);
+    std::vector<std::string> results(4);
+    std::vector<std::thread> threads;
+    for(std::size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&program = *compiled.program, &result = results[i]] {
+            std::ostringstream stream;
+            lynx::Output_Buffer output{stream};
+            lynx::Interpreter interpreter{output};
+            for(int run = 0; run < 20; ++run) {
+                interpreter.run(program);
+            }
+            output.flush();
+            result = stream.str();
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    for(const auto& result : results) {
+        ASSERT_EQ(result.size(), 20 * 3);
+        ASSERT_EQ(result.substr(0, 3), "620");
+    }
+}
+
+TEST(Program, Generator_Errors) {
+    const auto compiled = lynx::Program::compile("", "yield 1;\nfunc g() { yield 1; return 2; }");
+    ASSERT_EQ(compiled.program, nullptr);
+    ASSERT_EQ(compiled.diagnostics.size(), 2);
+    ASSERT_EQ(compiled.diagnostics[0].message, "'yield' outside of a function");
+    ASSERT_EQ(compiled.diagnostics[1].message, "Generator 'g' can't return a value");
+}
+
+TEST(Program, Unknown_Types_Of_Functions) {
+    const auto compiled = lynx::Program::compile("", "func f(n: integer): text { return n; }");
+    ASSERT_EQ(compiled.program, nullptr);
+    ASSERT_EQ(compiled.diagnostics.size(), 2);
+    ASSERT_EQ(compiled.diagnostics[0].message, "Unknown type 'integer' of parameter 'n'");
+    ASSERT_EQ(compiled.diagnostics[1].message, "Unknown return type 'text'");
+}
+
+namespace {
+
+    std::string run_lazy(const std::string& code) {
+        const auto compiled = lynx::Program::compile("lazy.lnx", code, nullptr, lynx::Body_Compilation::LAZY);
+        if(compiled.program == nullptr) {
+            return "Error: " + compiled.diagnostics[0].message;
+        }
+        std::ostringstream stream;
+        lynx::Output_Buffer output{stream};
+        lynx::Interpreter interpreter{output};
+        if(const auto result = interpreter.run(*compiled.program); !result.ok()) {
+            output << "Error: " << result.error;
+        }
+        output.flush();
+        return stream.str();
+    }
+
+}
+
+TEST(Program, Lazy_Bodies_Compile_On_First_Call) {
+    const auto compiled = lynx::Program::compile("lazy.lnx", "func unused(n: int): int { return n + 1; }\n"
+            "func used(n: int): int { return n * 2; }\nprint used(2); print used(3);", nullptr,
+            lynx::Body_Compilation::LAZY);
+    ASSERT_NE(compiled.program, nullptr);
+    const auto lazy = compiled.program->lazy_bodies();
+    ASSERT_NE(lazy, nullptr);
+    ASSERT_EQ(lazy->size(), 2);
+    ASSERT_EQ(lazy->compiled(), 0);
+    std::ostringstream stream;
+    lynx::Output_Buffer output{stream};
+    lynx::Interpreter interpreter{output};
+    ASSERT_TRUE(interpreter.run(*compiled.program).ok());
+    ASSERT_TRUE(interpreter.run(*compiled.program).ok());
+    output.flush();
+    ASSERT_EQ(stream.str(), "4646");
+    ASSERT_EQ(lazy->compiled(), 1);
+}
+
+TEST(Program, Lazy_Bodies_Run_Like_Eager_Ones) {
+    ASSERT_EQ(run_lazy("func fib(n: int): int { if n < 2 { return n; } return fib(n - 1) + fib(n - 2); }"
+            "print fib(15);"), "610");
+    ASSERT_EQ(run_lazy("func count(n: int): int { if n == 0 { return 0; } return count(n - 1); }"
+            "func size(a: int[]): int { return len(a); } print count(10000); print size([1, 2]);"), "02");
+    ASSERT_EQ(run_lazy("func g(n: int) { var i: int = 0; while i < n { yield i; i = i + 1; } }"
+            "for x in g(3) { print x; }"), "012");
+    ASSERT_EQ(run_lazy("func outer(): int { func inner(): int { return 5; } return inner(); } print outer();"),
+            "5");
+}
+
+TEST(Program, Lazy_Body_Errors_Are_Raised_On_Call) {
+    const std::string code = "func broken(): int { return 1 +; }\nfunc unknown(): int { return missing(); }\n";
+    ASSERT_EQ(run_lazy(code + "print 1;"), "1");
+    ASSERT_EQ(run_lazy(code + "print broken();"), "Error: lazy.lnx:1:32: Not a primary expression");
+    ASSERT_EQ(run_lazy(code + "print unknown();"), "Error: lazy.lnx:2:30: 'missing' is not a function");
+    const auto eager = lynx::Program::compile("lazy.lnx", code + "print 1;");
+    ASSERT_EQ(eager.program, nullptr);
+    ASSERT_EQ(eager.diagnostics.size(), 2);
+}
+
+TEST(Program, Lazy_Bodies_Shared_Between_Threads) {
+    const auto compiled = lynx::Program::compile("", "func a(n: int): int { return n + 1; }"
+            "func b(n: int): int { return a(n) * 2; } print b(20);", nullptr, lynx::Body_Compilation::LAZY);
+    ASSERT_NE(compiled.program, nullptr);
+    std::vector<std::string> results(8);
+    std::vector<std::thread> threads;
+    for(std::size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&program = *compiled.program, &result = results[i]] {
+            std::ostringstream stream;
+            lynx::Output_Buffer output{stream};
+            lynx::Interpreter interpreter{output};
+            interpreter.run(program);
+            output.flush();
+            result = stream.str();
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    for(const auto& result : results) {
+        ASSERT_EQ(result, "42");
+    }
+    ASSERT_EQ(compiled.program->lazy_bodies()->compiled(), 2);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "server.h"
+
+namespace {
+
+    std::string temp_path(const std::string& name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    // Runs a script through the server until it answers, since it may not be listening yet.
+    int run_remote(const std::string& socket, const std::string& script, std::string& output_text,
+            std::string& errors_text) {
+        for(int attempt = 0; attempt < 500; ++attempt) {
+            output_text.clear();
+            errors_text.clear();
+            lynx::Output_Buffer output{output_text};
+            lynx::Output_Buffer errors{errors_text};
+            if(const auto status = lynx::run_remote(socket, script, output, errors); status >= 0) {
+                return status;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+        return -1;
+    }
+
+}
+
+TEST(Server, Cache_Invalidation) {
+    const auto path = temp_path("lynx_server_cache.lnx");
+    std::ofstream{path} << "print 1;\n";
+    lynx::Program_Cache cache;
+    const auto first = cache.get(path);
+    ASSERT_NE(first.program, nullptr);
+    ASSERT_EQ(cache.get(path).program, first.program);
+    ASSERT_EQ(cache.hits(), 1);
+    ASSERT_EQ(cache.misses(), 1);
+    std::ofstream{path} << "print 12;\n";
+    ASSERT_NE(cache.get(path).program, first.program);
+    ASSERT_EQ(cache.misses(), 2);
+    std::filesystem::remove(path);
+    const auto missing = cache.get(path);
+    ASSERT_EQ(missing.program, nullptr);
+    ASSERT_TRUE(missing.diagnostics.empty());
+}
+
+TEST(Server, Round_Trip) {
+    const auto socket = temp_path("lynx_server_test.sock");
+    const auto script = temp_path("lynx_server_script.lnx");
+    const auto broken = temp_path("lynx_server_broken.lnx");
+    std::ofstream{script} << "func f(n: int): int { return n * 2; }\nprint f(21);\n";
+    std::ofstream{broken} << "print (;\n";
+    lynx::Server server{socket, 2};
+    std::thread serving{[&server] { server.serve(); }};
+    std::string output;
+    std::string errors;
+    ASSERT_EQ(run_remote(socket, script, output, errors), 0);
+    ASSERT_EQ(output, "42");
+    ASSERT_EQ(run_remote(socket, script, output, errors), 0);
+    ASSERT_EQ(output, "42");
+    ASSERT_EQ(server.cache().hits(), 1);
+    ASSERT_EQ(run_remote(socket, broken, output, errors), 2);
+    ASSERT_NE(errors.find("lynx_server_broken.lnx"), std::string::npos);
+    ASSERT_EQ(run_remote(socket, temp_path("lynx_server_missing.lnx"), output, errors), 1);
+    ASSERT_NE(errors.find("not found"), std::string::npos);
+    server.stop();
+    serving.join();
+    ASSERT_FALSE(std::filesystem::exists(socket));
+    std::filesystem::remove(script);
+    std::filesystem::remove(broken);
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <sstream>
+
+#include "big_integer.h"
+#include "interpreter.h"
+
+namespace {
+
+    const std::string SCRIPT{
+            "var squares: int[] = array(100, 0); var i: int = 0;"
+            "while i < 100 { squares[i] = i * i; i = i + 1; }"
+            "var names: int[string] = {\"one\": 1, \"two\": 2};"
+            "var ratio: float = 0.75; var flags: bool[] = [true, false]; var greeting: string = \"hello\";"
+            "func square(n: int): int { return squares[n]; }"
+            "print \"prologue \";"
+            "snapshot();"
+            "names[\"three\"] = 3;"
+            "print square(12); print names; print ratio; print flags; print greeting;"};
+
+    std::string run(const lynx::Program& program, const lynx::Snapshot* snapshot) {
+        std::ostringstream stream;
+        lynx::Output_Buffer output{stream};
+        lynx::Interpreter interpreter{output};
+        const auto result = snapshot == nullptr ? interpreter.run(program)
+                : interpreter.run_from_snapshot(program, *snapshot);
+        if(!result.ok()) {
+            output << "Error: " << result.error;
+        }
+        output.flush();
+        return stream.str();
+    }
+
+}
+
+TEST(Snapshot, Restore_Matches_A_Full_Run) {
+    const auto compiled = lynx::Program::compile("", SCRIPT);
+    ASSERT_NE(compiled.program, nullptr);
+    std::ostringstream stream;
+    lynx::Output_Buffer output{stream};
+    lynx::Interpreter interpreter{output};
+    lynx::Snapshot snapshot;
+    ASSERT_TRUE(interpreter.run_to_snapshot(*compiled.program, snapshot).ok());
+    output.flush();
+    ASSERT_EQ(stream.str(), "prologue ");
+    ASSERT_EQ(snapshot.globals.size(), 6);
+    ASSERT_EQ(snapshot.globals[0].name, "squares");
+
+    const auto path = (std::filesystem::temp_directory_path() / "lynx_snapshot_test.snap").string();
+    lynx::write_snapshot(path, snapshot);
+    const auto restored = lynx::read_snapshot(path);
+    std::filesystem::remove(path);
+    // A fresh compilation of the same source, as in a later process.
+    const auto recompiled = lynx::Program::compile("", SCRIPT);
+    const auto full = run(*recompiled.program, nullptr);
+    ASSERT_EQ(full, "prologue 144{one: 1, two: 2, three: 3}0.75[true, false]hello");
+    ASSERT_EQ("prologue " + run(*recompiled.program, &restored), full);
+}
+
+TEST(Snapshot, Different_Source_Is_Rejected) {
+    const auto compiled = lynx::Program::compile("", "var x: int = 1; snapshot(); print x;");
+    lynx::Snapshot snapshot;
+    std::ostringstream stream;
+    lynx::Output_Buffer output{stream};
+    lynx::Interpreter interpreter{output};
+    ASSERT_TRUE(interpreter.run_to_snapshot(*compiled.program, snapshot).ok());
+    const auto changed = lynx::Program::compile("", "var x: int = 2; snapshot(); print x;");
+    ASSERT_EQ(run(*changed.program, &snapshot), "Error: The snapshot wasn't taken of this script");
+}
+
+TEST(Snapshot, Generators_Are_Rejected) {
+    const auto compiled = lynx::Program::compile("", "func g() { yield 1; } var x: int = g(); snapshot();");
+    ASSERT_NE(compiled.program, nullptr);
+    lynx::Snapshot snapshot;
+    std::ostringstream stream;
+    lynx::Output_Buffer output{stream};
+    lynx::Interpreter interpreter{output};
+    const auto result = interpreter.run_to_snapshot(*compiled.program, snapshot);
+    ASSERT_FALSE(result.ok());
+    ASSERT_EQ(result.error, "Generator 'x' can't be stored in a snapshot");
+}
+
+TEST(Snapshot, Marker_Only_At_Top_Level) {
+    auto compiled = lynx::Program::compile("", "func f() { snapshot(); }");
+    ASSERT_EQ(compiled.diagnostics.size(), 1);
+    ASSERT_EQ(compiled.diagnostics[0].message, "'snapshot()' has to be a statement at the top level");
+    compiled = lynx::Program::compile("", "snapshot(); snapshot();");
+    ASSERT_EQ(compiled.diagnostics.size(), 1);
+    compiled = lynx::Program::compile("", "var x: int = 1; print x;");
+    ASSERT_EQ(compiled.program->snapshot_point(), lynx::Program::NO_SNAPSHOT);
+}
+
+TEST(Snapshot, Corrupt_File_Is_Rejected) {
+    const auto path = (std::filesystem::temp_directory_path() / "lynx_snapshot_corrupt.snap").string();
+    lynx::Snapshot snapshot;
+    snapshot.globals.push_back(lynx::Snapshot::Global{"s", lynx::make_string("text")});
+    lynx::write_snapshot(path, snapshot);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 2);
+    ASSERT_THROW(lynx::read_snapshot(path), std::runtime_error);
+    std::filesystem::resize_file(path, 0);
+    ASSERT_THROW(lynx::read_snapshot(path), std::runtime_error);
+    std::filesystem::remove(path);
+    ASSERT_THROW(lynx::read_snapshot(path), std::runtime_error);
+}
+
+TEST(Snapshot, Big_Integers) {
+    const auto path = (std::filesystem::temp_directory_path() / "lynx_snapshot_big.snap").string();
+    lynx::Snapshot snapshot;
+    snapshot.globals.push_back(lynx::Snapshot::Global{"big", lynx::make_integer(
+            lynx::Big_Integer::parse("-123456789012345678901234567890"))});
+    snapshot.globals.push_back(lynx::Snapshot::Global{"small", lynx::Value{lynx::Value::Type::INTEGER, 42LL}});
+    lynx::write_snapshot(path, snapshot);
+    const auto restored = lynx::read_snapshot(path);
+    std::filesystem::remove(path);
+    ASSERT_EQ(lynx::compare_integers(restored.globals[0].value, snapshot.globals[0].value), 0);
+    ASSERT_EQ(std::get<long long>(restored.globals[1].value.data), 42);
+}
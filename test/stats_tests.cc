@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "program.h"
+#include "stats.h"
+
+TEST(Stats, Records_Phases) {
+    lynx::Phase_Recorder phases;
+    phases.begin("first");
+    std::vector<std::unique_ptr<int>> allocated;
+    for(int i = 0; i < 100; ++i) {
+        allocated.push_back(std::make_unique<int>(i));
+    }
+    phases.begin("second");
+    phases.end();
+    ASSERT_EQ(phases.phases().size(), 2u);
+    ASSERT_EQ(phases.phases()[0].name, "first");
+    ASSERT_GE(phases.phases()[0].allocations, 100u);
+    ASSERT_EQ(phases.phases()[1].allocations, 0u);
+    ASSERT_GT(phases.phases()[1].peak_rss_bytes, 0u);
+}
+
+TEST(Stats, Counts_Tokens_And_Nodes) {
+    lynx::Phase_Recorder phases;
+    const auto compiled = lynx::Program::compile("", "var a: int = 1 + 2; print a;", &phases);
+    ASSERT_TRUE(compiled.diagnostics.empty());
+    // var a : int = 1 + 2 ; print a ;
+    ASSERT_EQ(compiled.program->tokens(), 12u);
+    // The declaration, its binary operation and two literals, the print and its identifier.
+    ASSERT_EQ(compiled.program->nodes(), 6u);
+    std::vector<std::string> names;
+    for(const auto& phase : phases.phases()) {
+        names.push_back(phase.name);
+    }
+    ASSERT_EQ(names, (std::vector<std::string>{"lex", "parse", "fuse", "resolve"}));
+
+    std::ostringstream json;
+    lynx::write_stats_json(json, lynx::Run_Stats{phases.phases(), compiled.program->tokens(),
+            compiled.program->nodes()});
+    ASSERT_EQ(json.str().rfind("{\n  \"phases\": [\n    {\"name\": \"lex\", \"wall_seconds\": ", 0), 0u);
+    ASSERT_NE(json.str().find("\"tokens\": 12,\n  \"nodes\": 6,\n"), std::string::npos);
+}
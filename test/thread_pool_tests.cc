@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+#include "thread_pool.h"
+
+TEST(Thread_Pool, Runs_All_Tasks) {
+    lynx::Thread_Pool pool{4};
+    lynx::Task_Group group;
+    std::atomic<int> sum{};
+    for(int i = 1; i <= 1000; ++i) {
+        pool.submit(group, [&sum, i] {
+            sum += i;
+        });
+    }
+    pool.wait(group);
+    ASSERT_TRUE(group.done());
+    ASSERT_EQ(sum.load(), 500500);
+}
+
+TEST(Thread_Pool, Nested_Groups) {
+    lynx::Thread_Pool pool{2};
+    lynx::Task_Group outer;
+    std::atomic<int> count{};
+    for(int i = 0; i < 8; ++i) {
+        pool.submit(outer, [&pool, &count] {
+            lynx::Task_Group inner;
+            for(int j = 0; j < 8; ++j) {
+                pool.submit(inner, [&count] {
+                    ++count;
+                });
+            }
+            pool.wait(inner);
+        });
+    }
+    pool.wait(outer);
+    ASSERT_EQ(count.load(), 64);
+}